@@ -0,0 +1,117 @@
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include "include/actor.h"
+
+// The ping-pong latency between two actors and the throughput of many actors, that pass
+// the messages to each other, on task_scheduler. A message is passed on without a new allocation,
+// so the timings include only the mailboxes, the activations and the scheduling.
+
+struct BenchMessage : public RefCountObject<BenchMessage>, public intrusive_mpsc_hook<>
+{
+	BenchMessage(uint64_t hops, uint64_t seed) : Hops(hops), Seed(seed) { }
+
+	uint64_t Hops;
+	uint64_t Seed;
+};
+
+/// <summary>
+/// An actor, that passes each message to a random actor, or to the next one, if the seed is zero,
+/// until the message has made all its hops
+/// </summary>
+class Relay final : public actor<Relay, BenchMessage>
+{
+public:
+	Relay(task_scheduler& scheduler, size_t batch_size, std::vector<Relay*>& peers, std::atomic<size_t>& finished)
+		: actor(scheduler, batch_size), Peers(peers), Finished(finished), Index(peers.size()) { }
+
+	void receive(intrusive_ptr<BenchMessage> message) noexcept
+	{
+		if (--message->Hops == 0)
+		{
+			if (Finished.fetch_sub(1, std::memory_order_acq_rel) == 1)
+			{
+				Finished.notify_all();
+			}
+			return;
+		}
+
+		if (message->Seed == 0)
+		{
+			Peers[(Index + 1) % Peers.size()]->send(std::move(message));
+			return;
+		}
+		message->Seed = message->Seed * 6364136223846793005ull + 1442695040888963407ull;
+		Peers[(message->Seed >> 33) % Peers.size()]->send(std::move(message));
+	}
+
+	std::vector<Relay*>& Peers;
+	std::atomic<size_t>& Finished;
+	size_t Index;
+};
+
+/// <summary>
+/// Passes the messages between the actors and measures the hops per second
+/// </summary>
+static double relay(task_scheduler& scheduler, size_t actor_count, size_t message_count, uint64_t hops, size_t batch_size, bool random)
+{
+	auto peers = std::vector<Relay*>();
+	auto actors = std::vector<intrusive_ptr<Relay>>();
+	auto finished = std::atomic<size_t>(message_count);
+	for (size_t i = 0; i < actor_count; ++i)
+	{
+		actors.push_back(intrusive_ptr<Relay>(new Relay(scheduler, batch_size, peers, finished)));
+		peers.push_back(actors.back().get());
+	}
+
+	auto messages = std::vector<intrusive_ptr<BenchMessage>>();
+	for (size_t i = 0; i < message_count; ++i)
+	{
+		messages.push_back(make_intrusive<BenchMessage>(hops, random ? i + 1 : 0));
+	}
+
+	auto start = std::chrono::steady_clock::now();
+	for (size_t i = 0; i < message_count; ++i)
+	{
+		actors[i % actor_count]->send(std::move(messages[i]));
+	}
+	for (auto remaining = finished.load(std::memory_order_acquire); remaining != 0; remaining = finished.load(std::memory_order_acquire))
+	{
+		finished.wait(remaining, std::memory_order_acquire);
+	}
+	auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	scheduler.wait_idle();
+	return static_cast<double>(message_count * hops) / elapsed;
+}
+
+int main()
+{
+	auto hardware = std::max(std::thread::hardware_concurrency(), 1u);
+	constexpr auto exchanges = uint64_t(1000000);
+
+	printf("Ping-pong of one message between two actors, %llu hops\n", static_cast<unsigned long long>(exchanges));
+	for (unsigned workers = 1; workers <= std::min(hardware, 2u); ++workers)
+	{
+		auto scheduler = task_scheduler(workers);
+		auto rate = relay(scheduler, 2, 1, exchanges, 64, false);
+		printf("%2u workers   %8.1f ns per hop\n", workers, 1e9 / rate);
+	}
+
+	printf("\nMany actors, each message makes 100 hops between random actors\n");
+	for (unsigned workers = 1; workers <= hardware; workers *= 2)
+	{
+		auto scheduler = task_scheduler(workers);
+		for (auto actor_count : { size_t(100), size_t(10000) })
+		{
+			printf("%2u workers %6zu actors   batch 1 %7.2f Mhops/s   batch 64 %7.2f Mhops/s\n", workers, actor_count,
+				relay(scheduler, actor_count, actor_count * 4, 100, 1, true) / 1e6,
+				relay(scheduler, actor_count, actor_count * 4, 100, 64, true) / 1e6);
+		}
+	}
+	return 0;
+}
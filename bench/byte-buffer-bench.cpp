@@ -0,0 +1,170 @@
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstring>
+#include <deque>
+#include <span>
+#include <vector>
+#include "include/byte_buffer.h"
+
+// The parse-and-forward of the length-prefixed messages of 64 KiB: the bytes are received in chunks
+// of 16 KiB, each complete message is forwarded to one or several outputs, which keep a few messages in flight.
+// byte_slice receives into the buffers of byte_buffer_pool up to the end of the current message and forwards
+// the received bytes without a copy, the baseline receives into a std::vector and copies each message out.
+
+static constexpr size_t header_size = 4;
+static constexpr size_t payload_size = 65536;
+static constexpr size_t chunk_size = 16384;
+
+/// <summary>
+/// The received stream of the messages, that is repeated from the beginning after its end
+/// </summary>
+class BenchStream final
+{
+public:
+	explicit BenchStream(size_t message_count)
+	{
+		auto seed = uint64_t(1);
+		for (size_t i = 0; i < message_count; ++i)
+		{
+			auto length = static_cast<uint32_t>(payload_size);
+			auto header = reinterpret_cast<const std::byte*>(&length);
+			m_bytes.insert(m_bytes.end(), header, header + header_size);
+			for (size_t j = 0; j < payload_size; ++j)
+			{
+				seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+				m_bytes.push_back(static_cast<std::byte>(seed >> 56));
+			}
+		}
+	}
+
+	/// <summary>
+	/// Copies the next bytes of the stream as a receive call would, at most one chunk at a time
+	/// </summary>
+	inline size_t receive(std::span<std::byte> into) noexcept
+	{
+		auto count = std::min({ into.size(), chunk_size, m_bytes.size() - m_position });
+		std::memcpy(into.data(), m_bytes.data() + m_position, count);
+		m_position = m_position + count == m_bytes.size() ? 0 : m_position + count;
+		return count;
+	}
+
+	inline void rewind() noexcept
+	{
+		m_position = 0;
+	}
+
+private:
+	std::vector<std::byte> m_bytes;
+	size_t m_position { 0 };
+};
+
+static inline uint32_t read_length(const std::byte* header) noexcept
+{
+	auto length = uint32_t(0);
+	std::memcpy(&length, header, header_size);
+	return length;
+}
+
+/// <summary>
+/// Receives until the buffer holds the specified number of the bytes
+/// </summary>
+static inline void receive_until(BenchStream& stream, std::byte* buffer, size_t& received, size_t count) noexcept
+{
+	while (received < count)
+	{
+		received += stream.receive(std::span<std::byte>(buffer + received, count - received));
+	}
+}
+
+/// <summary>
+/// Measures the forwarded bytes per second of the messages received into the pooled buffers
+/// </summary>
+static double forward_slices(BenchStream& stream, size_t message_count, size_t outputs, size_t in_flight, uint64_t& checksum)
+{
+	stream.rewind();
+	auto pool = byte_buffer_pool(header_size + payload_size, 64);
+	auto forwarded = std::deque<byte_slice>();
+	auto start = std::chrono::steady_clock::now();
+	for (size_t i = 0; i < message_count; ++i)
+	{
+		auto buffer = pool.acquire();
+		auto received = size_t(0);
+		receive_until(stream, buffer->data(), received, header_size);
+		receive_until(stream, buffer->data(), received, header_size + read_length(buffer->data()));
+		auto message = byte_slice(std::move(buffer), received);
+		for (size_t output = 0; output < outputs; ++output)
+		{
+			forwarded.push_back(message);
+		}
+
+		while (forwarded.size() > in_flight * outputs)
+		{
+			auto& sent = forwarded.front();
+			checksum += static_cast<uint64_t>(sent[header_size]) ^ static_cast<uint64_t>(sent[sent.size() - 1]);
+			forwarded.pop_front();
+		}
+	}
+	auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	return static_cast<double>(message_count * (header_size + payload_size)) / elapsed;
+}
+
+/// <summary>
+/// Measures the forwarded bytes per second of the messages copied out of the receive buffer
+/// </summary>
+static double forward_copies(BenchStream& stream, size_t message_count, size_t outputs, size_t in_flight, uint64_t& checksum)
+{
+	stream.rewind();
+	auto buffer = std::vector<std::byte>(4 * (header_size + payload_size));
+	auto received = size_t(0);
+	auto forwarded = std::deque<std::vector<std::byte>>();
+	auto start = std::chrono::steady_clock::now();
+	for (size_t i = 0; i < message_count;)
+	{
+		received += stream.receive(std::span<std::byte>(buffer.data() + received, buffer.size() - received));
+		while (received >= header_size && received >= header_size + read_length(buffer.data()) && i < message_count)
+		{
+			auto size = header_size + read_length(buffer.data());
+			for (size_t output = 0; output < outputs; ++output)
+			{
+				forwarded.emplace_back(buffer.begin(), buffer.begin() + size);
+			}
+			std::memmove(buffer.data(), buffer.data() + size, received - size);
+			received -= size;
+			++i;
+
+			while (forwarded.size() > in_flight * outputs)
+			{
+				auto& sent = forwarded.front();
+				checksum += static_cast<uint64_t>(sent[header_size]) ^ static_cast<uint64_t>(sent[sent.size() - 1]);
+				forwarded.pop_front();
+			}
+		}
+	}
+	auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	return static_cast<double>(message_count * (header_size + payload_size)) / elapsed;
+}
+
+int main()
+{
+	constexpr auto messages = size_t(20000);
+	constexpr auto in_flight = size_t(8);
+
+	auto stream = BenchStream(64);
+	auto checksum = uint64_t(0);
+	printf("Parse and forward of %zu messages of 64 KiB, received in chunks of 16 KiB, %zu messages in flight\n", messages, in_flight);
+	for (auto outputs : { size_t(1), size_t(4) })
+	{
+		printf("%zu outputs   byte_slice %7.2f GB/s   std::vector copies %7.2f GB/s\n", outputs,
+			forward_slices(stream, messages, outputs, in_flight, checksum) / 1e9,
+			forward_copies(stream, messages, outputs, in_flight, checksum) / 1e9);
+	}
+	if (checksum == 0)
+	{
+		printf("The checksum is unexpected\n");
+	}
+	return 0;
+}
@@ -0,0 +1,189 @@
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <chrono>
+#include <cstddef>
+#include <system_error>
+#include <thread>
+#include <vector>
+#if !defined(_WIN32)
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+#include "include/byte_chain.h"
+
+// A proxy forwarding a stream from one local channel to another, compared for socketpairs and pipes.
+// byte_chain receives by readv into the buffers of byte_buffer_pool and sends the same slices by writev,
+// the baselines receive into a std::vector and either write it directly or append it to an output
+// std::vector first, as the framing code does, that queues the bytes until the descriptor is writable.
+// A source thread writes into the first channel, and a sink thread reads from the second one.
+
+#if defined(_WIN32)
+
+int main()
+{
+	printf("The benchmark requires the POSIX socketpair and pipe\n");
+	return 0;
+}
+
+#else
+
+static constexpr size_t read_size = 256 * 1024;
+
+/// <summary>
+/// A pair of the connected descriptors: the bytes written into the second one are read from the first one
+/// </summary>
+struct BenchChannel
+{
+	explicit BenchChannel(bool socket)
+	{
+		int descriptors[2];
+		auto result = socket ? ::socketpair(AF_UNIX, SOCK_STREAM, 0, descriptors) : ::pipe(descriptors);
+		if (result != 0)
+		{
+			throw std::system_error(errno, std::system_category());
+		}
+		Read = descriptors[0];
+		Write = descriptors[1];
+	}
+
+	~BenchChannel()
+	{
+		::close(Read);
+		::close(Write);
+	}
+
+	int Read;
+	int Write;
+};
+
+static void write_all(int descriptor, const std::byte* data, size_t size)
+{
+	while (size != 0)
+	{
+		auto written = ::write(descriptor, data, size);
+		if (written < 0)
+		{
+			if (errno == EINTR)
+			{
+				continue;
+			}
+			throw std::system_error(errno, std::system_category());
+		}
+		data += written;
+		size -= static_cast<size_t>(written);
+	}
+}
+
+static size_t read_some(int descriptor, std::byte* data, size_t size)
+{
+	while (true)
+	{
+		auto received = ::read(descriptor, data, size);
+		if (received >= 0)
+		{
+			return static_cast<size_t>(received);
+		}
+		if (errno != EINTR)
+		{
+			throw std::system_error(errno, std::system_category());
+		}
+	}
+}
+
+/// <summary>
+/// Forwards the stream by byte_chain
+/// </summary>
+static void forward_chain(int from, int to, size_t total)
+{
+	auto pool = byte_buffer_pool(65536, 16);
+	auto chain = byte_chain();
+	for (size_t forwarded = 0; forwarded < total;)
+	{
+		chain.read_from(from, pool, read_size);
+		while (!chain.empty())
+		{
+			forwarded += *chain.write_to(to);
+		}
+	}
+}
+
+/// <summary>
+/// Forwards the stream by writing the receive buffer directly
+/// </summary>
+static void forward_direct(int from, int to, size_t total)
+{
+	auto buffer = std::vector<std::byte>(read_size);
+	for (size_t forwarded = 0; forwarded < total;)
+	{
+		auto received = read_some(from, buffer.data(), buffer.size());
+		write_all(to, buffer.data(), received);
+		forwarded += received;
+	}
+}
+
+/// <summary>
+/// Forwards the stream by copying the received bytes to an output buffer and writing it
+/// </summary>
+static void forward_copied(int from, int to, size_t total)
+{
+	auto buffer = std::vector<std::byte>(read_size);
+	auto output = std::vector<std::byte>();
+	for (size_t forwarded = 0; forwarded < total;)
+	{
+		auto received = read_some(from, buffer.data(), buffer.size());
+		output.insert(output.end(), buffer.begin(), buffer.begin() + static_cast<ptrdiff_t>(received));
+		write_all(to, output.data(), output.size());
+		forwarded += output.size();
+		output.clear();
+	}
+}
+
+/// <summary>
+/// Measures the forwarded bytes per second between two channels of the specified kind
+/// </summary>
+template<class Forward>
+static double forward(bool socket, size_t total, Forward&& proxy)
+{
+	auto input = BenchChannel(socket);
+	auto output = BenchChannel(socket);
+	auto start = std::chrono::steady_clock::now();
+	auto source = std::thread([&]()
+	{
+		auto block = std::vector<std::byte>(65536, std::byte { 0x5a });
+		for (size_t written = 0; written < total; written += block.size())
+		{
+			write_all(input.Write, block.data(), block.size());
+		}
+	});
+	auto sink = std::thread([&]()
+	{
+		auto block = std::vector<std::byte>(read_size);
+		for (size_t received = 0; received < total;)
+		{
+			received += read_some(output.Read, block.data(), block.size());
+		}
+	});
+	proxy(input.Read, output.Write, total);
+	source.join();
+	sink.join();
+	auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	return static_cast<double>(total) / elapsed;
+}
+
+int main()
+{
+	constexpr auto total = size_t(512) * 1024 * 1024;
+
+	printf("Proxy of %zu MiB between two local channels\n", total / (1024 * 1024));
+	for (auto socket : { true, false })
+	{
+		printf("%-10s   byte_chain %6.2f GB/s   read/write %6.2f GB/s   copy to output %6.2f GB/s\n", socket ? "socketpair" : "pipe",
+			forward(socket, total, forward_chain) / 1e9,
+			forward(socket, total, forward_direct) / 1e9,
+			forward(socket, total, forward_copied) / 1e9);
+	}
+	return 0;
+}
+
+#endif
@@ -0,0 +1,168 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "include/concurrent_hash_map.h"
+
+// The scaling of the readers of concurrent_hash_map from 1 to 64 threads with a single writer,
+// that keeps inserting and erasing keys, compared with std::unordered_map guarded by std::mutex.
+// The borrowed reads by visit() do no counter operations, the reads by find() take a reference.
+
+struct BenchItem : public RefCountObject<BenchItem>
+{
+	BenchItem(uint64_t value) : Value(value) { }
+
+	uint64_t Value;
+};
+
+/// <summary>
+/// The baseline: an unordered map guarded by a single mutex
+/// </summary>
+class locked_map final
+{
+public:
+	inline void insert(uint64_t key, intrusive_ptr<BenchItem> value)
+	{
+		auto lock = std::lock_guard(m_mutex);
+		m_entries.emplace(key, std::move(value));
+	}
+
+	inline intrusive_ptr<BenchItem> erase(uint64_t key)
+	{
+		auto lock = std::lock_guard(m_mutex);
+		auto found = m_entries.find(key);
+		if (found == m_entries.end())
+		{
+			return intrusive_ptr<BenchItem>();
+		}
+		auto value = std::move(found->second);
+		m_entries.erase(found);
+		return value;
+	}
+
+	inline uint64_t read(uint64_t key) const
+	{
+		auto lock = std::lock_guard(m_mutex);
+		auto found = m_entries.find(key);
+		return found != m_entries.end() ? found->second->Value : 0;
+	}
+
+private:
+	mutable std::mutex m_mutex;
+	std::unordered_map<uint64_t, intrusive_ptr<BenchItem>> m_entries;
+};
+
+/// <summary>
+/// Adapts concurrent_hash_map to the interface of the benchmark, the reads borrow the values
+/// </summary>
+class borrowing_map
+{
+public:
+	inline void insert(uint64_t key, intrusive_ptr<BenchItem> value)
+	{
+		m_entries.insert(key, std::move(value));
+	}
+
+	inline intrusive_ptr<BenchItem> erase(uint64_t key)
+	{
+		return m_entries.erase(key);
+	}
+
+	inline uint64_t read(uint64_t key) const
+	{
+		auto value = uint64_t(0);
+		m_entries.visit(key, [&](const BenchItem& item) { value = item.Value; });
+		return value;
+	}
+
+protected:
+	concurrent_hash_map<uint64_t, BenchItem> m_entries;
+};
+
+/// <summary>
+/// Reads the values of concurrent_hash_map by taking the references
+/// </summary>
+class referencing_map final : public borrowing_map
+{
+public:
+	inline uint64_t read(uint64_t key) const
+	{
+		auto value = m_entries.find(key);
+		return value ? value->Value : 0;
+	}
+};
+
+/// <summary>
+/// Measures the reads per second of all readers together, while the writer runs
+/// </summary>
+template<class Map>
+static double read_throughput(uint64_t key_count, unsigned reader_count, size_t reads)
+{
+	auto map = Map();
+	for (uint64_t key = 0; key < key_count; key += 2)
+	{
+		map.insert(key, make_intrusive<BenchItem>(key + 1));
+	}
+
+	auto stop = std::atomic<bool>(false);
+	auto writer = std::thread([&]()
+	{
+		auto random = std::mt19937_64(7);
+		while (!stop.load(std::memory_order_relaxed))
+		{
+			auto key = random() % key_count;
+			if (!map.erase(key))
+			{
+				map.insert(key, make_intrusive<BenchItem>(key + 1));
+			}
+		}
+	});
+
+	auto checksum = std::atomic<uint64_t>(0);
+	auto readers = std::vector<std::thread>();
+	auto slice = reads / reader_count;
+	auto start = std::chrono::steady_clock::now();
+	for (unsigned r = 0; r < reader_count; ++r)
+	{
+		readers.emplace_back([&, r]()
+		{
+			auto random = std::mt19937_64(r + 1);
+			auto sum = uint64_t(0);
+			for (size_t i = 0; i < slice; ++i)
+			{
+				sum += map.read(random() % key_count);
+			}
+			checksum += sum;
+		});
+	}
+	for (auto& reader : readers)
+	{
+		reader.join();
+	}
+	auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	stop = true;
+	writer.join();
+	return static_cast<double>(slice * reader_count) / elapsed;
+}
+
+int main()
+{
+	constexpr auto key_count = uint64_t(100000);
+	constexpr auto reads = size_t(4000000);
+
+	printf("Reads with one writer, %llu keys, %zu reads\n", static_cast<unsigned long long>(key_count), reads);
+	for (unsigned readers = 1; readers <= 64; readers *= 2)
+	{
+		printf("%2u readers   visit %7.2f Mops/s   find %7.2f Mops/s   mutex map %7.2f Mops/s\n", readers,
+			read_throughput<borrowing_map>(key_count, readers, reads) / 1e6,
+			read_throughput<referencing_map>(key_count, readers, reads) / 1e6,
+			read_throughput<locked_map>(key_count, readers, reads) / 1e6);
+	}
+	epoch_domain::instance().flush();
+	return 0;
+}
@@ -0,0 +1,168 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <random>
+#include <shared_mutex>
+#include <thread>
+#include <vector>
+#include "include/concurrent_skip_list.h"
+
+// The scaling of the readers of concurrent_skip_list with a single writer,
+// that keeps inserting and erasing keys, compared with std::map guarded by std::shared_mutex.
+// Each read is a lookup followed by a short range scan.
+
+struct BenchItem : public RefCountObject<BenchItem>
+{
+	BenchItem(uint64_t value) : Value(value) { }
+
+	uint64_t Value;
+};
+
+/// <summary>
+/// The baseline: an ordered map, whose readers share a reader-writer lock
+/// </summary>
+class locked_map final
+{
+public:
+	inline bool insert(uint64_t key, intrusive_ptr<BenchItem> value)
+	{
+		auto lock = std::unique_lock(m_mutex);
+		return m_entries.emplace(key, std::move(value)).second;
+	}
+
+	inline intrusive_ptr<BenchItem> erase(uint64_t key)
+	{
+		auto lock = std::unique_lock(m_mutex);
+		auto found = m_entries.find(key);
+		if (found == m_entries.end())
+		{
+			return intrusive_ptr<BenchItem>();
+		}
+		auto value = std::move(found->second);
+		m_entries.erase(found);
+		return value;
+	}
+
+	inline uint64_t read(uint64_t key, size_t scan_length) const
+	{
+		auto lock = std::shared_lock(m_mutex);
+		auto sum = uint64_t(0);
+		auto current = m_entries.lower_bound(key);
+		for (size_t i = 0; i < scan_length && current != m_entries.end(); ++i, ++current)
+		{
+			sum += current->second->Value;
+		}
+		return sum;
+	}
+
+private:
+	mutable std::shared_mutex m_mutex;
+	std::map<uint64_t, intrusive_ptr<BenchItem>> m_entries;
+};
+
+/// <summary>
+/// Adapts concurrent_skip_list to the interface of the benchmark
+/// </summary>
+class skip_list_map final
+{
+public:
+	inline bool insert(uint64_t key, intrusive_ptr<BenchItem> value)
+	{
+		return m_entries.insert(key, std::move(value));
+	}
+
+	inline intrusive_ptr<BenchItem> erase(uint64_t key)
+	{
+		return m_entries.erase(key);
+	}
+
+	inline uint64_t read(uint64_t key, size_t scan_length) const
+	{
+		auto sum = uint64_t(0);
+		auto current = m_entries.lower_bound(key);
+		for (size_t i = 0; i < scan_length && current != m_entries.end(); ++i, ++current)
+		{
+			sum += current.value()->Value;
+		}
+		return sum;
+	}
+
+private:
+	concurrent_skip_list<uint64_t, BenchItem> m_entries;
+};
+
+/// <summary>
+/// Measures the reads per second of all readers together, while the writer runs
+/// </summary>
+template<class Map>
+static double read_throughput(uint64_t key_count, size_t scan_length, unsigned reader_count, size_t reads_per_reader)
+{
+	auto map = Map();
+	for (uint64_t key = 0; key < key_count; key += 2)
+	{
+		map.insert(key, make_intrusive<BenchItem>(key));
+	}
+
+	auto stop = std::atomic<bool>(false);
+	auto writer = std::thread([&]()
+	{
+		auto random = std::mt19937_64(7);
+		while (!stop.load(std::memory_order_relaxed))
+		{
+			auto key = random() % key_count;
+			if (!map.erase(key))
+			{
+				map.insert(key, make_intrusive<BenchItem>(key));
+			}
+		}
+	});
+
+	auto checksum = std::atomic<uint64_t>(0);
+	auto readers = std::vector<std::thread>();
+	auto start = std::chrono::steady_clock::now();
+	for (unsigned r = 0; r < reader_count; ++r)
+	{
+		readers.emplace_back([&, r]()
+		{
+			auto random = std::mt19937_64(r + 1);
+			auto sum = uint64_t(0);
+			for (size_t i = 0; i < reads_per_reader; ++i)
+			{
+				sum += map.read(random() % key_count, scan_length);
+			}
+			checksum += sum;
+		});
+	}
+	for (auto& reader : readers)
+	{
+		reader.join();
+	}
+	auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	stop = true;
+	writer.join();
+	return static_cast<double>(reads_per_reader * reader_count) / elapsed;
+}
+
+int main()
+{
+	constexpr auto key_count = uint64_t(100000);
+	constexpr auto reads_per_reader = size_t(200000);
+
+	printf("Reads with one writer, %llu keys, %zu reads per reader\n",
+		static_cast<unsigned long long>(key_count), reads_per_reader);
+	auto hardware = std::max(std::thread::hardware_concurrency(), 1u);
+	for (auto scan_length : { size_t(1), size_t(16) })
+	{
+		for (unsigned readers = 1; readers <= hardware; readers *= 2)
+		{
+			printf("scan %2zu %2u readers   skip list %7.2f Mops/s   shared_mutex map %7.2f Mops/s\n", scan_length, readers,
+				read_throughput<skip_list_map>(key_count, scan_length, readers, reads_per_reader) / 1e6,
+				read_throughput<locked_map>(key_count, scan_length, readers, reads_per_reader) / 1e6);
+		}
+	}
+	epoch_domain::instance().flush();
+	return 0;
+}
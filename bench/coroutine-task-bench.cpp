@@ -0,0 +1,207 @@
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <atomic>
+#include <chrono>
+#include <coroutine>
+#include <cstdlib>
+#include <exception>
+#include <new>
+#include <thread>
+#include <utility>
+#include "include/coroutine_task.h"
+
+// The allocations per await and the cost of an await of task<T>, whose frames are recycled
+// by coroutine_frame_pool, compared with a minimal lazy task allocating its frames on the heap,
+// and the latency of resuming a suspended coroutine. The allocations are counted by replacing
+// the global operator new.
+
+static std::atomic<size_t> allocations { 0 };
+
+void* operator new(size_t size)
+{
+	allocations.fetch_add(1, std::memory_order_relaxed);
+	if (auto memory = std::malloc(size != 0 ? size : 1))
+	{
+		return memory;
+	}
+	throw std::bad_alloc();
+}
+
+void operator delete(void* memory) noexcept
+{
+	std::free(memory);
+}
+
+void operator delete(void* memory, size_t) noexcept
+{
+	std::free(memory);
+}
+
+/// <summary>
+/// The baseline: a lazy task with the symmetric transfer, whose frame is allocated by the global operator new
+/// </summary>
+template<class T>
+class plain_task final
+{
+public:
+	struct promise_type
+	{
+		struct final_awaiter
+		{
+			inline bool await_ready() const noexcept { return false; }
+
+			inline std::coroutine_handle<> await_suspend(std::coroutine_handle<promise_type> frame) const noexcept
+			{
+				return frame.promise().m_continuation;
+			}
+
+			inline void await_resume() const noexcept { }
+		};
+
+		inline plain_task get_return_object() noexcept
+		{
+			return plain_task(std::coroutine_handle<promise_type>::from_promise(*this));
+		}
+
+		inline std::suspend_always initial_suspend() const noexcept { return { }; }
+		inline final_awaiter final_suspend() const noexcept { return { }; }
+		inline void return_value(T value) noexcept { m_value = value; }
+		inline void unhandled_exception() const noexcept { std::terminate(); }
+
+		T m_value { };
+		std::coroutine_handle<> m_continuation { std::noop_coroutine() };
+	};
+
+	explicit plain_task(std::coroutine_handle<promise_type> frame) noexcept : m_frame(frame) { }
+	plain_task(plain_task&& other) noexcept : m_frame(std::exchange(other.m_frame, nullptr)) { }
+
+	~plain_task()
+	{
+		if (m_frame)
+		{
+			m_frame.destroy();
+		}
+	}
+
+	inline bool await_ready() const noexcept { return false; }
+
+	inline std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) const noexcept
+	{
+		m_frame.promise().m_continuation = awaiting;
+		return m_frame;
+	}
+
+	inline T await_resume() const noexcept { return m_frame.promise().m_value; }
+
+	inline T run()
+	{
+		m_frame.resume();
+		return m_frame.promise().m_value;
+	}
+
+private:
+	std::coroutine_handle<promise_type> m_frame;
+};
+
+static task<uint64_t> pooled_leaf(uint64_t value)
+{
+	co_return value * 3;
+}
+
+static task<uint64_t> pooled_sum(uint64_t count)
+{
+	auto sum = uint64_t(0);
+	for (uint64_t i = 0; i < count; ++i)
+	{
+		sum += co_await pooled_leaf(i);
+	}
+	co_return sum;
+}
+
+static plain_task<uint64_t> plain_leaf(uint64_t value)
+{
+	co_return value * 3;
+}
+
+static plain_task<uint64_t> plain_sum(uint64_t count)
+{
+	auto sum = uint64_t(0);
+	for (uint64_t i = 0; i < count; ++i)
+	{
+		sum += co_await plain_leaf(i);
+	}
+	co_return sum;
+}
+
+/// <summary>
+/// Prints the time and the allocations per await of the loop, that awaits a new leaf task each time
+/// </summary>
+template<class Run>
+static void report_awaits(const char* name, uint64_t count, Run&& run)
+{
+	auto before = allocations.load(std::memory_order_relaxed);
+	auto start = std::chrono::steady_clock::now();
+	auto sum = run(count);
+	auto elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+	auto allocated = allocations.load(std::memory_order_relaxed) - before;
+	printf("%-22s %7.2f ns per await   %.4f allocations per await%s\n", name,
+		elapsed / static_cast<double>(count), static_cast<double>(allocated) / static_cast<double>(count),
+		sum == count * (count - 1) / 2 * 3 ? "" : "   the sum is wrong");
+}
+
+/// <summary>
+/// Suspends the coroutine until the measuring thread resumes it
+/// </summary>
+struct manual_resume
+{
+	inline bool await_ready() const noexcept { return false; }
+
+	inline void await_suspend(std::coroutine_handle<> awaiting) const noexcept
+	{
+		suspended.store(awaiting.address(), std::memory_order_release);
+	}
+
+	inline void await_resume() const noexcept { }
+
+	static inline std::atomic<void*> suspended { nullptr };
+};
+
+static task<uint64_t> resumed_loop(uint64_t count)
+{
+	auto sum = uint64_t(0);
+	for (uint64_t i = 0; i < count; ++i)
+	{
+		co_await manual_resume { };
+		sum += co_await pooled_leaf(i);
+	}
+	co_return sum;
+}
+
+int main()
+{
+	constexpr auto awaits = uint64_t(10000000);
+
+	printf("Awaits of a new leaf task, %llu awaits\n", static_cast<unsigned long long>(awaits));
+	report_awaits("task (pooled frames)", awaits, [](uint64_t count) { return sync_wait(pooled_sum(count)); });
+	report_awaits("plain lazy task", awaits, [](uint64_t count) { return plain_sum(count).run(); });
+
+	constexpr auto resumes = uint64_t(2000000);
+	auto waiter = std::thread([&]() { sync_wait(resumed_loop(resumes)); });
+	auto start = std::chrono::steady_clock::now();
+	for (uint64_t i = 0; i < resumes; ++i)
+	{
+		auto address = manual_resume::suspended.exchange(nullptr, std::memory_order_acquire);
+		while (address == nullptr)
+		{
+			std::this_thread::yield();
+			address = manual_resume::suspended.exchange(nullptr, std::memory_order_acquire);
+		}
+		std::coroutine_handle<>::from_address(address).resume();
+	}
+	auto elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+	waiter.join();
+	printf("\nResume of a suspended task, that awaits one leaf task until the next suspension\n");
+	printf("%7.2f ns per resume\n", elapsed / static_cast<double>(resumes));
+	return 0;
+}
@@ -0,0 +1,145 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <random>
+#include <thread>
+#include <vector>
+#include "include/intrusive_cache.h"
+
+// The hit rate of the replacement policies and the throughput of sharded_cache
+// on synthetic traces. The traces are generated before the measurement,
+// so the timings do not include the random number generation.
+
+struct BenchItem : public RefCountObject<BenchItem>, public intrusive_cache_hook<>
+{
+	BenchItem(uint64_t key) : Key(key) { }
+
+	inline const uint64_t& key() const noexcept { return Key; }
+
+	uint64_t Key;
+};
+
+/// <summary>
+/// Generates the keys from 0 to key_count - 1 with the Zipf distribution
+/// </summary>
+static std::vector<uint64_t> zipf_trace(size_t key_count, double skew, size_t length, uint64_t seed)
+{
+	auto cdf = std::vector<double>(key_count);
+	auto sum = 0.0;
+	for (size_t i = 0; i < key_count; ++i)
+	{
+		sum += 1.0 / std::pow(static_cast<double>(i + 1), skew);
+		cdf[i] = sum;
+	}
+
+	auto random = std::mt19937_64(seed);
+	auto uniform = std::uniform_real_distribution<double>(0.0, sum);
+	auto trace = std::vector<uint64_t>(length);
+	for (auto& key : trace)
+	{
+		key = static_cast<uint64_t>(std::lower_bound(cdf.begin(), cdf.end(), uniform(random)) - cdf.begin());
+	}
+	return trace;
+}
+
+/// <summary>
+/// Replaces every period-th run of the trace by a sequential scan of the keys never used by the trace
+/// </summary>
+static void add_scans(std::vector<uint64_t>& trace, size_t period, size_t scan_length, uint64_t first_key)
+{
+	auto next_key = first_key;
+	for (size_t start = period; start + scan_length <= trace.size(); start += period)
+	{
+		for (size_t i = 0; i < scan_length; ++i)
+		{
+			trace[start + i] = next_key++;
+		}
+	}
+}
+
+template<class Policy>
+static double hit_rate(const std::vector<uint64_t>& trace, size_t capacity)
+{
+	auto cache = intrusive_cache<uint64_t, BenchItem, Policy>(capacity);
+	auto hits = size_t(0);
+	for (auto key : trace)
+	{
+		if (cache.find(key))
+		{
+			++hits;
+		}
+		else
+		{
+			cache.insert(make_intrusive<BenchItem>(key));
+		}
+	}
+	return static_cast<double>(hits) / static_cast<double>(trace.size());
+}
+
+static void report_hit_rates(const char* name, const std::vector<uint64_t>& trace)
+{
+	for (auto capacity : { size_t(1000), size_t(10000) })
+	{
+		printf("%-24s capacity %6zu   lru %6.2f%%   2q %6.2f%%\n", name, capacity,
+			100.0 * hit_rate<lru_policy>(trace, capacity),
+			100.0 * hit_rate<two_queue_policy>(trace, capacity));
+	}
+}
+
+/// <summary>
+/// Measures the find_or_insert operations per second of all threads together
+/// </summary>
+template<class Policy>
+static double throughput(const std::vector<uint64_t>& trace, size_t capacity, size_t shard_count, unsigned thread_count)
+{
+	auto cache = sharded_cache<uint64_t, BenchItem, Policy>(capacity, shard_count);
+	auto threads = std::vector<std::thread>();
+	auto slice = trace.size() / thread_count;
+
+	auto start = std::chrono::steady_clock::now();
+	for (unsigned t = 0; t < thread_count; ++t)
+	{
+		threads.emplace_back([&, t]()
+		{
+			auto end = trace.begin() + static_cast<ptrdiff_t>((t + 1) * slice);
+			for (auto current = trace.begin() + static_cast<ptrdiff_t>(t * slice); current != end; ++current)
+			{
+				auto key = *current;
+				cache.find_or_insert(key, [key]() { return make_intrusive<BenchItem>(key); });
+			}
+		});
+	}
+	for (auto& thread : threads)
+	{
+		thread.join();
+	}
+	auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	return static_cast<double>(slice * thread_count) / elapsed;
+}
+
+int main()
+{
+	constexpr auto key_count = size_t(100000);
+	constexpr auto length = size_t(2000000);
+
+	printf("Hit rate, %zu keys, %zu requests\n", key_count, length);
+	auto zipf = zipf_trace(key_count, 0.99, length, 1);
+	report_hit_rates("zipf 0.99", zipf);
+	auto scanned = zipf;
+	add_scans(scanned, 50000, 20000, key_count);
+	report_hit_rates("zipf 0.99 with scans", scanned);
+	report_hit_rates("zipf 0.7", zipf_trace(key_count, 0.7, length, 2));
+
+	printf("\nThroughput of find_or_insert, capacity 10000, zipf 0.99\n");
+	auto hardware = std::max(std::thread::hardware_concurrency(), 1u);
+	for (unsigned threads = 1; threads <= hardware; threads *= 2)
+	{
+		printf("%2u threads   1 shard %7.2f Mops/s   16 shards lru %7.2f Mops/s   16 shards 2q %7.2f Mops/s\n", threads,
+			throughput<lru_policy>(zipf, 10000, 1, threads) / 1e6,
+			throughput<lru_policy>(zipf, 10000, 16, threads) / 1e6,
+			throughput<two_queue_policy>(zipf, 10000, 16, threads) / 1e6);
+	}
+	return 0;
+}
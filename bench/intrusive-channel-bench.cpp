@@ -0,0 +1,274 @@
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <thread>
+#include <vector>
+#include "include/intrusive_channel.h"
+
+// The messages per second of intrusive_channel with single and batched sends compared with
+// a bounded std::deque guarded by std::mutex and condition variables, the latency of a paced
+// message stream and the delivery rate of broadcast_channel to several receivers.
+// The messages are allocated before the measurement.
+
+struct BenchMessage : public RefCountObject<BenchMessage>
+{
+	std::chrono::steady_clock::time_point Sent;
+	uint64_t Value { 0 };
+};
+
+static constexpr size_t capacity = 1024;
+static constexpr size_t batch_size = 32;
+
+/// <summary>
+/// The baseline: a bounded deque, whose blocked senders and receivers wait for condition variables
+/// </summary>
+class locked_channel final
+{
+public:
+	inline void send(std::span<intrusive_ptr<BenchMessage>> messages)
+	{
+		for (auto& message : messages)
+		{
+			auto lock = std::unique_lock(m_mutex);
+			m_not_full.wait(lock, [&]() { return m_items.size() < capacity; });
+			m_items.push_back(std::move(message));
+			lock.unlock();
+			m_not_empty.notify_one();
+		}
+	}
+
+	template<class Handler>
+	inline size_t consume(Handler&& handler, size_t max_count)
+	{
+		auto lock = std::unique_lock(m_mutex);
+		m_not_empty.wait(lock, [&]() { return !m_items.empty() || m_closed; });
+		auto count = std::min(max_count, m_items.size());
+		auto taken = std::vector<intrusive_ptr<BenchMessage>>();
+		for (size_t i = 0; i < count; ++i)
+		{
+			taken.push_back(std::move(m_items.front()));
+			m_items.pop_front();
+		}
+		lock.unlock();
+		m_not_full.notify_all();
+		for (auto& message : taken)
+		{
+			handler(std::move(message));
+		}
+		return count;
+	}
+
+	inline void close()
+	{
+		auto lock = std::lock_guard(m_mutex);
+		m_closed = true;
+		m_not_empty.notify_all();
+	}
+
+private:
+	std::mutex m_mutex;
+	std::condition_variable m_not_full;
+	std::condition_variable m_not_empty;
+	std::deque<intrusive_ptr<BenchMessage>> m_items;
+	bool m_closed { false };
+};
+
+/// <summary>
+/// Adapts intrusive_channel to the interface of the benchmark
+/// </summary>
+class lock_free_channel final
+{
+public:
+	inline void send(std::span<intrusive_ptr<BenchMessage>> messages)
+	{
+		m_channel.send(messages);
+	}
+
+	template<class Handler>
+	inline size_t consume(Handler&& handler, size_t max_count)
+	{
+		return m_channel.consume(handler, max_count);
+	}
+
+	inline void close()
+	{
+		m_channel.close();
+	}
+
+private:
+	intrusive_channel<BenchMessage> m_channel { capacity };
+};
+
+static std::vector<intrusive_ptr<BenchMessage>> make_messages(size_t count)
+{
+	auto messages = std::vector<intrusive_ptr<BenchMessage>>();
+	messages.reserve(count);
+	for (size_t i = 0; i < count; ++i)
+	{
+		messages.push_back(make_intrusive<BenchMessage>());
+	}
+	return messages;
+}
+
+/// <summary>
+/// Measures the messages per second passed from the producers to the consumers.
+/// The producers send the batches of the specified size, the consumers always receive in batches.
+/// </summary>
+template<class Channel>
+static double throughput(size_t message_count, unsigned pair_count, size_t batch)
+{
+	auto slice = message_count / pair_count;
+	auto messages = std::vector<std::vector<intrusive_ptr<BenchMessage>>>();
+	for (unsigned p = 0; p < pair_count; ++p)
+	{
+		messages.push_back(make_messages(slice));
+	}
+
+	auto channel = Channel();
+	auto threads = std::vector<std::thread>();
+	auto start = std::chrono::steady_clock::now();
+	for (unsigned p = 0; p < pair_count; ++p)
+	{
+		threads.emplace_back([&, p]()
+		{
+			auto own = std::span<intrusive_ptr<BenchMessage>>(messages[p]);
+			for (size_t sent = 0; sent < own.size(); sent += batch)
+			{
+				channel.send(own.subspan(sent, std::min(batch, own.size() - sent)));
+			}
+		});
+	}
+	auto consumers = std::vector<std::thread>();
+	for (unsigned c = 0; c < pair_count; ++c)
+	{
+		consumers.emplace_back([&]()
+		{
+			auto handler = [](intrusive_ptr<BenchMessage> message) { ++message->Value; };
+			while (channel.consume(handler, batch_size) != 0)
+			{
+			}
+		});
+	}
+	for (auto& producer : threads)
+	{
+		producer.join();
+	}
+	channel.close();
+	for (auto& consumer : consumers)
+	{
+		consumer.join();
+	}
+	auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	return static_cast<double>(slice * pair_count) / elapsed;
+}
+
+/// <summary>
+/// Sends the stamped messages at the fixed interval and reports the percentiles of the latency in microseconds
+/// </summary>
+template<class Channel>
+static void latency(const char* name, size_t message_count, std::chrono::nanoseconds interval)
+{
+	auto messages = make_messages(message_count);
+	auto latencies = std::vector<double>();
+	latencies.reserve(message_count);
+	auto channel = Channel();
+	auto consumer = std::thread([&]()
+	{
+		auto handler = [&](intrusive_ptr<BenchMessage> message)
+		{
+			latencies.push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - message->Sent).count());
+		};
+		while (channel.consume(handler, batch_size) != 0)
+		{
+		}
+	});
+
+	auto next = std::chrono::steady_clock::now();
+	for (auto& message : messages)
+	{
+		while (std::chrono::steady_clock::now() < next)
+		{
+			std::this_thread::yield();
+		}
+		next += interval;
+		message->Sent = std::chrono::steady_clock::now();
+		channel.send(std::span<intrusive_ptr<BenchMessage>>(&message, 1));
+	}
+	channel.close();
+	consumer.join();
+
+	std::sort(latencies.begin(), latencies.end());
+	printf("%-22s p50 %8.2f us   p99 %8.2f us   p99.9 %8.2f us\n", name,
+		latencies[latencies.size() / 2], latencies[latencies.size() * 99 / 100], latencies[latencies.size() * 999 / 1000]);
+}
+
+/// <summary>
+/// Measures the deliveries per second from one sender to all receivers of the broadcast channel
+/// </summary>
+static double broadcast(size_t message_count, unsigned receiver_count)
+{
+	auto messages = make_messages(message_count);
+	auto channel = broadcast_channel<BenchMessage>(capacity);
+	auto receivers = std::vector<std::unique_ptr<broadcast_channel<BenchMessage>::receiver>>();
+	for (unsigned r = 0; r < receiver_count; ++r)
+	{
+		receivers.push_back(std::make_unique<broadcast_channel<BenchMessage>::receiver>(channel));
+	}
+
+	auto start = std::chrono::steady_clock::now();
+	auto threads = std::vector<std::thread>();
+	for (auto& current : receivers)
+	{
+		threads.emplace_back([&current]()
+		{
+			auto sum = uint64_t(0);
+			while (current->visit([&](const BenchMessage& message) { sum += message.Value; }, batch_size) != 0)
+			{
+			}
+		});
+	}
+	for (auto& message : messages)
+	{
+		channel.send(std::move(message));
+	}
+	channel.close();
+	for (auto& thread : threads)
+	{
+		thread.join();
+	}
+	auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	return static_cast<double>(message_count * receiver_count) / elapsed;
+}
+
+int main()
+{
+	constexpr auto message_count = size_t(2000000);
+
+	printf("Producer and consumer pairs, %zu messages, capacity %zu\n", message_count, capacity);
+	auto hardware = std::max(std::thread::hardware_concurrency() / 2, 1u);
+	for (unsigned pairs = 1; pairs <= hardware; pairs *= 2)
+	{
+		printf("%2u pairs   channel %7.2f Mmsg/s   batch of %zu %7.2f Mmsg/s   mutex deque %7.2f Mmsg/s\n", pairs,
+			throughput<lock_free_channel>(message_count, pairs, 1) / 1e6,
+			batch_size, throughput<lock_free_channel>(message_count, pairs, batch_size) / 1e6,
+			throughput<locked_channel>(message_count, pairs, 1) / 1e6);
+	}
+
+	printf("\nLatency of a message every 5 us\n");
+	latency<lock_free_channel>("intrusive_channel", 100000, std::chrono::microseconds(5));
+	latency<locked_channel>("mutex deque", 100000, std::chrono::microseconds(5));
+
+	printf("\nBroadcast, %zu messages\n", message_count / 4);
+	for (unsigned receivers = 1; receivers <= 8; receivers *= 2)
+	{
+		printf("%2u receivers   %7.2f Mdeliveries/s\n", receivers, broadcast(message_count / 4, receivers) / 1e6);
+	}
+	return 0;
+}
@@ -0,0 +1,149 @@
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <future>
+#include <new>
+#include <thread>
+#include <vector>
+#include "include/intrusive_future.h"
+
+// intrusive_promise and intrusive_future compared with std::promise and std::future:
+// the cost and the allocations of a promise satisfied and read on one thread,
+// of a chain of then() continuations in the style of folly::Future, and the round trip
+// of two threads waiting for each other's futures. The allocations are counted
+// by replacing the global operator new.
+
+static std::atomic<size_t> allocations { 0 };
+
+void* operator new(size_t size)
+{
+	allocations.fetch_add(1, std::memory_order_relaxed);
+	if (auto memory = std::malloc(size != 0 ? size : 1))
+	{
+		return memory;
+	}
+	throw std::bad_alloc();
+}
+
+void operator delete(void* memory) noexcept
+{
+	std::free(memory);
+}
+
+void operator delete(void* memory, size_t) noexcept
+{
+	std::free(memory);
+}
+
+/// <summary>
+/// Prints the time and the allocations per operation
+/// </summary>
+template<class Operation>
+static void report(const char* name, size_t count, Operation&& operation)
+{
+	auto before = allocations.load(std::memory_order_relaxed);
+	auto sum = uint64_t(0);
+	auto start = std::chrono::steady_clock::now();
+	for (size_t i = 0; i < count; ++i)
+	{
+		sum += operation(static_cast<int>(i & 0xffff));
+	}
+	auto elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+	auto allocated = allocations.load(std::memory_order_relaxed) - before;
+	printf("%-30s %8.2f ns   %.2f allocations%s\n", name, elapsed / static_cast<double>(count),
+		static_cast<double>(allocated) / static_cast<double>(count), sum == 0 ? "   the sum is unexpected" : "");
+}
+
+/// <summary>
+/// Measures the round trips per second: the first thread satisfies a promise, the second one waits
+/// for its future and satisfies the reply, which the first thread waits for
+/// </summary>
+template<template<class> class Promise>
+static double round_trips(size_t count)
+{
+	auto requests = std::vector<Promise<int>>(count);
+	auto replies = std::vector<Promise<int>>(count);
+	auto request_futures = std::vector<decltype(requests.front().get_future())>();
+	auto reply_futures = std::vector<decltype(replies.front().get_future())>();
+	for (size_t i = 0; i < count; ++i)
+	{
+		request_futures.push_back(requests[i].get_future());
+		reply_futures.push_back(replies[i].get_future());
+	}
+
+	auto start = std::chrono::steady_clock::now();
+	auto responder = std::thread([&]()
+	{
+		for (size_t i = 0; i < count; ++i)
+		{
+			replies[i].set_value(request_futures[i].get() + 1);
+		}
+	});
+	auto sum = uint64_t(0);
+	for (size_t i = 0; i < count; ++i)
+	{
+		requests[i].set_value(static_cast<int>(i));
+		sum += static_cast<uint64_t>(reply_futures[i].get());
+	}
+	auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	responder.join();
+	if (sum == 0)
+	{
+		printf("The sum is unexpected\n");
+	}
+	return static_cast<double>(count) / elapsed;
+}
+
+int main()
+{
+	constexpr auto count = size_t(1000000);
+
+	printf("Operations on one thread, the time and the allocations per operation\n");
+	report("intrusive set and get", count, [](int value)
+	{
+		auto promise = intrusive_promise<int>();
+		auto future = promise.get_future();
+		promise.set_value(value);
+		return static_cast<uint64_t>(future.get()) + 1;
+	});
+	report("std set and get", count, [](int value)
+	{
+		auto promise = std::promise<int>();
+		auto future = promise.get_future();
+		promise.set_value(value);
+		return static_cast<uint64_t>(future.get()) + 1;
+	});
+	report("intrusive chain of 4 then()", count, [](int value)
+	{
+		auto promise = intrusive_promise<int>();
+		auto future = promise.get_future()
+			.then([](int current) { return current + 1; })
+			.then([](int current) { return current * 2; })
+			.then([](int current) { return current - 1; })
+			.then([](int current) { return static_cast<uint64_t>(current) + 1; });
+		promise.set_value(value);
+		return future.get();
+	});
+	report("std chain of 4 promises", count, [](int value)
+	{
+		// Without then(), each stage is a promise satisfied by the reader of the previous future
+		auto first = std::promise<int>();
+		auto second = std::promise<int>();
+		auto third = std::promise<int>();
+		auto fourth = std::promise<uint64_t>();
+		first.set_value(value);
+		second.set_value(first.get_future().get() + 1);
+		third.set_value(second.get_future().get() * 2);
+		fourth.set_value(static_cast<uint64_t>(third.get_future().get() - 1) + 1);
+		return fourth.get_future().get();
+	});
+
+	constexpr auto trips = size_t(200000);
+	printf("\nRound trips between two threads, %zu trips\n", trips);
+	printf("intrusive_future %8.0f trips/s   std::future %8.0f trips/s\n",
+		round_trips<intrusive_promise>(trips), round_trips<std::promise>(trips));
+	return 0;
+}
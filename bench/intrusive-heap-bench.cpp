@@ -0,0 +1,142 @@
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <chrono>
+#include <random>
+#include <set>
+#include <utility>
+#include <vector>
+#include "include/intrusive_heap.h"
+
+// A scheduler loop on intrusive_heap compared with the one on std::set.
+// Each step runs the most urgent job and reschedules it later, then moves a random waiting job
+// earlier by the decrease-key. The set erases and inserts the job again to change its key.
+
+struct BenchJob : public RefCountObject<BenchJob>, public intrusive_heap_hook<>
+{
+	BenchJob(uint64_t deadline) : Deadline(deadline) { }
+
+	bool operator<(const BenchJob& other) const noexcept
+	{
+		return Deadline < other.Deadline;
+	}
+
+	uint64_t Deadline;
+	uint64_t Runs { 0 };
+};
+
+/// <summary>
+/// The baseline: the jobs ordered by the deadline and the address in a set
+/// </summary>
+class set_scheduler final
+{
+	using entry = std::pair<uint64_t, BenchJob*>;
+
+public:
+	~set_scheduler()
+	{
+		for (auto& current : m_jobs)
+		{
+			intrusive_ptr_release(current.second);
+		}
+	}
+
+	inline void push(intrusive_ptr<BenchJob> job)
+	{
+		m_jobs.emplace(job->Deadline, job.get());
+		job.detach();
+	}
+
+	inline intrusive_ptr<BenchJob> pop()
+	{
+		auto first = m_jobs.begin();
+		auto job = intrusive_ptr<BenchJob>(first->second, false);
+		m_jobs.erase(first);
+		return job;
+	}
+
+	inline void decrease(BenchJob& job, uint64_t deadline)
+	{
+		m_jobs.erase(entry(job.Deadline, &job));
+		job.Deadline = deadline;
+		m_jobs.emplace(deadline, &job);
+	}
+
+private:
+	std::set<entry> m_jobs;
+};
+
+/// <summary>
+/// Adapts intrusive_heap to the interface of the benchmark
+/// </summary>
+class heap_scheduler final
+{
+public:
+	inline void push(intrusive_ptr<BenchJob> job)
+	{
+		m_jobs.push(std::move(job));
+	}
+
+	inline intrusive_ptr<BenchJob> pop()
+	{
+		return m_jobs.pop();
+	}
+
+	inline void decrease(BenchJob& job, uint64_t deadline)
+	{
+		job.Deadline = deadline;
+		m_jobs.decrease(job);
+	}
+
+private:
+	intrusive_heap<BenchJob> m_jobs;
+};
+
+/// <summary>
+/// Measures the scheduler steps per second
+/// </summary>
+template<class Scheduler>
+static double schedule(size_t job_count, size_t steps)
+{
+	auto random = std::mt19937_64(1);
+	auto jobs = std::vector<BenchJob*>();
+	auto scheduler = Scheduler();
+	for (size_t i = 0; i < job_count; ++i)
+	{
+		auto job = make_intrusive<BenchJob>(random() % (job_count * 16));
+		jobs.push_back(job.get());
+		scheduler.push(std::move(job));
+	}
+
+	auto start = std::chrono::steady_clock::now();
+	for (size_t i = 0; i < steps; ++i)
+	{
+		auto job = scheduler.pop();
+		++job->Runs;
+		job->Deadline += 1 + random() % (job_count * 16);
+		auto now = job->Deadline;
+		scheduler.push(std::move(job));
+
+		auto& waiting = *jobs[random() % job_count];
+		if (waiting.Deadline > now / 2 + 1)
+		{
+			scheduler.decrease(waiting, waiting.Deadline - 1 - random() % (now / 2));
+		}
+	}
+	auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	return static_cast<double>(steps) / elapsed;
+}
+
+int main()
+{
+	constexpr auto steps = size_t(2000000);
+
+	printf("Scheduler steps, each is a pop, a push and a decrease-key\n");
+	for (auto job_count : { size_t(100), size_t(10000), size_t(1000000) })
+	{
+		printf("%7zu jobs   intrusive_heap %7.2f Msteps/s   std::set %7.2f Msteps/s\n", job_count,
+			schedule<heap_scheduler>(job_count, steps) / 1e6,
+			schedule<set_scheduler>(job_count, steps) / 1e6);
+	}
+	return 0;
+}
@@ -0,0 +1,127 @@
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <chrono>
+#include <list>
+#include <random>
+#include <vector>
+#include "include/intrusive_list.h"
+
+// The queue churn of intrusive_list compared with std::list<intrusive_ptr<T>>.
+// The rotation pops the front and pushes it back, the removal erases a random member
+// by reference and appends it again. std::list keeps an iterator of each member aside,
+// so both lists erase in O(1) and the difference is the node allocation and the counter traffic.
+
+struct BenchItem : public RefCountObject<BenchItem>, public intrusive_list_hook<>
+{
+	BenchItem(size_t id) : Id(id) { }
+
+	size_t Id;
+	uint64_t Visits { 0 };
+};
+
+/// <summary>
+/// The baseline: a list of the pointers with the iterators of the members kept by their identifiers
+/// </summary>
+class std_queue final
+{
+public:
+	explicit std_queue(size_t count) : m_positions(count) { }
+
+	inline void push_back(intrusive_ptr<BenchItem> ptr)
+	{
+		auto id = ptr->Id;
+		m_items.push_back(std::move(ptr));
+		m_positions[id] = std::prev(m_items.end());
+	}
+
+	inline intrusive_ptr<BenchItem> pop_front()
+	{
+		auto ptr = std::move(m_items.front());
+		m_items.pop_front();
+		return ptr;
+	}
+
+	inline intrusive_ptr<BenchItem> erase(BenchItem& object)
+	{
+		auto position = m_positions[object.Id];
+		auto ptr = std::move(*position);
+		m_items.erase(position);
+		return ptr;
+	}
+
+private:
+	std::list<intrusive_ptr<BenchItem>> m_items;
+	std::vector<std::list<intrusive_ptr<BenchItem>>::iterator> m_positions;
+};
+
+/// <summary>
+/// Adapts intrusive_list to the interface of the benchmark
+/// </summary>
+class intrusive_queue final
+{
+public:
+	explicit intrusive_queue(size_t) { }
+
+	inline void push_back(intrusive_ptr<BenchItem> ptr)
+	{
+		m_items.push_back(std::move(ptr));
+	}
+
+	inline intrusive_ptr<BenchItem> pop_front()
+	{
+		return m_items.pop_front();
+	}
+
+	inline intrusive_ptr<BenchItem> erase(BenchItem& object)
+	{
+		return m_items.erase(object);
+	}
+
+private:
+	intrusive_list<BenchItem> m_items;
+};
+
+/// <summary>
+/// Measures the operations per second, each of them takes a member out of the queue and puts it back
+/// </summary>
+template<class Queue>
+static double churn(size_t count, size_t operations, bool random_removal)
+{
+	auto objects = std::vector<BenchItem*>();
+	auto queue = Queue(count);
+	for (size_t i = 0; i < count; ++i)
+	{
+		auto object = make_intrusive<BenchItem>(i);
+		objects.push_back(object.get());
+		queue.push_back(std::move(object));
+	}
+
+	auto random = std::mt19937_64(1);
+	auto start = std::chrono::steady_clock::now();
+	for (size_t i = 0; i < operations; ++i)
+	{
+		auto object = random_removal ? queue.erase(*objects[random() % count]) : queue.pop_front();
+		++object->Visits;
+		queue.push_back(std::move(object));
+	}
+	auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	return static_cast<double>(operations) / elapsed;
+}
+
+int main()
+{
+	constexpr auto operations = size_t(10000000);
+
+	printf("Queue churn, %zu operations\n", operations);
+	for (auto count : { size_t(16), size_t(1024), size_t(1000000) })
+	{
+		printf("%7zu members   rotation   intrusive_list %7.2f Mops/s   std::list %7.2f Mops/s\n", count,
+			churn<intrusive_queue>(count, operations, false) / 1e6,
+			churn<std_queue>(count, operations, false) / 1e6);
+		printf("%7zu members   removal    intrusive_list %7.2f Mops/s   std::list %7.2f Mops/s\n", count,
+			churn<intrusive_queue>(count, operations, true) / 1e6,
+			churn<std_queue>(count, operations, true) / 1e6);
+	}
+	return 0;
+}
@@ -0,0 +1,139 @@
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <chrono>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "include/intrusive_mpsc_queue.h"
+
+// The scaling of the producers of intrusive_mpsc_queue compared with std::deque guarded by std::mutex.
+// The messages are allocated before the measurement and the consumer keeps them until it ends,
+// so the timings include only the queue: the push, the batch pop and the hand-over of the references.
+
+struct BenchItem : public RefCountObject<BenchItem>, public intrusive_mpsc_hook<>
+{
+	uint64_t Value { 0 };
+};
+
+/// <summary>
+/// The baseline: a deque guarded by a single mutex, that the consumer swaps out in batches
+/// </summary>
+class locked_queue final
+{
+public:
+	inline void push(intrusive_ptr<BenchItem> ptr)
+	{
+		auto lock = std::lock_guard(m_mutex);
+		m_items.push_back(std::move(ptr));
+	}
+
+	template<class Handler>
+	inline size_t consume(Handler&& handler)
+	{
+		{
+			auto lock = std::lock_guard(m_mutex);
+			m_batch.swap(m_items);
+		}
+		auto count = m_batch.size();
+		for (auto& item : m_batch)
+		{
+			handler(std::move(item));
+		}
+		m_batch.clear();
+		return count;
+	}
+
+private:
+	std::mutex m_mutex;
+	std::deque<intrusive_ptr<BenchItem>> m_items;
+	std::deque<intrusive_ptr<BenchItem>> m_batch;
+};
+
+/// <summary>
+/// Adapts intrusive_mpsc_queue to the interface of the benchmark
+/// </summary>
+class lock_free_queue final
+{
+public:
+	inline void push(intrusive_ptr<BenchItem> ptr)
+	{
+		m_items.push(std::move(ptr));
+	}
+
+	template<class Handler>
+	inline size_t consume(Handler&& handler)
+	{
+		return m_items.consume(handler, 256);
+	}
+
+private:
+	intrusive_mpsc_queue<BenchItem> m_items;
+};
+
+/// <summary>
+/// Measures the messages per second passed from all producers to the single consumer
+/// </summary>
+template<class Queue>
+static double transfer(size_t message_count, unsigned producer_count)
+{
+	auto slice = message_count / producer_count;
+	auto messages = std::vector<std::vector<intrusive_ptr<BenchItem>>>(producer_count);
+	for (auto& own : messages)
+	{
+		own.reserve(slice);
+		for (size_t i = 0; i < slice; ++i)
+		{
+			own.push_back(make_intrusive<BenchItem>());
+		}
+	}
+
+	auto queue = Queue();
+	auto received = std::vector<intrusive_ptr<BenchItem>>();
+	received.reserve(slice * producer_count);
+	auto start = std::chrono::steady_clock::now();
+	auto producers = std::vector<std::thread>();
+	for (unsigned p = 0; p < producer_count; ++p)
+	{
+		producers.emplace_back([&, p]()
+		{
+			for (auto& message : messages[p])
+			{
+				queue.push(std::move(message));
+			}
+		});
+	}
+	while (received.size() != slice * producer_count)
+	{
+		auto handler = [&](intrusive_ptr<BenchItem> message)
+		{
+			++message->Value;
+			received.push_back(std::move(message));
+		};
+		if (queue.consume(handler) == 0)
+		{
+			std::this_thread::yield();
+		}
+	}
+	auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	for (auto& producer : producers)
+	{
+		producer.join();
+	}
+	return static_cast<double>(received.size()) / elapsed;
+}
+
+int main()
+{
+	constexpr auto message_count = size_t(2000000);
+
+	printf("Producers to one consumer, %zu messages\n", message_count);
+	for (unsigned producers = 1; producers <= 64; producers *= 2)
+	{
+		printf("%2u producers   intrusive_mpsc_queue %7.2f Mmsg/s   mutex deque %7.2f Mmsg/s\n", producers,
+			transfer<lock_free_queue>(message_count, producers) / 1e6,
+			transfer<locked_queue>(message_count, producers) / 1e6);
+	}
+	return 0;
+}
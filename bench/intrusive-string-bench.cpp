@@ -0,0 +1,144 @@
+#if defined(__GNUC__) && !defined(__clang__)
+// GCC reports the replaced operator new and operator delete below as mismatched, when it inlines them into the containers
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <map>
+#include <new>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "include/intrusive_string.h"
+
+// intrusive_string compared with std::string as the keys of a map-heavy workload: every key is stored
+// in a hash index, in an ordered index and in a log, the indexes are looked up by std::string_view
+// and copied as a snapshot. Half of the keys fit inside the object, the rest are 24 to 87 characters long.
+// The memory in use is tracked by replacing the global operator new and the sized operator delete,
+// that the containers use to free their nodes and arrays while the indexes are built.
+
+static std::atomic<size_t> allocated_bytes { 0 };
+
+void* operator new(size_t size)
+{
+	allocated_bytes.fetch_add(size, std::memory_order_relaxed);
+	if (auto memory = std::malloc(size != 0 ? size : 1))
+	{
+		return memory;
+	}
+	throw std::bad_alloc();
+}
+
+void operator delete(void* memory) noexcept
+{
+	std::free(memory);
+}
+
+void operator delete(void* memory, size_t size) noexcept
+{
+	allocated_bytes.fetch_sub(size, std::memory_order_relaxed);
+	std::free(memory);
+}
+
+/// <summary>
+/// A transparent hash of std::string, so both key types are looked up by std::string_view without a copy
+/// </summary>
+struct string_hash
+{
+	using is_transparent = void;
+
+	inline size_t operator()(std::string_view value) const noexcept
+	{
+		return std::hash<std::string_view>()(value);
+	}
+};
+
+/// <summary>
+/// The indexes of the records, whose keys are stored three times
+/// </summary>
+template<class Key, class Hash>
+struct BenchIndexes
+{
+	std::unordered_map<Key, uint32_t, Hash, std::equal_to<>> ById;
+	std::map<Key, uint32_t, std::less<>> Ordered;
+	std::vector<Key> Log;
+};
+
+static std::vector<std::string> make_keys(size_t count)
+{
+	auto keys = std::vector<std::string>();
+	auto seed = uint64_t(1);
+	for (size_t i = 0; i < count; ++i)
+	{
+		seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+		auto key = (i % 2 == 0 ? std::string("k") : std::string("/service/region-") + std::to_string(seed >> 56) + "/tenant/")
+			+ std::to_string(i);
+		key.append(i % 2 == 0 ? 0 : (seed >> 33) % 48, 'x');
+		keys.push_back(std::move(key));
+	}
+	return keys;
+}
+
+/// <summary>
+/// Runs the workload and prints the time of each stage and the memory of the indexes
+/// </summary>
+template<class Key, class Hash>
+static void run(const char* name, const std::vector<std::string>& keys)
+{
+	auto before = allocated_bytes.load(std::memory_order_relaxed);
+	auto start = std::chrono::steady_clock::now();
+	auto indexes = BenchIndexes<Key, Hash>();
+	for (size_t i = 0; i < keys.size(); ++i)
+	{
+		auto key = Key(keys[i]);
+		indexes.ById.emplace(key, static_cast<uint32_t>(i));
+		indexes.Ordered.emplace(key, static_cast<uint32_t>(i));
+		indexes.Log.push_back(std::move(key));
+	}
+	auto built = std::chrono::steady_clock::now();
+	auto memory = allocated_bytes.load(std::memory_order_relaxed) - before;
+
+	auto sum = uint64_t(0);
+	for (auto pass = 0; pass < 4; ++pass)
+	{
+		for (auto& key : keys)
+		{
+			sum += indexes.ById.find(std::string_view(key))->second;
+		}
+	}
+	auto hashed = std::chrono::steady_clock::now();
+	for (auto& key : keys)
+	{
+		sum += indexes.Ordered.find(std::string_view(key))->second;
+	}
+	auto ordered = std::chrono::steady_clock::now();
+	auto snapshot = indexes;
+	auto copied = std::chrono::steady_clock::now();
+
+	auto count = static_cast<double>(keys.size());
+	printf("%-16s build %6.1f ns   hash find %6.1f ns   ordered find %6.1f ns   snapshot %7.1f ms   %7.1f MB%s\n", name,
+		std::chrono::duration<double, std::nano>(built - start).count() / count,
+		std::chrono::duration<double, std::nano>(hashed - built).count() / count / 4,
+		std::chrono::duration<double, std::nano>(ordered - hashed).count() / count,
+		std::chrono::duration<double, std::milli>(copied - ordered).count(),
+		static_cast<double>(memory) / 1e6,
+		sum != (count - 1) * count / 2 * 5 || snapshot.Log.size() != keys.size() ? "   the sum is wrong" : "");
+}
+
+int main()
+{
+	constexpr auto count = size_t(1000000);
+
+	auto keys = make_keys(count);
+	printf("%zu keys, each stored in a hash index, an ordered index and a log\n", count);
+	run<intrusive_string, intrusive_string_hash>("intrusive_string", keys);
+	run<std::string, string_hash>("std::string", keys);
+	return 0;
+}
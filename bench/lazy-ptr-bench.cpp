@@ -0,0 +1,156 @@
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+#include "include/lazy_ptr.h"
+
+// lazy_ptr compared with a value computed under std::call_once and shared by std::shared_ptr:
+// the first access of many values raced by all threads at once, and the steady-state read
+// of a value, that is computed already. The derived values read one dependency each.
+
+/// <summary>
+/// The computation of a value, that the compiler cannot remove
+/// </summary>
+static uint64_t compute(uint64_t seed) noexcept
+{
+	for (auto i = 0; i < 100; ++i)
+	{
+		seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+	}
+	return seed | 1;
+}
+
+/// <summary>
+/// The baseline: a memoized value guarded by std::once_flag
+/// </summary>
+class once_value final
+{
+public:
+	once_value(uint64_t seed, std::shared_ptr<once_value> dependency) : m_seed(seed), m_dependency(std::move(dependency)) { }
+
+	inline uint64_t get()
+	{
+		std::call_once(m_once, [this]() { m_value = compute(m_seed + (m_dependency ? m_dependency->get() : 0)); });
+		return *m_value;
+	}
+
+private:
+	uint64_t m_seed;
+	std::shared_ptr<once_value> m_dependency;
+	std::once_flag m_once;
+	std::optional<uint64_t> m_value;
+};
+
+static std::vector<lazy_ptr<uint64_t>> make_lazy_values(size_t count)
+{
+	auto values = std::vector<lazy_ptr<uint64_t>>();
+	for (size_t i = 0; i < count; ++i)
+	{
+		auto base = make_lazy([i]() { return compute(i); });
+		values.push_back(make_lazy([i](uint64_t dependency) { return compute(i + dependency); }, base));
+	}
+	return values;
+}
+
+static std::vector<std::shared_ptr<once_value>> make_once_values(size_t count)
+{
+	auto values = std::vector<std::shared_ptr<once_value>>();
+	for (size_t i = 0; i < count; ++i)
+	{
+		values.push_back(std::make_shared<once_value>(i, std::make_shared<once_value>(i, nullptr)));
+	}
+	return values;
+}
+
+static uint64_t read(const lazy_ptr<uint64_t>& value)
+{
+	return value.get();
+}
+
+static uint64_t read(const std::shared_ptr<once_value>& value)
+{
+	return value->get();
+}
+
+/// <summary>
+/// Measures the values per second, that all threads access for the first time together
+/// </summary>
+template<class Values>
+static double first_access(Values& values, unsigned thread_count)
+{
+	auto checksum = std::atomic<uint64_t>(0);
+	auto threads = std::vector<std::thread>();
+	auto start = std::chrono::steady_clock::now();
+	for (unsigned t = 0; t < thread_count; ++t)
+	{
+		threads.emplace_back([&]()
+		{
+			auto sum = uint64_t(0);
+			for (auto& value : values)
+			{
+				sum += read(value);
+			}
+			checksum += sum;
+		});
+	}
+	for (auto& thread : threads)
+	{
+		thread.join();
+	}
+	auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	return static_cast<double>(values.size()) / elapsed;
+}
+
+/// <summary>
+/// Measures the nanoseconds per read of the values, that are computed already
+/// </summary>
+template<class Values>
+static double steady_read(Values& values, size_t passes)
+{
+	auto sum = uint64_t(0);
+	auto start = std::chrono::steady_clock::now();
+	for (size_t pass = 0; pass < passes; ++pass)
+	{
+		for (auto& value : values)
+		{
+			sum += read(value);
+		}
+	}
+	auto elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+	if (sum == 0)
+	{
+		printf("The sum is unexpected\n");
+	}
+	return elapsed / static_cast<double>(values.size() * passes);
+}
+
+int main()
+{
+	constexpr auto count = size_t(200000);
+
+	printf("First access of %zu derived values by all threads at once\n", count);
+	auto hardware = std::max(std::thread::hardware_concurrency(), 1u);
+	for (unsigned threads = 1; threads <= hardware; threads *= 2)
+	{
+		auto lazy_values = make_lazy_values(count);
+		auto once_values = make_once_values(count);
+		printf("%2u threads   lazy_ptr %7.2f M/s   call_once %7.2f M/s\n", threads,
+			first_access(lazy_values, threads) / 1e6,
+			first_access(once_values, threads) / 1e6);
+	}
+
+	auto lazy_values = make_lazy_values(1000);
+	auto once_values = make_once_values(1000);
+	first_access(lazy_values, 1);
+	first_access(once_values, 1);
+	printf("\nSteady-state read\n");
+	printf("lazy_ptr %6.2f ns   call_once %6.2f ns\n", steady_read(lazy_values, 20000), steady_read(once_values, 20000));
+	return 0;
+}
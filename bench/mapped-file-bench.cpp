@@ -0,0 +1,157 @@
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <chrono>
+#include <cstddef>
+#include <filesystem>
+#include <system_error>
+#include <vector>
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+#include "include/mapped_file.h"
+
+// The reads of a file in the page cache through mapped_slice compared with pread into a std::vector:
+// the sequential read of the whole file by the records of 64 KiB and the reads of the records of 4 KiB
+// at random offsets. Each run maps or opens the file again, so the page faults of the mapping are included.
+// Every cache line of a record is read, as a parser touches all the bytes.
+
+#if defined(_WIN32)
+
+int main()
+{
+	printf("The benchmark requires the POSIX pread\n");
+	return 0;
+}
+
+#else
+
+/// <summary>
+/// Reads every cache line of the record
+/// </summary>
+static inline uint64_t touch(const std::byte* data, size_t size) noexcept
+{
+	auto sum = uint64_t(0);
+	for (size_t i = 0; i < size; i += 64)
+	{
+		sum += static_cast<uint64_t>(data[i]);
+	}
+	return sum;
+}
+
+/// <summary>
+/// The offsets of the random reads, that are aligned to the record size
+/// </summary>
+static std::vector<size_t> make_offsets(size_t file_size, size_t record_size, size_t count)
+{
+	auto offsets = std::vector<size_t>();
+	auto seed = uint64_t(1);
+	for (size_t i = 0; i < count; ++i)
+	{
+		seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+		offsets.push_back((seed >> 33) % (file_size / record_size) * record_size);
+	}
+	return offsets;
+}
+
+/// <summary>
+/// Measures the bytes per second read by the records at the offsets through a new mapping
+/// </summary>
+static double read_mapped(const std::filesystem::path& path, const mapping_options& options,
+	const std::vector<size_t>& offsets, size_t record_size, uint64_t& checksum)
+{
+	auto start = std::chrono::steady_clock::now();
+	auto file = map_file(path, options);
+	for (auto offset : offsets)
+	{
+		auto record = file.slice(offset, record_size);
+		checksum += touch(record.data(), record.size());
+	}
+	auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	return static_cast<double>(offsets.size() * record_size) / elapsed;
+}
+
+/// <summary>
+/// Measures the bytes per second read by the records at the offsets by pread into a buffer
+/// </summary>
+static double read_copied(const std::filesystem::path& path, const std::vector<size_t>& offsets, size_t record_size, uint64_t& checksum)
+{
+	auto start = std::chrono::steady_clock::now();
+	auto descriptor = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+	if (descriptor < 0)
+	{
+		throw std::system_error(errno, std::system_category());
+	}
+	auto buffer = std::vector<std::byte>(record_size);
+	for (auto offset : offsets)
+	{
+		auto received = ::pread(descriptor, buffer.data(), record_size, static_cast<off_t>(offset));
+		if (received < 0)
+		{
+			::close(descriptor);
+			throw std::system_error(errno, std::system_category());
+		}
+		checksum += touch(buffer.data(), static_cast<size_t>(received));
+	}
+	::close(descriptor);
+	auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	return static_cast<double>(offsets.size() * record_size) / elapsed;
+}
+
+int main()
+{
+	constexpr auto file_size = size_t(256) << 20;
+	constexpr auto sequential_record = size_t(65536);
+	constexpr auto random_record = size_t(4096);
+
+	auto path = std::filesystem::temp_directory_path() / "mapped-file-bench.dat";
+	{
+		auto block = std::vector<std::byte>(1 << 20);
+		for (size_t i = 0; i < block.size(); ++i)
+		{
+			block[i] = static_cast<std::byte>(i * 131);
+		}
+		auto stream = fopen(path.c_str(), "wb");
+		for (size_t written = 0; stream != nullptr && written < file_size; written += block.size())
+		{
+			fwrite(block.data(), 1, block.size(), stream);
+		}
+		if (stream == nullptr || fclose(stream) != 0)
+		{
+			printf("The file cannot be written\n");
+			return 1;
+		}
+	}
+
+	auto sequential = std::vector<size_t>();
+	for (size_t offset = 0; offset < file_size; offset += sequential_record)
+	{
+		sequential.push_back(offset);
+	}
+	auto random = make_offsets(file_size, random_record, 200000);
+	auto checksum = uint64_t(0);
+	// Brings the whole file into the page cache
+	read_copied(path, sequential, sequential_record, checksum);
+
+	printf("%zu MiB in the page cache\n", file_size >> 20);
+	for (auto populate : { false, true })
+	{
+		auto name = populate ? "mapped, populated" : "mapped";
+		printf("%-18s sequential 64 KiB %6.2f GB/s   random 4 KiB %6.2f GB/s\n", name,
+			read_mapped(path, { access_hint::sequential, populate, false }, sequential, sequential_record, checksum) / 1e9,
+			read_mapped(path, { access_hint::random, populate, false }, random, random_record, checksum) / 1e9);
+	}
+	printf("%-18s sequential 64 KiB %6.2f GB/s   random 4 KiB %6.2f GB/s\n", "pread",
+		read_copied(path, sequential, sequential_record, checksum) / 1e9,
+		read_copied(path, random, random_record, checksum) / 1e9);
+
+	std::filesystem::remove(path);
+	if (checksum == 0)
+	{
+		printf("The checksum is unexpected\n");
+	}
+	return 0;
+}
+
+#endif
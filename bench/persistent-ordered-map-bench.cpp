@@ -0,0 +1,153 @@
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <chrono>
+#include <map>
+#include <random>
+#include <vector>
+#include "include/persistent_ordered_map.h"
+
+// The throughput of the point and range operations of persistent_ordered_map across versions.
+// The updates produce a new version each, or one per transaction of a batch, while the last
+// eight versions stay alive. The reads run on the oldest kept version, while the newer ones exist.
+// std::map updated in place, without any versions, is the reference.
+
+static constexpr size_t kept_versions = 8;
+
+using persistent_map = persistent_ordered_map<uint64_t, uint64_t>;
+
+static persistent_map make_persistent(uint64_t key_count)
+{
+	auto map = persistent_map();
+	for (uint64_t key = 0; key < key_count; ++key)
+	{
+		map.insert_or_assign(key * 2, key);
+	}
+	return map;
+}
+
+static std::map<uint64_t, uint64_t> make_std(uint64_t key_count)
+{
+	auto map = std::map<uint64_t, uint64_t>();
+	for (uint64_t key = 0; key < key_count; ++key)
+	{
+		map.emplace(key * 2, key);
+	}
+	return map;
+}
+
+/// <summary>
+/// Measures the updates per second, the batch of the updates makes one version
+/// </summary>
+static double versioned_updates(uint64_t key_count, size_t updates, size_t batch)
+{
+	auto versions = std::vector<persistent_map>(kept_versions, make_persistent(key_count));
+	auto random = std::mt19937_64(1);
+	auto start = std::chrono::steady_clock::now();
+	for (size_t i = 0; i < updates / batch; ++i)
+	{
+		auto& latest = versions[i % kept_versions];
+		latest = versions[(i + kept_versions - 1) % kept_versions].transact([&](persistent_map& version)
+		{
+			for (size_t j = 0; j < batch; ++j)
+			{
+				version.insert_or_assign(random() % (key_count * 2), i);
+			}
+		});
+	}
+	auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	return static_cast<double>(updates / batch * batch) / elapsed;
+}
+
+static double in_place_updates(uint64_t key_count, size_t updates)
+{
+	auto map = make_std(key_count);
+	auto random = std::mt19937_64(1);
+	auto start = std::chrono::steady_clock::now();
+	for (size_t i = 0; i < updates; ++i)
+	{
+		map.insert_or_assign(random() % (key_count * 2), i);
+	}
+	auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	return static_cast<double>(updates) / elapsed;
+}
+
+/// <summary>
+/// Measures the reads per second on the oldest version, each of them is a lookup or a range scan
+/// </summary>
+template<class Read>
+static double reads(size_t count, Read&& read)
+{
+	auto random = std::mt19937_64(2);
+	auto sum = uint64_t(0);
+	auto start = std::chrono::steady_clock::now();
+	for (size_t i = 0; i < count; ++i)
+	{
+		sum += read(random());
+	}
+	auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	if (sum == 0)
+	{
+		printf("The sum is unexpected\n");
+	}
+	return static_cast<double>(count) / elapsed;
+}
+
+int main()
+{
+	constexpr auto key_count = uint64_t(1000000);
+	constexpr auto updates = size_t(1000000);
+	constexpr auto lookups = size_t(2000000);
+	constexpr auto scans = size_t(200000);
+	constexpr auto scan_keys = uint64_t(200);
+
+	printf("Updates, %llu keys, %zu versions alive\n", static_cast<unsigned long long>(key_count), kept_versions);
+	for (auto batch : { size_t(1), size_t(16), size_t(256) })
+	{
+		printf("%3zu per version   persistent_ordered_map %7.2f Mops/s\n", batch,
+			versioned_updates(key_count, updates, batch) / 1e6);
+	}
+	printf("in place          std::map               %7.2f Mops/s\n", in_place_updates(key_count, updates) / 1e6);
+
+	auto oldest = make_persistent(key_count);
+	auto newer = std::vector<persistent_map>();
+	auto random = std::mt19937_64(3);
+	for (size_t i = 0; i < kept_versions; ++i)
+	{
+		newer.push_back((newer.empty() ? oldest : newer.back()).set(random() % (key_count * 2), i));
+	}
+	auto reference = make_std(key_count);
+
+	printf("\nReads of the oldest version\n");
+	printf("lookup            persistent_ordered_map %7.2f Mops/s   std::map %7.2f Mops/s\n",
+		reads(lookups, [&](uint64_t random_key)
+		{
+			auto value = oldest.find(random_key % (key_count * 2));
+			return value != nullptr ? *value + 1 : 1;
+		}) / 1e6,
+		reads(lookups, [&](uint64_t random_key)
+		{
+			auto found = reference.find(random_key % (key_count * 2));
+			return found != reference.end() ? found->second + 1 : 1;
+		}) / 1e6);
+	printf("range of %3llu      persistent_ordered_map %7.2f Mops/s   std::map %7.2f Mops/s\n",
+		static_cast<unsigned long long>(scan_keys),
+		reads(scans, [&](uint64_t random_key)
+		{
+			auto first = random_key % (key_count * 2);
+			auto sum = uint64_t(1);
+			oldest.for_each_range(first, first + scan_keys, [&](uint64_t, uint64_t value) { sum += value; });
+			return sum;
+		}) / 1e6,
+		reads(scans, [&](uint64_t random_key)
+		{
+			auto first = random_key % (key_count * 2);
+			auto sum = uint64_t(1);
+			for (auto it = reference.lower_bound(first); it != reference.end() && it->first < first + scan_keys; ++it)
+			{
+				sum += it->second;
+			}
+			return sum;
+		}) / 1e6);
+	return 0;
+}
@@ -0,0 +1,150 @@
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <chrono>
+#include <random>
+#include <type_traits>
+#include <vector>
+#include "include/persistent_vector.h"
+
+// persistent_vector compared with copying std::vector snapshots.
+// Each edit keeps a snapshot of the version before it, the last eight snapshots stay alive.
+// The iteration, the concatenation and the slicing are measured on the same sizes.
+
+static constexpr size_t kept_snapshots = 8;
+
+/// <summary>
+/// Measures the edits per second, each of them takes a snapshot and assigns a random element
+/// </summary>
+template<class Vector>
+static double snapshot_edits(size_t size, size_t edits)
+{
+	auto current = Vector();
+	for (size_t i = 0; i < size; ++i)
+	{
+		current.push_back(i);
+	}
+
+	auto snapshots = std::vector<Vector>(kept_snapshots);
+	auto random = std::mt19937_64(1);
+	auto start = std::chrono::steady_clock::now();
+	for (size_t i = 0; i < edits; ++i)
+	{
+		snapshots[i % kept_snapshots] = current;
+		auto index = static_cast<size_t>(random() % size);
+		if constexpr (std::is_same_v<Vector, std::vector<uint64_t>>)
+		{
+			current[index] = i;
+		}
+		else
+		{
+			current.assign(index, i);
+		}
+	}
+	auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	return static_cast<double>(edits) / elapsed;
+}
+
+/// <summary>
+/// Measures the elements per second visited by the iteration
+/// </summary>
+template<class Vector>
+static double iteration(size_t size, size_t passes)
+{
+	auto vector = Vector();
+	for (size_t i = 0; i < size; ++i)
+	{
+		vector.push_back(i);
+	}
+
+	auto sum = uint64_t(0);
+	auto start = std::chrono::steady_clock::now();
+	for (size_t pass = 0; pass < passes; ++pass)
+	{
+		for (auto value : vector)
+		{
+			sum += value;
+		}
+	}
+	auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	if (sum == 0)
+	{
+		printf("The sum is unexpected\n");
+	}
+	return static_cast<double>(size * passes) / elapsed;
+}
+
+/// <summary>
+/// Measures the operations per second, each of them concatenates the halves
+/// of the vector in the other order and slices the middle of the result
+/// </summary>
+template<class Vector>
+static double concat_slice(size_t size, size_t operations)
+{
+	auto vector = Vector();
+	for (size_t i = 0; i < size; ++i)
+	{
+		vector.push_back(i);
+	}
+
+	auto random = std::mt19937_64(2);
+	auto checksum = uint64_t(0);
+	auto start = std::chrono::steady_clock::now();
+	for (size_t i = 0; i < operations; ++i)
+	{
+		auto split = static_cast<size_t>(random() % size);
+		if constexpr (std::is_same_v<Vector, std::vector<uint64_t>>)
+		{
+			auto joined = Vector(vector.begin() + static_cast<ptrdiff_t>(split), vector.end());
+			joined.insert(joined.end(), vector.begin(), vector.begin() + static_cast<ptrdiff_t>(split));
+			auto middle = Vector(joined.begin() + static_cast<ptrdiff_t>(size / 4), joined.end() - static_cast<ptrdiff_t>(size / 4));
+			checksum += middle.size();
+		}
+		else
+		{
+			auto joined = vector.drop(split).concat(vector.take(split));
+			auto middle = joined.slice(size / 4, size - size / 4);
+			checksum += middle.size();
+		}
+	}
+	auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	if (checksum == 0)
+	{
+		printf("The checksum is unexpected\n");
+	}
+	return static_cast<double>(operations) / elapsed;
+}
+
+int main()
+{
+	using persistent = persistent_vector<uint64_t>;
+	using copied = std::vector<uint64_t>;
+
+	printf("Snapshot and edit, %zu snapshots alive\n", kept_snapshots);
+	for (auto size : { size_t(1000), size_t(100000), size_t(1000000) })
+	{
+		auto edits = size_t(20000000) / size + 1000;
+		printf("%8zu elements   persistent_vector %10.0f edits/s   std::vector %10.0f edits/s\n", size,
+			snapshot_edits<persistent>(size, edits * 10),
+			snapshot_edits<copied>(size, edits));
+	}
+
+	printf("\nIteration\n");
+	for (auto size : { size_t(1000), size_t(1000000) })
+	{
+		auto passes = size_t(100000000) / size;
+		printf("%8zu elements   persistent_vector %7.0f M/s   std::vector %7.0f M/s\n", size,
+			iteration<persistent>(size, passes) / 1e6,
+			iteration<copied>(size, passes) / 1e6);
+	}
+
+	printf("\nConcatenation of the rotated halves and a slice of the middle\n");
+	for (auto size : { size_t(1000), size_t(100000), size_t(1000000) })
+	{
+		auto operations = size_t(20000000) / size + 1000;
+		printf("%8zu elements   persistent_vector %10.0f ops/s   std::vector %10.0f ops/s\n", size,
+			concat_slice<persistent>(size, operations * 10),
+			concat_slice<copied>(size, operations));
+	}
+	return 0;
+}
@@ -0,0 +1,197 @@
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <chrono>
+#include <cstddef>
+#include <filesystem>
+#include <memory>
+#include <system_error>
+#include <vector>
+#if defined(__linux__)
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+#include "include/registered_buffer_pool.h"
+
+// The reads and the writes of a file by the blocks of 64 KiB through io_uring with the buffers
+// of registered_buffer_pool, that are kept alive by the references carried in the user data,
+// compared with pread and pwrite into a single std::vector. The ring keeps up to 32 operations in flight.
+// If io_uring is missing in the kernel, denied by a seccomp profile or the buffers cannot be registered,
+// only the system calls are measured.
+
+#if !defined(__linux__)
+
+int main()
+{
+	printf("The benchmark requires io_uring\n");
+	return 0;
+}
+
+#else
+
+static constexpr size_t block_size = 65536;
+static constexpr size_t depth = 32;
+
+/// <summary>
+/// Reads every cache line of the block
+/// </summary>
+static inline uint64_t touch(const std::byte* data, size_t size) noexcept
+{
+	auto sum = uint64_t(0);
+	for (size_t i = 0; i < size; i += 64)
+	{
+		sum += static_cast<uint64_t>(data[i]);
+	}
+	return sum;
+}
+
+/// <summary>
+/// An open descriptor of the file, that is closed on destruction
+/// </summary>
+struct BenchFile
+{
+	BenchFile(const std::filesystem::path& path, int flags) : Fd(::open(path.c_str(), flags | O_CLOEXEC, 0600))
+	{
+		if (Fd < 0)
+		{
+			throw std::system_error(errno, std::system_category());
+		}
+	}
+
+	~BenchFile()
+	{
+		::close(Fd);
+	}
+
+	int Fd;
+};
+
+/// <summary>
+/// Measures the bytes per second of reading or writing the file by the fixed operations of the ring
+/// </summary>
+static double transfer_ring(io_ring& ring, registered_buffer_pool& pool, int fd, size_t file_size, bool write, uint64_t& checksum)
+{
+	auto start = std::chrono::steady_clock::now();
+	auto next = size_t(0);
+	auto in_flight = size_t(0);
+	for (size_t done = 0; done < file_size;)
+	{
+		while (in_flight < depth && next < file_size)
+		{
+			auto buffer = pool.try_acquire();
+			if (!buffer)
+			{
+				break;
+			}
+			if (write)
+			{
+				buffer->resize(block_size);
+				buffer->data()[0] = static_cast<std::byte>(next >> 16);
+				ring.prepare_write_fixed(fd, std::move(buffer), next);
+			}
+			else
+			{
+				ring.prepare_read_fixed(fd, std::move(buffer), block_size, next);
+			}
+			next += block_size;
+			++in_flight;
+		}
+
+		io_uring_cqe completion;
+		ring.wait(completion);
+		do
+		{
+			auto buffer = from_user_data(completion.user_data);
+			if (completion.res < 0)
+			{
+				throw std::system_error(-completion.res, std::system_category());
+			}
+			if (!write)
+			{
+				checksum += touch(buffer->data(), static_cast<size_t>(completion.res));
+			}
+			done += static_cast<size_t>(completion.res);
+			--in_flight;
+		}
+		while (ring.peek(completion));
+	}
+	auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	return static_cast<double>(file_size) / elapsed;
+}
+
+/// <summary>
+/// Measures the bytes per second of reading or writing the file by pread or pwrite
+/// </summary>
+static double transfer_syscalls(int fd, size_t file_size, bool write, uint64_t& checksum)
+{
+	auto buffer = std::vector<std::byte>(block_size);
+	auto start = std::chrono::steady_clock::now();
+	for (size_t offset = 0; offset < file_size; offset += block_size)
+	{
+		ssize_t result;
+		if (write)
+		{
+			buffer[0] = static_cast<std::byte>(offset >> 16);
+			result = ::pwrite(fd, buffer.data(), block_size, static_cast<off_t>(offset));
+		}
+		else
+		{
+			result = ::pread(fd, buffer.data(), block_size, static_cast<off_t>(offset));
+		}
+		if (result < 0)
+		{
+			throw std::system_error(errno, std::system_category());
+		}
+		if (!write)
+		{
+			checksum += touch(buffer.data(), static_cast<size_t>(result));
+		}
+	}
+	auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	return static_cast<double>(file_size) / elapsed;
+}
+
+int main()
+{
+	constexpr auto file_size = size_t(256) << 20;
+
+	auto path = std::filesystem::temp_directory_path() / "registered-buffer-pool-bench.dat";
+	auto checksum = uint64_t(0);
+	auto file = BenchFile(path, O_RDWR | O_CREAT | O_TRUNC);
+	// Creates the file and brings it into the page cache
+	transfer_syscalls(file.Fd, file_size, true, checksum);
+	transfer_syscalls(file.Fd, file_size, false, checksum);
+
+	printf("%zu MiB in the page cache by the blocks of %zu KiB\n", file_size >> 20, block_size >> 10);
+	auto pool = registered_buffer_pool(2 * depth, block_size);
+	auto ring = std::unique_ptr<io_ring>();
+	try
+	{
+		ring = std::make_unique<io_ring>(static_cast<unsigned>(2 * depth));
+		ring->register_buffers(pool);
+	}
+	catch (const std::system_error& e)
+	{
+		printf("io_uring is unavailable: %s\n", e.what());
+		ring = nullptr;
+	}
+	if (ring)
+	{
+		printf("%-22s read %6.2f GB/s   write %6.2f GB/s\n", "io_uring fixed buffers",
+			transfer_ring(*ring, pool, file.Fd, file_size, false, checksum) / 1e9,
+			transfer_ring(*ring, pool, file.Fd, file_size, true, checksum) / 1e9);
+		ring->unregister_buffers();
+	}
+	printf("%-22s read %6.2f GB/s   write %6.2f GB/s\n", "pread and pwrite",
+		transfer_syscalls(file.Fd, file_size, false, checksum) / 1e9,
+		transfer_syscalls(file.Fd, file_size, true, checksum) / 1e9);
+
+	std::filesystem::remove(path);
+	if (checksum == 0)
+	{
+		printf("The checksum is unexpected\n");
+	}
+	return 0;
+}
+
+#endif
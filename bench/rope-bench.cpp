@@ -0,0 +1,96 @@
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <string>
+#include <vector>
+#include "include/rope.h"
+
+// The edit latency of rope on a 100 MB document compared with std::string.
+// Each edit inserts a short text or erases a short range at a random position.
+// The latencies are sorted and reported as the median, the 99th percentile and the maximum.
+
+/// <summary>
+/// The latencies of the edits in microseconds
+/// </summary>
+struct latency_report
+{
+	double median;
+	double p99;
+	double max;
+};
+
+static latency_report summarize(std::vector<double>& latencies)
+{
+	std::sort(latencies.begin(), latencies.end());
+	return latency_report {
+		latencies[latencies.size() / 2],
+		latencies[latencies.size() * 99 / 100],
+		latencies.back()
+	};
+}
+
+/// <summary>
+/// Applies the edits alternating the inserts and the erasures and measures each of them
+/// </summary>
+template<class Document, class Insert, class Erase>
+static latency_report edit(Document& document, size_t edits, Insert&& insert, Erase&& erase)
+{
+	auto random = std::mt19937_64(1);
+	auto latencies = std::vector<double>();
+	latencies.reserve(edits);
+	for (size_t i = 0; i < edits; ++i)
+	{
+		auto position = static_cast<size_t>(random() % (document.size() - 64));
+		auto start = std::chrono::steady_clock::now();
+		if (i % 2 == 0)
+		{
+			insert(document, position);
+		}
+		else
+		{
+			erase(document, position);
+		}
+		latencies.push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count());
+	}
+	return summarize(latencies);
+}
+
+static void print(const char* name, const latency_report& report)
+{
+	printf("%-12s median %10.2f us   p99 %10.2f us   max %10.2f us\n", name, report.median, report.p99, report.max);
+}
+
+int main()
+{
+	constexpr auto document_size = size_t(100) << 20;
+	constexpr auto inserted = std::string_view("an inserted phrase");
+	constexpr auto erased = size_t(16);
+
+	auto text = std::string(document_size, ' ');
+	auto random = std::mt19937_64(2);
+	for (auto& c : text)
+	{
+		c = static_cast<char>('a' + random() % 26);
+	}
+
+	printf("Edits of a %zu MB document\n", document_size >> 20);
+	auto document = rope(text);
+	auto piece = rope(inserted);
+	print("rope", edit(document, 100000,
+		[&](rope& target, size_t position) { target.insert(position, piece); },
+		[&](rope& target, size_t position) { target.erase(position, erased); }));
+
+	auto baseline = text;
+	print("std::string", edit(baseline, 200,
+		[&](std::string& target, size_t position) { target.insert(position, inserted); },
+		[&](std::string& target, size_t position) { target.erase(position, erased); }));
+
+	auto start = std::chrono::steady_clock::now();
+	document.compact();
+	auto elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	printf("compaction of the edited rope %.2f ms\n", elapsed);
+	return 0;
+}
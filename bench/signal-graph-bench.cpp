@@ -0,0 +1,114 @@
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <chrono>
+#include <vector>
+#include "include/signal_graph.h"
+
+// The update latency of signal_graph after a change of one source of a graph of about 1M nodes
+// compared with the full recomputation of the same graph stored in a std::vector.
+// The graph is a balanced binary tree: the sources are the leaves, each computed node
+// combines two nodes of the layer below, so a change of a source recomputes one path to the root.
+
+/// <summary>
+/// The combination of two values, that the compiler cannot fold
+/// </summary>
+static inline uint64_t combine(uint64_t left, uint64_t right) noexcept
+{
+	return (left ^ (right >> 1)) * 0x9e3779b97f4a7c15ull + right;
+}
+
+/// <summary>
+/// The graph of the sources and the computed nodes of the tree
+/// </summary>
+struct BenchGraph
+{
+	explicit BenchGraph(size_t leaves)
+	{
+		auto layer = std::vector<signal<uint64_t>>();
+		for (size_t i = 0; i < leaves; ++i)
+		{
+			Sources.push_back(make_source(uint64_t(i)));
+			layer.push_back(Sources.back());
+		}
+		while (layer.size() > 1)
+		{
+			auto next = std::vector<signal<uint64_t>>();
+			for (size_t i = 0; i < layer.size(); i += 2)
+			{
+				next.push_back(make_computed([](uint64_t left, uint64_t right) { return combine(left, right); }, layer[i], layer[i + 1]));
+			}
+			layer = std::move(next);
+		}
+		Root = layer.front();
+	}
+
+	std::vector<signal_source<uint64_t>> Sources;
+	signal<uint64_t> Root;
+};
+
+/// <summary>
+/// The baseline: the same tree in an array, whose node i combines the nodes 2i and 2i + 1
+/// </summary>
+static uint64_t recompute(std::vector<uint64_t>& tree, size_t leaves)
+{
+	for (auto i = leaves - 1; i > 0; --i)
+	{
+		tree[i] = combine(tree[2 * i], tree[2 * i + 1]);
+	}
+	return tree[1];
+}
+
+int main()
+{
+	constexpr auto leaves = size_t(1) << 19;
+	constexpr auto changes = size_t(100000);
+	constexpr auto recomputations = size_t(200);
+
+	auto start = std::chrono::steady_clock::now();
+	auto graph = BenchGraph(leaves);
+	auto built = std::chrono::steady_clock::now();
+	auto root = graph.Root.get();
+	auto computed = std::chrono::steady_clock::now();
+	printf("Binary tree of %zu sources, %zu nodes\n", leaves, 2 * leaves - 1);
+	printf("build %8.2f ms   first get %8.2f ms\n",
+		std::chrono::duration<double, std::milli>(built - start).count(),
+		std::chrono::duration<double, std::milli>(computed - built).count());
+
+	auto tree = std::vector<uint64_t>(2 * leaves);
+	for (size_t i = 0; i < leaves; ++i)
+	{
+		tree[leaves + i] = i;
+	}
+	if (recompute(tree, leaves) != root)
+	{
+		printf("The roots differ\n");
+	}
+
+	auto seed = uint64_t(1);
+	auto sum = uint64_t(0);
+	start = std::chrono::steady_clock::now();
+	for (size_t i = 0; i < changes; ++i)
+	{
+		seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+		graph.Sources[(seed >> 33) % leaves].set(seed);
+		sum += graph.Root.get();
+	}
+	auto incremental = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+
+	seed = 1;
+	start = std::chrono::steady_clock::now();
+	for (size_t i = 0; i < recomputations; ++i)
+	{
+		seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+		tree[leaves + (seed >> 33) % leaves] = seed;
+		sum += recompute(tree, leaves);
+	}
+	auto full = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+
+	printf("\nUpdate of one source and get of the root\n");
+	printf("signal_graph %10.2f us   full recomputation %10.2f us%s\n",
+		incremental / static_cast<double>(changes), full / static_cast<double>(recomputations),
+		sum == 0 ? "   the sum is unexpected" : "");
+	return 0;
+}
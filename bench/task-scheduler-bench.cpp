@@ -0,0 +1,326 @@
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "include/task_scheduler.h"
+
+// task_scheduler on the fork-join and the wide-DAG workloads compared with a thread pool,
+// whose workers share a single std::deque of std::function guarded by std::mutex.
+// The fork-join spawns a binary tree of tasks from the tasks themselves, each inner task
+// is joined by a continuation, that runs after both children. The wide DAG is built before
+// the measurement: every task of a layer depends on two random tasks of the previous one.
+
+/// <summary>
+/// The work of a single task, that the compiler cannot remove
+/// </summary>
+static uint64_t spin(uint64_t seed, unsigned iterations) noexcept
+{
+	for (unsigned i = 0; i < iterations; ++i)
+	{
+		seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+	}
+	return seed;
+}
+
+/// <summary>
+/// The baseline: the workers take the functions from a shared queue guarded by a mutex
+/// </summary>
+class mutex_pool final
+{
+public:
+	explicit mutex_pool(unsigned worker_count)
+	{
+		for (unsigned i = 0; i < worker_count; ++i)
+		{
+			m_workers.emplace_back([this]() { run(); });
+		}
+	}
+
+	~mutex_pool()
+	{
+		{
+			auto lock = std::lock_guard(m_mutex);
+			m_stopping = true;
+		}
+		m_ready.notify_all();
+		for (auto& worker : m_workers)
+		{
+			worker.join();
+		}
+	}
+
+	inline void submit(std::function<void()> function)
+	{
+		{
+			auto lock = std::lock_guard(m_mutex);
+			m_queue.push_back(std::move(function));
+			++m_unfinished;
+		}
+		m_ready.notify_one();
+	}
+
+	inline void wait_idle()
+	{
+		auto lock = std::unique_lock(m_mutex);
+		m_idle.wait(lock, [&]() { return m_unfinished == 0; });
+	}
+
+private:
+	inline void run()
+	{
+		auto lock = std::unique_lock(m_mutex);
+		while (true)
+		{
+			m_ready.wait(lock, [&]() { return m_stopping || !m_queue.empty(); });
+			if (m_queue.empty())
+			{
+				return;
+			}
+			auto function = std::move(m_queue.front());
+			m_queue.pop_front();
+			lock.unlock();
+			function();
+			lock.lock();
+			if (--m_unfinished == 0)
+			{
+				m_idle.notify_all();
+			}
+		}
+	}
+
+private:
+	std::mutex m_mutex;
+	std::condition_variable m_ready;
+	std::condition_variable m_idle;
+	std::deque<std::function<void()>> m_queue;
+	size_t m_unfinished { 0 };
+	bool m_stopping { false };
+	std::vector<std::thread> m_workers;
+};
+
+/// <summary>
+/// Spawns the subtree of the fork-join on task_scheduler
+/// </summary>
+static void fork(task_scheduler& scheduler, unsigned depth, unsigned work, std::atomic<uint64_t>& sum)
+{
+	if (depth == 0)
+	{
+		sum.fetch_add(spin(depth, work), std::memory_order_relaxed);
+		return;
+	}
+
+	auto left = make_task([&scheduler, depth, work, &sum] { fork(scheduler, depth - 1, work, sum); });
+	auto right = make_task([&scheduler, depth, work, &sum] { fork(scheduler, depth - 1, work, sum); });
+	auto join = make_task([depth, work, &sum] { sum.fetch_add(spin(depth, work), std::memory_order_relaxed); });
+	left->precede(*join);
+	right->precede(*join);
+	scheduler.submit(std::move(join));
+	scheduler.submit(std::move(left));
+	scheduler.submit(std::move(right));
+}
+
+/// <summary>
+/// A join of the fork-join on the mutex pool, that counts down its finished children
+/// </summary>
+struct pool_join
+{
+	std::atomic<int> pending { 2 };
+	std::shared_ptr<pool_join> parent;
+	unsigned depth { 0 };
+};
+
+static void finish(mutex_pool& pool, std::shared_ptr<pool_join> join, unsigned work, std::atomic<uint64_t>& sum);
+
+/// <summary>
+/// Spawns the subtree of the fork-join on the mutex pool
+/// </summary>
+static void fork(mutex_pool& pool, unsigned depth, unsigned work, std::atomic<uint64_t>& sum, std::shared_ptr<pool_join> parent)
+{
+	if (depth == 0)
+	{
+		sum.fetch_add(spin(depth, work), std::memory_order_relaxed);
+		finish(pool, std::move(parent), work, sum);
+		return;
+	}
+
+	auto join = std::make_shared<pool_join>();
+	join->parent = std::move(parent);
+	join->depth = depth;
+	for (auto child = 0; child < 2; ++child)
+	{
+		pool.submit([&pool, depth, work, &sum, join]() { fork(pool, depth - 1, work, sum, join); });
+	}
+}
+
+/// <summary>
+/// Submits the join, when the last of its children has finished
+/// </summary>
+static void finish(mutex_pool& pool, std::shared_ptr<pool_join> join, unsigned work, std::atomic<uint64_t>& sum)
+{
+	if (join && join->pending.fetch_sub(1) == 1)
+	{
+		pool.submit([&pool, join, work, &sum]()
+		{
+			sum.fetch_add(spin(join->depth, work), std::memory_order_relaxed);
+			finish(pool, join->parent, work, sum);
+		});
+	}
+}
+
+static double fork_join_scheduler(unsigned workers, unsigned depth, unsigned work)
+{
+	auto sum = std::atomic<uint64_t>(0);
+	auto scheduler = task_scheduler(workers);
+	auto start = std::chrono::steady_clock::now();
+	scheduler.submit(make_task([&] { fork(scheduler, depth, work, sum); }));
+	scheduler.wait_idle();
+	auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	return static_cast<double>((size_t(1) << (depth + 1)) - 1) / elapsed;
+}
+
+static double fork_join_pool(unsigned workers, unsigned depth, unsigned work)
+{
+	auto sum = std::atomic<uint64_t>(0);
+	auto pool = mutex_pool(workers);
+	auto start = std::chrono::steady_clock::now();
+	pool.submit([&] { fork(pool, depth, work, sum, nullptr); });
+	pool.wait_idle();
+	auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	return static_cast<double>((size_t(1) << (depth + 1)) - 1) / elapsed;
+}
+
+/// <summary>
+/// The predecessors of each task of the wide DAG by the layers
+/// </summary>
+static std::vector<std::vector<std::pair<size_t, size_t>>> make_dag(size_t width, size_t layers)
+{
+	auto random = std::mt19937_64(1);
+	auto dag = std::vector<std::vector<std::pair<size_t, size_t>>>(layers, std::vector<std::pair<size_t, size_t>>(width));
+	for (auto& layer : dag)
+	{
+		for (auto& predecessors : layer)
+		{
+			predecessors = { random() % width, random() % width };
+		}
+	}
+	return dag;
+}
+
+static double wide_dag_scheduler(unsigned workers, const std::vector<std::vector<std::pair<size_t, size_t>>>& dag, unsigned work)
+{
+	auto sum = std::atomic<uint64_t>(0);
+	auto tasks = std::vector<std::vector<intrusive_ptr<graph_task>>>();
+	for (size_t l = 0; l < dag.size(); ++l)
+	{
+		tasks.emplace_back();
+		for (size_t i = 0; i < dag[l].size(); ++i)
+		{
+			tasks.back().push_back(make_task([i, work, &sum] { sum.fetch_add(spin(i, work), std::memory_order_relaxed); }));
+			if (l != 0)
+			{
+				tasks[l - 1][dag[l][i].first]->precede(*tasks.back().back());
+				tasks[l - 1][dag[l][i].second]->precede(*tasks.back().back());
+			}
+		}
+	}
+
+	auto scheduler = task_scheduler(workers);
+	auto start = std::chrono::steady_clock::now();
+	for (auto& layer : tasks)
+	{
+		for (auto& task : layer)
+		{
+			scheduler.submit(task);
+		}
+	}
+	scheduler.wait_idle();
+	auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	return static_cast<double>(dag.size() * dag.front().size()) / elapsed;
+}
+
+static double wide_dag_pool(unsigned workers, const std::vector<std::vector<std::pair<size_t, size_t>>>& dag, unsigned work)
+{
+	struct node
+	{
+		std::atomic<int> pending { 0 };
+		std::vector<node*> successors;
+		size_t index { 0 };
+	};
+
+	auto sum = std::atomic<uint64_t>(0);
+	auto nodes = std::vector<std::vector<node>>();
+	for (auto& layer : dag)
+	{
+		nodes.emplace_back(layer.size());
+	}
+	for (size_t l = 0; l < dag.size(); ++l)
+	{
+		for (size_t i = 0; i < dag[l].size(); ++i)
+		{
+			nodes[l][i].index = i;
+			if (l != 0)
+			{
+				nodes[l - 1][dag[l][i].first].successors.push_back(&nodes[l][i]);
+				nodes[l - 1][dag[l][i].second].successors.push_back(&nodes[l][i]);
+				nodes[l][i].pending = 2;
+			}
+		}
+	}
+
+	auto pool = mutex_pool(workers);
+	std::function<void(node*)> execute = [&](node* current)
+	{
+		sum.fetch_add(spin(current->index, work), std::memory_order_relaxed);
+		for (auto successor : current->successors)
+		{
+			if (successor->pending.fetch_sub(1) == 1)
+			{
+				pool.submit([&execute, successor]() { execute(successor); });
+			}
+		}
+	};
+	auto start = std::chrono::steady_clock::now();
+	for (auto& current : nodes.front())
+	{
+		pool.submit([&execute, &current]() { execute(&current); });
+	}
+	pool.wait_idle();
+	auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	return static_cast<double>(dag.size() * dag.front().size()) / elapsed;
+}
+
+int main()
+{
+	constexpr auto depth = 18u;
+	constexpr auto work = 200u;
+
+	auto hardware = std::max(std::thread::hardware_concurrency(), 1u);
+	printf("Fork-join of depth %u, %u iterations of work per task\n", depth, work);
+	for (unsigned workers = 1; workers <= hardware; workers *= 2)
+	{
+		printf("%2u workers   task_scheduler %7.2f Mtasks/s   mutex pool %7.2f Mtasks/s\n", workers,
+			fork_join_scheduler(workers, depth, work) / 1e6,
+			fork_join_pool(workers, depth, work) / 1e6);
+	}
+
+	auto dag = make_dag(10000, 50);
+	printf("\nWide DAG of %zu layers of %zu tasks\n", dag.size(), dag.front().size());
+	for (unsigned workers = 1; workers <= hardware; workers *= 2)
+	{
+		printf("%2u workers   task_scheduler %7.2f Mtasks/s   mutex pool %7.2f Mtasks/s\n", workers,
+			wide_dag_scheduler(workers, dag, work) / 1e6,
+			wide_dag_pool(workers, dag, work) / 1e6);
+	}
+	return 0;
+}
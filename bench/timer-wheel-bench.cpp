@@ -0,0 +1,163 @@
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <chrono>
+#include <map>
+#include <random>
+#include <utility>
+#include <vector>
+#include "include/timer_wheel.h"
+
+// 10M timer schedules with heavy cancellation on timer_wheel compared with std::multimap,
+// whose timers keep their own iterators, so both cancel a timer by reference.
+// A pool of timers is reused round-robin: a timer still armed, when its turn comes, is cancelled
+// and scheduled again, like a retransmission timer. The clock advances one tick per ten schedules.
+
+struct BenchTimer;
+
+// The multimap holds the references, since intrusive_ptr requires the complete type
+using timer_map = std::multimap<uint64_t, BenchTimer*>;
+
+struct BenchTimer : public RefCountObject<BenchTimer>, public timer_wheel_hook<>
+{
+	uint64_t Fired { 0 };
+	// Used only by the multimap
+	timer_map::iterator Position;
+	bool Armed { false };
+};
+
+/// <summary>
+/// The baseline: the timers ordered by the expiry in a multimap
+/// </summary>
+class ordered_timers final
+{
+public:
+	inline bool cancel(BenchTimer& timer)
+	{
+		if (!timer.Armed)
+		{
+			return false;
+		}
+		timer.Armed = false;
+		auto released = intrusive_ptr<BenchTimer>(timer.Position->second, false);
+		m_timers.erase(timer.Position);
+		return true;
+	}
+
+	inline void schedule_after(intrusive_ptr<BenchTimer> timer, uint64_t delay)
+	{
+		timer->Armed = true;
+		timer->Position = m_timers.emplace(m_now + delay, timer.get());
+		timer.detach();
+	}
+
+	template<class Handler>
+	inline size_t advance(uint64_t now, Handler&& handler)
+	{
+		m_now = now;
+		auto count = size_t(0);
+		while (!m_timers.empty() && m_timers.begin()->first <= now)
+		{
+			auto timer = intrusive_ptr<BenchTimer>(m_timers.begin()->second, false);
+			m_timers.erase(m_timers.begin());
+			timer->Armed = false;
+			handler(std::move(timer));
+			++count;
+		}
+		return count;
+	}
+
+private:
+	uint64_t m_now { 0 };
+	timer_map m_timers;
+};
+
+/// <summary>
+/// Adapts timer_wheel to the interface of the benchmark
+/// </summary>
+class wheel_timers final
+{
+public:
+	inline bool cancel(BenchTimer& timer)
+	{
+		return m_wheel.cancel(timer);
+	}
+
+	inline void schedule_after(intrusive_ptr<BenchTimer> timer, uint64_t delay)
+	{
+		m_wheel.schedule_after(std::move(timer), delay);
+	}
+
+	template<class Handler>
+	inline size_t advance(uint64_t now, Handler&& handler)
+	{
+		return m_wheel.advance(now, handler);
+	}
+
+private:
+	timer_wheel<BenchTimer> m_wheel;
+};
+
+struct churn_result
+{
+	double rate;
+	size_t fired;
+	size_t cancelled;
+};
+
+/// <summary>
+/// Measures the schedules per second including the cancellations and the firing
+/// </summary>
+template<class Timers>
+static churn_result churn(size_t pool_size, size_t schedules, uint64_t max_delay)
+{
+	auto pool = std::vector<intrusive_ptr<BenchTimer>>();
+	for (size_t i = 0; i < pool_size; ++i)
+	{
+		pool.push_back(make_intrusive<BenchTimer>());
+	}
+
+	auto timers = Timers();
+	auto random = std::mt19937_64(1);
+	auto now = uint64_t(0);
+	auto fired = size_t(0);
+	auto cancelled = size_t(0);
+	auto start = std::chrono::steady_clock::now();
+	for (size_t i = 0; i < schedules; ++i)
+	{
+		auto& timer = pool[i % pool_size];
+		if (timers.cancel(*timer))
+		{
+			++cancelled;
+		}
+		timers.schedule_after(timer, 1 + random() % max_delay);
+		if (i % 10 == 9)
+		{
+			fired += timers.advance(++now, [](intrusive_ptr<BenchTimer> expired) { ++expired->Fired; });
+		}
+	}
+	auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	for (auto& timer : pool)
+	{
+		timers.cancel(*timer);
+	}
+	return churn_result { static_cast<double>(schedules) / elapsed, fired, cancelled };
+}
+
+int main()
+{
+	constexpr auto schedules = size_t(10000000);
+	constexpr auto pool_size = size_t(1000000);
+	// A timer is reused after pool_size / 10 ticks, most of them are cancelled before they fire
+	constexpr auto max_delay = uint64_t(pool_size / 10 * 4);
+
+	printf("%zu schedules, %zu timers, the delays up to %llu ticks\n",
+		schedules, pool_size, static_cast<unsigned long long>(max_delay));
+	for (auto [name, result] : {
+		std::pair { "timer_wheel", churn<wheel_timers>(pool_size, schedules, max_delay) },
+		std::pair { "std::multimap", churn<ordered_timers>(pool_size, schedules, max_delay) } })
+	{
+		printf("%-14s %7.2f Mops/s   fired %8zu   cancelled %8zu\n", name, result.rate / 1e6, result.fired, result.cancelled);
+	}
+	return 0;
+}
@@ -0,0 +1,133 @@
+#pragma once
+#include <stddef.h>
+#include <atomic>
+#include <type_traits>
+#include <utility>
+#include "intrusive_mpsc_queue.h"
+#include "intrusive_ptr.h"
+#include "task_scheduler.h"
+
+/// <summary>
+/// A base class of an actor, that processes the messages of its mailbox on <see cref="task_scheduler"/>.
+/// The mailbox is an <see cref="intrusive_mpsc_queue"/>, so a send moves the reference
+/// of the message into the mailbox without allocations and changes of the reference count.
+/// The actor is activated on the scheduler only when its mailbox becomes non-empty,
+/// and an activation keeps the actor alive while it has pending messages.
+/// The messages of an actor are never processed concurrently.
+/// </summary>
+/// <typeparam name="Derived">
+/// The type of the actor, that provides the function <c>receive(intrusive_ptr&lt;Message&gt;) noexcept</c>.
+/// The messages are processed by a task of the scheduler, that must not throw,
+/// so the function has to handle its own failures.
+/// </typeparam>
+/// <typeparam name="Message">
+/// The type of the messages derived from <see cref="RefCountObject"/> and <see cref="intrusive_mpsc_hook"/>
+/// </typeparam>
+template<class Derived, intrusive_counter_type Message>
+class actor : public RefCountObject<Derived>
+{
+    static_assert(std::is_base_of_v<intrusive_mpsc_hook<>, Message>,
+        "The message type must contain an intrusive_mpsc_hook");
+
+public:
+    /// <summary>
+    /// Sends the message to the actor. Can be called from any number of threads concurrently.
+    /// If the activation of the idle actor cannot be allocated or queued,
+    /// the calling thread processes the pending messages itself, so no message is left behind.
+    /// </summary>
+    /// <param name="message">
+    /// - A pointer to the message, that is not queued to any mailbox.
+    /// The reference is transferred to the mailbox. An empty pointer is ignored.
+    /// </param>
+    inline void send(intrusive_ptr<Message> message)
+    {
+        if (!message)
+        {
+            return;
+        }
+
+        // The count is never less than the number of queued messages
+        auto pending = m_pending.fetch_add(1, std::memory_order_acq_rel);
+        m_mailbox.push(std::move(message));
+        if (pending == 0 && !activate(false))
+        {
+            process();
+        }
+    }
+
+protected:
+    /// <summary>
+    /// Provides a new instance of the base class <see cref="actor"/>
+    /// </summary>
+    /// <param name="scheduler">
+    /// - The scheduler, that runs the actor. It must outlive the pending messages of the actor.
+    /// </param>
+    /// <param name="batch_size">
+    /// - The maximum number of messages processed by one activation,
+    /// before the actor yields the worker to the other tasks
+    /// </param>
+    explicit actor(task_scheduler& scheduler, size_t batch_size = 64) noexcept
+        : m_scheduler(&scheduler)
+        , m_batch_size(batch_size != 0 ? batch_size : 1) { }
+
+    ~actor() override = default;
+
+private:
+    /// <summary>
+    /// Queues a new activation of the actor to the scheduler
+    /// </summary>
+    /// <returns>
+    /// False, if the activation cannot be allocated or queued
+    /// </returns>
+    inline bool activate(bool yield) noexcept
+    {
+        try
+        {
+            auto self = intrusive_ptr<Derived>(static_cast<Derived*>(this));
+            auto activation = make_task([self = std::move(self)] { self->process(); });
+            if (yield)
+            {
+                m_scheduler->post(std::move(activation));
+            }
+            else
+            {
+                m_scheduler->submit(std::move(activation));
+            }
+            return true;
+        }
+        catch (...)
+        {
+            return false;
+        }
+    }
+
+    /// <summary>
+    /// Processes a batch of messages, then either yields to the other tasks,
+    /// if there are pending messages left, or goes idle until the next send.
+    /// If the yield cannot be queued, the current activation keeps processing.
+    /// </summary>
+    inline void process() noexcept
+    {
+        static_assert(noexcept(std::declval<Derived&>().receive(std::declval<intrusive_ptr<Message>>())),
+            "The receive function of the actor must be noexcept");
+
+        while (true)
+        {
+            auto processed = m_mailbox.consume([this](intrusive_ptr<Message> message)
+            {
+                static_cast<Derived*>(this)->receive(std::move(message));
+            }, m_batch_size);
+
+            if (m_pending.fetch_sub(processed, std::memory_order_acq_rel) == processed || activate(true))
+            {
+                return;
+            }
+        }
+    }
+
+private:
+    intrusive_mpsc_queue<Message> m_mailbox;
+    std::atomic<size_t> m_pending { 0 };
+    task_scheduler* m_scheduler;
+    size_t m_batch_size;
+};
@@ -0,0 +1,443 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <new>
+#include <optional>
+#include <span>
+#include <utility>
+#include <vector>
+#include "intrusive_ptr.h"
+
+/// <summary>
+/// A fixed-capacity array of bytes stored in the same allocation as its header
+/// </summary>
+class byte_buffer final : public RefCountObject<byte_buffer>
+{
+    struct trailing_t { };
+
+public:
+    static void* operator new(size_t size, trailing_t, size_t extra)
+    {
+        return ::operator new(size + extra);
+    }
+
+    static void operator delete(void* ptr, trailing_t, size_t) noexcept
+    {
+        ::operator delete(ptr);
+    }
+
+    static void operator delete(void* ptr) noexcept
+    {
+        ::operator delete(ptr);
+    }
+
+    /// <summary>
+    /// Allocates a buffer with uninitialized bytes
+    /// </summary>
+    /// <returns>
+    /// A pointer holding the only reference to the buffer
+    /// </returns>
+    static byte_buffer* create(size_t capacity)
+    {
+        auto created = new (trailing_t { }, capacity) byte_buffer(capacity);
+        intrusive_ptr_add_ref(created);
+        return created;
+    }
+
+    inline std::byte* data() noexcept
+    {
+        return reinterpret_cast<std::byte*>(this + 1);
+    }
+
+    inline size_t capacity() const noexcept
+    {
+        return m_capacity;
+    }
+
+private:
+    explicit byte_buffer(size_t capacity) noexcept : m_capacity(capacity) { }
+
+private:
+    const size_t m_capacity;
+};
+
+/// <summary>
+/// A pool of equally sized buffers used by one thread for receiving data.
+/// The pool keeps a reference to each of its buffers, and a buffer becomes free again,
+/// when the slices of the received bytes, that may live on other threads, have released it.
+/// </summary>
+class byte_buffer_pool final
+{
+public:
+    /// <summary>
+    /// Provides an empty pool
+    /// </summary>
+    /// <param name="block_size">
+    /// - The capacity of each buffer
+    /// </param>
+    /// <param name="max_buffers">
+    /// - The number of the buffers kept by the pool, the rest of the buffers are not reused
+    /// </param>
+    explicit byte_buffer_pool(size_t block_size = 16384, size_t max_buffers = 64)
+        : m_block_size(block_size)
+        , m_max_buffers(max_buffers) { }
+
+    byte_buffer_pool(const byte_buffer_pool&) = delete;
+    byte_buffer_pool& operator=(const byte_buffer_pool&) = delete;
+
+    inline size_t block_size() const noexcept
+    {
+        return m_block_size;
+    }
+
+    /// <summary>
+    /// Returns the number of the buffers kept by the pool
+    /// </summary>
+    inline size_t size() const noexcept
+    {
+        return m_buffers.size();
+    }
+
+    /// <summary>
+    /// Provides a buffer, that no one else refers to, starting the search after the last provided one
+    /// </summary>
+    inline intrusive_ptr<byte_buffer> acquire()
+    {
+        auto count = m_buffers.size();
+        for (size_t i = 0; i < count; ++i)
+        {
+            auto index = m_next + i < count ? m_next + i : m_next + i - count;
+            if (m_buffers[index].use_count() == 1)
+            {
+                m_next = index + 1 < count ? index + 1 : 0;
+                return m_buffers[index];
+            }
+        }
+
+        auto created = intrusive_ptr<byte_buffer>(byte_buffer::create(m_block_size), false);
+        if (count < m_max_buffers)
+        {
+            m_buffers.push_back(created);
+        }
+        return created;
+    }
+
+private:
+    const size_t m_block_size;
+    const size_t m_max_buffers;
+    std::vector<intrusive_ptr<byte_buffer>> m_buffers;
+    size_t m_next { 0 };
+};
+
+class byte_builder;
+
+/// <summary>
+/// An immutable range of bytes of a shared <see cref="byte_buffer"/>.
+/// Slicing, splitting and copying a slice take O(1) and only change the reference count of the buffer.
+/// </summary>
+class byte_slice final
+{
+    friend class byte_builder;
+
+public:
+    byte_slice() noexcept = default;
+
+    /// <summary>
+    /// Provides a slice of the first bytes of the buffer
+    /// </summary>
+    inline byte_slice(intrusive_ptr<byte_buffer> buffer, size_t count) noexcept
+        : m_buffer(std::move(buffer))
+        , m_data(m_buffer->data())
+        , m_size(count) { }
+
+    /// <summary>
+    /// Copies the bytes into a new buffer
+    /// </summary>
+    static byte_slice copy_from(std::span<const std::byte> bytes)
+    {
+        auto buffer = intrusive_ptr<byte_buffer>(byte_buffer::create(bytes.size()), false);
+        auto data = buffer->data();
+        if (!bytes.empty())
+        {
+            std::memcpy(data, bytes.data(), bytes.size());
+        }
+        return byte_slice(std::move(buffer), data, bytes.size());
+    }
+
+    inline const std::byte* data() const noexcept
+    {
+        return m_data;
+    }
+
+    inline size_t size() const noexcept
+    {
+        return m_size;
+    }
+
+    inline bool empty() const noexcept
+    {
+        return m_size == 0;
+    }
+
+    inline std::byte operator[](size_t index) const noexcept
+    {
+        return m_data[index];
+    }
+
+    inline std::span<const std::byte> span() const noexcept
+    {
+        return std::span<const std::byte>(m_data, m_size);
+    }
+
+    inline operator std::span<const std::byte>() const noexcept
+    {
+        return span();
+    }
+
+    /// <summary>
+    /// Returns the number of the slices and the builders sharing the buffer
+    /// </summary>
+    inline uint32_t use_count() const noexcept
+    {
+        return m_buffer.use_count();
+    }
+
+    /// <summary>
+    /// Returns a slice of the part of the bytes sharing the buffer
+    /// </summary>
+    /// <param name="offset">
+    /// - The position of the first byte of the slice
+    /// </param>
+    /// <param name="count">
+    /// - The number of the bytes, that is limited by the end of the current slice
+    /// </param>
+    inline byte_slice slice(size_t offset, size_t count = SIZE_MAX) const
+    {
+        offset = std::min(offset, m_size);
+        return byte_slice(m_buffer, m_data + offset, std::min(count, m_size - offset));
+    }
+
+    /// <summary>
+    /// Removes the first bytes from the slice and returns them as a new slice
+    /// </summary>
+    inline byte_slice split_to(size_t count)
+    {
+        count = std::min(count, m_size);
+        auto front = byte_slice(m_buffer, m_data, count);
+        advance(count);
+        return front;
+    }
+
+    /// <summary>
+    /// Removes the bytes starting from the position and returns them as a new slice
+    /// </summary>
+    inline byte_slice split_off(size_t offset)
+    {
+        offset = std::min(offset, m_size);
+        auto back = byte_slice(m_buffer, m_data + offset, m_size - offset);
+        m_size = offset;
+        return back;
+    }
+
+    /// <summary>
+    /// Skips the first bytes of the slice
+    /// </summary>
+    inline void advance(size_t count) noexcept
+    {
+        count = std::min(count, m_size);
+        m_data += count;
+        m_size -= count;
+    }
+
+    /// <summary>
+    /// Shortens the slice to the specified number of the bytes
+    /// </summary>
+    inline void truncate(size_t count) noexcept
+    {
+        m_size = std::min(count, m_size);
+    }
+
+    /// <summary>
+    /// Turns the buffer back into a builder, if the slice is its only owner.
+    /// The slice becomes empty on success.
+    /// </summary>
+    /// <returns>
+    /// An empty builder reusing the whole capacity of the buffer, or nothing, if the buffer is shared
+    /// </returns>
+    inline std::optional<byte_builder> try_reclaim();
+
+    friend inline bool operator==(const byte_slice& left, const byte_slice& right) noexcept
+    {
+        return left.m_size == right.m_size && (left.m_size == 0 || std::memcmp(left.m_data, right.m_data, left.m_size) == 0);
+    }
+
+private:
+    inline byte_slice(intrusive_ptr<byte_buffer> buffer, const std::byte* data, size_t count) noexcept
+        : m_buffer(std::move(buffer))
+        , m_data(data)
+        , m_size(count) { }
+
+private:
+    intrusive_ptr<byte_buffer> m_buffer;
+    const std::byte* m_data { nullptr };
+    size_t m_size { 0 };
+};
+
+/// <summary>
+/// A growable sequence of bytes written into a <see cref="byte_buffer"/>.
+/// Freezing turns the written bytes into a <see cref="byte_slice"/> without copying, and the builder
+/// keeps writing into the rest of the same buffer. When all slices of the buffer are released,
+/// the builder reuses the buffer from its beginning instead of allocating a new one.
+/// </summary>
+class byte_builder final
+{
+    friend class byte_slice;
+
+    static constexpr size_t min_capacity = 64;
+
+    struct reclaim_t { };
+
+public:
+    byte_builder() noexcept = default;
+
+    explicit byte_builder(size_t capacity)
+    {
+        if (capacity != 0)
+        {
+            m_buffer = intrusive_ptr<byte_buffer>(byte_buffer::create(capacity), false);
+        }
+    }
+
+    byte_builder(byte_builder&&) noexcept = default;
+    byte_builder& operator=(byte_builder&&) noexcept = default;
+
+    byte_builder(const byte_builder&) = delete;
+    byte_builder& operator=(const byte_builder&) = delete;
+
+    inline std::byte* data() noexcept
+    {
+        return m_buffer ? m_buffer->data() + m_offset : nullptr;
+    }
+
+    inline size_t size() const noexcept
+    {
+        return m_size;
+    }
+
+    inline bool empty() const noexcept
+    {
+        return m_size == 0;
+    }
+
+    /// <summary>
+    /// Returns the number of the bytes, that can be written without growing
+    /// </summary>
+    inline size_t capacity() const noexcept
+    {
+        return m_buffer ? m_buffer->capacity() - m_offset : 0;
+    }
+
+    /// <summary>
+    /// Ensures the space for the additional bytes. The written bytes are moved to the beginning of the buffer,
+    /// if no slice refers to it any more, or to a new buffer, if the space is still insufficient.
+    /// </summary>
+    inline void reserve(size_t additional)
+    {
+        auto required = m_size + additional;
+        if (required <= capacity())
+        {
+            return;
+        }
+        if (m_buffer && m_buffer.use_count() == 1 && required <= m_buffer->capacity())
+        {
+            std::memmove(m_buffer->data(), data(), m_size);
+            m_offset = 0;
+            return;
+        }
+
+        auto grown = intrusive_ptr<byte_buffer>(byte_buffer::create(std::max({ required, min_capacity, capacity() * 2 })), false);
+        if (m_size != 0)
+        {
+            std::memcpy(grown->data(), data(), m_size);
+        }
+        m_buffer = std::move(grown);
+        m_offset = 0;
+    }
+
+    /// <summary>
+    /// Provides the space for writing the bytes directly, for example by receiving into it.
+    /// The written bytes are added by <see cref="commit"/>.
+    /// </summary>
+    inline std::span<std::byte> prepare(size_t count)
+    {
+        reserve(count);
+        return std::span<std::byte>(data() + m_size, count);
+    }
+
+    /// <summary>
+    /// Adds the bytes written into the space provided by <see cref="prepare"/>
+    /// </summary>
+    inline void commit(size_t count) noexcept
+    {
+        m_size += count;
+    }
+
+    inline void append(std::span<const std::byte> bytes)
+    {
+        if (!bytes.empty())
+        {
+            std::memcpy(prepare(bytes.size()).data(), bytes.data(), bytes.size());
+            commit(bytes.size());
+        }
+    }
+
+    inline void push_back(std::byte value)
+    {
+        prepare(1)[0] = value;
+        commit(1);
+    }
+
+    inline void clear() noexcept
+    {
+        m_size = 0;
+    }
+
+    /// <summary>
+    /// Moves the written bytes into an immutable slice sharing the buffer.
+    /// The builder becomes empty and keeps the rest of the capacity.
+    /// </summary>
+    inline byte_slice freeze()
+    {
+        if (m_size == 0)
+        {
+            return byte_slice();
+        }
+        auto frozen = byte_slice(m_buffer, data(), m_size);
+        m_offset += m_size;
+        m_size = 0;
+        return frozen;
+    }
+
+private:
+    byte_builder(reclaim_t, intrusive_ptr<byte_buffer> buffer) noexcept : m_buffer(std::move(buffer)) { }
+
+private:
+    intrusive_ptr<byte_buffer> m_buffer;
+    // The beginning of the bytes, that have not been frozen yet
+    size_t m_offset { 0 };
+    size_t m_size { 0 };
+};
+
+inline std::optional<byte_builder> byte_slice::try_reclaim()
+{
+    if (!m_buffer || m_buffer.use_count() != 1)
+    {
+        return std::nullopt;
+    }
+    m_data = nullptr;
+    m_size = 0;
+    return byte_builder(byte_builder::reclaim_t { }, std::move(m_buffer));
+}
@@ -0,0 +1,344 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <deque>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <system_error>
+#include <utility>
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <winsock2.h>
+#pragma comment(lib, "ws2_32.lib")
+#else
+#include <errno.h>
+#include <sys/uio.h>
+#endif
+#include "byte_buffer.h"
+
+/// <summary>
+/// A sequence of bytes made of shared <see cref="byte_slice"/> objects, that is appended, prepended,
+/// split and consumed without copying the bytes. The slices are exported directly as the vectors
+/// of the gathering writes, and the scattering reads fill the buffers of a <see cref="byte_buffer_pool"/>,
+/// so the data may be forwarded from one descriptor to another without any copy of the payload.
+/// The consumed slices are released at once, so their buffers return to the pool.
+/// </summary>
+class byte_chain final
+{
+public:
+#if defined(_WIN32)
+    using io_vector = WSABUF;
+    using native_handle_type = SOCKET;
+#else
+    using io_vector = iovec;
+    using native_handle_type = int;
+#endif
+
+    // The number of the vectors passed to a single system call
+    static constexpr size_t io_batch = 64;
+
+    using const_iterator = std::deque<byte_slice>::const_iterator;
+
+    byte_chain() noexcept = default;
+
+    byte_chain(byte_chain&& other) noexcept
+        : m_slices(std::move(other.m_slices))
+        , m_size(std::exchange(other.m_size, 0)) { }
+
+    byte_chain& operator=(byte_chain&& other) noexcept
+    {
+        m_slices = std::move(other.m_slices);
+        m_size = std::exchange(other.m_size, 0);
+        return *this;
+    }
+
+    byte_chain(const byte_chain&) = default;
+    byte_chain& operator=(const byte_chain&) = default;
+
+    /// <summary>
+    /// Returns the total number of the bytes
+    /// </summary>
+    inline size_t size() const noexcept
+    {
+        return m_size;
+    }
+
+    inline bool empty() const noexcept
+    {
+        return m_size == 0;
+    }
+
+    inline size_t slice_count() const noexcept
+    {
+        return m_slices.size();
+    }
+
+    inline const_iterator begin() const noexcept
+    {
+        return m_slices.begin();
+    }
+
+    inline const_iterator end() const noexcept
+    {
+        return m_slices.end();
+    }
+
+    inline void append(byte_slice slice)
+    {
+        if (!slice.empty())
+        {
+            m_size += slice.size();
+            m_slices.push_back(std::move(slice));
+        }
+    }
+
+    /// <summary>
+    /// Moves the slices of the other chain to the end of the current one
+    /// </summary>
+    inline void append(byte_chain&& other)
+    {
+        for (auto& slice : other.m_slices)
+        {
+            m_slices.push_back(std::move(slice));
+        }
+        m_size += std::exchange(other.m_size, 0);
+        other.m_slices.clear();
+    }
+
+    inline void prepend(byte_slice slice)
+    {
+        if (!slice.empty())
+        {
+            m_size += slice.size();
+            m_slices.push_front(std::move(slice));
+        }
+    }
+
+    /// <summary>
+    /// Removes the first bytes, releasing the slices, that have been consumed entirely
+    /// </summary>
+    inline void consume(size_t count) noexcept
+    {
+        count = std::min(count, m_size);
+        m_size -= count;
+        while (count != 0)
+        {
+            auto& front = m_slices.front();
+            if (front.size() > count)
+            {
+                front.advance(count);
+                return;
+            }
+            count -= front.size();
+            m_slices.pop_front();
+        }
+    }
+
+    /// <summary>
+    /// Removes the first bytes from the chain and returns them as a new chain.
+    /// Only the slice at the boundary is split, the rest are moved.
+    /// </summary>
+    inline byte_chain split_to(size_t count)
+    {
+        count = std::min(count, m_size);
+        auto front = byte_chain();
+        while (count != 0)
+        {
+            auto& first = m_slices.front();
+            if (first.size() > count)
+            {
+                front.append(first.split_to(count));
+                m_size -= count;
+                break;
+            }
+            count -= first.size();
+            m_size -= first.size();
+            front.append(std::move(first));
+            m_slices.pop_front();
+        }
+        return front;
+    }
+
+    /// <summary>
+    /// Copies the first bytes to the destination, for example to parse a header spanning several slices
+    /// </summary>
+    /// <returns>
+    /// The number of the copied bytes
+    /// </returns>
+    inline size_t copy_to(std::span<std::byte> destination) const noexcept
+    {
+        size_t copied = 0;
+        for (auto& slice : m_slices)
+        {
+            if (copied == destination.size())
+            {
+                break;
+            }
+            auto count = std::min(slice.size(), destination.size() - copied);
+            std::memcpy(destination.data() + copied, slice.data(), count);
+            copied += count;
+        }
+        return copied;
+    }
+
+    /// <summary>
+    /// Describes the first slices by the vectors of a gathering write
+    /// </summary>
+    /// <returns>
+    /// The number of the filled vectors
+    /// </returns>
+    inline size_t gather(std::span<io_vector> vectors) const noexcept
+    {
+        auto count = std::min(vectors.size(), m_slices.size());
+        for (size_t i = 0; i < count; ++i)
+        {
+            vectors[i] = make_io_vector(const_cast<std::byte*>(m_slices[i].data()), m_slices[i].size());
+        }
+        return count;
+    }
+
+    /// <summary>
+    /// Writes the first slices by a single gathering write and consumes the written bytes
+    /// </summary>
+    /// <param name="handle">
+    /// - A descriptor on POSIX or a socket on Windows
+    /// </param>
+    /// <returns>
+    /// The number of the written bytes, or nothing, if the write would block.
+    /// Throws <see cref="std::system_error"/> on other failures.
+    /// </returns>
+    inline std::optional<size_t> write_to(native_handle_type handle)
+    {
+        io_vector vectors[io_batch];
+        auto count = gather(vectors);
+        if (count == 0)
+        {
+            return 0;
+        }
+#if defined(_WIN32)
+        DWORD written = 0;
+        if (WSASend(handle, vectors, static_cast<DWORD>(count), &written, 0, nullptr, nullptr) == SOCKET_ERROR)
+        {
+            auto error = WSAGetLastError();
+            return failure(error, error == WSAEWOULDBLOCK);
+        }
+#else
+        ssize_t written;
+        do
+        {
+            written = ::writev(handle, vectors, static_cast<int>(count));
+        }
+        while (written < 0 && errno == EINTR);
+        if (written < 0)
+        {
+            auto error = errno;
+            return failure(error, error == EAGAIN || error == EWOULDBLOCK);
+        }
+#endif
+        consume(static_cast<size_t>(written));
+        return static_cast<size_t>(written);
+    }
+
+    /// <summary>
+    /// Receives the bytes by a single scattering read into the buffers of the pool
+    /// and appends the filled parts of the buffers to the chain
+    /// </summary>
+    /// <param name="handle">
+    /// - A descriptor on POSIX or a socket on Windows
+    /// </param>
+    /// <param name="pool">
+    /// - The pool of the buffers, whose unfilled ones return to it at once
+    /// </param>
+    /// <param name="max_size">
+    /// - The maximal number of the bytes to receive, that must not be zero
+    /// </param>
+    /// <returns>
+    /// The number of the received bytes, that is zero at the end of the stream,
+    /// or nothing, if the read would block. Throws <see cref="std::system_error"/> on other failures.
+    /// </returns>
+    /// <exception cref="std::invalid_argument">
+    /// Thrown, if the maximal size is zero, since the result of the read could not be told
+    /// from the end of the stream
+    /// </exception>
+    inline std::optional<size_t> read_from(native_handle_type handle, byte_buffer_pool& pool, size_t max_size)
+    {
+        if (max_size == 0)
+        {
+            throw std::invalid_argument("The maximal size of the read must not be zero");
+        }
+
+        auto block_size = pool.block_size();
+        // The rounded up division must not overflow for the sizes close to the maximum
+        auto count = std::min(io_batch, max_size / block_size + (max_size % block_size != 0 ? 1 : 0));
+        intrusive_ptr<byte_buffer> buffers[io_batch];
+        io_vector vectors[io_batch];
+        for (size_t i = 0; i < count; ++i)
+        {
+            buffers[i] = pool.acquire();
+            vectors[i] = make_io_vector(buffers[i]->data(), std::min(block_size, max_size - i * block_size));
+        }
+
+#if defined(_WIN32)
+        DWORD received = 0;
+        DWORD flags = 0;
+        if (WSARecv(handle, vectors, static_cast<DWORD>(count), &received, &flags, nullptr, nullptr) == SOCKET_ERROR)
+        {
+            auto error = WSAGetLastError();
+            return failure(error, error == WSAEWOULDBLOCK);
+        }
+#else
+        ssize_t received;
+        do
+        {
+            received = ::readv(handle, vectors, static_cast<int>(count));
+        }
+        while (received < 0 && errno == EINTR);
+        if (received < 0)
+        {
+            auto error = errno;
+            return failure(error, error == EAGAIN || error == EWOULDBLOCK);
+        }
+#endif
+
+        auto remaining = static_cast<size_t>(received);
+        for (size_t i = 0; remaining != 0; ++i)
+        {
+            auto filled = std::min(remaining, block_size);
+            append(byte_slice(std::move(buffers[i]), filled));
+            remaining -= filled;
+        }
+        return static_cast<size_t>(received);
+    }
+
+private:
+    static inline io_vector make_io_vector(std::byte* data, size_t size) noexcept
+    {
+#if defined(_WIN32)
+        return io_vector { static_cast<ULONG>(size), reinterpret_cast<CHAR*>(data) };
+#else
+        return io_vector { data, size };
+#endif
+    }
+
+    /// <summary>
+    /// Reports a blocked operation by nothing and throws on other errors
+    /// </summary>
+    static inline std::optional<size_t> failure(int error, bool would_block)
+    {
+        if (would_block)
+        {
+            return std::nullopt;
+        }
+        throw std::system_error(error, std::system_category());
+    }
+
+private:
+    std::deque<byte_slice> m_slices;
+    size_t m_size { 0 };
+};
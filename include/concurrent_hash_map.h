@@ -0,0 +1,601 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <utility>
+#include <vector>
+#include "epoch_domain.h"
+#include "intrusive_ptr.h"
+
+/// <summary>
+/// A concurrent hash map of keys to intrusive pointers.
+/// The lookups are lock-free: they pin the epoch by <see cref="epoch_domain::guard"/>
+/// and traverse the chains of entries without changing any reference counts, so a value found
+/// there stays alive and may be upgraded to a strong reference even while it is being erased.
+/// The writers are serialized by the mutex of one of the shards selected by the hash.
+/// Each shard grows its table incrementally: the writers move a few buckets of the previous table
+/// at a time, while the lookups search the bucket of the table that currently holds the key.
+/// </summary>
+/// <typeparam name="Key">
+/// The type of the keys
+/// </typeparam>
+/// <typeparam name="T">
+/// The type of the values derived from <see cref="RefCountObject"/>
+/// </typeparam>
+/// <typeparam name="Hash">
+/// The hash function of the keys
+/// </typeparam>
+/// <typeparam name="KeyEqual">
+/// The equality of the keys
+/// </typeparam>
+template<class Key, intrusive_counter_type T, class Hash = std::hash<Key>, class KeyEqual = std::equal_to<Key>>
+class concurrent_hash_map final
+{
+    static constexpr size_t initial_buckets = 16;
+    static constexpr size_t migration_step = 4;
+
+    // The bucket of the previous table, whose entries have been moved to the current one
+    static constexpr uintptr_t moved_bit = 1;
+
+    /// <summary>
+    /// An entry of a chain, that owns a reference to its value.
+    /// The constructor copies the key, so it may throw.
+    /// </summary>
+    class entry final : public RefCountObject<entry>
+    {
+    public:
+        inline entry(const Key& key, uint64_t hash, T* value, entry* next)
+            : m_key(key)
+            , m_hash(hash)
+            , m_value(value)
+            , m_next(next) { }
+
+        ~entry() override
+        {
+            if (auto value = m_value.load(std::memory_order_relaxed))
+            {
+                intrusive_ptr_release(value);
+            }
+        }
+
+        const Key m_key;
+        const uint64_t m_hash;
+        std::atomic<T*> m_value;
+        std::atomic<entry*> m_next;
+    };
+
+    using bucket = std::atomic<uintptr_t>;
+
+    /// <summary>
+    /// An array of buckets stored after the table
+    /// </summary>
+    class table final : public RefCountObject<table>
+    {
+        struct trailing_t { };
+
+    public:
+        static void* operator new(size_t size, trailing_t, size_t count)
+        {
+            return ::operator new(size + count * sizeof(bucket));
+        }
+
+        static void operator delete(void* ptr, trailing_t, size_t) noexcept
+        {
+            ::operator delete(ptr);
+        }
+
+        static void operator delete(void* ptr) noexcept
+        {
+            ::operator delete(ptr);
+        }
+
+        static table* create(size_t count)
+        {
+            auto created = new (trailing_t { }, count) table(count);
+            intrusive_ptr_add_ref(created);
+            return created;
+        }
+
+        ~table() override
+        {
+            std::destroy_n(buckets(), m_mask + 1);
+        }
+
+        inline bucket* buckets() noexcept
+        {
+            return reinterpret_cast<bucket*>(this + 1);
+        }
+
+        inline bucket& at(uint64_t hash) noexcept
+        {
+            return buckets()[hash & m_mask];
+        }
+
+        const size_t m_mask;
+        std::atomic<table*> m_previous { nullptr };
+
+    private:
+        explicit table(size_t count) noexcept : m_mask(count - 1)
+        {
+            std::uninitialized_value_construct_n(buckets(), count);
+        }
+    };
+
+    static inline entry* pointer(uintptr_t value) noexcept
+    {
+        return reinterpret_cast<entry*>(value & ~moved_bit);
+    }
+
+    static inline bool is_moved(uintptr_t value) noexcept
+    {
+        return (value & moved_bit) != 0;
+    }
+
+    /// <summary>
+    /// The objects unlinked by a writer, that are retired when the writer leaves the scope.
+    /// It is declared before the lock of the shard, so the retirement runs after the lock is released:
+    /// the retirement may release the values, whose destructors may change the map.
+    /// </summary>
+    struct retired_objects
+    {
+        retired_objects() noexcept = default;
+
+        retired_objects(const retired_objects&) = delete;
+        retired_objects& operator=(const retired_objects&) = delete;
+
+        ~retired_objects()
+        {
+            auto& domain = epoch_domain::instance();
+            for (auto item : m_entries)
+            {
+                domain.retire(item);
+            }
+            if (m_value != nullptr)
+            {
+                domain.retire(m_value);
+            }
+            if (m_table != nullptr)
+            {
+                domain.retire(m_table);
+            }
+        }
+
+        std::vector<entry*> m_entries;
+        T* m_value { nullptr };
+        table* m_table { nullptr };
+    };
+
+    struct alignas(64) shard
+    {
+        std::mutex m_mutex;
+        std::atomic<table*> m_table { table::create(initial_buckets) };
+        std::atomic<size_t> m_count { 0 };
+        size_t m_migrated { 0 };
+    };
+
+public:
+    /// <summary>
+    /// Provides a new empty instance of <see cref="concurrent_hash_map"/>
+    /// </summary>
+    /// <param name="shard_count">
+    /// - The number of independently locked shards, that is rounded up to a power of two
+    /// </param>
+    explicit concurrent_hash_map(size_t shard_count = 16)
+    {
+        while ((size_t(1) << m_shard_bits) < shard_count)
+        {
+            ++m_shard_bits;
+        }
+        m_shards = std::make_unique<shard[]>(size_t(1) << m_shard_bits);
+    }
+
+    concurrent_hash_map(const concurrent_hash_map&) = delete;
+    concurrent_hash_map& operator=(const concurrent_hash_map&) = delete;
+
+    /// <summary>
+    /// Destroys the map, that must not be accessed concurrently
+    /// </summary>
+    ~concurrent_hash_map()
+    {
+        for (size_t i = 0; i < shard_count(); ++i)
+        {
+            auto current = m_shards[i].m_table.load(std::memory_order_acquire);
+            if (auto previous = current->m_previous.load(std::memory_order_relaxed))
+            {
+                release_table(previous);
+            }
+            release_table(current);
+        }
+    }
+
+    /// <summary>
+    /// Returns the number of entries, that is approximate while the map is changed
+    /// </summary>
+    inline size_t size() const noexcept
+    {
+        auto count = size_t(0);
+        for (size_t i = 0; i < shard_count(); ++i)
+        {
+            count += m_shards[i].m_count.load(std::memory_order_relaxed);
+        }
+        return count;
+    }
+
+    inline bool empty() const noexcept
+    {
+        return size() == 0;
+    }
+
+    /// <summary>
+    /// Finds the value by the key without locking
+    /// </summary>
+    /// <returns>
+    /// A strong reference to the value or an empty pointer, if the key is missing
+    /// </returns>
+    inline intrusive_ptr<T> find(const Key& key) const
+    {
+        auto guard = epoch_domain::instance().pin();
+        auto found = lookup(key);
+        return intrusive_ptr<T>(found != nullptr ? found->m_value.load(std::memory_order_acquire) : nullptr);
+    }
+
+    inline bool contains(const Key& key) const
+    {
+        auto guard = epoch_domain::instance().pin();
+        return lookup(key) != nullptr;
+    }
+
+    /// <summary>
+    /// Calls the handler with the value found by the key without locking
+    /// and without changing the reference count of the value
+    /// </summary>
+    /// <param name="key">
+    /// - The key of the value
+    /// </param>
+    /// <param name="handler">
+    /// - The function called with the borrowed value, that must not keep a reference to it
+    /// </param>
+    /// <returns>
+    /// Returns <see langword="true"/>, if the key is found,
+    /// otherwise it returns <see langword="false"/>.
+    /// </returns>
+    template<class Handler>
+    inline bool visit(const Key& key, Handler&& handler) const
+    {
+        auto guard = epoch_domain::instance().pin();
+        auto found = lookup(key);
+        if (found == nullptr)
+        {
+            return false;
+        }
+        handler(*found->m_value.load(std::memory_order_acquire));
+        return true;
+    }
+
+    /// <summary>
+    /// Calls the handler for each entry. The writers of a shard are blocked while it is visited.
+    /// </summary>
+    /// <param name="handler">
+    /// - The function called with the key and the borrowed value of each entry
+    /// </param>
+    template<class Handler>
+    void for_each(Handler&& handler) const
+    {
+        for (size_t i = 0; i < shard_count(); ++i)
+        {
+            auto& current = m_shards[i];
+            auto lock = std::lock_guard(current.m_mutex);
+            auto newest = current.m_table.load(std::memory_order_relaxed);
+            for (auto visited : { newest->m_previous.load(std::memory_order_relaxed), newest })
+            {
+                for (size_t b = 0; visited != nullptr && b <= visited->m_mask; ++b)
+                {
+                    auto head = visited->buckets()[b].load(std::memory_order_relaxed);
+                    for (auto item = pointer(head); item != nullptr; item = item->m_next.load(std::memory_order_relaxed))
+                    {
+                        handler(item->m_key, *item->m_value.load(std::memory_order_relaxed));
+                    }
+                }
+            }
+        }
+    }
+
+    /// <summary>
+    /// Inserts the value, if the key is missing. An empty pointer is never stored.
+    /// </summary>
+    /// <returns>
+    /// Returns <see langword="true"/>, if the value was inserted,
+    /// otherwise it returns <see langword="false"/>.
+    /// </returns>
+    inline bool insert(const Key& key, intrusive_ptr<T> value)
+    {
+        return update(key, std::move(value), false);
+    }
+
+    /// <summary>
+    /// Inserts the value or replaces the value of the existing key.
+    /// The replaced value is released after the concurrent lookups have finished.
+    /// An empty pointer is never stored, so the map is left unchanged.
+    /// </summary>
+    /// <returns>
+    /// Returns <see langword="true"/>, if the value was inserted,
+    /// otherwise it returns <see langword="false"/>.
+    /// </returns>
+    inline bool insert_or_assign(const Key& key, intrusive_ptr<T> value)
+    {
+        return update(key, std::move(value), true);
+    }
+
+    /// <summary>
+    /// Removes the entry by the key
+    /// </summary>
+    /// <returns>
+    /// The removed value or an empty pointer, if the key is missing
+    /// </returns>
+    intrusive_ptr<T> erase(const Key& key)
+    {
+        auto hash = mix(m_hash(key));
+        auto& current = shard_of(hash);
+        auto retired = retired_objects();
+        auto lock = std::lock_guard(current.m_mutex);
+        auto& head = prepare(current, hash, retired);
+
+        auto item = pointer(head.load(std::memory_order_relaxed));
+        entry* previous = nullptr;
+        while (item != nullptr && !(item->m_hash == hash && m_equal(item->m_key, key)))
+        {
+            previous = item;
+            item = item->m_next.load(std::memory_order_relaxed);
+        }
+
+        if (item == nullptr)
+        {
+            return intrusive_ptr<T>();
+        }
+
+        // The only allocation is made before the entry is unlinked
+        retired.m_entries.reserve(retired.m_entries.size() + 1);
+        auto next = item->m_next.load(std::memory_order_relaxed);
+        if (previous != nullptr)
+        {
+            previous->m_next.store(next, std::memory_order_release);
+        }
+        else
+        {
+            head.store(reinterpret_cast<uintptr_t>(next), std::memory_order_release);
+        }
+        current.m_count.fetch_sub(1, std::memory_order_relaxed);
+
+        auto value = intrusive_ptr<T>(item->m_value.load(std::memory_order_relaxed));
+        retired.m_entries.push_back(item);
+        return value;
+    }
+
+private:
+    inline size_t shard_count() const noexcept
+    {
+        return size_t(1) << m_shard_bits;
+    }
+
+    /// <summary>
+    /// Spreads the bits of the hash, so the high bits select the shard and the low bits select the bucket
+    /// </summary>
+    static inline uint64_t mix(size_t hash) noexcept
+    {
+        auto value = static_cast<uint64_t>(hash);
+        value ^= value >> 33;
+        value *= 0xff51afd7ed558ccdull;
+        value ^= value >> 33;
+        return value;
+    }
+
+    inline shard& shard_of(uint64_t hash) const noexcept
+    {
+        return m_shards[m_shard_bits != 0 ? hash >> (64 - m_shard_bits) : 0];
+    }
+
+    /// <summary>
+    /// Finds the entry in the bucket of the table, that currently holds the key
+    /// </summary>
+    entry* lookup(const Key& key) const
+    {
+        auto hash = mix(m_hash(key));
+        auto& current = shard_of(hash);
+        while (true)
+        {
+            auto newest = current.m_table.load(std::memory_order_acquire);
+            auto head = uintptr_t(moved_bit);
+            if (auto previous = newest->m_previous.load(std::memory_order_acquire))
+            {
+                head = previous->at(hash).load(std::memory_order_acquire);
+            }
+            if (is_moved(head))
+            {
+                head = newest->at(hash).load(std::memory_order_acquire);
+            }
+
+            // The table has been replaced by a newer one, since it was loaded
+            if (is_moved(head))
+            {
+                continue;
+            }
+
+            for (auto item = pointer(head); item != nullptr; item = item->m_next.load(std::memory_order_acquire))
+            {
+                if (item->m_hash == hash && m_equal(item->m_key, key))
+                {
+                    return item;
+                }
+            }
+            return nullptr;
+        }
+    }
+
+    bool update(const Key& key, intrusive_ptr<T> value, bool assign)
+    {
+        if (!value)
+        {
+            return false;
+        }
+
+        auto hash = mix(m_hash(key));
+        auto& current = shard_of(hash);
+        auto retired = retired_objects();
+        auto lock = std::lock_guard(current.m_mutex);
+        auto& head = prepare(current, hash, retired);
+
+        for (auto item = pointer(head.load(std::memory_order_relaxed)); item != nullptr;
+            item = item->m_next.load(std::memory_order_relaxed))
+        {
+            if (item->m_hash == hash && m_equal(item->m_key, key))
+            {
+                if (assign)
+                {
+                    retired.m_value = item->m_value.exchange(value.detach(), std::memory_order_acq_rel);
+                }
+                return false;
+            }
+        }
+
+        // The value is detached only after the constructor, that copies the key, has succeeded
+        auto created = new entry(key, hash, value.get(), pointer(head.load(std::memory_order_relaxed)));
+        value.detach();
+        intrusive_ptr_add_ref(created);
+        head.store(reinterpret_cast<uintptr_t>(created), std::memory_order_release);
+
+        auto count = current.m_count.fetch_add(1, std::memory_order_relaxed) + 1;
+        auto newest = current.m_table.load(std::memory_order_relaxed);
+        if (count > newest->m_mask + 1 && newest->m_previous.load(std::memory_order_relaxed) == nullptr)
+        {
+            try
+            {
+                grow(current);
+            }
+            catch (const std::bad_alloc&)
+            {
+                // The entry is inserted already, the shard keeps its table and the next insert grows it
+            }
+        }
+        return true;
+    }
+
+    /// <summary>
+    /// Continues the migration of the shard and provides the bucket of the current table for the hash
+    /// </summary>
+    bucket& prepare(shard& current, uint64_t hash, retired_objects& retired)
+    {
+        auto newest = current.m_table.load(std::memory_order_relaxed);
+        if (auto previous = newest->m_previous.load(std::memory_order_relaxed))
+        {
+            migrate_bucket(previous, newest, hash & previous->m_mask, retired);
+            for (auto i = size_t(0); i < migration_step && current.m_migrated <= previous->m_mask; ++i)
+            {
+                migrate_bucket(previous, newest, current.m_migrated++, retired);
+            }
+
+            if (current.m_migrated > previous->m_mask)
+            {
+                newest->m_previous.store(nullptr, std::memory_order_release);
+                retired.m_table = previous;
+            }
+        }
+        return newest->at(hash);
+    }
+
+    void grow(shard& current)
+    {
+        auto previous = current.m_table.load(std::memory_order_relaxed);
+        auto created = table::create((previous->m_mask + 1) * 2);
+        created->m_previous.store(previous, std::memory_order_relaxed);
+        current.m_migrated = 0;
+        current.m_table.store(created, std::memory_order_release);
+    }
+
+    /// <summary>
+    /// Copies the entries of the bucket of the previous table to the current one
+    /// and retires them, since the lookups that have started earlier may still traverse them.
+    /// All copies are made before any of them is published, so an exception of an allocation
+    /// or of a copy of a key leaves both tables unchanged.
+    /// </summary>
+    static void migrate_bucket(table* previous, table* newest, size_t index, retired_objects& retired)
+    {
+        auto& source = previous->buckets()[index];
+        auto head = source.load(std::memory_order_relaxed);
+        if (is_moved(head))
+        {
+            return;
+        }
+
+        auto count = size_t(0);
+        for (auto item = pointer(head); item != nullptr; item = item->m_next.load(std::memory_order_relaxed))
+        {
+            ++count;
+        }
+        retired.m_entries.reserve(retired.m_entries.size() + count);
+
+        // The copies are chained privately and do not own their values until they are published
+        entry* copies = nullptr;
+        try
+        {
+            for (auto item = pointer(head); item != nullptr; item = item->m_next.load(std::memory_order_relaxed))
+            {
+                copies = new entry(item->m_key, item->m_hash, item->m_value.load(std::memory_order_relaxed), copies);
+            }
+        }
+        catch (...)
+        {
+            while (copies != nullptr)
+            {
+                auto next = copies->m_next.load(std::memory_order_relaxed);
+                copies->m_value.store(nullptr, std::memory_order_relaxed);
+                delete copies;
+                copies = next;
+            }
+            throw;
+        }
+
+        while (copies != nullptr)
+        {
+            auto next = copies->m_next.load(std::memory_order_relaxed);
+            auto& target = newest->at(copies->m_hash);
+            intrusive_ptr_add_ref(copies->m_value.load(std::memory_order_relaxed));
+            intrusive_ptr_add_ref(copies);
+            copies->m_next.store(pointer(target.load(std::memory_order_relaxed)), std::memory_order_relaxed);
+            target.store(reinterpret_cast<uintptr_t>(copies), std::memory_order_release);
+            copies = next;
+        }
+        source.store(moved_bit, std::memory_order_release);
+
+        for (auto item = pointer(head); item != nullptr;)
+        {
+            auto next = item->m_next.load(std::memory_order_relaxed);
+            retired.m_entries.push_back(item);
+            item = next;
+        }
+    }
+
+    static void release_table(table* released)
+    {
+        for (size_t b = 0; b <= released->m_mask; ++b)
+        {
+            auto item = pointer(released->buckets()[b].load(std::memory_order_relaxed));
+            while (item != nullptr)
+            {
+                auto next = item->m_next.load(std::memory_order_relaxed);
+                intrusive_ptr_release(item);
+                item = next;
+            }
+        }
+        intrusive_ptr_release(released);
+    }
+
+private:
+    std::unique_ptr<shard[]> m_shards;
+    unsigned m_shard_bits { 0 };
+    [[no_unique_address]] Hash m_hash;
+    [[no_unique_address]] KeyEqual m_equal;
+};
@@ -0,0 +1,557 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <optional>
+#include <utility>
+#include "epoch_domain.h"
+#include "intrusive_ptr.h"
+
+/// <summary>
+/// A lock-free ordered map of keys to intrusive pointers, based on a skip list.
+/// The nodes of the list are objects derived from <see cref="RefCountObject"/>,
+/// whose links carry a mark of the logical deletion in the lowest bit.
+/// Readers traverse the list under <see cref="epoch_domain::guard"/> without changing
+/// any reference counts, and an unlinked node is released through
+/// <see cref="intrusive_ptr_release"/> by <see cref="epoch_domain"/> after the readers have left.
+/// </summary>
+/// <remarks>
+/// The nodes removed by a thread are released at the end of its next operation on any structure
+/// using the domain, after the readers pinned at the removal have left, or on <see cref="flush"/>.
+/// </remarks>
+/// <typeparam name="Key">
+/// The type of the keys
+/// </typeparam>
+/// <typeparam name="T">
+/// The type of the values derived from <see cref="RefCountObject"/>
+/// </typeparam>
+/// <typeparam name="Compare">
+/// The strict weak ordering of the keys
+/// </typeparam>
+template<class Key, intrusive_counter_type T, class Compare = std::less<Key>>
+class concurrent_skip_list final
+{
+    static constexpr unsigned max_height = 24;
+    static constexpr uintptr_t mark_bit = 1;
+
+    using link = std::atomic<uintptr_t>;
+
+    /// <summary>
+    /// A node linked at the levels below its height. The links are stored after the node.
+    /// </summary>
+    class node final : public RefCountObject<node>
+    {
+        struct trailing_t { };
+
+    public:
+        static void* operator new(size_t size, trailing_t, size_t height)
+        {
+            return ::operator new(size + height * sizeof(link));
+        }
+
+        static void operator delete(void* ptr, trailing_t, size_t) noexcept
+        {
+            ::operator delete(ptr);
+        }
+
+        static void operator delete(void* ptr) noexcept
+        {
+            ::operator delete(ptr);
+        }
+
+        static auto create(const Key& key, intrusive_ptr<T> value, unsigned height)
+        {
+            return intrusive_ptr<node>(new (trailing_t { }, height) node(key, std::move(value), height));
+        }
+
+        ~node() override
+        {
+            std::destroy_n(links(), m_height);
+        }
+
+        inline link* links() noexcept
+        {
+            return reinterpret_cast<link*>(this + 1);
+        }
+
+        const Key m_key;
+        const intrusive_ptr<T> m_value;
+        const unsigned m_height;
+
+    private:
+        node(const Key& key, intrusive_ptr<T> value, unsigned height)
+            : m_key(key)
+            , m_value(std::move(value))
+            , m_height(height)
+        {
+            std::uninitialized_value_construct_n(links(), height);
+        }
+    };
+
+    static inline node* pointer(uintptr_t value) noexcept
+    {
+        return reinterpret_cast<node*>(value & ~mark_bit);
+    }
+
+    static inline bool is_marked(uintptr_t value) noexcept
+    {
+        return (value & mark_bit) != 0;
+    }
+
+    static inline uintptr_t address(node* ptr) noexcept
+    {
+        return reinterpret_cast<uintptr_t>(ptr);
+    }
+
+    struct position
+    {
+        link* m_preds[max_height];
+        node* m_succs[max_height];
+    };
+
+public:
+    /// <summary>
+    /// A forward iterator over the entries of <see cref="concurrent_skip_list"/> in order,
+    /// that skips the entries removed before they are reached.
+    /// A non-end iterator pins the epoch, so it must be used and destroyed by the thread that created it.
+    /// </summary>
+    class const_iterator final
+    {
+        friend class concurrent_skip_list;
+
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using difference_type = ptrdiff_t;
+
+        const_iterator() noexcept = default;
+
+        inline const_iterator(const const_iterator& other)
+            : m_node(other.m_node)
+        {
+            if (other.m_guard)
+            {
+                m_guard.emplace(epoch_domain::instance().pin());
+            }
+        }
+
+        const_iterator(const_iterator&& other) noexcept = default;
+
+        inline const_iterator& operator=(const_iterator other) noexcept
+        {
+            std::swap(m_node, other.m_node);
+            m_guard.swap(other.m_guard);
+            return *this;
+        }
+
+        inline const Key& key() const noexcept
+        {
+            return m_node->m_key;
+        }
+
+        /// <summary>
+        /// Provides the borrowed value, that must be copied to outlive the iterator
+        /// </summary>
+        inline const intrusive_ptr<T>& value() const noexcept
+        {
+            return m_node->m_value;
+        }
+
+        inline const_iterator& operator++() noexcept
+        {
+            m_node = next_alive(m_node->links()[0].load(std::memory_order_acquire));
+            if (m_node == nullptr)
+            {
+                m_guard.reset();
+            }
+            return *this;
+        }
+
+        inline const_iterator operator++(int)
+        {
+            auto it = *this;
+            ++(*this);
+            return it;
+        }
+
+        inline bool operator==(const const_iterator& other) const noexcept
+        {
+            return m_node == other.m_node;
+        }
+
+        inline bool operator!=(const const_iterator& other) const noexcept
+        {
+            return m_node != other.m_node;
+        }
+
+    private:
+        inline const_iterator(epoch_domain::guard&& guard, node* current) noexcept
+            : m_node(current)
+        {
+            if (current != nullptr)
+            {
+                m_guard.emplace(std::move(guard));
+            }
+        }
+
+    private:
+        node* m_node { nullptr };
+        std::optional<epoch_domain::guard> m_guard;
+    };
+
+    /// <summary>
+    /// Provides a new empty instance of <see cref="concurrent_skip_list"/>
+    /// </summary>
+    concurrent_skip_list() noexcept = default;
+
+    concurrent_skip_list(const concurrent_skip_list&) = delete;
+    concurrent_skip_list& operator=(const concurrent_skip_list&) = delete;
+
+    /// <summary>
+    /// Destroys the list, that must not be accessed concurrently
+    /// </summary>
+    ~concurrent_skip_list()
+    {
+        auto current = pointer(m_head[0].load(std::memory_order_acquire));
+        while (current != nullptr)
+        {
+            auto next = pointer(current->links()[0].load(std::memory_order_relaxed));
+            intrusive_ptr_release(current);
+            current = next;
+        }
+    }
+
+    /// <summary>
+    /// Returns the approximate number of entries
+    /// </summary>
+    inline size_t size() const noexcept
+    {
+        return m_size.load(std::memory_order_relaxed);
+    }
+
+    /// <summary>
+    /// Releases the nodes removed by the current thread and by the exited threads at once,
+    /// if no reader is pinned. Is useful before checking the release of an erased value.
+    /// </summary>
+    static inline void flush()
+    {
+        epoch_domain::instance().flush();
+    }
+
+    inline bool empty() const
+    {
+        auto guard = epoch_domain::instance().pin();
+        return next_alive(m_head[0].load(std::memory_order_acquire)) == nullptr;
+    }
+
+    inline const_iterator begin() const
+    {
+        auto guard = epoch_domain::instance().pin();
+        auto first = next_alive(m_head[0].load(std::memory_order_acquire));
+        return const_iterator(std::move(guard), first);
+    }
+
+    inline const_iterator end() const noexcept
+    {
+        return const_iterator();
+    }
+
+    /// <summary>
+    /// Provides an iterator to the first entry, whose key is not less than the specified one
+    /// </summary>
+    inline const_iterator lower_bound(const Key& key) const
+    {
+        auto guard = epoch_domain::instance().pin();
+        return const_iterator(std::move(guard), search(key));
+    }
+
+    /// <summary>
+    /// Finds the value by the key
+    /// </summary>
+    /// <returns>
+    /// A strong reference to the value or an empty pointer, if the key is missing
+    /// </returns>
+    inline intrusive_ptr<T> find(const Key& key) const
+    {
+        auto guard = epoch_domain::instance().pin();
+        auto found = search(key);
+        return found != nullptr && !m_compare(key, found->m_key)
+            ? found->m_value
+            : intrusive_ptr<T>();
+    }
+
+    inline bool contains(const Key& key) const
+    {
+        auto guard = epoch_domain::instance().pin();
+        auto found = search(key);
+        return found != nullptr && !m_compare(key, found->m_key);
+    }
+
+    /// <summary>
+    /// Calls the handler for each entry in the range in order.
+    /// The handler borrows the values and must not keep references to them.
+    /// </summary>
+    /// <param name="first">
+    /// - The lowest key of the range
+    /// </param>
+    /// <param name="last">
+    /// - The key following the range
+    /// </param>
+    /// <param name="handler">
+    /// - The function called with the key and the value of each entry
+    /// </param>
+    template<class Handler>
+    inline void for_each_range(const Key& first, const Key& last, Handler&& handler) const
+    {
+        auto guard = epoch_domain::instance().pin();
+        for (auto current = search(first); current != nullptr && m_compare(current->m_key, last);
+            current = next_alive(current->links()[0].load(std::memory_order_acquire)))
+        {
+            handler(current->m_key, *current->m_value);
+        }
+    }
+
+    /// <summary>
+    /// Inserts the value, if the key is missing. An empty pointer is never stored.
+    /// </summary>
+    /// <returns>
+    /// Returns <see langword="true"/>, if the value was inserted,
+    /// otherwise it returns <see langword="false"/>.
+    /// </returns>
+    bool insert(const Key& key, intrusive_ptr<T> value)
+    {
+        if (!value)
+        {
+            return false;
+        }
+
+        auto guard = epoch_domain::instance().pin();
+        auto height = random_height();
+        auto created = intrusive_ptr<node>();
+        auto at = position();
+
+        while (true)
+        {
+            if (locate(key, at))
+            {
+                return false;
+            }
+
+            if (!created)
+            {
+                created = node::create(key, std::move(value), height);
+            }
+            for (unsigned level = 0; level < height; ++level)
+            {
+                created->links()[level].store(address(at.m_succs[level]), std::memory_order_relaxed);
+            }
+
+            auto expected = address(at.m_succs[0]);
+            if (at.m_preds[0]->compare_exchange_strong(expected, address(created.get())))
+            {
+                break;
+            }
+        }
+
+        // The reference of the list, that is retired by the thread removing the node
+        intrusive_ptr_add_ref(created.get());
+        m_size.fetch_add(1, std::memory_order_relaxed);
+        link_upper_levels(key, created.get(), at);
+
+        // The node could be linked again at an upper level after the remover had unlinked it,
+        // so the reference of the inserter is retired too
+        if (is_marked(created->links()[0].load()))
+        {
+            locate(key, at);
+            epoch_domain::instance().retire(created.detach());
+        }
+        return true;
+    }
+
+    /// <summary>
+    /// Removes the entry by the key
+    /// </summary>
+    /// <returns>
+    /// The removed value or an empty pointer, if the key is missing
+    /// </returns>
+    intrusive_ptr<T> erase(const Key& key)
+    {
+        auto guard = epoch_domain::instance().pin();
+        auto at = position();
+        if (!locate(key, at))
+        {
+            return intrusive_ptr<T>();
+        }
+
+        auto victim = at.m_succs[0];
+        for (auto level = victim->m_height - 1; level > 0; --level)
+        {
+            auto next = victim->links()[level].load();
+            while (!is_marked(next) && !victim->links()[level].compare_exchange_weak(next, next | mark_bit)) { }
+        }
+
+        auto next = victim->links()[0].load();
+        while (true)
+        {
+            if (is_marked(next))
+            {
+                return intrusive_ptr<T>();
+            }
+            if (victim->links()[0].compare_exchange_weak(next, next | mark_bit))
+            {
+                break;
+            }
+        }
+
+        auto value = victim->m_value;
+        m_size.fetch_sub(1, std::memory_order_relaxed);
+        locate(key, at);
+        epoch_domain::instance().retire(victim);
+        return value;
+    }
+
+private:
+    static unsigned random_height() noexcept
+    {
+        thread_local uint32_t state = static_cast<uint32_t>(reinterpret_cast<uintptr_t>(&state)) | 1;
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+
+        // Each level is kept with the probability 1/4
+        auto height = 1u;
+        for (auto bits = state; height < max_height && (bits & 3) == 0; bits >>= 2)
+        {
+            ++height;
+        }
+        return height;
+    }
+
+    /// <summary>
+    /// Skips the removed nodes starting from the link
+    /// </summary>
+    static node* next_alive(uintptr_t next) noexcept
+    {
+        auto current = pointer(next);
+        while (current != nullptr && is_marked(current->links()[0].load(std::memory_order_acquire)))
+        {
+            current = pointer(current->links()[0].load(std::memory_order_acquire));
+        }
+        return current;
+    }
+
+    /// <summary>
+    /// Finds the first node, whose key is not less than the specified one, without changing the links
+    /// </summary>
+    node* search(const Key& key) const noexcept
+    {
+        link* links = m_head;
+        node* current = nullptr;
+        for (auto level = static_cast<int>(max_height) - 1; level >= 0; --level)
+        {
+            current = pointer(links[level].load(std::memory_order_acquire));
+            while (current != nullptr)
+            {
+                auto next = current->links()[level].load(std::memory_order_acquire);
+                if (is_marked(next))
+                {
+                    current = pointer(next);
+                    continue;
+                }
+
+                if (!m_compare(current->m_key, key))
+                {
+                    break;
+                }
+                links = current->links();
+                current = pointer(next);
+            }
+        }
+        return current;
+    }
+
+    /// <summary>
+    /// Finds the predecessors and the successors of the key at each level
+    /// and unlinks the removed nodes on the way
+    /// </summary>
+    /// <returns>
+    /// Returns <see langword="true"/>, if the key is found,
+    /// otherwise it returns <see langword="false"/>.
+    /// </returns>
+    bool locate(const Key& key, position& at) const noexcept
+    {
+    retry:
+        link* links = m_head;
+        for (auto level = static_cast<int>(max_height) - 1; level >= 0; --level)
+        {
+            auto current = pointer(links[level].load(std::memory_order_acquire));
+            while (current != nullptr)
+            {
+                auto next = current->links()[level].load(std::memory_order_acquire);
+                if (is_marked(next))
+                {
+                    auto expected = address(current);
+                    if (!links[level].compare_exchange_strong(expected, next & ~mark_bit))
+                    {
+                        goto retry;
+                    }
+                    current = pointer(next);
+                    continue;
+                }
+
+                if (!m_compare(current->m_key, key))
+                {
+                    break;
+                }
+                links = current->links();
+                current = pointer(next);
+            }
+            at.m_preds[level] = &links[level];
+            at.m_succs[level] = current;
+        }
+        return at.m_succs[0] != nullptr && !m_compare(key, at.m_succs[0]->m_key);
+    }
+
+    /// <summary>
+    /// Links the node inserted at the lowest level to the upper levels,
+    /// until the node is marked as removed
+    /// </summary>
+    void link_upper_levels(const Key& key, node* inserted, position& at) const noexcept
+    {
+        for (unsigned level = 1; level < inserted->m_height; ++level)
+        {
+            while (true)
+            {
+                auto next = inserted->links()[level].load();
+                if (is_marked(next))
+                {
+                    return;
+                }
+
+                auto succ = address(at.m_succs[level]);
+                if (next != succ && !inserted->links()[level].compare_exchange_strong(next, succ))
+                {
+                    return;
+                }
+
+                if (at.m_preds[level]->compare_exchange_strong(succ, address(inserted)))
+                {
+                    break;
+                }
+
+                if (!locate(key, at) || at.m_succs[0] != inserted)
+                {
+                    return;
+                }
+            }
+        }
+    }
+
+private:
+    mutable link m_head[max_height] { };
+    std::atomic<size_t> m_size { 0 };
+    [[no_unique_address]] Compare m_compare;
+};
@@ -0,0 +1,637 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+#include <condition_variable>
+#include <coroutine>
+#include <exception>
+#include <mutex>
+#include <new>
+#include <optional>
+#include <type_traits>
+#include <utility>
+#include "intrusive_ptr.h"
+
+/// <summary>
+/// A thread-local recycling allocator of coroutine frames.
+/// The freed frames are cached in the lists of the size classes of 64 bytes,
+/// so a coroutine, whose frame size has been seen on the thread, is created without a heap allocation.
+/// </summary>
+class coroutine_frame_pool final
+{
+    static constexpr size_t granularity = 64;
+    static constexpr size_t class_count = 16;
+    static constexpr uint32_t max_cached = 64;
+
+    struct free_frame
+    {
+        free_frame* m_next;
+    };
+
+    struct cache
+    {
+        ~cache()
+        {
+            t_alive = false;
+            for (auto head : m_heads)
+            {
+                while (head != nullptr)
+                {
+                    auto next = head->m_next;
+                    ::operator delete(head);
+                    head = next;
+                }
+            }
+        }
+
+        free_frame* m_heads[class_count] { };
+        uint32_t m_counts[class_count] { };
+    };
+
+public:
+    coroutine_frame_pool() = delete;
+
+    /// <summary>
+    /// Allocates the memory of a coroutine frame
+    /// </summary>
+    static inline void* allocate(size_t size)
+    {
+        auto index = (size - 1) / granularity;
+        if (index >= class_count)
+        {
+            return ::operator new(size);
+        }
+
+        if (t_alive)
+        {
+            auto& local = local_cache();
+            if (auto frame = local.m_heads[index])
+            {
+                local.m_heads[index] = frame->m_next;
+                --local.m_counts[index];
+                return frame;
+            }
+        }
+        // A frame of a size class may be cached by another thread, so it always has the full size of the class
+        return ::operator new((index + 1) * granularity);
+    }
+
+    /// <summary>
+    /// Returns the memory of a coroutine frame to the cache of the current thread
+    /// </summary>
+    static inline void deallocate(void* memory, size_t size) noexcept
+    {
+        auto index = (size - 1) / granularity;
+        if (index < class_count && t_alive)
+        {
+            auto& local = local_cache();
+            if (local.m_counts[index] < max_cached)
+            {
+                auto frame = static_cast<free_frame*>(memory);
+                frame->m_next = local.m_heads[index];
+                local.m_heads[index] = frame;
+                ++local.m_counts[index];
+                return;
+            }
+        }
+        ::operator delete(memory);
+    }
+
+private:
+    static inline cache& local_cache() noexcept
+    {
+        thread_local cache instance;
+        return instance;
+    }
+
+    // The cache may be already destroyed, when a frame is freed by a thread-local destructor
+    static inline thread_local bool t_alive { true };
+};
+
+/// <summary>
+/// The storage of the result or the exception of a coroutine
+/// </summary>
+template<class T>
+class coroutine_result
+{
+public:
+    template<class Value>
+    inline void return_value(Value&& value) noexcept(std::is_nothrow_constructible_v<T, Value&&>)
+    {
+        m_value.emplace(std::forward<Value>(value));
+    }
+
+    inline void unhandled_exception() noexcept
+    {
+        m_exception = std::current_exception();
+    }
+
+    /// <summary>
+    /// Returns the result or rethrows the exception of the completed coroutine
+    /// </summary>
+    inline T& result()
+    {
+        if (m_exception)
+        {
+            std::rethrow_exception(m_exception);
+        }
+        return *m_value;
+    }
+
+private:
+    std::optional<T> m_value;
+    std::exception_ptr m_exception;
+};
+
+template<>
+class coroutine_result<void>
+{
+public:
+    inline void return_void() noexcept { }
+
+    inline void unhandled_exception() noexcept
+    {
+        m_exception = std::current_exception();
+    }
+
+    inline void result()
+    {
+        if (m_exception)
+        {
+            std::rethrow_exception(m_exception);
+        }
+    }
+
+private:
+    std::exception_ptr m_exception;
+};
+
+/// <summary>
+/// A base of the promises, whose coroutine frames are allocated by <see cref="coroutine_frame_pool"/>
+/// and destroyed, when the last reference to the promise is released
+/// </summary>
+template<class Promise>
+class refcounted_promise : public RefCountObject<Promise>
+{
+public:
+    static inline void* operator new(size_t size)
+    {
+        return coroutine_frame_pool::allocate(size);
+    }
+
+    static inline void operator delete(void* memory, size_t size) noexcept
+    {
+        coroutine_frame_pool::deallocate(memory, size);
+    }
+
+    /// <summary>
+    /// Destroys the whole coroutine frame instead of the promise alone,
+    /// when <see cref="RefCountObject"/> deletes the promise with the last reference
+    /// </summary>
+    static inline void operator delete(refcounted_promise* promise, std::destroying_delete_t) noexcept
+    {
+        std::coroutine_handle<Promise>::from_promise(*static_cast<Promise*>(promise)).destroy();
+    }
+
+    inline std::suspend_always initial_suspend() const noexcept
+    {
+        return { };
+    }
+
+protected:
+    refcounted_promise() noexcept = default;
+    ~refcounted_promise() override = default;
+};
+
+template<class T>
+class task;
+
+template<class T>
+class task_promise final : public refcounted_promise<task_promise<T>>, public coroutine_result<T>
+{
+    friend class task<T>;
+
+    struct final_awaiter
+    {
+        inline bool await_ready() const noexcept
+        {
+            return false;
+        }
+
+        inline std::coroutine_handle<> await_suspend(std::coroutine_handle<task_promise> frame) const noexcept
+        {
+            auto continuation = frame.promise().m_continuation;
+            return continuation ? continuation : std::noop_coroutine();
+        }
+
+        inline void await_resume() const noexcept { }
+    };
+
+public:
+    task<T> get_return_object() noexcept;
+
+    inline final_awaiter final_suspend() const noexcept
+    {
+        return { };
+    }
+
+private:
+    std::coroutine_handle<> m_continuation;
+};
+
+/// <summary>
+/// A lazy coroutine, whose frame is the reference-counted object: the promise derives from
+/// <see cref="RefCountObject"/>, the task and its awaiter hold <see cref="intrusive_ptr"/> to it,
+/// and the frame is destroyed with the last reference. The coroutine starts when the task is awaited,
+/// and the awaiting coroutine is resumed by the symmetric transfer on completion.
+/// A task can be awaited only once.
+/// </summary>
+/// <typeparam name="T">
+/// The type of the result
+/// </typeparam>
+template<class T = void>
+class task final
+{
+public:
+    using promise_type = task_promise<T>;
+
+private:
+    template<bool Move>
+    struct awaiter
+    {
+        inline bool await_ready() const noexcept
+        {
+            return handle().done();
+        }
+
+        inline std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) const noexcept
+        {
+            m_promise->m_continuation = awaiting;
+            return handle();
+        }
+
+        inline decltype(auto) await_resume() const
+        {
+            if constexpr (Move && !std::is_void_v<T>)
+            {
+                return T(std::move(m_promise->result()));
+            }
+            else
+            {
+                return m_promise->result();
+            }
+        }
+
+        inline std::coroutine_handle<promise_type> handle() const noexcept
+        {
+            return std::coroutine_handle<promise_type>::from_promise(*m_promise);
+        }
+
+        intrusive_ptr<promise_type> m_promise;
+    };
+
+public:
+    task() noexcept = default;
+
+    explicit task(intrusive_ptr<promise_type> promise) noexcept : m_promise(std::move(promise)) { }
+
+    task(task&&) noexcept = default;
+    task& operator=(task&&) noexcept = default;
+
+    task(const task&) = delete;
+    task& operator=(const task&) = delete;
+
+    /// <summary>
+    /// Checks whether the task has a coroutine
+    /// </summary>
+    inline bool is_valid() const noexcept
+    {
+        return static_cast<bool>(m_promise);
+    }
+
+    /// <summary>
+    /// Checks whether the coroutine has completed
+    /// </summary>
+    inline bool is_ready() const noexcept
+    {
+        return m_promise && std::coroutine_handle<promise_type>::from_promise(*m_promise).done();
+    }
+
+    /// <summary>
+    /// Awaits the task, that is kept alive by the caller, and provides a reference to its result
+    /// </summary>
+    inline auto operator co_await() const & noexcept
+    {
+        return awaiter<false> { m_promise };
+    }
+
+    /// <summary>
+    /// Awaits the task, that is released after the result has been moved out of it
+    /// </summary>
+    inline auto operator co_await() && noexcept
+    {
+        return awaiter<true> { std::move(m_promise) };
+    }
+
+private:
+    intrusive_ptr<promise_type> m_promise;
+};
+
+template<class T>
+inline task<T> task_promise<T>::get_return_object() noexcept
+{
+    return task<T>(intrusive_ptr<task_promise>(this));
+}
+
+template<class T>
+class shared_task;
+
+template<class T>
+class shared_task_promise final : public refcounted_promise<shared_task_promise<T>>, public coroutine_result<T>
+{
+    friend class shared_task<T>;
+
+    // The states of the coroutine. Any other value points to the list of the awaiters:
+    // the coroutine is running, since the first awaiter has started it.
+    static constexpr uintptr_t not_started = 0;
+    static constexpr uintptr_t completed = 2;
+
+    struct waiter
+    {
+        std::coroutine_handle<> m_handle;
+        waiter* m_next;
+    };
+
+    struct final_awaiter
+    {
+        inline bool await_ready() const noexcept
+        {
+            return false;
+        }
+
+        /// <summary>
+        /// Resumes all awaiters, the last one of them by the symmetric transfer.
+        /// Each awaiter holds a reference, so the frame outlives the loop.
+        /// </summary>
+        inline std::coroutine_handle<> await_suspend(std::coroutine_handle<shared_task_promise> frame) const noexcept
+        {
+            auto state = frame.promise().m_state.exchange(completed, std::memory_order_acq_rel);
+            auto current = state > completed ? reinterpret_cast<waiter*>(state) : nullptr;
+            if (current == nullptr)
+            {
+                return std::noop_coroutine();
+            }
+
+            while (current->m_next != nullptr)
+            {
+                auto next = current->m_next;
+                current->m_handle.resume();
+                current = next;
+            }
+            return current->m_handle;
+        }
+
+        inline void await_resume() const noexcept { }
+    };
+
+public:
+    shared_task<T> get_return_object() noexcept;
+
+    inline final_awaiter final_suspend() const noexcept
+    {
+        return { };
+    }
+
+private:
+    std::atomic<uintptr_t> m_state { not_started };
+};
+
+/// <summary>
+/// A lazy coroutine, that can be awaited by any number of coroutines concurrently.
+/// The frame is the reference-counted object like in <see cref="task"/>, so a copy of the task
+/// only increases the reference count. The first awaiter starts the coroutine,
+/// all awaiters are resumed on completion and get a reference to the same result.
+/// </summary>
+/// <typeparam name="T">
+/// The type of the result
+/// </typeparam>
+template<class T = void>
+class shared_task final
+{
+public:
+    using promise_type = shared_task_promise<T>;
+
+private:
+    struct awaiter
+    {
+        inline bool await_ready() const noexcept
+        {
+            return m_promise->m_state.load(std::memory_order_acquire) == promise_type::completed;
+        }
+
+        inline std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept
+        {
+            m_waiter.m_handle = awaiting;
+            auto state = m_promise->m_state.load(std::memory_order_acquire);
+            while (true)
+            {
+                if (state == promise_type::completed)
+                {
+                    return awaiting;
+                }
+
+                m_waiter.m_next = state > promise_type::completed
+                    ? reinterpret_cast<typename promise_type::waiter*>(state)
+                    : nullptr;
+                if (m_promise->m_state.compare_exchange_weak(state, reinterpret_cast<uintptr_t>(&m_waiter),
+                    std::memory_order_acq_rel, std::memory_order_acquire))
+                {
+                    break;
+                }
+            }
+
+            if (state == promise_type::not_started)
+            {
+                return std::coroutine_handle<promise_type>::from_promise(*m_promise);
+            }
+            return std::noop_coroutine();
+        }
+
+        inline decltype(auto) await_resume() const
+        {
+            if constexpr (std::is_void_v<T>)
+            {
+                m_promise->result();
+            }
+            else
+            {
+                return static_cast<const T&>(m_promise->result());
+            }
+        }
+
+        intrusive_ptr<promise_type> m_promise;
+        typename promise_type::waiter m_waiter { };
+    };
+
+public:
+    shared_task() noexcept = default;
+
+    explicit shared_task(intrusive_ptr<promise_type> promise) noexcept : m_promise(std::move(promise)) { }
+
+    inline bool is_valid() const noexcept
+    {
+        return static_cast<bool>(m_promise);
+    }
+
+    /// <summary>
+    /// Checks whether the coroutine has completed
+    /// </summary>
+    inline bool is_ready() const noexcept
+    {
+        return m_promise && m_promise->m_state.load(std::memory_order_acquire) == promise_type::completed;
+    }
+
+    /// <summary>
+    /// Awaits the task and provides a constant reference to the shared result
+    /// </summary>
+    inline auto operator co_await() const noexcept
+    {
+        return awaiter { m_promise };
+    }
+
+private:
+    intrusive_ptr<promise_type> m_promise;
+};
+
+template<class T>
+inline shared_task<T> shared_task_promise<T>::get_return_object() noexcept
+{
+    return shared_task<T>(intrusive_ptr<shared_task_promise>(this));
+}
+
+/// <summary>
+/// A coroutine, that awaits an awaitable for <see cref="sync_wait"/>
+/// and signals the waiting thread on completion
+/// </summary>
+template<class T>
+class sync_wait_driver final
+{
+public:
+    class promise_type final : public coroutine_result<T>
+    {
+        friend class sync_wait_driver;
+
+        struct final_awaiter
+        {
+            inline bool await_ready() const noexcept
+            {
+                return false;
+            }
+
+            inline void await_suspend(std::coroutine_handle<promise_type> frame) const noexcept
+            {
+                // The waiting thread destroys the frame only after the lock is released
+                auto& promise = frame.promise();
+                auto lock = std::lock_guard(promise.m_lock);
+                promise.m_done = true;
+                promise.m_completed.notify_one();
+            }
+
+            inline void await_resume() const noexcept { }
+        };
+
+    public:
+        inline sync_wait_driver get_return_object() noexcept
+        {
+            return sync_wait_driver(std::coroutine_handle<promise_type>::from_promise(*this));
+        }
+
+        inline std::suspend_always initial_suspend() const noexcept
+        {
+            return { };
+        }
+
+        inline final_awaiter final_suspend() const noexcept
+        {
+            return { };
+        }
+
+    private:
+        std::mutex m_lock;
+        std::condition_variable m_completed;
+        bool m_done { false };
+    };
+
+    explicit sync_wait_driver(std::coroutine_handle<promise_type> frame) noexcept : m_frame(frame) { }
+
+    sync_wait_driver(const sync_wait_driver&) = delete;
+    sync_wait_driver& operator=(const sync_wait_driver&) = delete;
+
+    ~sync_wait_driver()
+    {
+        m_frame.destroy();
+    }
+
+    /// <summary>
+    /// Starts the coroutine and blocks until it completes
+    /// </summary>
+    inline decltype(auto) run()
+    {
+        m_frame.resume();
+
+        auto& promise = m_frame.promise();
+        auto lock = std::unique_lock(promise.m_lock);
+        promise.m_completed.wait(lock, [&] { return promise.m_done; });
+        lock.unlock();
+
+        if constexpr (std::is_void_v<T>)
+        {
+            promise.result();
+        }
+        else
+        {
+            return T(std::move(promise.result()));
+        }
+    }
+
+private:
+    std::coroutine_handle<promise_type> m_frame;
+};
+
+template<class T, class Awaitable>
+inline sync_wait_driver<T> make_sync_wait_driver(Awaitable& awaitable)
+{
+    if constexpr (std::is_void_v<T>)
+    {
+        co_await std::move(awaitable);
+    }
+    else
+    {
+        co_return co_await std::move(awaitable);
+    }
+}
+
+/// <summary>
+/// Starts the task on the current thread and blocks until it completes
+/// </summary>
+/// <returns>
+/// The result of the task. The exception of the task is rethrown.
+/// </returns>
+template<class T>
+inline T sync_wait(task<T> awaitable)
+{
+    return make_sync_wait_driver<T>(awaitable).run();
+}
+
+/// <summary>
+/// Awaits the shared task on the current thread and blocks until it completes
+/// </summary>
+/// <returns>
+/// A copy of the result of the task. The exception of the task is rethrown.
+/// </returns>
+template<class T>
+inline T sync_wait(const shared_task<T>& awaitable)
+{
+    auto copy = awaitable;
+    return make_sync_wait_driver<T>(copy).run();
+}
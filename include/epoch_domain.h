@@ -0,0 +1,315 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <utility>
+#include <vector>
+#include "intrusive_ptr.h"
+
+/// <summary>
+/// An epoch based reclamation of objects derived from <see cref="RefCountObject"/>,
+/// that are removed from concurrent structures while other threads may still read them.
+/// A reader pins the current epoch by <see cref="epoch_domain::guard"/> and may access
+/// any object reachable from a structure without changing its reference count.
+/// A writer retires the reference of the structure to an unlinked object, and the reference
+/// is released through <see cref="intrusive_ptr_release"/> after every thread pinned
+/// at the time of the retirement has unpinned.
+/// </summary>
+/// <remarks>
+/// The retired objects of a thread are collected, when it unpins the epoch, when it has retired
+/// 64 objects since the last collection, and on <see cref="flush"/>. The epoch advances by one step
+/// per collection and only while every pinned thread has observed it, so an object retired
+/// in a critical section is released at the end of the next one of the same thread, unless
+/// another thread stays pinned. The objects of a thread, that never pins again, wait for
+/// <see cref="flush"/> or for the exit of the thread, after which any collecting thread takes them.
+/// </remarks>
+class epoch_domain final
+{
+    static constexpr size_t collect_threshold = 64;
+
+    struct retired_object
+    {
+        void* m_pointer;
+        void (*m_release)(void*);
+        uint64_t m_epoch;
+    };
+
+    /// <summary>
+    /// The state of a thread using the domain, that is reused after the thread exits.
+    /// The pinned epoch is stored shifted left with the lowest bit set.
+    /// </summary>
+    struct alignas(64) record
+    {
+        std::atomic<uint64_t> m_pinned { 0 };
+        std::atomic<bool> m_in_use { true };
+        record* m_next { nullptr };
+        uint32_t m_nesting { 0 };
+        std::vector<retired_object> m_retired;
+    };
+
+    /// <summary>
+    /// Returns the record of the current thread to the domain on the exit of the thread
+    /// </summary>
+    struct thread_state
+    {
+        record* m_record { nullptr };
+
+        ~thread_state()
+        {
+            if (m_record != nullptr)
+            {
+                instance().detach(m_record);
+            }
+        }
+    };
+
+public:
+    /// <summary>
+    /// A pin of the current epoch by the current thread. The guards may be nested
+    /// and must be destroyed by the thread that created them.
+    /// </summary>
+    class guard final
+    {
+        friend class epoch_domain;
+
+    public:
+        inline guard(guard&& other) noexcept : m_record(std::exchange(other.m_record, nullptr)) { }
+
+        guard(const guard&) = delete;
+        guard& operator=(const guard&) = delete;
+        guard& operator=(guard&&) = delete;
+
+        inline ~guard()
+        {
+            if (m_record != nullptr && --m_record->m_nesting == 0)
+            {
+                m_record->m_pinned.store(0, std::memory_order_release);
+                if (!m_record->m_retired.empty())
+                {
+                    instance().collect_quietly(m_record);
+                }
+            }
+        }
+
+    private:
+        inline explicit guard(record* pinned) noexcept : m_record(pinned) { }
+
+    private:
+        record* m_record;
+    };
+
+    epoch_domain(const epoch_domain&) = delete;
+    epoch_domain& operator=(const epoch_domain&) = delete;
+
+    ~epoch_domain()
+    {
+        auto current = m_records.load(std::memory_order_acquire);
+        while (current != nullptr)
+        {
+            release_all(current->m_retired);
+            delete std::exchange(current, current->m_next);
+        }
+        release_all(m_orphans);
+    }
+
+    /// <summary>
+    /// Provides the domain shared by all concurrent structures of the process
+    /// </summary>
+    static epoch_domain& instance()
+    {
+        static epoch_domain domain;
+        return domain;
+    }
+
+    /// <summary>
+    /// Pins the current epoch by the current thread
+    /// </summary>
+    /// <returns>
+    /// The guard, that unpins the epoch on destruction
+    /// </returns>
+    [[nodiscard]] inline guard pin()
+    {
+        auto current = local_record();
+        if (current->m_nesting++ == 0)
+        {
+            auto epoch = m_epoch.load(std::memory_order_acquire);
+            current->m_pinned.store((epoch << 1) | 1, std::memory_order_seq_cst);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+        }
+        return guard(current);
+    }
+
+    /// <summary>
+    /// Releases a reference to an object after the threads pinned now have unpinned.
+    /// The object must already be unreachable for the threads that will pin later.
+    /// </summary>
+    /// <param name="ptr">
+    /// - A raw pointer to an instance, that implements <see cref="RefCountObject"/>
+    /// </param>
+    template<intrusive_counter_type T>
+    inline void retire(T* ptr)
+    {
+        auto current = local_record();
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        current->m_retired.push_back({ ptr, &release<T>, m_epoch.load(std::memory_order_relaxed) });
+        if (current->m_retired.size() >= collect_threshold)
+        {
+            collect(current);
+        }
+    }
+
+    /// <summary>
+    /// Tries to advance the epoch and releases the objects retired by the current thread,
+    /// that are no longer accessible
+    /// </summary>
+    inline void collect()
+    {
+        collect(local_record());
+    }
+
+    /// <summary>
+    /// Releases all objects retired by the current thread and by the exited threads,
+    /// if no thread is pinned
+    /// </summary>
+    inline void flush()
+    {
+        for (auto i = 0; i < 3; ++i)
+        {
+            try_advance();
+        }
+        collect(local_record());
+    }
+
+private:
+    epoch_domain() = default;
+
+    template<class T>
+    static void release(void* ptr)
+    {
+        intrusive_ptr_release(static_cast<T*>(ptr));
+    }
+
+    static void release_all(std::vector<retired_object>& objects)
+    {
+        for (auto& object : objects)
+        {
+            object.m_release(object.m_pointer);
+        }
+        objects.clear();
+    }
+
+    static void take_released(std::vector<retired_object>& retired, std::vector<retired_object>& ready, uint64_t epoch)
+    {
+        auto first = std::partition(retired.begin(), retired.end(),
+            [epoch](const retired_object& object) { return object.m_epoch + 2 > epoch; });
+        ready.insert(ready.end(), first, retired.end());
+        retired.erase(first, retired.end());
+    }
+
+    inline record* local_record()
+    {
+        thread_local thread_state state;
+        if (state.m_record == nullptr)
+        {
+            state.m_record = attach();
+        }
+        return state.m_record;
+    }
+
+    /// <summary>
+    /// Takes a record released by an exited thread or adds a new one
+    /// </summary>
+    inline record* attach()
+    {
+        for (auto current = m_records.load(std::memory_order_acquire); current != nullptr; current = current->m_next)
+        {
+            auto in_use = false;
+            if (!current->m_in_use.load(std::memory_order_relaxed)
+                && current->m_in_use.compare_exchange_strong(in_use, true, std::memory_order_acquire))
+            {
+                return current;
+            }
+        }
+
+        auto created = new record();
+        created->m_next = m_records.load(std::memory_order_relaxed);
+        while (!m_records.compare_exchange_weak(created->m_next, created,
+            std::memory_order_release, std::memory_order_relaxed)) { }
+        return created;
+    }
+
+    inline void detach(record* current)
+    {
+        if (!current->m_retired.empty())
+        {
+            auto lock = std::lock_guard(m_orphans_mutex);
+            m_orphans.insert(m_orphans.end(), current->m_retired.begin(), current->m_retired.end());
+            current->m_retired.clear();
+            m_has_orphans.store(true, std::memory_order_relaxed);
+        }
+        current->m_in_use.store(false, std::memory_order_release);
+    }
+
+    /// <summary>
+    /// Advances the epoch, if every pinned thread has observed the current one
+    /// </summary>
+    inline uint64_t try_advance()
+    {
+        auto epoch = m_epoch.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        for (auto current = m_records.load(std::memory_order_acquire); current != nullptr; current = current->m_next)
+        {
+            auto pinned = current->m_pinned.load(std::memory_order_acquire);
+            if ((pinned & 1) != 0 && (pinned >> 1) != epoch)
+            {
+                return epoch;
+            }
+        }
+        m_epoch.compare_exchange_strong(epoch, epoch + 1, std::memory_order_acq_rel);
+        return m_epoch.load(std::memory_order_acquire);
+    }
+
+    /// <summary>
+    /// Collects on the unpin, the objects, that cannot be collected now, wait for the next one
+    /// </summary>
+    inline void collect_quietly(record* current) noexcept
+    {
+        try
+        {
+            collect(current);
+        }
+        catch (...)
+        {
+        }
+    }
+
+    inline void collect(record* current)
+    {
+        // The objects retired in the epoch E may be reached only by the threads pinned in E - 1 or E
+        auto epoch = try_advance();
+        auto ready = std::vector<retired_object>();
+        take_released(current->m_retired, ready, epoch);
+
+        if (m_has_orphans.load(std::memory_order_relaxed))
+        {
+            auto lock = std::unique_lock(m_orphans_mutex, std::try_to_lock);
+            if (lock.owns_lock())
+            {
+                take_released(m_orphans, ready, epoch);
+                m_has_orphans.store(!m_orphans.empty(), std::memory_order_relaxed);
+            }
+        }
+
+        // The release may retire other objects, so the vectors are not iterated here
+        release_all(ready);
+    }
+
+private:
+    std::atomic<uint64_t> m_epoch { 1 };
+    std::atomic<record*> m_records { nullptr };
+    std::mutex m_orphans_mutex;
+    std::vector<retired_object> m_orphans;
+    std::atomic<bool> m_has_orphans { false };
+};
@@ -0,0 +1,759 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <algorithm>
+#include <bit>
+#include <concepts>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+#include "intrusive_list.h"
+#include "intrusive_ptr.h"
+
+template<class Tag>
+struct intrusive_cache_list_tag { };
+
+/// <summary>
+/// A cache hook embedded into an object next to <see cref="RefCountObject"/>.
+/// The hook holds the links of the object in the replacement queue and in the hash chain
+/// of <see cref="intrusive_cache"/>, so caching the object never allocates memory.
+/// </summary>
+/// <typeparam name="Tag">
+/// A tag type that distinguishes several cache hooks of the same object
+/// </typeparam>
+template<class Tag = void>
+class intrusive_cache_hook : public intrusive_list_hook<intrusive_cache_list_tag<Tag>>
+{
+    template<class Key, class T, class Policy, class Hash, class KeyEqual, class CacheTag>
+    friend class intrusive_cache;
+
+    friend struct lru_policy;
+    friend struct two_queue_policy;
+
+public:
+    intrusive_cache_hook() noexcept = default;
+
+    /// <summary>
+    /// Provides a new unlinked instance of <see cref="intrusive_cache_hook"/>.
+    /// The links of the copied object are never copied.
+    /// </summary>
+    intrusive_cache_hook(const intrusive_cache_hook&) noexcept { }
+
+    intrusive_cache_hook& operator=(const intrusive_cache_hook&) noexcept
+    {
+        return *this;
+    }
+
+private:
+    intrusive_cache_hook* m_chain_next { nullptr };
+    uint64_t m_hash { 0 };
+    uint8_t m_queue { 0 };
+};
+
+/// <summary>
+/// A type concept that allows you to cache only the objects that contain
+/// <see cref="intrusive_cache_hook"/> with the specified tag and provide their keys
+/// </summary>
+template<typename T, class Key, class Tag>
+concept intrusive_cache_type =
+    intrusive_counter_type<T> && std::is_base_of_v<intrusive_cache_hook<Tag>, T>
+    && requires(const T& object) { { object.key() } -> std::convertible_to<const Key&>; };
+
+/// <summary>
+/// The replacement policy, that evicts the least recently used entry
+/// </summary>
+struct lru_policy
+{
+    static constexpr bool skip_pinned = false;
+
+    template<class T, class Tag>
+    class queue final
+    {
+    public:
+        explicit queue(size_t) noexcept { }
+
+        inline void insert(intrusive_ptr<T> object) noexcept
+        {
+            m_entries.push_front(std::move(object));
+        }
+
+        inline void touch(T& object) noexcept
+        {
+            m_entries.push_front(m_entries.erase(object));
+        }
+
+        inline intrusive_ptr<T> erase(T& object) noexcept
+        {
+            return m_entries.erase(object);
+        }
+
+        template<class CanEvict>
+        inline intrusive_ptr<T> evict(CanEvict&& can_evict) noexcept
+        {
+            return evict_from(m_entries, can_evict);
+        }
+
+        inline void clear(intrusive_list<T, intrusive_cache_list_tag<Tag>>& released) noexcept
+        {
+            released.splice_back(m_entries);
+        }
+
+    private:
+        intrusive_list<T, intrusive_cache_list_tag<Tag>> m_entries;
+    };
+
+    /// <summary>
+    /// Unlinks the least recently used member of the list, that may be evicted
+    /// </summary>
+    template<class List, class CanEvict>
+    static auto evict_from(List& entries, CanEvict& can_evict) noexcept
+    {
+        for (auto it = entries.end(); it != entries.begin();)
+        {
+            --it;
+            if (can_evict(*it))
+            {
+                return entries.erase(*it);
+            }
+        }
+        return decltype(entries.erase(*entries.begin()))();
+    }
+};
+
+/// <summary>
+/// The 2Q replacement policy. The new entries are queued in the FIFO, that takes a quarter
+/// of the capacity, and the entries evicted from it are remembered by the hashes
+/// of their keys in the ghost FIFO, that takes a half of the capacity. An entry inserted again
+/// while its fingerprint is remembered goes to the main LRU queue, so a scan of new keys
+/// never evicts the entries that are accessed repeatedly.
+/// </summary>
+struct two_queue_policy
+{
+    static constexpr bool skip_pinned = false;
+
+    template<class T, class Tag>
+    class queue final
+    {
+        static constexpr uint8_t in_queue = 0;
+        static constexpr uint8_t main_queue = 1;
+
+        using hook_type = intrusive_cache_hook<Tag>;
+
+        /// <summary>
+        /// A FIFO of the hashes of the evicted entries with the open addressing set of them,
+        /// both are allocated once by the cache
+        /// </summary>
+        class ghost_queue final
+        {
+            struct slot
+            {
+                uint64_t m_hash { 0 };
+                uint32_t m_count { 0 };
+            };
+
+        public:
+            explicit ghost_queue(size_t capacity)
+                : m_ring(std::max<size_t>(capacity, 1))
+                , m_slots(std::bit_ceil(std::max<size_t>(capacity, 1) * 2)) { }
+
+            inline bool contains(uint64_t hash) const noexcept
+            {
+                return m_slots[find(hash)].m_count != 0;
+            }
+
+            inline void push(uint64_t hash) noexcept
+            {
+                if (m_count == m_ring.size())
+                {
+                    remove(m_ring[m_head]);
+                }
+                else
+                {
+                    ++m_count;
+                }
+
+                m_ring[m_head] = hash;
+                auto& added = m_slots[find(hash)];
+                added.m_hash = hash;
+                ++added.m_count;
+                m_head = (m_head + 1) % m_ring.size();
+            }
+
+        private:
+            inline size_t find(uint64_t hash) const noexcept
+            {
+                auto mask = m_slots.size() - 1;
+                auto index = static_cast<size_t>(hash) & mask;
+                while (m_slots[index].m_count != 0 && m_slots[index].m_hash != hash)
+                {
+                    index = (index + 1) & mask;
+                }
+                return index;
+            }
+
+            /// <summary>
+            /// Removes one occurrence of the hash, shifting back the following slots of the cluster
+            /// </summary>
+            inline void remove(uint64_t hash) noexcept
+            {
+                auto mask = m_slots.size() - 1;
+                auto index = find(hash);
+                if (--m_slots[index].m_count != 0)
+                {
+                    return;
+                }
+
+                for (auto next = (index + 1) & mask; m_slots[next].m_count != 0; next = (next + 1) & mask)
+                {
+                    auto home = static_cast<size_t>(m_slots[next].m_hash) & mask;
+                    if (((next - home) & mask) >= ((next - index) & mask))
+                    {
+                        m_slots[index] = m_slots[next];
+                        m_slots[next].m_count = 0;
+                        index = next;
+                    }
+                }
+            }
+
+        private:
+            std::vector<uint64_t> m_ring;
+            std::vector<slot> m_slots;
+            size_t m_head { 0 };
+            size_t m_count { 0 };
+        };
+
+    public:
+        explicit queue(size_t capacity)
+            : m_in_capacity(std::max<size_t>(capacity / 4, 1))
+            , m_ghosts(capacity / 2) { }
+
+        inline void insert(intrusive_ptr<T> object) noexcept
+        {
+            auto& hook = static_cast<hook_type&>(*object);
+            if (m_ghosts.contains(hook.m_hash))
+            {
+                hook.m_queue = main_queue;
+                m_main.push_front(std::move(object));
+            }
+            else
+            {
+                hook.m_queue = in_queue;
+                m_in.push_front(std::move(object));
+            }
+        }
+
+        inline void touch(T& object) noexcept
+        {
+            // The repeated accesses to a new entry are correlated and do not promote it
+            if (static_cast<hook_type&>(object).m_queue == main_queue)
+            {
+                m_main.push_front(m_main.erase(object));
+            }
+        }
+
+        inline intrusive_ptr<T> erase(T& object) noexcept
+        {
+            return static_cast<hook_type&>(object).m_queue == main_queue
+                ? m_main.erase(object)
+                : m_in.erase(object);
+        }
+
+        template<class CanEvict>
+        inline intrusive_ptr<T> evict(CanEvict&& can_evict) noexcept
+        {
+            if (m_in.size() > m_in_capacity || m_main.empty())
+            {
+                if (auto victim = evict_in(can_evict))
+                {
+                    return victim;
+                }
+                return lru_policy::evict_from(m_main, can_evict);
+            }
+
+            if (auto victim = lru_policy::evict_from(m_main, can_evict))
+            {
+                return victim;
+            }
+            return evict_in(can_evict);
+        }
+
+        inline void clear(intrusive_list<T, intrusive_cache_list_tag<Tag>>& released) noexcept
+        {
+            released.splice_back(m_in);
+            released.splice_back(m_main);
+        }
+
+    private:
+        template<class CanEvict>
+        inline intrusive_ptr<T> evict_in(CanEvict& can_evict) noexcept
+        {
+            auto victim = lru_policy::evict_from(m_in, can_evict);
+            if (victim)
+            {
+                m_ghosts.push(static_cast<hook_type&>(*victim).m_hash);
+            }
+            return victim;
+        }
+
+    private:
+        intrusive_list<T, intrusive_cache_list_tag<Tag>> m_in;
+        intrusive_list<T, intrusive_cache_list_tag<Tag>> m_main;
+        size_t m_in_capacity;
+        ghost_queue m_ghosts;
+    };
+};
+
+/// <summary>
+/// The replacement policy, that never evicts the entries referenced outside of the cache.
+/// The cache may exceed its capacity, while all of the candidates are pinned.
+/// </summary>
+/// <typeparam name="Policy">
+/// The underlying replacement policy
+/// </typeparam>
+template<class Policy>
+struct pin_aware_policy : public Policy
+{
+    static constexpr bool skip_pinned = true;
+};
+
+/// <summary>
+/// A cache of objects derived from <see cref="RefCountObject"/>, that are indexed by their keys.
+/// The objects are linked into the replacement queue and into the hash chains through the embedded
+/// <see cref="intrusive_cache_hook"/>, so only the bucket array is allocated by the cache.
+/// The cache holds one reference to each of its entries and releases it on the eviction.
+/// The cache is not thread-safe, see <see cref="sharded_cache"/>.
+/// </summary>
+/// <typeparam name="Key">
+/// The type of the keys
+/// </typeparam>
+/// <typeparam name="T">
+/// The type of the entries, that provides its key by the method key()
+/// </typeparam>
+/// <typeparam name="Policy">
+/// The replacement policy: <see cref="lru_policy"/>, <see cref="two_queue_policy"/>
+/// or <see cref="pin_aware_policy"/> of one of them
+/// </typeparam>
+template<class Key, class T, class Policy = lru_policy, class Hash = std::hash<Key>,
+    class KeyEqual = std::equal_to<Key>, class Tag = void>
+class intrusive_cache final
+{
+    static_assert(intrusive_cache_type<T, Key, Tag>,
+        "The type must be derived from RefCountObject and intrusive_cache_hook and provide key()");
+
+    template<class, class, class, class, class, class>
+    friend class sharded_cache;
+
+    using hook_type = intrusive_cache_hook<Tag>;
+    // The removed entries are released after the cache has become consistent again,
+    // so their destructors may use the cache
+    using released_list = intrusive_list<T, intrusive_cache_list_tag<Tag>>;
+
+public:
+    /// <summary>
+    /// Provides a new empty instance of <see cref="intrusive_cache"/>
+    /// </summary>
+    /// <param name="capacity">
+    /// - The maximal number of entries, that must not be zero
+    /// </param>
+    explicit intrusive_cache(size_t capacity)
+        : m_capacity(checked_capacity(capacity))
+        , m_queue(capacity)
+        , m_buckets(std::bit_ceil(std::max<size_t>(capacity, 8)), nullptr) { }
+
+    intrusive_cache(const intrusive_cache&) = delete;
+    intrusive_cache& operator=(const intrusive_cache&) = delete;
+
+    ~intrusive_cache()
+    {
+        clear();
+    }
+
+    inline size_t size() const noexcept
+    {
+        return m_size;
+    }
+
+    inline size_t capacity() const noexcept
+    {
+        return m_capacity;
+    }
+
+    inline bool empty() const noexcept
+    {
+        return m_size == 0;
+    }
+
+    /// <summary>
+    /// Finds the entry by the key and marks it as recently used
+    /// </summary>
+    /// <returns>
+    /// A pointer to the entry or an empty pointer, if the key is missing
+    /// </returns>
+    inline intrusive_ptr<T> find(const Key& key)
+    {
+        return find(key, mix(m_hash(key)));
+    }
+
+    /// <summary>
+    /// Checks whether the key is cached without changing the order of eviction
+    /// </summary>
+    inline bool contains(const Key& key) const
+    {
+        return lookup(key, mix(m_hash(key))) != nullptr;
+    }
+
+    /// <summary>
+    /// Inserts the object, if its key is missing, and evicts the entries over the capacity
+    /// </summary>
+    /// <param name="object">
+    /// - A pointer to the object, that is not cached yet
+    /// </param>
+    /// <returns>
+    /// Returns <see langword="true"/>, if the object was inserted,
+    /// otherwise it returns <see langword="false"/>. An empty pointer is never inserted.
+    /// </returns>
+    inline bool insert(intrusive_ptr<T> object)
+    {
+        if (!object)
+        {
+            return false;
+        }
+
+        auto hash = mix(m_hash(object->key()));
+        auto evicted = released_list();
+        return insert(std::move(object), hash, evicted);
+    }
+
+    /// <summary>
+    /// Removes the entry by the key
+    /// </summary>
+    /// <returns>
+    /// The removed entry or an empty pointer, if the key is missing
+    /// </returns>
+    inline intrusive_ptr<T> erase(const Key& key)
+    {
+        return erase(key, mix(m_hash(key)));
+    }
+
+    /// <summary>
+    /// Removes all entries and releases the references to them
+    /// </summary>
+    inline void clear() noexcept
+    {
+        auto released = released_list();
+        clear(released);
+    }
+
+private:
+    static inline size_t checked_capacity(size_t capacity)
+    {
+        if (capacity == 0)
+        {
+            // Every insert would evict the inserted entry at once
+            throw std::invalid_argument("The capacity of the cache must not be zero");
+        }
+        return capacity;
+    }
+
+    static inline uint64_t mix(size_t hash) noexcept
+    {
+        auto value = static_cast<uint64_t>(hash);
+        value ^= value >> 33;
+        value *= 0xff51afd7ed558ccdull;
+        value ^= value >> 33;
+        return value;
+    }
+
+    inline hook_type*& bucket(uint64_t hash) noexcept
+    {
+        return m_buckets[hash & (m_buckets.size() - 1)];
+    }
+
+    T* lookup(const Key& key, uint64_t hash) const
+    {
+        auto current = m_buckets[hash & (m_buckets.size() - 1)];
+        for (; current != nullptr; current = current->m_chain_next)
+        {
+            auto object = static_cast<T*>(current);
+            if (current->m_hash == hash && m_equal(object->key(), key))
+            {
+                return object;
+            }
+        }
+        return nullptr;
+    }
+
+    intrusive_ptr<T> find(const Key& key, uint64_t hash)
+    {
+        auto object = lookup(key, hash);
+        if (object == nullptr)
+        {
+            return intrusive_ptr<T>();
+        }
+
+        m_queue.touch(*object);
+        return intrusive_ptr<T>(object);
+    }
+
+    /// <summary>
+    /// Removes all entries, the references to them are moved to the list
+    /// </summary>
+    void clear(released_list& released) noexcept
+    {
+        std::fill(m_buckets.begin(), m_buckets.end(), nullptr);
+        m_queue.clear(released);
+        m_size = 0;
+    }
+
+    /// <summary>
+    /// Inserts the object, the references to the evicted entries are moved to the list
+    /// </summary>
+    bool insert(intrusive_ptr<T> object, uint64_t hash, released_list& evicted)
+    {
+        if (lookup(object->key(), hash) != nullptr)
+        {
+            return false;
+        }
+
+        if (m_size >= m_buckets.size())
+        {
+            rehash(m_buckets.size() * 2);
+        }
+
+        auto& hook = static_cast<hook_type&>(*object);
+        hook.m_hash = hash;
+        hook.m_chain_next = bucket(hash);
+        bucket(hash) = &hook;
+        m_queue.insert(std::move(object));
+        ++m_size;
+
+        while (m_size > m_capacity)
+        {
+            auto victim = m_queue.evict([](T& candidate) noexcept
+            {
+                return !Policy::skip_pinned || candidate.ReferenceCount() == 1;
+            });
+            if (!victim)
+            {
+                break;
+            }
+            unlink(*victim);
+            evicted.push_back(std::move(victim));
+        }
+        return true;
+    }
+
+    intrusive_ptr<T> erase(const Key& key, uint64_t hash)
+    {
+        auto object = lookup(key, hash);
+        if (object == nullptr)
+        {
+            return intrusive_ptr<T>();
+        }
+
+        unlink(*object);
+        return m_queue.erase(*object);
+    }
+
+    /// <summary>
+    /// Unlinks the entry from its hash chain
+    /// </summary>
+    void unlink(T& object) noexcept
+    {
+        auto& hook = static_cast<hook_type&>(object);
+        auto link = &bucket(hook.m_hash);
+        while (*link != &hook)
+        {
+            link = &(*link)->m_chain_next;
+        }
+        *link = hook.m_chain_next;
+        hook.m_chain_next = nullptr;
+        --m_size;
+    }
+
+    void rehash(size_t count)
+    {
+        auto buckets = std::vector<hook_type*>(count, nullptr);
+        for (auto current : m_buckets)
+        {
+            while (current != nullptr)
+            {
+                auto next = current->m_chain_next;
+                auto& head = buckets[current->m_hash & (count - 1)];
+                current->m_chain_next = head;
+                head = current;
+                current = next;
+            }
+        }
+        m_buckets.swap(buckets);
+    }
+
+private:
+    size_t m_capacity;
+    size_t m_size { 0 };
+    typename Policy::template queue<T, Tag> m_queue;
+    std::vector<hook_type*> m_buckets;
+    [[no_unique_address]] Hash m_hash;
+    [[no_unique_address]] KeyEqual m_equal;
+};
+
+/// <summary>
+/// A thread-safe cache split into shards, each of them is <see cref="intrusive_cache"/>
+/// guarded by its own mutex. The shard is selected by the high bits of the hash of the key,
+/// while the chains of a shard are selected by the low bits.
+/// </summary>
+template<class Key, class T, class Policy = lru_policy, class Hash = std::hash<Key>,
+    class KeyEqual = std::equal_to<Key>, class Tag = void>
+class sharded_cache final
+{
+    using cache_type = intrusive_cache<Key, T, Policy, Hash, KeyEqual, Tag>;
+    using released_list = typename cache_type::released_list;
+
+    struct alignas(64) shard
+    {
+        explicit shard(size_t capacity) : m_cache(capacity) { }
+
+        std::mutex m_mutex;
+        cache_type m_cache;
+    };
+
+public:
+    /// <summary>
+    /// Provides a new empty instance of <see cref="sharded_cache"/>
+    /// </summary>
+    /// <param name="capacity">
+    /// - The maximal number of entries, that is divided between the shards and must not be zero
+    /// </param>
+    /// <param name="shard_count">
+    /// - The number of shards, that is rounded up to a power of two
+    /// </param>
+    explicit sharded_cache(size_t capacity, size_t shard_count = 16)
+    {
+        auto count = std::bit_ceil(std::max<size_t>(shard_count, 1));
+        m_shard_bits = static_cast<unsigned>(std::countr_zero(count));
+        m_shards.reserve(count);
+        for (size_t i = 0; i < count; ++i)
+        {
+            m_shards.push_back(std::make_unique<shard>((capacity + count - 1) / count));
+        }
+    }
+
+    sharded_cache(const sharded_cache&) = delete;
+    sharded_cache& operator=(const sharded_cache&) = delete;
+
+    inline size_t size() const
+    {
+        auto count = size_t(0);
+        for (auto& current : m_shards)
+        {
+            auto lock = std::lock_guard(current->m_mutex);
+            count += current->m_cache.size();
+        }
+        return count;
+    }
+
+    inline intrusive_ptr<T> find(const Key& key)
+    {
+        auto hash = cache_type::mix(m_hash(key));
+        auto& current = shard_of(hash);
+        auto lock = std::lock_guard(current.m_mutex);
+        return current.m_cache.find(key, hash);
+    }
+
+    inline bool contains(const Key& key) const
+    {
+        auto hash = cache_type::mix(m_hash(key));
+        auto& current = shard_of(hash);
+        auto lock = std::lock_guard(current.m_mutex);
+        return current.m_cache.lookup(key, hash) != nullptr;
+    }
+
+    inline bool insert(intrusive_ptr<T> object)
+    {
+        if (!object)
+        {
+            return false;
+        }
+
+        auto hash = cache_type::mix(m_hash(object->key()));
+        auto& current = shard_of(hash);
+        auto evicted = released_list();
+        auto lock = std::lock_guard(current.m_mutex);
+        return current.m_cache.insert(std::move(object), hash, evicted);
+    }
+
+    /// <summary>
+    /// Finds the entry by the key or inserts the object created by the factory.
+    /// The factory is called under the lock of the shard.
+    /// </summary>
+    /// <param name="factory">
+    /// - A callable object that creates an object with the same key or returns an empty pointer
+    /// </param>
+    /// <returns>
+    /// A pointer to the cached entry or an empty pointer, if the factory returned it
+    /// </returns>
+    /// <exception cref="std::invalid_argument">
+    /// Thrown, if the key of the created object differs from the key, since the entry
+    /// would be filed under a shard and a chain, where its own key is never looked up
+    /// </exception>
+    template<class Factory>
+    intrusive_ptr<T> find_or_insert(const Key& key, Factory&& factory)
+    {
+        auto hash = cache_type::mix(m_hash(key));
+        auto& current = shard_of(hash);
+        auto evicted = released_list();
+        auto lock = std::lock_guard(current.m_mutex);
+        if (auto found = current.m_cache.find(key, hash))
+        {
+            return found;
+        }
+
+        auto created = intrusive_ptr<T>(factory());
+        if (!created)
+        {
+            return created;
+        }
+        if (!current.m_cache.m_equal(created->key(), key))
+        {
+            throw std::invalid_argument("The factory created an object with another key");
+        }
+
+        current.m_cache.insert(created, hash, evicted);
+        return created;
+    }
+
+    inline intrusive_ptr<T> erase(const Key& key)
+    {
+        auto hash = cache_type::mix(m_hash(key));
+        auto& current = shard_of(hash);
+        auto lock = std::lock_guard(current.m_mutex);
+        return current.m_cache.erase(key, hash);
+    }
+
+    /// <summary>
+    /// Removes all entries, the references to them are released outside of the locks of the shards
+    /// </summary>
+    inline void clear()
+    {
+        for (auto& current : m_shards)
+        {
+            auto released = released_list();
+            auto lock = std::lock_guard(current->m_mutex);
+            current->m_cache.clear(released);
+        }
+    }
+
+private:
+    inline shard& shard_of(uint64_t hash) const noexcept
+    {
+        return *m_shards[m_shard_bits != 0 ? hash >> (64 - m_shard_bits) : 0];
+    }
+
+private:
+    std::vector<std::unique_ptr<shard>> m_shards;
+    unsigned m_shard_bits { 0 };
+    [[no_unique_address]] Hash m_hash;
+};
@@ -0,0 +1,956 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+#include <bit>
+#include <memory>
+#include <span>
+#include <thread>
+#include "intrusive_ptr.h"
+
+/// <summary>
+/// An event count that lets the threads of a channel sleep on a futex until the state changes.
+/// The notifying side checks the number of sleepers first, so it makes no system calls
+/// while nobody waits.
+/// </summary>
+class channel_event final
+{
+public:
+    channel_event() noexcept = default;
+
+    channel_event(const channel_event&) = delete;
+    channel_event& operator=(const channel_event&) = delete;
+
+    /// <summary>
+    /// Registers the caller as a sleeper. The caller must check its condition again
+    /// after this call and then either wait for the returned key or cancel the wait.
+    /// </summary>
+    inline uint32_t prepare_wait() noexcept
+    {
+        m_waiters.fetch_add(1, std::memory_order_seq_cst);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        return m_key.load(std::memory_order_acquire);
+    }
+
+    inline void cancel_wait() noexcept
+    {
+        m_waiters.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    /// <summary>
+    /// Sleeps until the event is notified after the key was taken
+    /// </summary>
+    inline void wait(uint32_t key) noexcept
+    {
+        m_key.wait(key, std::memory_order_acquire);
+        m_waiters.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    /// <summary>
+    /// Wakes the sleepers up after the state they wait for has been published
+    /// </summary>
+    /// <param name="all">
+    /// - Whether all sleepers should be woken up instead of one
+    /// </param>
+    inline void notify(bool all) noexcept
+    {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (m_waiters.load(std::memory_order_relaxed) != 0)
+        {
+            m_key.fetch_add(1, std::memory_order_release);
+            if (all)
+            {
+                m_key.notify_all();
+            }
+            else
+            {
+                m_key.notify_one();
+            }
+        }
+    }
+
+private:
+    std::atomic<uint32_t> m_key { 0 };
+    std::atomic<uint32_t> m_waiters { 0 };
+};
+
+/// <summary>
+/// A bounded lock-free multi-producer multi-consumer channel of objects
+/// derived from <see cref="RefCountObject"/> (the Vyukov ring with the sequence numbers).
+/// A send transfers the reference of the caller into the ring and a receive transfers it out,
+/// so the messages pass the channel without any change of the reference count.
+/// The batch operations claim the consecutive cells with a single atomic operation.
+/// The blocking operations sleep on a futex while the channel is full or empty.
+/// </summary>
+/// <typeparam name="T">
+/// The type of the messages
+/// </typeparam>
+template<intrusive_counter_type T>
+class intrusive_channel final
+{
+    static constexpr size_t cache_line_size = 64;
+
+    struct cell
+    {
+        std::atomic<size_t> m_sequence;
+        T* m_value;
+    };
+
+public:
+    /// <summary>
+    /// Provides a new empty instance of <see cref="intrusive_channel"/>
+    /// </summary>
+    /// <param name="capacity">
+    /// - The maximum number of messages in the channel, rounded up to a power of two
+    /// </param>
+    explicit intrusive_channel(size_t capacity)
+        : m_mask(std::bit_ceil(capacity < 2 ? size_t(2) : capacity) - 1)
+        , m_cells(std::make_unique<cell[]>(m_mask + 1))
+    {
+        for (auto i = size_t(0); i <= m_mask; ++i)
+        {
+            m_cells[i].m_sequence.store(i, std::memory_order_relaxed);
+            m_cells[i].m_value = nullptr;
+        }
+    }
+
+    intrusive_channel(const intrusive_channel&) = delete;
+    intrusive_channel& operator=(const intrusive_channel&) = delete;
+
+    /// <summary>
+    /// Destroys a current instance of <see cref="intrusive_channel"/>
+    /// and releases the references to all messages left in the channel.
+    /// No thread may use the channel concurrently with the destruction.
+    /// </summary>
+    ~intrusive_channel()
+    {
+        auto end = m_send_position.load(std::memory_order_relaxed);
+        for (auto position = m_receive_position.load(std::memory_order_relaxed); position != end; ++position)
+        {
+            intrusive_ptr_release(m_cells[position & m_mask].m_value);
+        }
+    }
+
+    inline size_t capacity() const noexcept
+    {
+        return m_mask + 1;
+    }
+
+    /// <summary>
+    /// Closes the channel: the sends fail from now on, the receives drain the remaining messages
+    /// and then return empty pointers instead of blocking. Wakes all blocked threads up.
+    /// </summary>
+    inline void close() noexcept
+    {
+        m_closed.store(true, std::memory_order_seq_cst);
+        m_not_empty.notify(true);
+        m_not_full.notify(true);
+    }
+
+    inline bool is_closed() const noexcept
+    {
+        return m_closed.load(std::memory_order_acquire);
+    }
+
+    /// <summary>
+    /// Sends the message, if the channel is open and has a free cell.
+    /// An empty pointer is ignored and counts as sent, since an empty result of a receive means
+    /// that the channel is empty.
+    /// </summary>
+    /// <param name="message">
+    /// - A pointer to the message. The reference is transferred to the channel only on success,
+    /// otherwise the pointer keeps it.
+    /// </param>
+    /// <returns>
+    /// Returns <see langword="true"/>, if the message was sent, otherwise it returns <see langword="false"/>.
+    /// </returns>
+    inline bool try_send(intrusive_ptr<T>&& message) noexcept
+    {
+        return try_send(std::span<intrusive_ptr<T>>(&message, 1)) != 0;
+    }
+
+    /// <summary>
+    /// Sends the longest prefix of the messages that fits into the free cells of the channel.
+    /// The empty pointers take no cells: they are skipped and count as sent.
+    /// </summary>
+    /// <param name="messages">
+    /// - The pointers to the messages. The references of the sent prefix are transferred to the channel.
+    /// </param>
+    /// <returns>
+    /// The number of sent messages
+    /// </returns>
+    inline size_t try_send(std::span<intrusive_ptr<T>> messages) noexcept
+    {
+        if (messages.empty() || is_closed())
+        {
+            return 0;
+        }
+
+        auto present = size_t(0);
+        for (auto& message : messages)
+        {
+            present += message ? 1 : 0;
+        }
+
+        auto position = size_t(0);
+        auto count = present != 0 ? claim(m_send_position, present, 0, position) : size_t(0);
+        auto sent = size_t(0);
+        auto stored = size_t(0);
+        for (; sent < messages.size(); ++sent)
+        {
+            if (!messages[sent])
+            {
+                continue;
+            }
+            if (stored == count)
+            {
+                break;
+            }
+
+            auto& target = m_cells[(position + stored) & m_mask];
+            target.m_value = messages[sent].detach();
+            target.m_sequence.store(position + stored + 1, std::memory_order_release);
+            ++stored;
+        }
+
+        if (count != 0)
+        {
+            m_not_empty.notify(count > 1);
+        }
+        return sent;
+    }
+
+    /// <summary>
+    /// Sends the message and blocks while the channel is full
+    /// </summary>
+    /// <param name="message">
+    /// - A pointer to the message. The reference is transferred to the channel only on success,
+    /// otherwise the pointer keeps it.
+    /// </param>
+    /// <returns>
+    /// Returns <see langword="true"/>, if the message was sent,
+    /// or <see langword="false"/>, if the channel is closed.
+    /// </returns>
+    inline bool send(intrusive_ptr<T>&& message) noexcept
+    {
+        return send(std::span<intrusive_ptr<T>>(&message, 1)) != 0;
+    }
+
+    /// <summary>
+    /// Sends all messages in order and blocks while the channel is full
+    /// </summary>
+    /// <param name="messages">
+    /// - The pointers to the messages. The references of the sent prefix are transferred to the channel.
+    /// </param>
+    /// <returns>
+    /// The number of sent messages, that is less than the number of messages only if the channel is closed
+    /// </returns>
+    inline size_t send(std::span<intrusive_ptr<T>> messages) noexcept
+    {
+        auto sent = size_t(0);
+        while (sent < messages.size())
+        {
+            auto count = try_send(messages.subspan(sent));
+            if (count != 0)
+            {
+                sent += count;
+                continue;
+            }
+
+            auto key = m_not_full.prepare_wait();
+            if (is_closed())
+            {
+                m_not_full.cancel_wait();
+                break;
+            }
+            if (is_full())
+            {
+                m_not_full.wait(key);
+            }
+            else
+            {
+                m_not_full.cancel_wait();
+            }
+        }
+        return sent;
+    }
+
+    /// <summary>
+    /// Receives the next message, if the channel is not empty
+    /// </summary>
+    /// <returns>
+    /// A pointer to the message, that takes the reference held by the channel,
+    /// or an empty pointer, if the channel is empty
+    /// </returns>
+    inline intrusive_ptr<T> try_receive() noexcept
+    {
+        auto message = intrusive_ptr<T>();
+        try_consume([&](intrusive_ptr<T> received) { message = std::move(received); }, 1);
+        return message;
+    }
+
+    /// <summary>
+    /// Receives the next message and blocks while the channel is empty
+    /// </summary>
+    /// <returns>
+    /// A pointer to the message, that takes the reference held by the channel,
+    /// or an empty pointer, if the channel is closed and empty
+    /// </returns>
+    inline intrusive_ptr<T> receive() noexcept
+    {
+        auto message = intrusive_ptr<T>();
+        consume([&](intrusive_ptr<T> received) { message = std::move(received); }, 1);
+        return message;
+    }
+
+    /// <summary>
+    /// Receives up to the specified number of consecutive messages, that are ready,
+    /// and passes each of them to the handler in the order of the channel.
+    /// The reference held by the channel is transferred to the handler.
+    /// If the handler throws, the rest of the received messages are released and the exception is rethrown.
+    /// </summary>
+    /// <param name="handler">
+    /// - A callable object that accepts <see cref="intrusive_ptr"/> to a received message
+    /// </param>
+    /// <param name="max_count">
+    /// - The maximum number of messages to receive
+    /// </param>
+    /// <returns>
+    /// The number of received messages
+    /// </returns>
+    template<class Handler>
+    inline size_t try_consume(Handler&& handler, size_t max_count = SIZE_MAX)
+    {
+        if (max_count == 0)
+        {
+            return 0;
+        }
+
+        auto position = size_t(0);
+        auto count = claim(m_receive_position, max_count > capacity() ? capacity() : max_count, 1, position);
+        if (count == 0)
+        {
+            return 0;
+        }
+
+        // The cells are released before the handler runs, so the senders may proceed
+        T* values[64];
+        auto done = size_t(0);
+        auto chunk = size_t(0);
+        auto handled = size_t(0);
+        try
+        {
+            while (done < count)
+            {
+                chunk = count - done < 64 ? count - done : size_t(64);
+                take(position + done, chunk, values);
+
+                for (handled = 0; handled < chunk; ++handled)
+                {
+                    handler(intrusive_ptr<T>(values[handled], false));
+                }
+                done += chunk;
+                chunk = 0;
+            }
+        }
+        catch (...)
+        {
+            // The claimed cells cannot be returned to the channel, so the messages
+            // that were not passed to the handler yet are released
+            for (auto i = handled + 1; i < chunk; ++i)
+            {
+                intrusive_ptr_release(values[i]);
+            }
+            done += chunk;
+            while (done < count)
+            {
+                chunk = count - done < 64 ? count - done : size_t(64);
+                take(position + done, chunk, values);
+                for (auto i = size_t(0); i < chunk; ++i)
+                {
+                    intrusive_ptr_release(values[i]);
+                }
+                done += chunk;
+            }
+            throw;
+        }
+        return count;
+    }
+
+    /// <summary>
+    /// Blocks while the channel is empty, then receives up to the specified number of messages
+    /// like <see cref="try_consume"/>
+    /// </summary>
+    /// <returns>
+    /// The number of received messages, that is zero only if the channel is closed and empty
+    /// </returns>
+    template<class Handler>
+    inline size_t consume(Handler&& handler, size_t max_count = SIZE_MAX)
+    {
+        while (true)
+        {
+            auto count = try_consume(handler, max_count);
+            if (count != 0 || max_count == 0)
+            {
+                return count;
+            }
+
+            auto key = m_not_empty.prepare_wait();
+            if (!is_empty())
+            {
+                m_not_empty.cancel_wait();
+            }
+            else if (is_closed())
+            {
+                m_not_empty.cancel_wait();
+                return 0;
+            }
+            else
+            {
+                m_not_empty.wait(key);
+            }
+        }
+    }
+
+private:
+    /// <summary>
+    /// Moves the values out of the claimed cells and releases the cells to the senders
+    /// </summary>
+    inline void take(size_t position, size_t count, T** values) noexcept
+    {
+        for (auto i = size_t(0); i < count; ++i)
+        {
+            auto index = position + i;
+            auto& source = m_cells[index & m_mask];
+            values[i] = source.m_value;
+            source.m_value = nullptr;
+            source.m_sequence.store(index + m_mask + 1, std::memory_order_release);
+        }
+        m_not_full.notify(count > 1);
+    }
+
+    /// <summary>
+    /// Claims up to the specified number of consecutive cells, whose sequence numbers
+    /// are ahead of their positions by the lag, with a single CAS of the position
+    /// </summary>
+    /// <returns>
+    /// The number of claimed cells, that is zero if the first cell is not ready yet
+    /// </returns>
+    inline size_t claim(std::atomic<size_t>& counter, size_t max_count, size_t lag, size_t& position) noexcept
+    {
+        position = counter.load(std::memory_order_relaxed);
+        while (true)
+        {
+            auto count = size_t(0);
+            while (count < max_count
+                && m_cells[(position + count) & m_mask].m_sequence.load(std::memory_order_acquire) == position + count + lag)
+            {
+                ++count;
+            }
+
+            if (count == 0)
+            {
+                auto sequence = m_cells[position & m_mask].m_sequence.load(std::memory_order_acquire);
+                if (static_cast<intptr_t>(sequence - (position + lag)) < 0)
+                {
+                    return 0;
+                }
+                position = counter.load(std::memory_order_relaxed);
+                continue;
+            }
+
+            if (counter.compare_exchange_weak(position, position + count, std::memory_order_relaxed))
+            {
+                return count;
+            }
+        }
+    }
+
+    inline bool is_full() const noexcept
+    {
+        auto position = m_send_position.load(std::memory_order_relaxed);
+        auto sequence = m_cells[position & m_mask].m_sequence.load(std::memory_order_acquire);
+        return static_cast<intptr_t>(sequence - position) < 0;
+    }
+
+    inline bool is_empty() const noexcept
+    {
+        auto position = m_receive_position.load(std::memory_order_relaxed);
+        auto sequence = m_cells[position & m_mask].m_sequence.load(std::memory_order_acquire);
+        return static_cast<intptr_t>(sequence - (position + 1)) < 0;
+    }
+
+private:
+    const size_t m_mask;
+    const std::unique_ptr<cell[]> m_cells;
+    alignas(cache_line_size) std::atomic<size_t> m_send_position { 0 };
+    alignas(cache_line_size) std::atomic<size_t> m_receive_position { 0 };
+    alignas(cache_line_size) std::atomic<bool> m_closed { false };
+    channel_event m_not_empty;
+    channel_event m_not_full;
+};
+
+/// <summary>
+/// A bounded lock-free channel, that delivers every message to each of its current receivers.
+/// A cell holds the single reference of the sender to the message, that is shared by all receivers:
+/// the receivers visit the message without changing its reference count,
+/// and the last one of them releases the reference and frees the cell.
+/// The receivers that lag behind block the senders once the ring is full.
+/// </summary>
+/// <remarks>
+/// The receivers subscribe and unsubscribe at any time. The sender of a message stores
+/// the numbers of the subscriptions and the unsubscriptions it has observed in the cell,
+/// so a receiver reads only the messages, that count it, and its destructor leaves
+/// the counted messages it has not read. A message sent without receivers is released at once.
+/// </remarks>
+/// <typeparam name="T">
+/// The type of the messages
+/// </typeparam>
+template<intrusive_counter_type T>
+class broadcast_channel final
+{
+    static constexpr size_t cache_line_size = 64;
+
+    struct cell
+    {
+        std::atomic<size_t> m_sequence;
+        std::atomic<uint32_t> m_pending;
+        // The subscriptions and the unsubscriptions observed by the sender
+        std::atomic<uint64_t> m_joined;
+        std::atomic<uint64_t> m_departed;
+        T* m_value;
+    };
+
+public:
+    /// <summary>
+    /// A cursor of a single receiver of <see cref="broadcast_channel"/>.
+    /// Each receiver gets every message sent after its subscription.
+    /// A receiver may be used only by one thread at a time.
+    /// </summary>
+    class receiver final
+    {
+    public:
+        /// <summary>
+        /// Subscribes a new receiver to the channel, that must outlive it
+        /// </summary>
+        explicit receiver(broadcast_channel& channel) noexcept
+            : m_channel(&channel)
+            , m_joined(channel.m_joined.fetch_add(1, std::memory_order_seq_cst) + 1)
+        {
+            // The messages claimed from now on count the receiver. The ones claimed before
+            // may count it too, but not those a whole ring behind, since their cells could
+            // not have been reused without the receiver.
+            auto position = channel.m_send_position.load(std::memory_order_seq_cst);
+            m_position = position > channel.m_mask ? position - channel.m_mask - 1 : size_t(0);
+        }
+
+        receiver(const receiver&) = delete;
+        receiver& operator=(const receiver&) = delete;
+
+        /// <summary>
+        /// Unsubscribes the receiver and leaves the messages, that count it and have not been read.
+        /// Waits for the messages claimed by the concurrent senders, that are about to be stored.
+        /// </summary>
+        ~receiver()
+        {
+            m_departed = m_channel->m_departed.fetch_add(1, std::memory_order_seq_cst) + 1;
+            auto end = m_channel->m_send_position.load(std::memory_order_seq_cst);
+            for (; m_position != end; ++m_position)
+            {
+                auto& source = m_channel->cell_at(m_position);
+                while (static_cast<intptr_t>(source.m_sequence.load(std::memory_order_acquire) - (m_position + 1)) < 0)
+                {
+                    std::this_thread::yield();
+                }
+                if (counts(source))
+                {
+                    m_channel->leave(source, m_position);
+                }
+            }
+        }
+
+        /// <summary>
+        /// Passes up to the specified number of ready messages to the handler
+        /// as references, without changing their reference counts
+        /// </summary>
+        /// <param name="handler">
+        /// - A callable object that accepts a reference to a message
+        /// </param>
+        /// <param name="max_count">
+        /// - The maximum number of messages to visit
+        /// </param>
+        /// <returns>
+        /// The number of visited messages
+        /// </returns>
+        template<class Handler>
+        inline size_t try_visit(Handler&& handler, size_t max_count = SIZE_MAX)
+        {
+            auto count = size_t(0);
+            while (count < max_count)
+            {
+                auto source = next();
+                if (source == nullptr)
+                {
+                    break;
+                }
+
+                handler(static_cast<T&>(*source->m_value));
+                m_channel->leave(*source, m_position);
+                ++m_position;
+                ++count;
+            }
+            return count;
+        }
+
+        /// <summary>
+        /// Blocks while there are no messages for the receiver,
+        /// then visits up to the specified number of messages like <see cref="try_visit"/>
+        /// </summary>
+        /// <returns>
+        /// The number of visited messages, that is zero only if the channel is closed
+        /// and the receiver has visited all messages
+        /// </returns>
+        template<class Handler>
+        inline size_t visit(Handler&& handler, size_t max_count = SIZE_MAX)
+        {
+            while (true)
+            {
+                auto count = try_visit(handler, max_count);
+                if (count != 0 || max_count == 0)
+                {
+                    return count;
+                }
+
+                auto& event = m_channel->m_not_empty;
+                auto key = event.prepare_wait();
+                if (is_ready())
+                {
+                    event.cancel_wait();
+                }
+                else if (m_channel->is_closed())
+                {
+                    event.cancel_wait();
+                    return 0;
+                }
+                else
+                {
+                    event.wait(key);
+                }
+            }
+        }
+
+        /// <summary>
+        /// Receives the next message, if it is ready
+        /// </summary>
+        /// <returns>
+        /// A pointer to the message or an empty pointer. The last receiver of the message
+        /// takes the reference of the channel, the others add their own references.
+        /// </returns>
+        inline intrusive_ptr<T> try_receive() noexcept
+        {
+            auto next_cell = next();
+            if (next_cell == nullptr)
+            {
+                return intrusive_ptr<T>();
+            }
+
+            auto& source = *next_cell;
+            auto message = intrusive_ptr<T>();
+            if (source.m_pending.load(std::memory_order_acquire) == 1)
+            {
+                // No other receiver reads the cell any longer
+                message = intrusive_ptr<T>(source.m_value, false);
+                source.m_value = nullptr;
+                m_channel->release_cell(source, m_position);
+            }
+            else
+            {
+                message = intrusive_ptr<T>(source.m_value);
+                m_channel->leave(source, m_position);
+            }
+            ++m_position;
+            return message;
+        }
+
+        /// <summary>
+        /// Receives the next message and blocks while there are no messages for the receiver
+        /// </summary>
+        /// <returns>
+        /// A pointer to the message or an empty pointer, if the channel is closed
+        /// and the receiver has received all messages
+        /// </returns>
+        inline intrusive_ptr<T> receive() noexcept
+        {
+            while (true)
+            {
+                if (auto message = try_receive())
+                {
+                    return message;
+                }
+
+                auto& event = m_channel->m_not_empty;
+                auto key = event.prepare_wait();
+                if (is_ready())
+                {
+                    event.cancel_wait();
+                }
+                else if (m_channel->is_closed())
+                {
+                    event.cancel_wait();
+                    return intrusive_ptr<T>();
+                }
+                else
+                {
+                    event.wait(key);
+                }
+            }
+        }
+
+    private:
+        inline bool is_ready() noexcept
+        {
+            return next() != nullptr;
+        }
+
+        /// <summary>
+        /// Skips the messages, that do not count the receiver
+        /// </summary>
+        /// <returns>
+        /// The cell of the next message for the receiver or nullptr, if it has not been sent yet
+        /// </returns>
+        inline cell* next() noexcept
+        {
+            while (true)
+            {
+                auto& source = m_channel->cell_at(m_position);
+                auto difference = static_cast<intptr_t>(source.m_sequence.load(std::memory_order_acquire) - (m_position + 1));
+                if (difference < 0)
+                {
+                    return nullptr;
+                }
+                if (difference == 0 && counts(source))
+                {
+                    return &source;
+                }
+                // The message was sent before the subscription, and its cell may be reused already
+                ++m_position;
+            }
+        }
+
+        /// <summary>
+        /// Checks whether the stored message at the current position counts the receiver.
+        /// A cell that does not count the receiver may be reused meanwhile, so the sequence
+        /// is read again after the counters.
+        /// </summary>
+        inline bool counts(const cell& source) const noexcept
+        {
+            auto joined = source.m_joined.load(std::memory_order_relaxed);
+            auto departed = source.m_departed.load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            return source.m_sequence.load(std::memory_order_relaxed) == m_position + 1
+                && m_joined <= joined && m_departed > departed;
+        }
+
+    private:
+        broadcast_channel* m_channel;
+        size_t m_position { 0 };
+        uint64_t m_joined;
+        uint64_t m_departed { UINT64_MAX };
+    };
+
+    /// <summary>
+    /// Provides a new empty instance of <see cref="broadcast_channel"/>
+    /// </summary>
+    /// <param name="capacity">
+    /// - The maximum number of messages in the channel, rounded up to a power of two
+    /// </param>
+    explicit broadcast_channel(size_t capacity)
+        : m_mask(std::bit_ceil(capacity < 2 ? size_t(2) : capacity) - 1)
+        , m_cells(std::make_unique<cell[]>(m_mask + 1))
+    {
+        for (auto i = size_t(0); i <= m_mask; ++i)
+        {
+            m_cells[i].m_sequence.store(i, std::memory_order_relaxed);
+            m_cells[i].m_pending.store(0, std::memory_order_relaxed);
+            m_cells[i].m_joined.store(0, std::memory_order_relaxed);
+            m_cells[i].m_departed.store(0, std::memory_order_relaxed);
+            m_cells[i].m_value = nullptr;
+        }
+    }
+
+    broadcast_channel(const broadcast_channel&) = delete;
+    broadcast_channel& operator=(const broadcast_channel&) = delete;
+
+    /// <summary>
+    /// Destroys a current instance of <see cref="broadcast_channel"/>
+    /// and releases the references to all messages not read by every receiver.
+    /// No thread may use the channel concurrently with the destruction,
+    /// and all its receivers must be destroyed before.
+    /// </summary>
+    ~broadcast_channel()
+    {
+        // Only the last capacity positions may hold messages, the ones that are still
+        // readable have the sequence numbers set by the sender
+        auto end = m_send_position.load(std::memory_order_relaxed);
+        auto position = end > m_mask ? end - m_mask - 1 : size_t(0);
+        for (; position != end; ++position)
+        {
+            auto& source = cell_at(position);
+            if (source.m_sequence.load(std::memory_order_relaxed) == position + 1)
+            {
+                intrusive_ptr_release(source.m_value);
+            }
+        }
+    }
+
+    inline size_t capacity() const noexcept
+    {
+        return m_mask + 1;
+    }
+
+    /// <summary>
+    /// Closes the channel: the sends fail from now on, the receivers read the remaining messages
+    /// and then stop blocking. Wakes all blocked threads up.
+    /// </summary>
+    inline void close() noexcept
+    {
+        m_closed.store(true, std::memory_order_seq_cst);
+        m_not_empty.notify(true);
+        m_not_full.notify(true);
+    }
+
+    inline bool is_closed() const noexcept
+    {
+        return m_closed.load(std::memory_order_acquire);
+    }
+
+    /// <summary>
+    /// Sends the message to all current receivers, if the channel is open and has a free cell.
+    /// An empty pointer is ignored and counts as sent.
+    /// </summary>
+    /// <param name="message">
+    /// - A pointer to the message. The reference is transferred to the channel only on success,
+    /// otherwise the pointer keeps it.
+    /// </param>
+    /// <returns>
+    /// Returns <see langword="true"/>, if the message was sent, otherwise it returns <see langword="false"/>.
+    /// </returns>
+    inline bool try_send(intrusive_ptr<T>&& message) noexcept
+    {
+        if (is_closed())
+        {
+            return false;
+        }
+        if (!message)
+        {
+            return true;
+        }
+
+        auto position = m_send_position.load(std::memory_order_relaxed);
+        while (true)
+        {
+            auto sequence = cell_at(position).m_sequence.load(std::memory_order_acquire);
+            auto difference = static_cast<intptr_t>(sequence - position);
+            if (difference < 0)
+            {
+                return false;
+            }
+            if (difference > 0)
+            {
+                position = m_send_position.load(std::memory_order_relaxed);
+            }
+            else if (m_send_position.compare_exchange_weak(position, position + 1,
+                std::memory_order_seq_cst, std::memory_order_relaxed))
+            {
+                break;
+            }
+        }
+
+        // A receiver unsubscribes only after it has subscribed, so the departures are read first
+        // and the difference is the number of the receivers counted by the message
+        auto departed = m_departed.load(std::memory_order_seq_cst);
+        auto joined = m_joined.load(std::memory_order_seq_cst);
+        auto& target = cell_at(position);
+        if (joined == departed)
+        {
+            message.reset(nullptr);
+            release_cell(target, position);
+            return true;
+        }
+
+        target.m_value = message.detach();
+        target.m_pending.store(static_cast<uint32_t>(joined - departed), std::memory_order_relaxed);
+        target.m_joined.store(joined, std::memory_order_relaxed);
+        target.m_departed.store(departed, std::memory_order_relaxed);
+        target.m_sequence.store(position + 1, std::memory_order_release);
+        m_not_empty.notify(true);
+        return true;
+    }
+
+    /// <summary>
+    /// Sends the message to all receivers and blocks while the channel is full
+    /// </summary>
+    /// <returns>
+    /// Returns <see langword="true"/>, if the message was sent,
+    /// or <see langword="false"/>, if the channel is closed.
+    /// </returns>
+    inline bool send(intrusive_ptr<T>&& message) noexcept
+    {
+        while (!try_send(std::move(message)))
+        {
+            auto key = m_not_full.prepare_wait();
+            if (is_closed())
+            {
+                m_not_full.cancel_wait();
+                return false;
+            }
+
+            auto position = m_send_position.load(std::memory_order_relaxed);
+            auto sequence = cell_at(position).m_sequence.load(std::memory_order_acquire);
+            if (static_cast<intptr_t>(sequence - position) < 0)
+            {
+                m_not_full.wait(key);
+            }
+            else
+            {
+                m_not_full.cancel_wait();
+            }
+        }
+        return true;
+    }
+
+private:
+    inline cell& cell_at(size_t position) const noexcept
+    {
+        return m_cells[position & m_mask];
+    }
+
+    /// <summary>
+    /// Marks the cell as read by one more receiver and frees it after the last one
+    /// </summary>
+    inline void leave(cell& source, size_t position) noexcept
+    {
+        if (source.m_pending.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        {
+            intrusive_ptr_release(source.m_value);
+            source.m_value = nullptr;
+            release_cell(source, position);
+        }
+    }
+
+    inline void release_cell(cell& source, size_t position) noexcept
+    {
+        source.m_sequence.store(position + m_mask + 1, std::memory_order_release);
+        m_not_full.notify(false);
+    }
+
+private:
+    const size_t m_mask;
+    const std::unique_ptr<cell[]> m_cells;
+    alignas(cache_line_size) std::atomic<uint64_t> m_joined { 0 };
+    std::atomic<uint64_t> m_departed { 0 };
+    alignas(cache_line_size) std::atomic<size_t> m_send_position { 0 };
+    alignas(cache_line_size) std::atomic<bool> m_closed { false };
+    channel_event m_not_empty;
+    channel_event m_not_full;
+};
@@ -0,0 +1,508 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <future>
+#include <new>
+#include <optional>
+#include <type_traits>
+#include <utility>
+#include <variant>
+#include "intrusive_ptr.h"
+
+/// <summary>
+/// A type-erased callable object, that is stored inline when it fits into the buffer,
+/// so installing a continuation usually allocates no memory
+/// </summary>
+/// <typeparam name="Argument">
+/// The type of the argument passed to the callable object by reference
+/// </typeparam>
+template<class Argument>
+class future_continuation final
+{
+    static constexpr size_t inline_size = 64;
+
+    using invoke_type = void (*)(void* storage, Argument& argument);
+    using destroy_type = void (*)(void* storage) noexcept;
+
+public:
+    future_continuation() noexcept = default;
+
+    future_continuation(const future_continuation&) = delete;
+    future_continuation& operator=(const future_continuation&) = delete;
+
+    ~future_continuation()
+    {
+        if (m_destroy != nullptr)
+        {
+            m_destroy(m_buffer);
+        }
+    }
+
+    /// <summary>
+    /// Stores the callable object
+    /// </summary>
+    template<class Function>
+    inline void emplace(Function&& function)
+    {
+        using function_type = std::decay_t<Function>;
+        if constexpr (sizeof(function_type) <= inline_size
+            && alignof(function_type) <= alignof(std::max_align_t)
+            && std::is_nothrow_move_constructible_v<function_type>)
+        {
+            new (m_buffer) function_type(std::forward<Function>(function));
+            m_invoke = [](void* storage, Argument& argument)
+            {
+                (*static_cast<function_type*>(storage))(argument);
+            };
+            m_destroy = [](void* storage) noexcept
+            {
+                static_cast<function_type*>(storage)->~function_type();
+            };
+        }
+        else
+        {
+            *reinterpret_cast<function_type**>(m_buffer) = new function_type(std::forward<Function>(function));
+            m_invoke = [](void* storage, Argument& argument)
+            {
+                (**static_cast<function_type**>(storage))(argument);
+            };
+            m_destroy = [](void* storage) noexcept
+            {
+                delete *static_cast<function_type**>(storage);
+            };
+        }
+    }
+
+    /// <summary>
+    /// Invokes the stored callable object once and destroys it, even if the invocation throws
+    /// </summary>
+    inline void operator()(Argument& argument)
+    {
+        auto guard = destroy_guard { std::exchange(m_destroy, nullptr), m_buffer };
+        m_invoke(m_buffer, argument);
+    }
+
+private:
+    struct destroy_guard
+    {
+        destroy_type destroy;
+        void* storage;
+
+        ~destroy_guard() noexcept
+        {
+            destroy(storage);
+        }
+    };
+
+private:
+    alignas(std::max_align_t) unsigned char m_buffer[inline_size];
+    invoke_type m_invoke { nullptr };
+    destroy_type m_destroy { nullptr };
+};
+
+/// <summary>
+/// The shared state of <see cref="intrusive_promise"/> and <see cref="intrusive_future"/>
+/// allocated once: the reference count, the result, the continuation and the state word live in it.
+/// </summary>
+template<class T>
+class future_state final : public RefCountObject<future_state<T>>
+{
+    using stored_type = std::conditional_t<std::is_void_v<T>, std::monostate, T>;
+
+public:
+    // The bits of the state word
+    static constexpr uint32_t satisfied = 1;
+    static constexpr uint32_t ready = 2;
+    static constexpr uint32_t continued = 4;
+    static constexpr uint32_t waiting = 8;
+    static constexpr uint32_t retrieved = 16;
+
+    inline bool is_ready() const noexcept
+    {
+        return (m_state.load(std::memory_order_acquire) & ready) != 0;
+    }
+
+    inline bool is_satisfied() const noexcept
+    {
+        return (m_state.load(std::memory_order_acquire) & satisfied) != 0;
+    }
+
+    /// <summary>
+    /// Marks the future as retrieved. Returns false, if it has been retrieved already.
+    /// </summary>
+    inline bool retrieve() noexcept
+    {
+        return (m_state.fetch_or(retrieved, std::memory_order_relaxed) & retrieved) == 0;
+    }
+
+    /// <summary>
+    /// Stores the value. Throws <see cref="std::future_error"/>, if the state is satisfied already.
+    /// An exception thrown by the constructor of the value is propagated to the caller
+    /// and leaves the state unsatisfied, like <see cref="std::promise::set_value"/> does.
+    /// </summary>
+    template<class... Args>
+    inline void set_value(Args&&... args)
+    {
+        claim();
+        try
+        {
+            m_value.emplace(std::forward<Args>(args)...);
+        }
+        catch (...)
+        {
+            m_state.fetch_and(~satisfied, std::memory_order_acq_rel);
+            throw;
+        }
+        publish();
+    }
+
+    /// <summary>
+    /// Stores the exception. Throws <see cref="std::future_error"/>, if the state is satisfied already.
+    /// </summary>
+    inline void set_exception(std::exception_ptr exception)
+    {
+        claim();
+        m_exception = std::move(exception);
+        publish();
+    }
+
+    /// <summary>
+    /// Stores the exception, if the state is not satisfied yet
+    /// </summary>
+    inline bool try_set_exception(std::exception_ptr exception) noexcept
+    {
+        if ((m_state.fetch_or(satisfied, std::memory_order_acq_rel) & satisfied) != 0)
+        {
+            return false;
+        }
+        m_exception = std::move(exception);
+        publish();
+        return true;
+    }
+
+    /// <summary>
+    /// Blocks on the state word until the result is ready
+    /// </summary>
+    inline void wait() noexcept
+    {
+        auto state = m_state.load(std::memory_order_acquire);
+        while ((state & ready) == 0)
+        {
+            if ((state & waiting) == 0)
+            {
+                state = m_state.fetch_or(waiting, std::memory_order_acq_rel) | waiting;
+                continue;
+            }
+            m_state.wait(state, std::memory_order_acquire);
+            state = m_state.load(std::memory_order_acquire);
+        }
+    }
+
+    /// <summary>
+    /// Returns the stored value or rethrows the stored exception. The result must be ready.
+    /// </summary>
+    inline stored_type& value()
+    {
+        if (m_exception)
+        {
+            std::rethrow_exception(m_exception);
+        }
+        return *m_value;
+    }
+
+    inline const std::exception_ptr& exception() const noexcept
+    {
+        return m_exception;
+    }
+
+    /// <summary>
+    /// Installs the continuation, that is run by the thread storing the result,
+    /// or by the current thread, if the result is ready already
+    /// </summary>
+    template<class Function>
+    inline void set_continuation(Function&& function)
+    {
+        m_continuation.emplace(std::forward<Function>(function));
+        if ((m_state.fetch_or(continued, std::memory_order_acq_rel) & ready) != 0)
+        {
+            m_continuation(*this);
+        }
+    }
+
+private:
+    inline void claim()
+    {
+        if ((m_state.fetch_or(satisfied, std::memory_order_acq_rel) & satisfied) != 0)
+        {
+            throw std::future_error(std::future_errc::promise_already_satisfied);
+        }
+    }
+
+    inline void publish()
+    {
+        auto previous = m_state.fetch_or(ready, std::memory_order_acq_rel);
+        if ((previous & waiting) != 0)
+        {
+            m_state.notify_all();
+        }
+        if ((previous & continued) != 0)
+        {
+            m_continuation(*this);
+        }
+    }
+
+private:
+    std::atomic<uint32_t> m_state { 0 };
+    std::optional<stored_type> m_value;
+    std::exception_ptr m_exception;
+    future_continuation<future_state> m_continuation;
+};
+
+template<class T>
+class intrusive_future;
+
+/// <summary>
+/// The producer side of a single-allocation future. The promise and its future share
+/// one <see cref="future_state"/> derived from <see cref="RefCountObject"/>.
+/// A promise destroyed without a result stores <see cref="std::future_errc::broken_promise"/>.
+/// </summary>
+/// <typeparam name="T">
+/// The type of the result
+/// </typeparam>
+template<class T>
+class intrusive_promise final
+{
+public:
+    intrusive_promise() : m_state(make_intrusive<future_state<T>>()) { }
+
+    intrusive_promise(intrusive_promise&&) noexcept = default;
+    intrusive_promise& operator=(intrusive_promise&& other) noexcept
+    {
+        abandon();
+        m_state = std::move(other.m_state);
+        return *this;
+    }
+
+    intrusive_promise(const intrusive_promise&) = delete;
+    intrusive_promise& operator=(const intrusive_promise&) = delete;
+
+    ~intrusive_promise()
+    {
+        abandon();
+    }
+
+    /// <summary>
+    /// Provides the future of the shared state
+    /// </summary>
+    /// <exception cref="std::future_error">
+    /// Thrown with <see cref="std::future_errc::future_already_retrieved"/>, if the future has been provided already
+    /// </exception>
+    inline intrusive_future<T> get_future()
+    {
+        if (!m_state->retrieve())
+        {
+            throw std::future_error(std::future_errc::future_already_retrieved);
+        }
+        return intrusive_future<T>(m_state);
+    }
+
+    /// <summary>
+    /// Stores the value and runs the continuation or wakes the waiters up.
+    /// If the constructor of the value throws, the exception reaches the caller
+    /// and the promise may still be satisfied.
+    /// </summary>
+    template<class... Args>
+    inline void set_value(Args&&... args)
+    {
+        m_state->set_value(std::forward<Args>(args)...);
+    }
+
+    inline void set_exception(std::exception_ptr exception)
+    {
+        m_state->set_exception(std::move(exception));
+    }
+
+private:
+    inline void abandon() noexcept
+    {
+        // The error is not built for a satisfied state, since the promise is its only producer
+        if (m_state && !m_state->is_satisfied())
+        {
+            m_state->try_set_exception(std::make_exception_ptr(std::future_error(std::future_errc::broken_promise)));
+        }
+    }
+
+private:
+    intrusive_ptr<future_state<T>> m_state;
+};
+
+/// <summary>
+/// The consumer side of a single-allocation future. Waiting sleeps on the futex of the state word
+/// only when the result is not ready, and a continuation attached by <see cref="then"/>
+/// is stored inline in the shared state.
+/// </summary>
+/// <typeparam name="T">
+/// The type of the result
+/// </typeparam>
+template<class T>
+class intrusive_future final
+{
+    template<class U>
+    friend class intrusive_future;
+
+public:
+    intrusive_future() noexcept = default;
+
+    explicit intrusive_future(intrusive_ptr<future_state<T>> state) noexcept : m_state(std::move(state)) { }
+
+    intrusive_future(intrusive_future&&) noexcept = default;
+    intrusive_future& operator=(intrusive_future&&) noexcept = default;
+
+    intrusive_future(const intrusive_future&) = delete;
+    intrusive_future& operator=(const intrusive_future&) = delete;
+
+    /// <summary>
+    /// Checks whether the future refers to a shared state
+    /// </summary>
+    inline bool valid() const noexcept
+    {
+        return static_cast<bool>(m_state);
+    }
+
+    inline bool is_ready() const noexcept
+    {
+        return m_state->is_ready();
+    }
+
+    /// <summary>
+    /// Blocks until the result is ready
+    /// </summary>
+    inline void wait() const noexcept
+    {
+        m_state->wait();
+    }
+
+    /// <summary>
+    /// Waits for the result and takes it out of the future, that becomes invalid
+    /// </summary>
+    /// <returns>
+    /// The value of the result. The stored exception is rethrown.
+    /// </returns>
+    inline T get()
+    {
+        auto state = std::move(m_state);
+        state->wait();
+        if constexpr (std::is_void_v<T>)
+        {
+            state->value();
+        }
+        else
+        {
+            return std::move(state->value());
+        }
+    }
+
+    /// <summary>
+    /// Attaches the continuation, that is invoked with the value, when the result is ready.
+    /// The future becomes invalid. The exception of the result or of the continuation
+    /// is passed to the returned future, the continuation is not invoked on an exception.
+    /// </summary>
+    /// <param name="function">
+    /// - A callable object that accepts the value, or nothing for <c>intrusive_future&lt;void&gt;</c>
+    /// </param>
+    /// <returns>
+    /// The future of the result of the continuation
+    /// </returns>
+    template<class Function>
+    inline auto then(Function&& function)
+    {
+        using result_type = typename decltype(invoke_result_tag<Function>())::type;
+
+        auto state = std::move(m_state);
+        auto next = make_intrusive<future_state<result_type>>();
+        auto future = intrusive_future<result_type>(next);
+        state->set_continuation(
+            [function = std::forward<Function>(function), next = std::move(next)](future_state<T>& source) mutable
+            {
+                if (source.exception())
+                {
+                    next->set_exception(source.exception());
+                    return;
+                }
+
+                try
+                {
+                    if constexpr (std::is_void_v<T> && std::is_void_v<result_type>)
+                    {
+                        function();
+                        next->set_value();
+                    }
+                    else if constexpr (std::is_void_v<T>)
+                    {
+                        next->set_value(function());
+                    }
+                    else if constexpr (std::is_void_v<result_type>)
+                    {
+                        function(std::move(source.value()));
+                        next->set_value();
+                    }
+                    else
+                    {
+                        next->set_value(function(std::move(source.value())));
+                    }
+                }
+                catch (...)
+                {
+                    next->set_exception(std::current_exception());
+                }
+            });
+        return future;
+    }
+
+private:
+    template<class Type>
+    struct type_tag
+    {
+        using type = Type;
+    };
+
+    template<class Function>
+    static auto invoke_result_tag()
+    {
+        if constexpr (std::is_void_v<T>)
+        {
+            return type_tag<std::invoke_result_t<Function>>();
+        }
+        else
+        {
+            return type_tag<std::invoke_result_t<Function, T&&>>();
+        }
+    }
+
+private:
+    intrusive_ptr<future_state<T>> m_state;
+};
+
+/// <summary>
+/// Creates a future, whose result is the specified value
+/// </summary>
+template<class T>
+inline intrusive_future<std::decay_t<T>> make_ready_future(T&& value)
+{
+    auto state = make_intrusive<future_state<std::decay_t<T>>>();
+    state->set_value(std::forward<T>(value));
+    return intrusive_future<std::decay_t<T>>(std::move(state));
+}
+
+/// <summary>
+/// Creates a future of void, that is ready
+/// </summary>
+inline intrusive_future<void> make_ready_future()
+{
+    auto state = make_intrusive<future_state<void>>();
+    state->set_value();
+    return intrusive_future<void>(std::move(state));
+}
@@ -0,0 +1,407 @@
+#pragma once
+#include <stddef.h>
+#include <cassert>
+#include <functional>
+#include <type_traits>
+#include <vector>
+#include "intrusive_ptr.h"
+
+template<intrusive_counter_type T, class Compare, unsigned Arity, class Tag>
+class intrusive_heap;
+
+/// <summary>
+/// A heap hook embedded into an object next to <see cref="RefCountObject"/>.
+/// The hook holds the index of the object in <see cref="intrusive_heap"/>,
+/// so the object may be updated or erased by the reference without searching for it.
+/// </summary>
+/// <typeparam name="Tag">
+/// A tag type that distinguishes several heap hooks of the same object
+/// </typeparam>
+template<class Tag = void>
+class intrusive_heap_hook
+{
+    template<intrusive_counter_type T, class Compare, unsigned Arity, class HeapTag>
+    friend class intrusive_heap;
+
+    static constexpr size_t npos = static_cast<size_t>(-1);
+
+public:
+    intrusive_heap_hook() noexcept = default;
+
+    /// <summary>
+    /// Provides a new unlinked instance of <see cref="intrusive_heap_hook"/>.
+    /// The index of the copied object is never copied.
+    /// </summary>
+    intrusive_heap_hook(const intrusive_heap_hook&) noexcept { }
+
+    intrusive_heap_hook& operator=(const intrusive_heap_hook&) noexcept
+    {
+        return *this;
+    }
+
+    /// <summary>
+    /// Checks whether the object is a member of a heap through the current hook
+    /// </summary>
+    inline bool is_linked() const noexcept
+    {
+        return m_index != npos;
+    }
+
+private:
+    size_t m_index { npos };
+};
+
+/// <summary>
+/// A type concept that allows you to create intrusive heaps only of the objects
+/// that contain <see cref="intrusive_heap_hook"/> with the specified tag
+/// </summary>
+template<typename T, class Tag>
+concept intrusive_heap_type =
+    intrusive_counter_type<T> && std::is_base_of_v<intrusive_heap_hook<Tag>, T>;
+
+/// <summary>
+/// A d-ary min-heap of objects derived from <see cref="RefCountObject"/>,
+/// that keep their indices in the embedded <see cref="intrusive_heap_hook"/>.
+/// The heap holds one reference to each of its members. The members are moved inside the heap
+/// as raw pointers, so the sifts never change the reference counts.
+/// The push, the pop, the update and the erase by the reference take O(log n).
+/// If the comparison throws, the operation restores the members moved by the sift and rethrows,
+/// so the heap stays as it was before the operation.
+/// </summary>
+/// <typeparam name="T">
+/// The type of the members
+/// </typeparam>
+/// <typeparam name="Compare">
+/// The strict weak ordering of the members. The top of the heap is the least member.
+/// </typeparam>
+/// <typeparam name="Arity">
+/// The number of children of a node
+/// </typeparam>
+/// <typeparam name="Tag">
+/// The tag of the hook, through which the members are linked
+/// </typeparam>
+template<intrusive_counter_type T, class Compare = std::less<T>, unsigned Arity = 4, class Tag = void>
+class intrusive_heap final
+{
+    static_assert(intrusive_heap_type<T, Tag>,
+        "The type must be derived from RefCountObject and intrusive_heap_hook with the same tag");
+    static_assert(Arity >= 2, "The heap must have at least two children per node");
+
+    using hook_type = intrusive_heap_hook<Tag>;
+
+    static constexpr bool nothrow_compare() noexcept
+    {
+        if constexpr (std::is_same_v<Compare, std::less<T>>)
+        {
+            // The standard function object does not declare noexcept on every library
+            return noexcept(static_cast<bool>(std::declval<const T&>() < std::declval<const T&>()));
+        }
+        else
+        {
+            return std::is_nothrow_invocable_r_v<bool, Compare&, const T&, const T&>;
+        }
+    }
+
+public:
+    /// <summary>
+    /// Provides a new empty instance of <see cref="intrusive_heap"/>
+    /// </summary>
+    intrusive_heap() noexcept = default;
+
+    intrusive_heap(const intrusive_heap&) = delete;
+    intrusive_heap& operator=(const intrusive_heap&) = delete;
+
+    /// <summary>
+    /// Destroys a current instance of <see cref="intrusive_heap"/>
+    /// and releases the references to all of its members
+    /// </summary>
+    ~intrusive_heap()
+    {
+        clear();
+    }
+
+    inline bool empty() const noexcept
+    {
+        return m_items.empty();
+    }
+
+    inline size_t size() const noexcept
+    {
+        return m_items.size();
+    }
+
+    /// <summary>
+    /// Reserves the storage for the specified number of members
+    /// </summary>
+    inline void reserve(size_t count)
+    {
+        m_items.reserve(count);
+    }
+
+    /// <summary>
+    /// Provides the least member without taking a reference. The heap must not be empty.
+    /// </summary>
+    inline T& top() const noexcept
+    {
+        return *m_items.front();
+    }
+
+    /// <summary>
+    /// Checks whether the object is a member of the current heap
+    /// </summary>
+    inline bool contains(const T& object) const noexcept
+    {
+        auto index = static_cast<const hook_type&>(object).m_index;
+        return index < m_items.size() && m_items[index] == &object;
+    }
+
+    /// <summary>
+    /// Adds the object, that is not a member of any heap through the same hook.
+    /// An empty pointer is ignored.
+    /// </summary>
+    /// <param name="ptr">
+    /// - A pointer to the object. The reference is transferred to the heap only on success.
+    /// </param>
+    inline void push(intrusive_ptr<T> ptr)
+    {
+        if (!ptr)
+        {
+            return;
+        }
+
+        m_items.push_back(nullptr);
+        try
+        {
+            sift_up(ptr.get(), m_items.size() - 1);
+        }
+        catch (...)
+        {
+            m_items.pop_back();
+            throw;
+        }
+        ptr.detach();
+    }
+
+    /// <summary>
+    /// Removes the least member. The heap must not be empty.
+    /// </summary>
+    /// <returns>
+    /// A pointer to the removed member, that takes the reference held by the heap
+    /// </returns>
+    inline intrusive_ptr<T> pop() noexcept(nothrow_compare())
+    {
+        return remove_at(0);
+    }
+
+    /// <summary>
+    /// Removes the member of the heap
+    /// </summary>
+    /// <param name="object">
+    /// - A reference to a member of the current heap
+    /// </param>
+    /// <returns>
+    /// A pointer to the removed member, that takes the reference held by the heap
+    /// </returns>
+    inline intrusive_ptr<T> erase(T& object) noexcept(nothrow_compare())
+    {
+        assert(contains(object) && "The object is not a member of the heap");
+        return remove_at(static_cast<hook_type&>(object).m_index);
+    }
+
+    /// <summary>
+    /// Restores the order of the heap after the key of the member has been changed in any direction
+    /// </summary>
+    /// <param name="object">
+    /// - A reference to a member of the current heap
+    /// </param>
+    inline void update(T& object) noexcept(nothrow_compare())
+    {
+        assert(contains(object) && "The object is not a member of the heap");
+        auto index = static_cast<hook_type&>(object).m_index;
+        try
+        {
+            reposition(&object, index);
+        }
+        catch (...)
+        {
+            place(&object, index);
+            throw;
+        }
+    }
+
+    /// <summary>
+    /// Restores the order of the heap after the key of the member has been decreased
+    /// </summary>
+    /// <param name="object">
+    /// - A reference to a member of the current heap
+    /// </param>
+    inline void decrease(T& object) noexcept(nothrow_compare())
+    {
+        assert(contains(object) && "The object is not a member of the heap");
+        auto index = static_cast<hook_type&>(object).m_index;
+        try
+        {
+            sift_up(&object, index);
+        }
+        catch (...)
+        {
+            place(&object, index);
+            throw;
+        }
+    }
+
+    /// <summary>
+    /// Removes all members and releases the references to them.
+    /// The members are released after the heap is emptied, so their destructors may use the heap.
+    /// </summary>
+    inline void clear() noexcept
+    {
+        auto items = std::move(m_items);
+        m_items.clear();
+        for (auto item : items)
+        {
+            static_cast<hook_type*>(item)->m_index = hook_type::npos;
+        }
+        for (auto item : items)
+        {
+            intrusive_ptr_release(item);
+        }
+    }
+
+private:
+    static inline size_t parent(size_t index) noexcept
+    {
+        return (index - 1) / Arity;
+    }
+
+    inline void place(T* item, size_t index) noexcept
+    {
+        m_items[index] = item;
+        static_cast<hook_type*>(item)->m_index = index;
+    }
+
+    /// <summary>
+    /// Moves the hole at the index up until the item may be placed there.
+    /// If the comparison throws, the hole is moved back to the index.
+    /// </summary>
+    inline void sift_up(T* item, size_t index) noexcept(nothrow_compare())
+    {
+        auto hole = index;
+        try
+        {
+            while (hole > 0)
+            {
+                auto up = parent(hole);
+                if (!m_compare(*item, *m_items[up]))
+                {
+                    break;
+                }
+                place(m_items[up], hole);
+                hole = up;
+            }
+        }
+        catch (...)
+        {
+            // Each moved member returns one level up, starting from the one next to the index
+            auto carried = m_items[index];
+            for (auto current = index; current != hole;)
+            {
+                current = parent(current);
+                std::swap(carried, m_items[current]);
+                place(m_items[current], current);
+            }
+            throw;
+        }
+        place(item, hole);
+    }
+
+    /// <summary>
+    /// Moves the hole at the index down until the item may be placed there.
+    /// If the comparison throws, the hole is moved back to the index.
+    /// </summary>
+    inline void sift_down(T* item, size_t index) noexcept(nothrow_compare())
+    {
+        auto count = m_items.size();
+        auto hole = index;
+        try
+        {
+            while (true)
+            {
+                auto first = hole * Arity + 1;
+                if (first >= count)
+                {
+                    break;
+                }
+
+                auto last = first + Arity < count ? first + Arity : count;
+                auto least = first;
+                for (auto child = first + 1; child < last; ++child)
+                {
+                    if (m_compare(*m_items[child], *m_items[least]))
+                    {
+                        least = child;
+                    }
+                }
+
+                if (!m_compare(*m_items[least], *item))
+                {
+                    break;
+                }
+                place(m_items[least], hole);
+                hole = least;
+            }
+        }
+        catch (...)
+        {
+            for (auto current = hole; current != index; current = parent(current))
+            {
+                place(m_items[parent(current)], current);
+            }
+            throw;
+        }
+        place(item, hole);
+    }
+
+    /// <summary>
+    /// Places the item into the hole at the index, sifting it in the direction its key requires
+    /// </summary>
+    inline void reposition(T* item, size_t index) noexcept(nothrow_compare())
+    {
+        if (index > 0 && m_compare(*item, *m_items[parent(index)]))
+        {
+            sift_up(item, index);
+        }
+        else
+        {
+            sift_down(item, index);
+        }
+    }
+
+    inline intrusive_ptr<T> remove_at(size_t index) noexcept(nothrow_compare())
+    {
+        auto removed = m_items[index];
+        auto last = m_items.back();
+        m_items.pop_back();
+        if (last != removed)
+        {
+            try
+            {
+                reposition(last, index);
+            }
+            catch (...)
+            {
+                // The capacity is kept by the pop, so the push does not reallocate
+                m_items.push_back(last);
+                place(last, m_items.size() - 1);
+                place(removed, index);
+                throw;
+            }
+        }
+        static_cast<hook_type*>(removed)->m_index = hook_type::npos;
+        return intrusive_ptr<T>(removed, false);
+    }
+
+private:
+    std::vector<T*> m_items;
+    [[no_unique_address]] Compare m_compare;
+};
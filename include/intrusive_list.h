@@ -0,0 +1,492 @@
+#pragma once
+#include <stddef.h>
+#include <cassert>
+#include <iterator>
+#include <type_traits>
+#include "intrusive_ptr.h"
+
+template<intrusive_counter_type T, class Tag>
+class intrusive_list;
+
+/// <summary>
+/// A list hook embedded into an object next to <see cref="RefCountObject"/>.
+/// The hook holds the links of the object in an <see cref="intrusive_list"/>,
+/// so linking and unlinking the object never allocates memory.
+/// </summary>
+/// <typeparam name="Tag">
+/// A tag type that distinguishes several hooks of the same object.
+/// An object can be a member of as many lists as it has hooks.
+/// </typeparam>
+template<class Tag = void>
+class intrusive_list_hook
+{
+    template<intrusive_counter_type T, class ListTag>
+    friend class intrusive_list;
+
+public:
+    /// <summary>
+    /// Provides a new unlinked instance of <see cref="intrusive_list_hook"/>
+    /// </summary>
+    intrusive_list_hook() noexcept = default;
+
+    /// <summary>
+    /// Provides a new unlinked instance of <see cref="intrusive_list_hook"/>.
+    /// The links of the copied object are never copied.
+    /// </summary>
+    intrusive_list_hook(const intrusive_list_hook&) noexcept { }
+
+    /// <summary>
+    /// Keeps the current links of the object,
+    /// since the links of the copied object are never copied
+    /// </summary>
+    /// <returns>
+    /// A reference to the current hook
+    /// </returns>
+    intrusive_list_hook& operator=(const intrusive_list_hook&) noexcept
+    {
+        return *this;
+    }
+
+    /// <summary>
+    /// Checks whether the object is a member of a list through the current hook
+    /// </summary>
+    /// <returns>
+    /// Returns <see langword="true"/>, if the object is linked into a list,
+    /// otherwise it returns <see langword="false"/>.
+    /// </returns>
+    inline bool is_linked() const noexcept
+    {
+        return m_next != nullptr;
+    }
+
+private:
+    intrusive_list_hook* m_prev { nullptr };
+    intrusive_list_hook* m_next { nullptr };
+};
+
+/// <summary>
+/// A type concept that allows you to create intrusive lists only of the objects
+/// that contain <see cref="intrusive_list_hook"/> with the specified tag
+/// </summary>
+template<typename T, class Tag>
+concept intrusive_list_type =
+    intrusive_counter_type<T> && std::is_base_of_v<intrusive_list_hook<Tag>, T>;
+
+/// <summary>
+/// A doubly linked list of objects derived from <see cref="RefCountObject"/>,
+/// that links the objects through the embedded <see cref="intrusive_list_hook"/>.
+/// The list holds one reference to each of its members,
+/// all of the operations except the cleanup are O(1) and never allocate memory.
+/// </summary>
+/// <typeparam name="T">
+/// The type derived from <see cref="RefCountObject"/> and <see cref="intrusive_list_hook"/>
+/// </typeparam>
+/// <typeparam name="Tag">
+/// The tag of the hook, through which the objects are linked
+/// </typeparam>
+template<intrusive_counter_type T, class Tag = void>
+class intrusive_list final
+{
+    static_assert(intrusive_list_type<T, Tag>,
+        "The type must contain an intrusive_list_hook with the specified tag");
+
+    using hook_type = intrusive_list_hook<Tag>;
+
+public:
+    /// <summary>
+    /// A bidirectional iterator over the members of <see cref="intrusive_list"/>
+    /// </summary>
+    template<bool Const>
+    class basic_iterator final
+    {
+        friend class intrusive_list;
+
+    public:
+        using iterator_category = std::bidirectional_iterator_tag;
+        using value_type = T;
+        using difference_type = ptrdiff_t;
+        using pointer = std::conditional_t<Const, const T*, T*>;
+        using reference = std::conditional_t<Const, const T&, T&>;
+
+        basic_iterator() noexcept = default;
+
+        inline basic_iterator(const basic_iterator<false>& other) noexcept
+            requires Const
+            : m_hook(other.m_hook) { }
+
+        inline reference operator*() const noexcept
+        {
+            return *intrusive_list::to_object(m_hook);
+        }
+
+        inline pointer operator->() const noexcept
+        {
+            return intrusive_list::to_object(m_hook);
+        }
+
+        inline basic_iterator& operator++() noexcept
+        {
+            m_hook = m_hook->m_next;
+            return *this;
+        }
+
+        inline basic_iterator operator++(int) noexcept
+        {
+            auto it = *this;
+            m_hook = m_hook->m_next;
+            return it;
+        }
+
+        inline basic_iterator& operator--() noexcept
+        {
+            m_hook = m_hook->m_prev;
+            return *this;
+        }
+
+        inline basic_iterator operator--(int) noexcept
+        {
+            auto it = *this;
+            m_hook = m_hook->m_prev;
+            return it;
+        }
+
+        inline bool operator==(const basic_iterator& other) const noexcept
+        {
+            return m_hook == other.m_hook;
+        }
+
+        inline bool operator!=(const basic_iterator& other) const noexcept
+        {
+            return m_hook != other.m_hook;
+        }
+
+    private:
+        inline explicit basic_iterator(const hook_type* hook) noexcept
+            : m_hook(const_cast<hook_type*>(hook)) { }
+
+    private:
+        hook_type* m_hook { nullptr };
+    };
+
+    using iterator = basic_iterator<false>;
+    using const_iterator = basic_iterator<true>;
+
+public:
+    /// <summary>
+    /// Provides a new empty instance of <see cref="intrusive_list"/>
+    /// </summary>
+    inline intrusive_list() noexcept
+    {
+        m_root.m_prev = &m_root;
+        m_root.m_next = &m_root;
+    }
+
+    intrusive_list(const intrusive_list&) = delete;
+    intrusive_list& operator=(const intrusive_list&) = delete;
+
+    /// <summary>
+    /// Provides a new instance of <see cref="intrusive_list"/>
+    /// based on the specified one whose members were moved
+    /// </summary>
+    /// <param name="other">
+    /// - A reference to another intrusive list
+    /// </param>
+    inline intrusive_list(intrusive_list&& other) noexcept : intrusive_list()
+    {
+        splice_back(other);
+    }
+
+    /// <summary>
+    /// Releases all the members of the current list and
+    /// moves the members of the specified one to the current list
+    /// </summary>
+    /// <param name="other">
+    /// - A reference to another intrusive list
+    /// </param>
+    /// <returns>
+    /// A reference to current intrusive list
+    /// </returns>
+    inline intrusive_list& operator=(intrusive_list&& other) noexcept
+    {
+        if (this != &other)
+        {
+            clear();
+            splice_back(other);
+        }
+        return *this;
+    }
+
+    /// <summary>
+    /// Destroys a current instance of <see cref="intrusive_list"/>
+    /// and releases the references to all of its members
+    /// </summary>
+    inline ~intrusive_list() noexcept
+    {
+        clear();
+    }
+
+    /// <summary>
+    /// Checks whether the list has no members
+    /// </summary>
+    inline bool empty() const noexcept
+    {
+        return m_root.m_next == &m_root;
+    }
+
+    /// <summary>
+    /// Returns the current number of members of the list
+    /// </summary>
+    inline size_t size() const noexcept
+    {
+        return m_size;
+    }
+
+    /// <summary>
+    /// Provides the first member of the list without taking a reference.
+    /// The list must not be empty.
+    /// </summary>
+    inline T& front() const noexcept
+    {
+        return *to_object(m_root.m_next);
+    }
+
+    /// <summary>
+    /// Provides the last member of the list without taking a reference.
+    /// The list must not be empty.
+    /// </summary>
+    inline T& back() const noexcept
+    {
+        return *to_object(m_root.m_prev);
+    }
+
+    inline iterator begin() noexcept { return iterator(m_root.m_next); }
+    inline iterator end() noexcept { return iterator(&m_root); }
+    inline const_iterator begin() const noexcept { return const_iterator(m_root.m_next); }
+    inline const_iterator end() const noexcept { return const_iterator(&m_root); }
+
+    /// <summary>
+    /// Links the object to the beginning of the list.
+    /// The reference held by the pointer is transferred to the list.
+    /// An empty pointer is ignored.
+    /// </summary>
+    /// <param name="ptr">
+    /// - A pointer to an object that is not linked through the hook of the list
+    /// </param>
+    inline void push_front(intrusive_ptr<T> ptr) noexcept
+    {
+        if (auto object = ptr.detach())
+        {
+            link_before(m_root.m_next, object);
+        }
+    }
+
+    /// <summary>
+    /// Links the object to the end of the list.
+    /// The reference held by the pointer is transferred to the list.
+    /// An empty pointer is ignored.
+    /// </summary>
+    /// <param name="ptr">
+    /// - A pointer to an object that is not linked through the hook of the list
+    /// </param>
+    inline void push_back(intrusive_ptr<T> ptr) noexcept
+    {
+        if (auto object = ptr.detach())
+        {
+            link_before(&m_root, object);
+        }
+    }
+
+    /// <summary>
+    /// Links the object before the specified position in the list.
+    /// The reference held by the pointer is transferred to the list.
+    /// An empty pointer is ignored.
+    /// </summary>
+    /// <param name="pos">
+    /// - An iterator of the current list
+    /// </param>
+    /// <param name="ptr">
+    /// - A pointer to an object that is not linked through the hook of the list
+    /// </param>
+    /// <returns>
+    /// An iterator to the inserted object or the position, if the pointer is empty
+    /// </returns>
+    inline iterator insert(const_iterator pos, intrusive_ptr<T> ptr) noexcept
+    {
+        auto object = ptr.detach();
+        if (object == nullptr)
+        {
+            return iterator(pos.m_hook);
+        }
+
+        link_before(pos.m_hook, object);
+        return iterator(to_hook(object));
+    }
+
+    /// <summary>
+    /// Unlinks the first member of the list.
+    /// The reference held by the list is transferred to the result.
+    /// </summary>
+    /// <returns>
+    /// A pointer to the unlinked object or an empty pointer, if the list is empty
+    /// </returns>
+    inline intrusive_ptr<T> pop_front() noexcept
+    {
+        return empty()
+            ? intrusive_ptr<T>()
+            : intrusive_ptr<T>(unlink(m_root.m_next), false);
+    }
+
+    /// <summary>
+    /// Unlinks the last member of the list.
+    /// The reference held by the list is transferred to the result.
+    /// </summary>
+    /// <returns>
+    /// A pointer to the unlinked object or an empty pointer, if the list is empty
+    /// </returns>
+    inline intrusive_ptr<T> pop_back() noexcept
+    {
+        return empty()
+            ? intrusive_ptr<T>()
+            : intrusive_ptr<T>(unlink(m_root.m_prev), false);
+    }
+
+    /// <summary>
+    /// Unlinks the specified member of the list.
+    /// The reference held by the list is transferred to the result.
+    /// </summary>
+    /// <param name="object">
+    /// - A reference to an object linked into the current list
+    /// </param>
+    /// <returns>
+    /// A pointer to the unlinked object
+    /// </returns>
+    inline intrusive_ptr<T> erase(T& object) noexcept
+    {
+        assert(owns(to_hook(&object)) && "The object is not a member of the list");
+        return intrusive_ptr<T>(unlink(to_hook(&object)), false);
+    }
+
+    /// <summary>
+    /// Unlinks the member of the list at the specified position
+    /// and releases the reference held by the list
+    /// </summary>
+    /// <param name="pos">
+    /// - An iterator to a member of the current list
+    /// </param>
+    /// <returns>
+    /// An iterator to the member following the unlinked one
+    /// </returns>
+    inline iterator erase(const_iterator pos) noexcept
+    {
+        auto next = pos.m_hook->m_next;
+        intrusive_ptr_release(unlink(pos.m_hook));
+        return iterator(next);
+    }
+
+    /// <summary>
+    /// Moves all the members of the specified list to the end of the current one.
+    /// The references are transferred without changing the reference counts.
+    /// </summary>
+    /// <param name="other">
+    /// - A reference to another intrusive list
+    /// </param>
+    inline void splice_back(intrusive_list& other) noexcept
+    {
+        if (this == &other || other.empty())
+        {
+            return;
+        }
+
+        auto first = other.m_root.m_next;
+        auto last = other.m_root.m_prev;
+
+        first->m_prev = m_root.m_prev;
+        m_root.m_prev->m_next = first;
+        last->m_next = &m_root;
+        m_root.m_prev = last;
+        m_size += other.m_size;
+
+        other.m_root.m_prev = &other.m_root;
+        other.m_root.m_next = &other.m_root;
+        other.m_size = 0;
+    }
+
+    /// <summary>
+    /// Unlinks all the members of the list and releases the references to them
+    /// </summary>
+    inline void clear() noexcept
+    {
+        while (!empty())
+        {
+            intrusive_ptr_release(unlink(m_root.m_next));
+        }
+    }
+
+private:
+    static inline T* to_object(hook_type* hook) noexcept
+    {
+        return static_cast<T*>(hook);
+    }
+
+    static inline const T* to_object(const hook_type* hook) noexcept
+    {
+        return static_cast<const T*>(hook);
+    }
+
+    static inline hook_type* to_hook(T* object) noexcept
+    {
+        return static_cast<hook_type*>(object);
+    }
+
+    /// <summary>
+    /// Checks whether the hook is linked into the current list. The links are followed
+    /// in both directions at once, so the check takes the distance to the nearer end of the list.
+    /// </summary>
+    inline bool owns(const hook_type* hook) const noexcept
+    {
+        if (!hook->is_linked())
+        {
+            return false;
+        }
+
+        auto forward = hook;
+        auto backward = hook;
+        while (true)
+        {
+            forward = forward->m_next;
+            backward = backward->m_prev;
+            if (forward == &m_root || backward == &m_root)
+            {
+                return true;
+            }
+            if (forward == hook || backward == hook)
+            {
+                return false;
+            }
+        }
+    }
+
+    inline void link_before(hook_type* next, T* object) noexcept
+    {
+        auto hook = to_hook(object);
+        hook->m_next = next;
+        hook->m_prev = next->m_prev;
+        next->m_prev->m_next = hook;
+        next->m_prev = hook;
+        ++m_size;
+    }
+
+    inline T* unlink(hook_type* hook) noexcept
+    {
+        hook->m_prev->m_next = hook->m_next;
+        hook->m_next->m_prev = hook->m_prev;
+        hook->m_prev = nullptr;
+        hook->m_next = nullptr;
+        --m_size;
+        return to_object(hook);
+    }
+
+private:
+    hook_type m_root;
+    size_t m_size { 0 };
+};
@@ -0,0 +1,234 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+#include <type_traits>
+#include "intrusive_ptr.h"
+
+template<intrusive_counter_type T, class Tag>
+class intrusive_mpsc_queue;
+
+/// <summary>
+/// A queue hook embedded into an object next to <see cref="RefCountObject"/>.
+/// The hook holds the link of the object in an <see cref="intrusive_mpsc_queue"/>,
+/// so pushing the object never allocates memory.
+/// </summary>
+/// <typeparam name="Tag">
+/// A tag type that distinguishes several hooks of the same object
+/// </typeparam>
+template<class Tag = void>
+class intrusive_mpsc_hook
+{
+    template<intrusive_counter_type T, class QueueTag>
+    friend class intrusive_mpsc_queue;
+
+public:
+    /// <summary>
+    /// Provides a new unlinked instance of <see cref="intrusive_mpsc_hook"/>
+    /// </summary>
+    intrusive_mpsc_hook() noexcept = default;
+
+    /// <summary>
+    /// Provides a new unlinked instance of <see cref="intrusive_mpsc_hook"/>.
+    /// The link of the copied object is never copied.
+    /// </summary>
+    intrusive_mpsc_hook(const intrusive_mpsc_hook&) noexcept { }
+
+    /// <summary>
+    /// Keeps the current link of the object,
+    /// since the link of the copied object is never copied
+    /// </summary>
+    /// <returns>
+    /// A reference to the current hook
+    /// </returns>
+    intrusive_mpsc_hook& operator=(const intrusive_mpsc_hook&) noexcept
+    {
+        return *this;
+    }
+
+private:
+    std::atomic<intrusive_mpsc_hook*> m_next { nullptr };
+};
+
+/// <summary>
+/// A lock-free unbounded multi-producer single-consumer queue of objects
+/// derived from <see cref="RefCountObject"/> (the intrusive Vyukov queue).
+/// The objects are linked through the embedded <see cref="intrusive_mpsc_hook"/>:
+/// a push transfers the reference of the caller into the queue
+/// and a pop transfers it out, without allocations and changes of the reference count.
+/// </summary>
+/// <typeparam name="T">
+/// The type derived from <see cref="RefCountObject"/> and <see cref="intrusive_mpsc_hook"/>
+/// </typeparam>
+/// <typeparam name="Tag">
+/// The tag of the hook, through which the objects are linked
+/// </typeparam>
+template<intrusive_counter_type T, class Tag = void>
+class intrusive_mpsc_queue final
+{
+    static_assert(std::is_base_of_v<intrusive_mpsc_hook<Tag>, T>,
+        "The type must contain an intrusive_mpsc_hook with the specified tag");
+
+    using hook_type = intrusive_mpsc_hook<Tag>;
+
+    static constexpr size_t cache_line_size = 64;
+
+public:
+    /// <summary>
+    /// Provides a new empty instance of <see cref="intrusive_mpsc_queue"/>
+    /// </summary>
+    inline intrusive_mpsc_queue() noexcept
+        : m_head(&m_stub)
+        , m_tail(&m_stub) { }
+
+    intrusive_mpsc_queue(const intrusive_mpsc_queue&) = delete;
+    intrusive_mpsc_queue& operator=(const intrusive_mpsc_queue&) = delete;
+
+    /// <summary>
+    /// Destroys a current instance of <see cref="intrusive_mpsc_queue"/>
+    /// and releases the references to all the queued objects.
+    /// No producer may push to the queue concurrently with the destruction.
+    /// </summary>
+    inline ~intrusive_mpsc_queue() noexcept
+    {
+        while (auto object = pop_raw())
+        {
+            intrusive_ptr_release(object);
+        }
+    }
+
+    /// <summary>
+    /// Pushes the object to the end of the queue.
+    /// The reference held by the pointer is transferred to the queue.
+    /// Can be called from any number of threads concurrently.
+    /// </summary>
+    /// <param name="ptr">
+    /// - A pointer to an object that is not queued through the hook of the queue
+    /// </param>
+    inline void push(intrusive_ptr<T> ptr) noexcept
+    {
+        if (auto object = ptr.detach())
+        {
+            push_hook(to_hook(object));
+        }
+    }
+
+    /// <summary>
+    /// Pops the object from the beginning of the queue.
+    /// The reference held by the queue is transferred to the result.
+    /// Must be called only from the consumer thread.
+    /// </summary>
+    /// <returns>
+    /// A pointer to the popped object or an empty pointer,
+    /// if the queue is empty or the next producer has not finished its push yet
+    /// </returns>
+    inline intrusive_ptr<T> pop() noexcept
+    {
+        return intrusive_ptr<T>(pop_raw(), false);
+    }
+
+    /// <summary>
+    /// Pops up to the specified number of objects from the queue and passes each of them
+    /// to the handler in the order of the queue. The reference held by the queue
+    /// is transferred to the handler. Must be called only from the consumer thread.
+    /// </summary>
+    /// <param name="handler">
+    /// - A callable object that accepts <see cref="intrusive_ptr"/> to a popped object
+    /// </param>
+    /// <param name="max_count">
+    /// - The maximum number of objects to pop
+    /// </param>
+    /// <returns>
+    /// The number of popped objects
+    /// </returns>
+    template<class Handler>
+    inline size_t consume(Handler&& handler, size_t max_count = SIZE_MAX)
+    {
+        auto count = size_t(0);
+        while (count < max_count)
+        {
+            auto object = pop_raw();
+            if (object == nullptr)
+            {
+                break;
+            }
+
+            ++count;
+            handler(intrusive_ptr<T>(object, false));
+        }
+        return count;
+    }
+
+    /// <summary>
+    /// Checks whether the queue has no objects.
+    /// Must be called only from the consumer thread.
+    /// </summary>
+    inline bool empty() const noexcept
+    {
+        return m_tail == &m_stub
+            && m_stub.m_next.load(std::memory_order_acquire) == nullptr
+            && m_head.load(std::memory_order_acquire) == &m_stub;
+    }
+
+private:
+    static inline T* to_object(hook_type* hook) noexcept
+    {
+        return static_cast<T*>(hook);
+    }
+
+    static inline hook_type* to_hook(T* object) noexcept
+    {
+        return static_cast<hook_type*>(object);
+    }
+
+    inline void push_hook(hook_type* hook) noexcept
+    {
+        hook->m_next.store(nullptr, std::memory_order_relaxed);
+        auto prev = m_head.exchange(hook, std::memory_order_acq_rel);
+        prev->m_next.store(hook, std::memory_order_release);
+    }
+
+    inline T* pop_raw() noexcept
+    {
+        auto tail = m_tail;
+        auto next = tail->m_next.load(std::memory_order_acquire);
+
+        if (tail == &m_stub)
+        {
+            if (next == nullptr)
+            {
+                return nullptr;
+            }
+
+            m_tail = next;
+            tail = next;
+            next = next->m_next.load(std::memory_order_acquire);
+        }
+
+        if (next != nullptr)
+        {
+            m_tail = next;
+            return to_object(tail);
+        }
+
+        if (tail != m_head.load(std::memory_order_acquire))
+        {
+            return nullptr;
+        }
+
+        push_hook(&m_stub);
+
+        next = tail->m_next.load(std::memory_order_acquire);
+        if (next != nullptr)
+        {
+            m_tail = next;
+            return to_object(tail);
+        }
+        return nullptr;
+    }
+
+private:
+    alignas(cache_line_size) std::atomic<hook_type*> m_head;
+    alignas(cache_line_size) hook_type* m_tail;
+    hook_type m_stub;
+};
@@ -1,7 +1,9 @@
 ﻿#pragma once
 #include <stdint.h>
+#include <atomic>
 #include <type_traits>
 #include <concepts>
+#include <utility>
 
 template<class Derived>
 class RefCountObject;
@@ -15,7 +17,7 @@ class RefCountObject;
 template<class Derived>
 inline void intrusive_ptr_add_ref(RefCountObject<Derived>* ptr)
 {
-    ++(ptr->m_ref_count);
+    ptr->m_ref_count.fetch_add(1, std::memory_order_relaxed);
 }
 
 /// <summary>
@@ -28,7 +30,7 @@ inline void intrusive_ptr_add_ref(RefCountObject<Derived>* ptr)
 template<class Derived>
 inline void intrusive_ptr_release(RefCountObject<Derived>* ptr)
 {
-    if (--(ptr->m_ref_count) == 0)
+    if (ptr->m_ref_count.fetch_sub(1, std::memory_order_acq_rel) == 1)
     {
         delete static_cast<const Derived*>(ptr);
     }
@@ -56,7 +58,7 @@ public:
     /// </returns>
     inline uint32_t ReferenceCount() const
     {
-        return m_ref_count;
+        return m_ref_count.load(std::memory_order_acquire);
     }
 
 protected:
@@ -65,6 +67,20 @@ protected:
     /// </summary>
     RefCountObject() = default;
 
+    /// <summary>
+    /// Provides a copy of the base class <see cref="RefCountObject"/>.
+    /// The copy has its own count of references, that is not copied.
+    /// </summary>
+    RefCountObject(const RefCountObject&) noexcept { }
+
+    /// <summary>
+    /// Keeps the count of references of the current instance, that is not assigned
+    /// </summary>
+    RefCountObject& operator=(const RefCountObject&) noexcept
+    {
+        return *this;
+    }
+
     /// <summary>
     /// Destroys the instance <see cref="RefCountObject"/>. 
     /// Destruction is only available through a derived class.
@@ -72,7 +88,7 @@ protected:
     virtual ~RefCountObject() = default;
 
 private:
-    uint32_t m_ref_count { 0 };
+    std::atomic<uint32_t> m_ref_count { 0 };
 }; 
 
 /// <summary>
@@ -160,7 +176,7 @@ public:
             return *this;
         }
 
-        m_pointer = other.get();
+        intrusive_ptr(other).swap(*this);
         return *this;
     }
 
@@ -181,7 +197,7 @@ public:
             return *this;
         }
         
-        m_pointer = std::move(other);
+        intrusive_ptr(std::move(other)).swap(*this);
         return *this;
     }
 
@@ -304,9 +320,9 @@ public:
     /// <param name="other">
     /// - A reference to another intrusive pointer
     /// </param>
-    inline void swap(intrusive_ptr& other)
+    inline void swap(intrusive_ptr& other) noexcept
     {
-        std::swap(*m_pointer, *other.get());
+        std::swap(m_pointer, other.m_pointer);
     }
 
     /// <summary>
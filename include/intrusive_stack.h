@@ -0,0 +1,300 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <cassert>
+#include <atomic>
+#include <type_traits>
+#include "epoch_domain.h"
+#include "intrusive_ptr.h"
+
+template<intrusive_counter_type T, class Tag>
+class intrusive_stack;
+
+/// <summary>
+/// A stack hook embedded into an object next to <see cref="RefCountObject"/>.
+/// The hook holds the link of the object in an <see cref="intrusive_stack"/>,
+/// so pushing the object never allocates memory.
+/// </summary>
+/// <typeparam name="Tag">
+/// A tag type that distinguishes several hooks of the same object
+/// </typeparam>
+template<class Tag = void>
+class intrusive_stack_hook
+{
+    template<intrusive_counter_type T, class StackTag>
+    friend class intrusive_stack;
+
+public:
+    /// <summary>
+    /// Provides a new unlinked instance of <see cref="intrusive_stack_hook"/>
+    /// </summary>
+    intrusive_stack_hook() noexcept = default;
+
+    /// <summary>
+    /// Provides a new unlinked instance of <see cref="intrusive_stack_hook"/>.
+    /// The link of the copied object is never copied.
+    /// </summary>
+    intrusive_stack_hook(const intrusive_stack_hook&) noexcept { }
+
+    /// <summary>
+    /// Keeps the current link of the object,
+    /// since the link of the copied object is never copied
+    /// </summary>
+    /// <returns>
+    /// A reference to the current hook
+    /// </returns>
+    intrusive_stack_hook& operator=(const intrusive_stack_hook&) noexcept
+    {
+        return *this;
+    }
+
+private:
+    std::atomic<intrusive_stack_hook*> m_next { nullptr };
+};
+
+/// <summary>
+/// A lock-free LIFO of objects derived from <see cref="RefCountObject"/> (the Treiber stack).
+/// The objects are linked through the embedded <see cref="intrusive_stack_hook"/>:
+/// a push transfers the reference of the caller into the stack without allocations
+/// and changes of the reference count, and a pop transfers it out.
+/// The top of the stack is a tagged pointer, whose tag is changed by every operation,
+/// so an object popped and pushed back meanwhile does not break a concurrent pop (ABA).
+/// </summary>
+/// <remarks>
+/// A concurrent pop may read the link of an object that has just been popped by another thread,
+/// so a pop pins <see cref="epoch_domain"/>, and every object leaving the stack gets one more
+/// reference, that is retired to the domain. The object stays allocated until the pops,
+/// that could still read it, have finished, and its count is one higher until the retired
+/// reference is collected.
+/// On 64-bit targets the pointer and the tag share a single word: the addresses of the hooks
+/// must fit into the low 48 bits, which is checked by an assert on the push. Heaps with 57-bit
+/// addresses (5-level paging) or with tagged high bits (ARM TBI or MTE) are not supported.
+/// The tag has 16 bits there and wraps after 65536 operations, so a pop is protected from ABA
+/// only while fewer operations complete between its read of the top and its CAS.
+/// </remarks>
+/// <typeparam name="T">
+/// The type derived from <see cref="RefCountObject"/> and <see cref="intrusive_stack_hook"/>
+/// </typeparam>
+/// <typeparam name="Tag">
+/// The tag of the hook, through which the objects are linked
+/// </typeparam>
+template<intrusive_counter_type T, class Tag = void>
+class intrusive_stack final
+{
+    static_assert(std::is_base_of_v<intrusive_stack_hook<Tag>, T>,
+        "The type must contain an intrusive_stack_hook with the specified tag");
+
+    using hook_type = intrusive_stack_hook<Tag>;
+
+    static constexpr unsigned pointer_bits = sizeof(void*) == 8 ? 48 : 32;
+    static constexpr uint64_t pointer_mask = (uint64_t(1) << pointer_bits) - 1;
+
+public:
+    /// <summary>
+    /// Provides a new empty instance of <see cref="intrusive_stack"/>
+    /// </summary>
+    inline intrusive_stack() noexcept : m_top(0) { }
+
+    intrusive_stack(const intrusive_stack&) = delete;
+    intrusive_stack& operator=(const intrusive_stack&) = delete;
+
+    /// <summary>
+    /// Provides a new instance of <see cref="intrusive_stack"/>
+    /// that takes all the objects of the specified one.
+    /// The specified stack may be used concurrently by other threads.
+    /// </summary>
+    /// <param name="other">
+    /// - A reference to another intrusive stack
+    /// </param>
+    /// <exception cref="std::bad_alloc">
+    /// Thrown, if the references of the taken objects cannot be retired.
+    /// The objects are pushed back to the specified stack.
+    /// </exception>
+    inline intrusive_stack(intrusive_stack&& other)
+        : m_top(pack(other.take_all(), 0)) { }
+
+    /// <summary>
+    /// Destroys a current instance of <see cref="intrusive_stack"/>
+    /// and releases the references to all of its objects.
+    /// No other thread may use the stack concurrently with the destruction.
+    /// </summary>
+    inline ~intrusive_stack() noexcept
+    {
+        auto hook = to_hook(m_top.load(std::memory_order_acquire));
+        while (hook != nullptr)
+        {
+            auto next = hook->m_next.load(std::memory_order_relaxed);
+            intrusive_ptr_release(to_object(hook));
+            hook = next;
+        }
+    }
+
+    /// <summary>
+    /// Pushes the object to the top of the stack.
+    /// The reference held by the pointer is transferred to the stack.
+    /// </summary>
+    /// <param name="ptr">
+    /// - A pointer to an object that is not linked through the hook of the stack
+    /// </param>
+    inline void push(intrusive_ptr<T> ptr) noexcept
+    {
+        auto object = ptr.detach();
+        if (object == nullptr)
+        {
+            return;
+        }
+
+        auto hook = static_cast<hook_type*>(object);
+        assert((static_cast<uint64_t>(reinterpret_cast<uintptr_t>(hook)) & ~pointer_mask) == 0
+            && "The address does not fit into the pointer bits of the tagged top");
+        auto top = m_top.load(std::memory_order_relaxed);
+        do
+        {
+            hook->m_next.store(to_hook(top), std::memory_order_relaxed);
+        }
+        while (!m_top.compare_exchange_weak(top, pack(hook, tag_of(top) + 1),
+            std::memory_order_release, std::memory_order_relaxed));
+    }
+
+    /// <summary>
+    /// Pops the object from the top of the stack.
+    /// The reference held by the stack is transferred to the result.
+    /// </summary>
+    /// <returns>
+    /// A pointer to the popped object or an empty pointer, if the stack is empty
+    /// </returns>
+    /// <exception cref="std::bad_alloc">
+    /// Thrown, if the additional reference cannot be retired. The object is pushed back.
+    /// </exception>
+    inline intrusive_ptr<T> pop()
+    {
+        auto guard = epoch_domain::instance().pin();
+        auto top = m_top.load(std::memory_order_acquire);
+        while (auto hook = to_hook(top))
+        {
+            // The object on the top is kept allocated by the guard, even if it is popped meanwhile
+            auto next = hook->m_next.load(std::memory_order_relaxed);
+            if (m_top.compare_exchange_weak(top, pack(next, tag_of(top) + 1),
+                std::memory_order_acquire, std::memory_order_acquire))
+            {
+                hook->m_next.store(nullptr, std::memory_order_relaxed);
+                retire_or_restore(hook, hook);
+                return intrusive_ptr<T>(to_object(hook), false);
+            }
+        }
+        return intrusive_ptr<T>();
+    }
+
+    /// <summary>
+    /// Pops all the objects of the stack at once.
+    /// The references held by the stack are transferred to the result.
+    /// </summary>
+    /// <returns>
+    /// A new stack containing the popped objects in the same order
+    /// </returns>
+    /// <exception cref="std::bad_alloc">
+    /// Thrown, if the references of the popped objects cannot be retired. The objects are pushed back.
+    /// </exception>
+    inline intrusive_stack pop_all()
+    {
+        return intrusive_stack(std::move(*this));
+    }
+
+    /// <summary>
+    /// Checks whether the stack has no objects
+    /// </summary>
+    inline bool empty() const noexcept
+    {
+        return to_hook(m_top.load(std::memory_order_acquire)) == nullptr;
+    }
+
+private:
+    static inline uint64_t pack(hook_type* hook, uint64_t tag) noexcept
+    {
+        return (static_cast<uint64_t>(reinterpret_cast<uintptr_t>(hook)) & pointer_mask)
+            | (tag << pointer_bits);
+    }
+
+    static inline hook_type* to_hook(uint64_t value) noexcept
+    {
+        return reinterpret_cast<hook_type*>(static_cast<uintptr_t>(value & pointer_mask));
+    }
+
+    static inline uint64_t tag_of(uint64_t value) noexcept
+    {
+        return value >> pointer_bits;
+    }
+
+    static inline T* to_object(hook_type* hook) noexcept
+    {
+        return static_cast<T*>(hook);
+    }
+
+    /// <summary>
+    /// Adds a reference to each object of the chain and retires it,
+    /// since a concurrent pop may still read the links of the objects
+    /// </summary>
+    static void retire(hook_type* first)
+    {
+        auto& domain = epoch_domain::instance();
+        for (auto hook = first; hook != nullptr; hook = hook->m_next.load(std::memory_order_relaxed))
+        {
+            intrusive_ptr_add_ref(to_object(hook));
+            try
+            {
+                domain.retire(to_object(hook));
+            }
+            catch (...)
+            {
+                intrusive_ptr_release(to_object(hook));
+                throw;
+            }
+        }
+    }
+
+    /// <summary>
+    /// Retires the removed chain or pushes it back to the stack, if the retirement throws
+    /// </summary>
+    inline void retire_or_restore(hook_type* first, hook_type* last)
+    {
+        try
+        {
+            retire(first);
+        }
+        catch (...)
+        {
+            auto top = m_top.load(std::memory_order_relaxed);
+            do
+            {
+                last->m_next.store(to_hook(top), std::memory_order_relaxed);
+            }
+            while (!m_top.compare_exchange_weak(top, pack(first, tag_of(top) + 1),
+                std::memory_order_release, std::memory_order_relaxed));
+            throw;
+        }
+    }
+
+    inline hook_type* take_all()
+    {
+        auto top = m_top.load(std::memory_order_acquire);
+        while (!m_top.compare_exchange_weak(top, pack(nullptr, tag_of(top) + 1),
+            std::memory_order_acquire, std::memory_order_acquire))
+        {
+        }
+
+        auto first = to_hook(top);
+        if (first != nullptr)
+        {
+            auto last = first;
+            while (auto next = last->m_next.load(std::memory_order_relaxed))
+            {
+                last = next;
+            }
+            retire_or_restore(first, last);
+        }
+        return first;
+    }
+
+private:
+    std::atomic<uint64_t> m_top;
+};
@@ -0,0 +1,321 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <algorithm>
+#include <compare>
+#include <cstring>
+#include <functional>
+#include <new>
+#include <string>
+#include <string_view>
+#include <utility>
+#include "intrusive_ptr.h"
+
+/// <summary>
+/// An immutable string, that is copied in O(1). The strings up to <see cref="inline_capacity"/> characters
+/// are stored inside the object without any allocation, the longer ones are stored after a header
+/// derived from <see cref="RefCountObject"/> in a single allocation shared by the copies.
+/// The header caches the length and the hash, so hashing and comparing the shared strings is cheap.
+/// </summary>
+class intrusive_string final
+{
+    /// <summary>
+    /// The characters stored after the header, that keeps the length and the hash of the string
+    /// </summary>
+    class string_data final : public RefCountObject<string_data>
+    {
+        struct trailing_t { };
+
+    public:
+        static void* operator new(size_t size, trailing_t, size_t extra)
+        {
+            return ::operator new(size + extra);
+        }
+
+        static void operator delete(void* ptr, trailing_t, size_t) noexcept
+        {
+            ::operator delete(ptr);
+        }
+
+        static void operator delete(void* ptr) noexcept
+        {
+            ::operator delete(ptr);
+        }
+
+        static string_data* create(std::string_view value)
+        {
+            auto created = new (trailing_t { }, value.size()) string_data(value.size(), std::hash<std::string_view>()(value));
+            std::copy(value.begin(), value.end(), created->data());
+            intrusive_ptr_add_ref(created);
+            return created;
+        }
+
+        inline char* data() noexcept
+        {
+            return reinterpret_cast<char*>(this + 1);
+        }
+
+        const size_t m_size;
+        const size_t m_hash;
+
+    private:
+        string_data(size_t size, size_t hash) noexcept : m_size(size), m_hash(hash) { }
+    };
+
+    static constexpr size_t storage_size = 16;
+
+    // The last byte of the storage: zero for a shared string, the flag with the length for an inline one
+    static constexpr size_t tag_index = storage_size - 1;
+    static constexpr unsigned char inline_flag = 0x80;
+
+public:
+    static constexpr size_t inline_capacity = storage_size - 1;
+
+    /// <summary>
+    /// Provides an empty string
+    /// </summary>
+    intrusive_string() noexcept
+    {
+        set_inline(0);
+    }
+
+    intrusive_string(std::string_view value)
+    {
+        if (value.size() <= inline_capacity)
+        {
+            std::memcpy(m_storage, value.data(), value.size());
+            set_inline(value.size());
+        }
+        else
+        {
+            set_shared(string_data::create(value));
+        }
+    }
+
+    intrusive_string(const char* value) : intrusive_string(std::string_view(value)) { }
+
+    intrusive_string(const std::string& value) : intrusive_string(std::string_view(value)) { }
+
+    intrusive_string(const intrusive_string& other) noexcept
+    {
+        std::memcpy(m_storage, other.m_storage, storage_size);
+        if (!is_inline())
+        {
+            intrusive_ptr_add_ref(shared());
+        }
+    }
+
+    intrusive_string(intrusive_string&& other) noexcept
+    {
+        std::memcpy(m_storage, other.m_storage, storage_size);
+        other.set_inline(0);
+    }
+
+    intrusive_string& operator=(const intrusive_string& other) noexcept
+    {
+        intrusive_string(other).swap(*this);
+        return *this;
+    }
+
+    intrusive_string& operator=(intrusive_string&& other) noexcept
+    {
+        intrusive_string(std::move(other)).swap(*this);
+        return *this;
+    }
+
+    ~intrusive_string()
+    {
+        if (!is_inline())
+        {
+            intrusive_ptr_release(shared());
+        }
+    }
+
+    inline void swap(intrusive_string& other) noexcept
+    {
+        unsigned char buffer[storage_size];
+        std::memcpy(buffer, m_storage, storage_size);
+        std::memcpy(m_storage, other.m_storage, storage_size);
+        std::memcpy(other.m_storage, buffer, storage_size);
+    }
+
+    /// <summary>
+    /// Checks whether the characters are stored inside the object
+    /// </summary>
+    inline bool is_inline() const noexcept
+    {
+        return m_storage[tag_index] != 0;
+    }
+
+    inline size_t size() const noexcept
+    {
+        return is_inline() ? m_storage[tag_index] & ~inline_flag : shared()->m_size;
+    }
+
+    inline bool empty() const noexcept
+    {
+        return size() == 0;
+    }
+
+    /// <summary>
+    /// Returns the characters, that are not terminated by zero
+    /// </summary>
+    inline const char* data() const noexcept
+    {
+        return is_inline() ? reinterpret_cast<const char*>(m_storage) : shared()->data();
+    }
+
+    inline char operator[](size_t index) const noexcept
+    {
+        return data()[index];
+    }
+
+    inline std::string_view view() const noexcept
+    {
+        if (is_inline())
+        {
+            return std::string_view(reinterpret_cast<const char*>(m_storage), m_storage[tag_index] & ~inline_flag);
+        }
+        auto data = shared();
+        return std::string_view(data->data(), data->m_size);
+    }
+
+    inline operator std::string_view() const noexcept
+    {
+        return view();
+    }
+
+    inline std::string str() const
+    {
+        return std::string(view());
+    }
+
+    /// <summary>
+    /// Returns the hash equal to the hash of <see cref="std::string_view"/> with the same characters.
+    /// The hash of a shared string is computed once on creation.
+    /// </summary>
+    inline size_t hash() const noexcept
+    {
+        return is_inline() ? std::hash<std::string_view>()(view()) : shared()->m_hash;
+    }
+
+    /// <summary>
+    /// Returns the number of the strings sharing the characters, or 0 for an inline string
+    /// </summary>
+    inline uint32_t use_count() const noexcept
+    {
+        return is_inline() ? 0 : shared()->ReferenceCount();
+    }
+
+    friend inline bool operator==(const intrusive_string& left, const intrusive_string& right) noexcept
+    {
+        if (std::memcmp(left.m_storage, right.m_storage, storage_size) == 0)
+        {
+            return true;
+        }
+        if (left.is_inline() || right.is_inline())
+        {
+            return false;
+        }
+        auto first = left.shared();
+        auto second = right.shared();
+        return first->m_hash == second->m_hash && left.view() == right.view();
+    }
+
+    friend inline bool operator==(const intrusive_string& left, std::string_view right) noexcept
+    {
+        return left.view() == right;
+    }
+
+    friend inline std::strong_ordering operator<=>(const intrusive_string& left, const intrusive_string& right) noexcept
+    {
+        return left.view() <=> right.view();
+    }
+
+    friend inline std::strong_ordering operator<=>(const intrusive_string& left, std::string_view right) noexcept
+    {
+        return left.view() <=> right;
+    }
+
+    // The exact overloads for the literals and std::string, which also convert to intrusive_string implicitly
+    friend inline bool operator==(const intrusive_string& left, const char* right) noexcept
+    {
+        return left.view() == std::string_view(right);
+    }
+
+    friend inline bool operator==(const intrusive_string& left, const std::string& right) noexcept
+    {
+        return left.view() == std::string_view(right);
+    }
+
+    friend inline std::strong_ordering operator<=>(const intrusive_string& left, const char* right) noexcept
+    {
+        return left.view() <=> std::string_view(right);
+    }
+
+    friend inline std::strong_ordering operator<=>(const intrusive_string& left, const std::string& right) noexcept
+    {
+        return left.view() <=> std::string_view(right);
+    }
+
+private:
+    inline void set_inline(size_t size) noexcept
+    {
+        std::memset(m_storage + size, 0, storage_size - size);
+        m_storage[tag_index] = static_cast<unsigned char>(inline_flag | size);
+    }
+
+    inline void set_shared(string_data* data) noexcept
+    {
+        std::memset(m_storage, 0, storage_size);
+        std::memcpy(m_storage, &data, sizeof(data));
+    }
+
+    inline string_data* shared() const noexcept
+    {
+        string_data* data;
+        std::memcpy(&data, m_storage, sizeof(data));
+        return data;
+    }
+
+private:
+    alignas(string_data*) unsigned char m_storage[storage_size];
+};
+
+/// <summary>
+/// A transparent hash of <see cref="intrusive_string"/>, that allows looking up
+/// the keys of unordered containers by <see cref="std::string_view"/>
+/// </summary>
+struct intrusive_string_hash
+{
+    using is_transparent = void;
+
+    inline size_t operator()(const intrusive_string& value) const noexcept
+    {
+        return value.hash();
+    }
+
+    inline size_t operator()(std::string_view value) const noexcept
+    {
+        return std::hash<std::string_view>()(value);
+    }
+
+    inline size_t operator()(const char* value) const noexcept
+    {
+        return std::hash<std::string_view>()(value);
+    }
+
+    inline size_t operator()(const std::string& value) const noexcept
+    {
+        return std::hash<std::string_view>()(value);
+    }
+};
+
+template<>
+struct std::hash<intrusive_string>
+{
+    inline size_t operator()(const intrusive_string& value) const noexcept
+    {
+        return value.hash();
+    }
+};
@@ -0,0 +1,250 @@
+#pragma once
+#include <stdint.h>
+#include <atomic>
+#include <exception>
+#include <optional>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include "intrusive_ptr.h"
+
+/// <summary>
+/// A reference-counted memoized value, that is computed once on the first access.
+/// The evaluation is guarded by a state word in the same object instead of <see cref="std::once_flag"/>:
+/// the first thread moves it from pending to running and computes the value,
+/// the concurrent readers sleep on the word until it becomes ready.
+/// </summary>
+/// <typeparam name="T">
+/// The type of the value
+/// </typeparam>
+template<class T>
+class lazy_value : public RefCountObject<lazy_value<T>>
+{
+    // The states of the evaluation and the bit of the sleeping readers
+    static constexpr uint32_t pending = 0;
+    static constexpr uint32_t running = 1;
+    static constexpr uint32_t ready = 2;
+    static constexpr uint32_t failed = 3;
+    static constexpr uint32_t state_mask = 3;
+    static constexpr uint32_t waiting = 4;
+
+public:
+    ~lazy_value() override = default;
+
+    /// <summary>
+    /// Checks whether the value has been computed
+    /// </summary>
+    inline bool is_ready() const noexcept
+    {
+        return (m_state.load(std::memory_order_acquire) & state_mask) == ready;
+    }
+
+    /// <summary>
+    /// Returns the value, computing it on the first call. The exception of the computation
+    /// is memoized and rethrown by every call.
+    /// </summary>
+    inline const T& get()
+    {
+        auto state = m_state.load(std::memory_order_acquire);
+        if (state != ready)
+        {
+            state = evaluate(state);
+        }
+        if ((state & state_mask) == failed)
+        {
+            std::rethrow_exception(m_exception);
+        }
+        return *m_value;
+    }
+
+protected:
+    lazy_value() noexcept = default;
+
+    /// <summary>
+    /// Computes the value and releases the resources needed only for the computation
+    /// </summary>
+    virtual T compute() = 0;
+
+private:
+    inline uint32_t evaluate(uint32_t state)
+    {
+        while (true)
+        {
+            if ((state & state_mask) == pending)
+            {
+                if (m_state.compare_exchange_weak(state, running, std::memory_order_acquire))
+                {
+                    break;
+                }
+                continue;
+            }
+            if ((state & state_mask) != running)
+            {
+                return state;
+            }
+            if ((state & waiting) == 0)
+            {
+                if (!m_state.compare_exchange_weak(state, state | waiting, std::memory_order_acquire))
+                {
+                    continue;
+                }
+                state |= waiting;
+            }
+            m_state.wait(state, std::memory_order_acquire);
+            state = m_state.load(std::memory_order_acquire);
+        }
+
+        auto result = ready;
+        try
+        {
+            m_value.emplace(compute());
+        }
+        catch (...)
+        {
+            m_exception = std::current_exception();
+            result = failed;
+        }
+
+        if ((m_state.exchange(result, std::memory_order_acq_rel) & waiting) != 0)
+        {
+            m_state.notify_all();
+        }
+        return result;
+    }
+
+private:
+    std::atomic<uint32_t> m_state { pending };
+    std::optional<T> m_value;
+    std::exception_ptr m_exception;
+};
+
+/// <summary>
+/// A memoized value, that invokes the function with the values of its dependencies.
+/// The function and the references to the dependencies are released after the computation.
+/// </summary>
+template<class T, class Function, class... Dependencies>
+class lazy_thunk final : public lazy_value<T>
+{
+public:
+    explicit lazy_thunk(Function function, Dependencies... dependencies)
+        : m_thunk(std::in_place, std::move(function), std::move(dependencies)...) { }
+
+protected:
+    T compute() override
+    {
+        try
+        {
+            auto& function = m_thunk->m_function;
+            auto value = std::apply(
+                [&](const auto&... dependency) { return function(dependency.get()...); },
+                m_thunk->m_dependencies);
+            m_thunk.reset();
+            return value;
+        }
+        catch (...)
+        {
+            // The failure is memoized too, so the thunk is never needed again
+            m_thunk.reset();
+            throw;
+        }
+    }
+
+private:
+    struct thunk
+    {
+        thunk(Function function, Dependencies... dependencies)
+            : m_function(std::move(function))
+            , m_dependencies(std::move(dependencies)...) { }
+
+        Function m_function;
+        std::tuple<Dependencies...> m_dependencies;
+    };
+
+    std::optional<thunk> m_thunk;
+};
+
+/// <summary>
+/// A shared handle of a memoized value. The copies of the handle refer to the same
+/// <see cref="lazy_value"/>, so the value is computed once for all holders,
+/// and the steady-state access is a single acquire load.
+/// </summary>
+/// <typeparam name="T">
+/// The type of the value
+/// </typeparam>
+template<class T>
+class lazy_ptr final
+{
+public:
+    using element_type = T;
+
+    lazy_ptr() noexcept = default;
+
+    explicit lazy_ptr(intrusive_ptr<lazy_value<T>> value) noexcept : m_value(std::move(value)) { }
+
+    /// <summary>
+    /// Checks whether the handle refers to a value
+    /// </summary>
+    inline explicit operator bool() const noexcept
+    {
+        return static_cast<bool>(m_value);
+    }
+
+    /// <summary>
+    /// Checks whether the value has been computed
+    /// </summary>
+    inline bool is_ready() const noexcept
+    {
+        return m_value->is_ready();
+    }
+
+    /// <summary>
+    /// Returns the value, computing it on the first access by any holder
+    /// </summary>
+    inline const T& get() const
+    {
+        return m_value->get();
+    }
+
+    inline const T& operator*() const
+    {
+        return get();
+    }
+
+    inline const T* operator->() const
+    {
+        return &get();
+    }
+
+    /// <summary>
+    /// Returns the number of the holders of the value
+    /// </summary>
+    inline uint32_t use_count() const noexcept
+    {
+        return m_value.use_count();
+    }
+
+private:
+    intrusive_ptr<lazy_value<T>> m_value;
+};
+
+/// <summary>
+/// Creates a memoized value computed by the function from the values of the dependencies.
+/// Each dependency is computed once, even if it is shared by several values.
+/// The dependencies must not form a cycle.
+/// </summary>
+/// <param name="function">
+/// - A callable object that accepts constant references to the values of the dependencies
+/// </param>
+/// <param name="dependencies">
+/// - The handles of the memoized values, that the value depends on
+/// </param>
+template<class Function, class... Dependencies>
+inline auto make_lazy(Function&& function, Dependencies... dependencies)
+{
+    using function_type = std::decay_t<Function>;
+    using value_type = std::decay_t<std::invoke_result_t<function_type&, const typename Dependencies::element_type&...>>;
+    using thunk_type = lazy_thunk<value_type, function_type, Dependencies...>;
+
+    auto value = new thunk_type(std::forward<Function>(function), std::move(dependencies)...);
+    return lazy_ptr<value_type>(intrusive_ptr<lazy_value<value_type>>(value));
+}
@@ -0,0 +1,434 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <algorithm>
+#include <cstddef>
+#include <filesystem>
+#include <span>
+#include <string_view>
+#include <system_error>
+#include <utility>
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#include "intrusive_ptr.h"
+
+/// <summary>
+/// The expected access to a range of a mapped file, that is passed to the kernel as a hint
+/// </summary>
+enum class access_hint
+{
+    normal,
+    sequential,
+    random,
+    // The range is read ahead asynchronously
+    will_need,
+    // The pages of the range are dropped and read again on the next access
+    dont_need
+};
+
+/// <summary>
+/// The options of mapping a file
+/// </summary>
+struct mapping_options
+{
+    // The hint for the whole file
+    access_hint hint = access_hint::normal;
+    // Reads the whole file into the page cache and maps it before returning, where supported
+    bool populate = false;
+    // Aligns the mapping to the huge page size, so the kernel may back it by huge pages, where supported
+    bool huge_pages = false;
+};
+
+/// <summary>
+/// A read-only mapping of a whole file, that is unmapped with the last reference.
+/// The slices of the file hold the references, so the mapped bytes are shared without copying.
+/// </summary>
+class mapped_file final : public RefCountObject<mapped_file>
+{
+    static constexpr size_t huge_page_size = size_t(2) << 20;
+
+public:
+    /// <summary>
+    /// Maps the file. Throws <see cref="std::system_error"/>, if the file cannot be opened or mapped.
+    /// </summary>
+    explicit mapped_file(const std::filesystem::path& path, const mapping_options& options = { })
+    {
+        open(path, options);
+    }
+
+    mapped_file(const mapped_file&) = delete;
+    mapped_file& operator=(const mapped_file&) = delete;
+
+    ~mapped_file() override
+    {
+#if defined(_WIN32)
+        if (m_data != nullptr)
+        {
+            UnmapViewOfFile(m_data);
+        }
+        if (m_mapping != nullptr)
+        {
+            CloseHandle(m_mapping);
+        }
+        if (m_file != INVALID_HANDLE_VALUE)
+        {
+            CloseHandle(m_file);
+        }
+#else
+        if (m_data != nullptr)
+        {
+            ::munmap(const_cast<std::byte*>(m_data), m_size);
+        }
+#endif
+    }
+
+    inline const std::byte* data() const noexcept
+    {
+        return m_data;
+    }
+
+    inline size_t size() const noexcept
+    {
+        return m_size;
+    }
+
+    /// <summary>
+    /// Passes the hint about the range of the file to the kernel. The range is extended to the whole pages.
+    /// On Windows only <see cref="access_hint::will_need"/> has an effect.
+    /// </summary>
+    /// <returns>
+    /// True, if the hint has been accepted
+    /// </returns>
+    inline bool advise(size_t offset, size_t count, access_hint hint) const noexcept
+    {
+        offset = std::min(offset, m_size);
+        count = std::min(count, m_size - offset);
+        if (count == 0)
+        {
+            return true;
+        }
+#if defined(_WIN32)
+        if (hint != access_hint::will_need)
+        {
+            return true;
+        }
+        auto range = WIN32_MEMORY_RANGE_ENTRY { const_cast<std::byte*>(m_data + offset), count };
+        return PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0) != 0;
+#else
+        static const auto page_size = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+        auto begin = reinterpret_cast<uintptr_t>(m_data + offset) & ~(page_size - 1);
+        auto end = reinterpret_cast<uintptr_t>(m_data + offset + count);
+        return ::madvise(reinterpret_cast<void*>(begin), end - begin, native_advice(hint)) == 0;
+#endif
+    }
+
+private:
+#if defined(_WIN32)
+    inline void open(const std::filesystem::path& path, const mapping_options& options)
+    {
+        auto flags = options.hint == access_hint::sequential ? FILE_FLAG_SEQUENTIAL_SCAN
+            : options.hint == access_hint::random ? FILE_FLAG_RANDOM_ACCESS : FILE_ATTRIBUTE_NORMAL;
+        m_file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, flags, nullptr);
+        if (m_file == INVALID_HANDLE_VALUE)
+        {
+            throw std::system_error(static_cast<int>(GetLastError()), std::system_category(), "CreateFileW");
+        }
+
+        auto size = LARGE_INTEGER();
+        if (!GetFileSizeEx(m_file, &size))
+        {
+            fail("GetFileSizeEx");
+        }
+        m_size = static_cast<size_t>(size.QuadPart);
+        if (m_size == 0)
+        {
+            return;
+        }
+
+        m_mapping = CreateFileMappingW(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (m_mapping == nullptr)
+        {
+            fail("CreateFileMappingW");
+        }
+        m_data = static_cast<const std::byte*>(MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0));
+        if (m_data == nullptr)
+        {
+            fail("MapViewOfFile");
+        }
+        if (options.populate || options.hint == access_hint::will_need)
+        {
+            advise(0, m_size, access_hint::will_need);
+        }
+    }
+
+    /// <summary>
+    /// Releases the handles opened so far, since the destructor does not run for a throwing constructor
+    /// </summary>
+    [[noreturn]] inline void fail(const char* operation)
+    {
+        auto error = static_cast<int>(GetLastError());
+        if (m_mapping != nullptr)
+        {
+            CloseHandle(m_mapping);
+        }
+        CloseHandle(m_file);
+        throw std::system_error(error, std::system_category(), operation);
+    }
+#else
+    inline void open(const std::filesystem::path& path, const mapping_options& options)
+    {
+        auto file = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (file < 0)
+        {
+            throw std::system_error(errno, std::system_category(), "open");
+        }
+
+        struct stat status;
+        if (::fstat(file, &status) != 0)
+        {
+            fail(file, "fstat");
+        }
+        m_size = static_cast<size_t>(status.st_size);
+        if (m_size == 0)
+        {
+            ::close(file);
+            return;
+        }
+
+        auto flags = MAP_SHARED;
+#if defined(MAP_POPULATE)
+        if (options.populate)
+        {
+            flags |= MAP_POPULATE;
+        }
+#endif
+        auto address = options.huge_pages ? reserve_aligned() : nullptr;
+        if (address != nullptr)
+        {
+            flags |= MAP_FIXED;
+        }
+        auto mapped = ::mmap(address, m_size, PROT_READ, flags, file, 0);
+        if (mapped == MAP_FAILED)
+        {
+            if (address != nullptr)
+            {
+                ::munmap(address, m_size);
+            }
+            fail(file, "mmap");
+        }
+        ::close(file);
+        m_data = static_cast<const std::byte*>(mapped);
+
+#if defined(MADV_HUGEPAGE)
+        if (options.huge_pages)
+        {
+            ::madvise(mapped, m_size, MADV_HUGEPAGE);
+        }
+#endif
+        if (options.hint != access_hint::normal)
+        {
+            advise(0, m_size, options.hint);
+        }
+    }
+
+    /// <summary>
+    /// Reserves the address range aligned to the huge page size, that the file is mapped over
+    /// </summary>
+    /// <returns>
+    /// The aligned address, or null, if the range cannot be reserved
+    /// </returns>
+    inline void* reserve_aligned() const noexcept
+    {
+        auto reserved_size = m_size + huge_page_size;
+        auto reserved = ::mmap(nullptr, reserved_size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (reserved == MAP_FAILED)
+        {
+            return nullptr;
+        }
+
+        auto begin = reinterpret_cast<uintptr_t>(reserved);
+        auto aligned = (begin + huge_page_size - 1) & ~(huge_page_size - 1);
+        auto end = begin + reserved_size;
+        auto aligned_end = aligned + m_size;
+        if (aligned != begin)
+        {
+            ::munmap(reserved, aligned - begin);
+        }
+        // The tail beyond the last page of the file stays reserved otherwise
+        static const auto page_size = static_cast<uintptr_t>(::sysconf(_SC_PAGESIZE));
+        aligned_end = (aligned_end + page_size - 1) & ~(page_size - 1);
+        if (end > aligned_end)
+        {
+            ::munmap(reinterpret_cast<void*>(aligned_end), end - aligned_end);
+        }
+        return reinterpret_cast<void*>(aligned);
+    }
+
+    [[noreturn]] static inline void fail(int file, const char* operation)
+    {
+        auto error = errno;
+        ::close(file);
+        throw std::system_error(error, std::system_category(), operation);
+    }
+
+    static inline int native_advice(access_hint hint) noexcept
+    {
+        switch (hint)
+        {
+        case access_hint::sequential:
+            return MADV_SEQUENTIAL;
+        case access_hint::random:
+            return MADV_RANDOM;
+        case access_hint::will_need:
+            return MADV_WILLNEED;
+        case access_hint::dont_need:
+            return MADV_DONTNEED;
+        default:
+            return MADV_NORMAL;
+        }
+    }
+#endif
+
+private:
+    const std::byte* m_data { nullptr };
+    size_t m_size { 0 };
+#if defined(_WIN32)
+    HANDLE m_file { INVALID_HANDLE_VALUE };
+    HANDLE m_mapping { nullptr };
+#endif
+};
+
+/// <summary>
+/// A range of the bytes of a <see cref="mapped_file"/>, that keeps the mapping alive.
+/// Slicing and splitting take O(1) and only change the reference count of the mapping.
+/// </summary>
+class mapped_slice final
+{
+public:
+    mapped_slice() noexcept = default;
+
+    /// <summary>
+    /// Provides a slice of the whole file
+    /// </summary>
+    explicit mapped_slice(intrusive_ptr<mapped_file> file) noexcept
+        : m_file(std::move(file))
+        , m_data(m_file->data())
+        , m_size(m_file->size()) { }
+
+    inline const std::byte* data() const noexcept
+    {
+        return m_data;
+    }
+
+    inline size_t size() const noexcept
+    {
+        return m_size;
+    }
+
+    inline bool empty() const noexcept
+    {
+        return m_size == 0;
+    }
+
+    inline std::byte operator[](size_t index) const noexcept
+    {
+        return m_data[index];
+    }
+
+    inline std::span<const std::byte> span() const noexcept
+    {
+        return std::span<const std::byte>(m_data, m_size);
+    }
+
+    inline std::string_view view() const noexcept
+    {
+        return std::string_view(reinterpret_cast<const char*>(m_data), m_size);
+    }
+
+    /// <summary>
+    /// Returns the number of the slices sharing the mapping
+    /// </summary>
+    inline uint32_t use_count() const noexcept
+    {
+        return m_file.use_count();
+    }
+
+    /// <summary>
+    /// Returns a slice of the part of the bytes sharing the mapping
+    /// </summary>
+    /// <param name="offset">
+    /// - The position of the first byte of the slice
+    /// </param>
+    /// <param name="count">
+    /// - The number of the bytes, that is limited by the end of the current slice
+    /// </param>
+    inline mapped_slice slice(size_t offset, size_t count = SIZE_MAX) const
+    {
+        offset = std::min(offset, m_size);
+        return mapped_slice(m_file, m_data + offset, std::min(count, m_size - offset));
+    }
+
+    /// <summary>
+    /// Removes the first bytes from the slice and returns them as a new slice
+    /// </summary>
+    inline mapped_slice split_to(size_t count)
+    {
+        count = std::min(count, m_size);
+        auto front = mapped_slice(m_file, m_data, count);
+        advance(count);
+        return front;
+    }
+
+    inline void advance(size_t count) noexcept
+    {
+        count = std::min(count, m_size);
+        m_data += count;
+        m_size -= count;
+    }
+
+    inline void truncate(size_t count) noexcept
+    {
+        m_size = std::min(count, m_size);
+    }
+
+    /// <summary>
+    /// Passes the hint about the range of the slice to the kernel
+    /// </summary>
+    inline bool advise(access_hint hint) const noexcept
+    {
+        return !m_file || m_file->advise(static_cast<size_t>(m_data - m_file->data()), m_size, hint);
+    }
+
+private:
+    inline mapped_slice(intrusive_ptr<mapped_file> file, const std::byte* data, size_t count) noexcept
+        : m_file(std::move(file))
+        , m_data(data)
+        , m_size(count) { }
+
+private:
+    intrusive_ptr<mapped_file> m_file;
+    const std::byte* m_data { nullptr };
+    size_t m_size { 0 };
+};
+
+/// <summary>
+/// Maps the file and provides the slice of its whole content.
+/// Throws <see cref="std::system_error"/>, if the file cannot be opened or mapped.
+/// </summary>
+inline mapped_slice map_file(const std::filesystem::path& path, const mapping_options& options = { })
+{
+    return mapped_slice(intrusive_ptr<mapped_file>(new mapped_file(path, options)));
+}
@@ -0,0 +1,276 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <utility>
+#include <vector>
+#include "epoch_domain.h"
+#include "intrusive_ptr.h"
+
+/// <summary>
+/// A list of listeners, that are notified concurrently without locks and without changing reference counts.
+/// The listeners are published as an immutable array: a notification pins the epoch by
+/// <see cref="epoch_domain::guard"/> and iterates the current array, while the changes of the list
+/// are accumulated under the mutex and applied by building a single new array for the whole batch.
+/// The replaced array and the references to the removed listeners are retired to the epoch domain,
+/// so a listener unsubscribed during a notification stays alive until the notification ends.
+/// </summary>
+/// <typeparam name="T">
+/// The type of the listeners derived from <see cref="RefCountObject"/>
+/// </typeparam>
+template<intrusive_counter_type T>
+class observer_list final
+{
+    /// <summary>
+    /// An immutable array of listeners stored after the snapshot.
+    /// The list holds one reference to each listener, so the snapshots hold none.
+    /// </summary>
+    class snapshot final : public RefCountObject<snapshot>
+    {
+        struct trailing_t { };
+
+    public:
+        static void* operator new(size_t size, trailing_t, size_t count)
+        {
+            return ::operator new(size + count * sizeof(T*));
+        }
+
+        static void operator delete(void* ptr, trailing_t, size_t) noexcept
+        {
+            ::operator delete(ptr);
+        }
+
+        static void operator delete(void* ptr) noexcept
+        {
+            ::operator delete(ptr);
+        }
+
+        static snapshot* create(size_t count)
+        {
+            auto created = new (trailing_t { }, count) snapshot(count);
+            intrusive_ptr_add_ref(created);
+            return created;
+        }
+
+        inline T** begin() noexcept
+        {
+            return reinterpret_cast<T**>(this + 1);
+        }
+
+        inline T** end() noexcept
+        {
+            return begin() + m_size;
+        }
+
+        const size_t m_size;
+
+    private:
+        explicit snapshot(size_t count) noexcept : m_size(count) { }
+    };
+
+    /// <summary>
+    /// A change of the list waiting for the next notification or commit
+    /// </summary>
+    struct change
+    {
+        // A listener to add holds a reference, a listener to remove does not
+        T* m_listener;
+        bool m_add;
+    };
+
+public:
+    observer_list() : m_snapshot(snapshot::create(0)) { }
+
+    observer_list(const observer_list&) = delete;
+    observer_list& operator=(const observer_list&) = delete;
+
+    /// <summary>
+    /// Releases the listeners. No notification may run concurrently.
+    /// </summary>
+    ~observer_list()
+    {
+        auto current = m_snapshot.load(std::memory_order_relaxed);
+        std::for_each(current->begin(), current->end(), [](T* listener) { intrusive_ptr_release(listener); });
+        intrusive_ptr_release(current);
+        for (auto& pending : m_changes)
+        {
+            if (pending.m_add)
+            {
+                intrusive_ptr_release(pending.m_listener);
+            }
+        }
+    }
+
+    /// <summary>
+    /// Adds the listener to the list. It is notified starting from the next notification.
+    /// A listener may be added several times and is notified once for each addition.
+    /// An empty pointer is ignored.
+    /// </summary>
+    inline void subscribe(intrusive_ptr<T> listener)
+    {
+        if (!listener)
+        {
+            return;
+        }
+
+        auto lock = std::lock_guard(m_mutex);
+        m_changes.push_back({ listener.get(), true });
+        listener.detach();
+        m_changed.store(true, std::memory_order_release);
+    }
+
+    /// <summary>
+    /// Removes one addition of the listener from the list. It is not notified by the notifications
+    /// started after the call, while the running ones may still notify it.
+    /// </summary>
+    inline void unsubscribe(T& listener)
+    {
+        auto lock = std::lock_guard(m_mutex);
+        m_changes.push_back({ &listener, false });
+        m_changed.store(true, std::memory_order_release);
+    }
+
+    /// <summary>
+    /// Applies the pending changes by publishing a new array of listeners
+    /// </summary>
+    inline void commit()
+    {
+        auto retired = std::vector<T*>();
+        auto replaced = static_cast<snapshot*>(nullptr);
+        {
+            auto lock = std::lock_guard(m_mutex);
+            replaced = apply(retired);
+        }
+
+        // The release of a listener may unsubscribe from the list, so the references are retired without the lock
+        auto& domain = epoch_domain::instance();
+        for (auto listener : retired)
+        {
+            domain.retire(listener);
+        }
+        if (replaced != nullptr)
+        {
+            domain.retire(replaced);
+        }
+    }
+
+    /// <summary>
+    /// Invokes the function for each listener. The listeners may subscribe and unsubscribe
+    /// during the notification, and the notifications may run concurrently.
+    /// </summary>
+    /// <param name="function">
+    /// - A callable object that accepts a reference to a listener
+    /// </param>
+    template<class Function>
+    inline void notify(Function&& function)
+    {
+        if (m_changed.load(std::memory_order_acquire))
+        {
+            commit();
+        }
+
+        auto guard = epoch_domain::instance().pin();
+        auto current = m_snapshot.load(std::memory_order_acquire);
+        for (auto listener : *current)
+        {
+            function(*listener);
+        }
+    }
+
+    /// <summary>
+    /// Returns the number of the listeners without the pending changes
+    /// </summary>
+    inline size_t size() const noexcept
+    {
+        auto guard = epoch_domain::instance().pin();
+        return m_snapshot.load(std::memory_order_acquire)->m_size;
+    }
+
+private:
+    /// <summary>
+    /// Builds the array of the current listeners without the removed ones followed by the added ones.
+    /// A removal cancels the latest pending addition of the listener before it in the batch,
+    /// or else one occurrence of the listener in the current array.
+    /// The list is changed only after the new array has been built, so a failed allocation
+    /// keeps the current array and the pending changes.
+    /// </summary>
+    /// <param name="retired">
+    /// - An empty vector, that receives the removed listeners, whose references must be retired
+    /// </param>
+    /// <returns>
+    /// The replaced array, that must be retired, or null, if there were no changes
+    /// </returns>
+    inline snapshot* apply(std::vector<T*>& retired)
+    {
+        if (!m_changed.load(std::memory_order_relaxed))
+        {
+            return nullptr;
+        }
+
+        auto added = std::vector<T*>();
+        auto removed = std::vector<T*>();
+        auto released = std::vector<T*>();
+        for (auto& pending : m_changes)
+        {
+            if (pending.m_add)
+            {
+                added.push_back(pending.m_listener);
+                continue;
+            }
+
+            auto position = std::find(added.rbegin(), added.rend(), pending.m_listener);
+            if (position != added.rend())
+            {
+                released.push_back(*position);
+                added.erase(std::next(position).base());
+            }
+            else
+            {
+                removed.push_back(pending.m_listener);
+            }
+        }
+
+        auto current = m_snapshot.load(std::memory_order_relaxed);
+        auto retained = std::vector<T*>();
+        retained.reserve(current->m_size + added.size());
+        std::sort(removed.begin(), removed.end());
+        auto matched = std::vector<bool>(removed.size());
+        for (auto listener : *current)
+        {
+            auto index = static_cast<size_t>(std::lower_bound(removed.begin(), removed.end(), listener) - removed.begin());
+            while (index < removed.size() && removed[index] == listener && matched[index])
+            {
+                ++index;
+            }
+            if (index < removed.size() && removed[index] == listener)
+            {
+                matched[index] = true;
+                released.push_back(listener);
+                continue;
+            }
+            retained.push_back(listener);
+        }
+        retained.insert(retained.end(), added.begin(), added.end());
+
+        auto created = snapshot::create(retained.size());
+        std::uninitialized_copy(retained.begin(), retained.end(), created->begin());
+
+        // Nothing below throws
+        retired.swap(released);
+        m_changes.clear();
+        m_snapshot.store(created, std::memory_order_release);
+        // The flag is cleared after the publication, so a notification skipping the commit sees the new array
+        m_changed.store(false, std::memory_order_release);
+        return current;
+    }
+
+private:
+    std::atomic<snapshot*> m_snapshot;
+    std::atomic<bool> m_changed { false };
+    std::mutex m_mutex;
+    std::vector<change> m_changes;
+};
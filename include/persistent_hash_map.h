@@ -0,0 +1,744 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <bit>
+#include <functional>
+#include <memory>
+#include <new>
+#include <utility>
+#include "intrusive_ptr.h"
+
+/// <summary>
+/// A persistent (immutable) hash map based on the hash array mapped trie.
+/// The nodes of the trie are objects derived from <see cref="RefCountObject"/>,
+/// which are shared between versions of the map through <see cref="intrusive_ptr"/>.
+/// A copy of the map is a snapshot and takes O(1), an update copies
+/// only the path from the root to the changed entry, O(log32 n).
+/// The nodes that are referenced only by the current version are updated in place.
+/// </summary>
+/// <typeparam name="Key">
+/// The type of the keys
+/// </typeparam>
+/// <typeparam name="Value">
+/// The type of the mapped values
+/// </typeparam>
+/// <typeparam name="Hash">
+/// The hash function of the keys
+/// </typeparam>
+/// <typeparam name="KeyEqual">
+/// The equality comparer of the keys
+/// </typeparam>
+template<class Key, class Value, class Hash = std::hash<Key>, class KeyEqual = std::equal_to<Key>>
+class persistent_hash_map final
+{
+    static constexpr unsigned bits_per_level = 5;
+    static constexpr unsigned hash_bits = sizeof(size_t) * 8;
+
+    using entry_type = std::pair<Key, Value>;
+
+    /// <summary>
+    /// A compact trie node. The bitmaps mark the occupied slots of the level,
+    /// the entries and the children are stored in popcount order in trailing arrays
+    /// of the same allocation. The nodes below the last level contain only
+    /// the entries with colliding hashes.
+    /// </summary>
+    class node final : public RefCountObject<node>
+    {
+        struct trailing_t { };
+
+    public:
+        static void* operator new(size_t size, trailing_t, size_t extra)
+        {
+            return ::operator new(size + extra);
+        }
+
+        static void operator delete(void* ptr, trailing_t, size_t) noexcept
+        {
+            ::operator delete(ptr);
+        }
+
+        static void operator delete(void* ptr) noexcept
+        {
+            ::operator delete(ptr);
+        }
+
+        /// <summary>
+        /// Creates a node and constructs its slots from the specified generators
+        /// </summary>
+        template<class EntryAt, class ChildAt>
+        static auto create(uint32_t datamap, uint32_t nodemap,
+            uint32_t entry_count, uint32_t child_count, EntryAt&& entry_at, ChildAt&& child_at)
+        {
+            auto extra = entries_offset(child_count) + entry_count * sizeof(entry_type) - sizeof(node);
+            auto ptr = intrusive_ptr<node>(new (trailing_t { }, extra) node(datamap, nodemap));
+
+            for (; ptr->m_child_count < child_count; ++ptr->m_child_count)
+            {
+                new (ptr->children() + ptr->m_child_count) intrusive_ptr<node>(child_at(ptr->m_child_count));
+            }
+
+            for (; ptr->m_entry_count < entry_count; ++ptr->m_entry_count)
+            {
+                new (ptr->entries() + ptr->m_entry_count) entry_type(entry_at(ptr->m_entry_count));
+            }
+            return ptr;
+        }
+
+        ~node() override
+        {
+            for (auto i = m_entry_count; i > 0; --i)
+            {
+                std::destroy_at(entries() + i - 1);
+            }
+
+            for (auto i = m_child_count; i > 0; --i)
+            {
+                std::destroy_at(children() + i - 1);
+            }
+        }
+
+        inline auto* children() noexcept
+        {
+            return reinterpret_cast<intrusive_ptr<node>*>(
+                reinterpret_cast<char*>(this) + children_offset());
+        }
+
+        inline entry_type* entries() noexcept
+        {
+            return reinterpret_cast<entry_type*>(
+                reinterpret_cast<char*>(this) + entries_offset(m_child_count));
+        }
+
+        inline uint32_t data_index(uint32_t bit) const noexcept
+        {
+            return std::popcount(m_datamap & (bit - 1));
+        }
+
+        inline uint32_t node_index(uint32_t bit) const noexcept
+        {
+            return std::popcount(m_nodemap & (bit - 1));
+        }
+
+    private:
+        inline node(uint32_t datamap, uint32_t nodemap) noexcept
+            : m_datamap(datamap)
+            , m_nodemap(nodemap) { }
+
+        static constexpr size_t align_up(size_t size, size_t alignment) noexcept
+        {
+            return (size + alignment - 1) / alignment * alignment;
+        }
+
+        static constexpr size_t children_offset() noexcept
+        {
+            return align_up(sizeof(node), alignof(intrusive_ptr<node>));
+        }
+
+        static constexpr size_t entries_offset(uint32_t child_count) noexcept
+        {
+            return align_up(children_offset() + child_count * sizeof(intrusive_ptr<node>),
+                alignof(entry_type));
+        }
+
+    public:
+        uint32_t m_datamap;
+        uint32_t m_nodemap;
+        uint32_t m_entry_count { 0 };
+        uint32_t m_child_count { 0 };
+    };
+
+    using node_ptr = intrusive_ptr<node>;
+
+public:
+    using key_type = Key;
+    using mapped_type = Value;
+    using size_type = size_t;
+
+    /// <summary>
+    /// Provides a new empty instance of <see cref="persistent_hash_map"/>
+    /// </summary>
+    persistent_hash_map() noexcept = default;
+
+    /// <summary>
+    /// Provides a snapshot of the specified map in O(1).
+    /// The snapshot shares all the nodes with the specified map.
+    /// </summary>
+    persistent_hash_map(const persistent_hash_map&) noexcept = default;
+    persistent_hash_map(persistent_hash_map&& other) noexcept
+        : m_root(std::move(other.m_root))
+        , m_size(std::exchange(other.m_size, 0)) { }
+
+    persistent_hash_map& operator=(const persistent_hash_map&) noexcept = default;
+    persistent_hash_map& operator=(persistent_hash_map&& other) noexcept
+    {
+        m_root = std::move(other.m_root);
+        m_size = std::exchange(other.m_size, 0);
+        return *this;
+    }
+
+    /// <summary>
+    /// Returns the current number of entries of the map
+    /// </summary>
+    inline size_t size() const noexcept
+    {
+        return m_size;
+    }
+
+    /// <summary>
+    /// Checks whether the map has no entries
+    /// </summary>
+    inline bool empty() const noexcept
+    {
+        return m_size == 0;
+    }
+
+    /// <summary>
+    /// Finds the value mapped to the specified key
+    /// </summary>
+    /// <param name="key">
+    /// - The key of the entry
+    /// </param>
+    /// <returns>
+    /// A pointer to the value, that is valid until the current version is changed or destroyed,
+    /// or <see langword="nullptr"/>, if the map has no such key
+    /// </returns>
+    inline const Value* find(const Key& key) const
+    {
+        auto entry = find_entry(m_root.get(), Hash { }(key), 0, key);
+        return entry != nullptr ? &entry->second : nullptr;
+    }
+
+    /// <summary>
+    /// Checks whether the map contains the specified key
+    /// </summary>
+    inline bool contains(const Key& key) const
+    {
+        return find(key) != nullptr;
+    }
+
+    /// <summary>
+    /// Maps the value to the specified key in the current version of the map.
+    /// The nodes shared with other versions are copied, the rest are updated in place.
+    /// </summary>
+    /// <param name="key">
+    /// - The key of the entry
+    /// </param>
+    /// <param name="value">
+    /// - The value of the entry
+    /// </param>
+    /// <returns>
+    /// Returns <see langword="true"/>, if a new entry was inserted,
+    /// otherwise the value of the existing entry was replaced.
+    /// </returns>
+    inline bool insert_or_assign(Key key, Value value)
+    {
+        auto hash = Hash { }(key);
+        if (!m_root)
+        {
+            m_root = node::create(bit_of(hash, 0), 0, 1, 0,
+                [&](uint32_t) { return entry_type(std::move(key), std::move(value)); },
+                [](uint32_t) { return node_ptr(); });
+            ++m_size;
+            return true;
+        }
+
+        auto inserted = insert(m_root, hash, 0, key, value);
+        m_size += inserted ? 1 : 0;
+        return inserted;
+    }
+
+    /// <summary>
+    /// Removes the entry with the specified key from the current version of the map.
+    /// The nodes shared with other versions are copied, the rest are updated in place.
+    /// </summary>
+    /// <param name="key">
+    /// - The key of the entry
+    /// </param>
+    /// <returns>
+    /// Returns <see langword="true"/>, if the entry was removed,
+    /// otherwise the map has no such key.
+    /// </returns>
+    inline bool erase(const Key& key)
+    {
+        if (!m_root || !remove(m_root, Hash { }(key), 0, key))
+        {
+            return false;
+        }
+
+        if (--m_size == 0)
+        {
+            m_root.reset(nullptr);
+        }
+        return true;
+    }
+
+    /// <summary>
+    /// Provides a new version of the map with the value mapped to the specified key.
+    /// The current version is not changed.
+    /// </summary>
+    inline persistent_hash_map set(Key key, Value value) const
+    {
+        auto version = *this;
+        version.insert_or_assign(std::move(key), std::move(value));
+        return version;
+    }
+
+    /// <summary>
+    /// Provides a new version of the map without the specified key.
+    /// The current version is not changed.
+    /// </summary>
+    inline persistent_hash_map without(const Key& key) const
+    {
+        auto version = *this;
+        version.erase(key);
+        return version;
+    }
+
+    /// <summary>
+    /// Calls the handler for each entry of the map in unspecified order
+    /// </summary>
+    /// <param name="handler">
+    /// - A callable object that accepts the key and the value of an entry
+    /// </param>
+    template<class Handler>
+    inline void for_each(Handler&& handler) const
+    {
+        for_each_entry(m_root.get(), handler);
+    }
+
+    /// <summary>
+    /// Compares the current version of the map with the specified one.
+    /// The subtrees shared by the versions are skipped without visiting them.
+    /// </summary>
+    /// <param name="other">
+    /// - A reference to another version of the map
+    /// </param>
+    /// <param name="handler">
+    /// - A callable object that accepts the key, a pointer to the value in the current version
+    /// and a pointer to the value in the specified version. One of the pointers is
+    /// <see langword="nullptr"/>, if the entry was added or removed.
+    /// </param>
+    template<class Handler>
+    inline void diff(const persistent_hash_map& other, Handler&& handler) const
+    {
+        diff_nodes(m_root.get(), other.m_root.get(), 0, handler);
+    }
+
+private:
+    static inline uint32_t bit_of(size_t hash, unsigned shift) noexcept
+    {
+        return uint32_t(1) << ((hash >> shift) & ((1u << bits_per_level) - 1));
+    }
+
+    static inline bool is_collision(unsigned shift) noexcept
+    {
+        return shift >= hash_bits;
+    }
+
+    static const entry_type* find_entry(node* current, size_t hash, unsigned shift, const Key& key)
+    {
+        for (; current != nullptr; shift += bits_per_level)
+        {
+            if (is_collision(shift))
+            {
+                for (uint32_t i = 0; i < current->m_entry_count; ++i)
+                {
+                    if (KeyEqual { }(current->entries()[i].first, key))
+                    {
+                        return &current->entries()[i];
+                    }
+                }
+                return nullptr;
+            }
+
+            auto bit = bit_of(hash, shift);
+            if (current->m_datamap & bit)
+            {
+                auto& entry = current->entries()[current->data_index(bit)];
+                return KeyEqual { }(entry.first, key) ? &entry : nullptr;
+            }
+
+            current = current->m_nodemap & bit
+                ? current->children()[current->node_index(bit)].get()
+                : nullptr;
+        }
+        return nullptr;
+    }
+
+    /// <summary>
+    /// Creates a copy of the node with the same slots
+    /// </summary>
+    static node_ptr clone(node* source)
+    {
+        return node::create(source->m_datamap, source->m_nodemap,
+            source->m_entry_count, source->m_child_count,
+            [&](uint32_t i) { return source->entries()[i]; },
+            [&](uint32_t i) { return source->children()[i]; });
+    }
+
+    /// <summary>
+    /// Makes the node referenced by the slot exclusively owned by the slot
+    /// </summary>
+    static node* make_editable(node_ptr& slot)
+    {
+        if (slot.use_count() != 1)
+        {
+            slot = clone(slot.get());
+        }
+        return slot.get();
+    }
+
+    /// <summary>
+    /// Creates a node of the specified level containing two entries with different keys
+    /// </summary>
+    static node_ptr merge(entry_type&& first, size_t first_hash,
+        entry_type&& second, size_t second_hash, unsigned shift)
+    {
+        if (is_collision(shift))
+        {
+            return node::create(0, 0, 2, 0,
+                [&](uint32_t i) { return i == 0 ? std::move(first) : std::move(second); },
+                [](uint32_t) { return node_ptr(); });
+        }
+
+        auto first_bit = bit_of(first_hash, shift);
+        auto second_bit = bit_of(second_hash, shift);
+        if (first_bit == second_bit)
+        {
+            auto child = merge(std::move(first), first_hash,
+                std::move(second), second_hash, shift + bits_per_level);
+            return node::create(0, first_bit, 0, 1,
+                [](uint32_t) { return entry_type(); },
+                [&](uint32_t) { return std::move(child); });
+        }
+
+        auto ordered = first_bit < second_bit;
+        return node::create(first_bit | second_bit, 0, 2, 0,
+            [&](uint32_t i) { return (i == 0) == ordered ? std::move(first) : std::move(second); },
+            [](uint32_t) { return node_ptr(); });
+    }
+
+    static bool insert(node_ptr& slot, size_t hash, unsigned shift, Key& key, Value& value)
+    {
+        auto current = slot.get();
+
+        if (is_collision(shift))
+        {
+            for (uint32_t i = 0; i < current->m_entry_count; ++i)
+            {
+                if (KeyEqual { }(current->entries()[i].first, key))
+                {
+                    make_editable(slot)->entries()[i].second = std::move(value);
+                    return false;
+                }
+            }
+
+            slot = node::create(0, 0, current->m_entry_count + 1, 0,
+                [&](uint32_t i)
+                {
+                    return i < current->m_entry_count
+                        ? current->entries()[i]
+                        : entry_type(std::move(key), std::move(value));
+                },
+                [](uint32_t) { return node_ptr(); });
+            return true;
+        }
+
+        auto bit = bit_of(hash, shift);
+        if (current->m_datamap & bit)
+        {
+            auto index = current->data_index(bit);
+            auto& entry = current->entries()[index];
+            if (KeyEqual { }(entry.first, key))
+            {
+                make_editable(slot)->entries()[index].second = std::move(value);
+                return false;
+            }
+
+            auto unique = slot.use_count() == 1;
+            auto existing_hash = Hash { }(entry.first);
+            auto child = merge(
+                unique ? std::move(entry) : entry_type(entry), existing_hash,
+                entry_type(std::move(key), std::move(value)), hash, shift + bits_per_level);
+
+            auto child_index = current->node_index(bit);
+            slot = node::create(current->m_datamap & ~bit, current->m_nodemap | bit,
+                current->m_entry_count - 1, current->m_child_count + 1,
+                [&](uint32_t i)
+                {
+                    auto source = i < index ? i : i + 1;
+                    return unique
+                        ? std::move(current->entries()[source])
+                        : current->entries()[source];
+                },
+                [&](uint32_t i)
+                {
+                    return i < child_index ? current->children()[i]
+                        : i == child_index ? std::move(child)
+                        : current->children()[i - 1];
+                });
+            return true;
+        }
+
+        if (current->m_nodemap & bit)
+        {
+            auto index = current->node_index(bit);
+            return insert(make_editable(slot)->children()[index],
+                hash, shift + bits_per_level, key, value);
+        }
+
+        auto unique = slot.use_count() == 1;
+        auto index = current->data_index(bit);
+        slot = node::create(current->m_datamap | bit, current->m_nodemap,
+            current->m_entry_count + 1, current->m_child_count,
+            [&](uint32_t i)
+            {
+                if (i == index)
+                {
+                    return entry_type(std::move(key), std::move(value));
+                }
+
+                auto source = i < index ? i : i - 1;
+                return unique
+                    ? std::move(current->entries()[source])
+                    : current->entries()[source];
+            },
+            [&](uint32_t i) { return current->children()[i]; });
+        return true;
+    }
+
+    static bool remove(node_ptr& slot, size_t hash, unsigned shift, const Key& key)
+    {
+        auto current = slot.get();
+        auto unique = slot.use_count() == 1;
+
+        if (is_collision(shift))
+        {
+            for (uint32_t index = 0; index < current->m_entry_count; ++index)
+            {
+                if (KeyEqual { }(current->entries()[index].first, key))
+                {
+                    slot = node::create(0, 0, current->m_entry_count - 1, 0,
+                        [&](uint32_t i)
+                        {
+                            auto source = i < index ? i : i + 1;
+                            return unique
+                                ? std::move(current->entries()[source])
+                                : current->entries()[source];
+                        },
+                        [](uint32_t) { return node_ptr(); });
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        auto bit = bit_of(hash, shift);
+        if (current->m_datamap & bit)
+        {
+            auto index = current->data_index(bit);
+            if (!KeyEqual { }(current->entries()[index].first, key))
+            {
+                return false;
+            }
+
+            slot = node::create(current->m_datamap & ~bit, current->m_nodemap,
+                current->m_entry_count - 1, current->m_child_count,
+                [&](uint32_t i)
+                {
+                    auto source = i < index ? i : i + 1;
+                    return unique
+                        ? std::move(current->entries()[source])
+                        : current->entries()[source];
+                },
+                [&](uint32_t i) { return current->children()[i]; });
+            return true;
+        }
+
+        if ((current->m_nodemap & bit) == 0)
+        {
+            return false;
+        }
+
+        auto index = current->node_index(bit);
+        if (!remove(make_editable(slot)->children()[index], hash, shift + bits_per_level, key))
+        {
+            return false;
+        }
+
+        current = slot.get();
+        auto child = current->children()[index].get();
+        if (child->m_child_count != 0 || child->m_entry_count > 1)
+        {
+            return true;
+        }
+
+        // The child with a single entry or without entries is inlined into the current node
+        auto child_unique = current->children()[index].use_count() == 1;
+        auto has_entry = child->m_entry_count == 1;
+        auto data_index = current->data_index(bit);
+        slot = node::create(
+            has_entry ? current->m_datamap | bit : current->m_datamap,
+            current->m_nodemap & ~bit,
+            current->m_entry_count + (has_entry ? 1 : 0), current->m_child_count - 1,
+            [&](uint32_t i)
+            {
+                if (has_entry && i == data_index)
+                {
+                    return child_unique
+                        ? std::move(child->entries()[0])
+                        : child->entries()[0];
+                }
+
+                auto source = has_entry && i > data_index ? i - 1 : i;
+                return std::move(current->entries()[source]);
+            },
+            [&](uint32_t i) { return std::move(current->children()[i < index ? i : i + 1]); });
+        return true;
+    }
+
+    template<class Handler>
+    static void for_each_entry(node* current, Handler&& handler)
+    {
+        if (current == nullptr)
+        {
+            return;
+        }
+
+        for (uint32_t i = 0; i < current->m_entry_count; ++i)
+        {
+            handler(std::as_const(current->entries()[i].first),
+                std::as_const(current->entries()[i].second));
+        }
+
+        for (uint32_t i = 0; i < current->m_child_count; ++i)
+        {
+            for_each_entry(current->children()[i].get(), handler);
+        }
+    }
+
+    template<class Handler>
+    static void diff_entry(const entry_type& entry, node* other, unsigned shift,
+        bool entry_is_old, Handler& handler)
+    {
+        auto found = find_entry(other, Hash { }(entry.first), shift, entry.first);
+        for_each_entry(other, [&](const Key& key, const Value& value)
+        {
+            if (found != nullptr && &found->first == &key)
+            {
+                if (!(entry.second == value))
+                {
+                    entry_is_old
+                        ? handler(key, &entry.second, &value)
+                        : handler(key, &value, &entry.second);
+                }
+                return;
+            }
+
+            entry_is_old
+                ? handler(key, static_cast<const Value*>(nullptr), &value)
+                : handler(key, &value, static_cast<const Value*>(nullptr));
+        });
+
+        if (found == nullptr)
+        {
+            entry_is_old
+                ? handler(entry.first, &entry.second, static_cast<const Value*>(nullptr))
+                : handler(entry.first, static_cast<const Value*>(nullptr), &entry.second);
+        }
+    }
+
+    template<class Handler>
+    static void diff_nodes(node* old_node, node* new_node, unsigned shift, Handler& handler)
+    {
+        if (old_node == new_node)
+        {
+            return;
+        }
+
+        if (old_node == nullptr || new_node == nullptr)
+        {
+            auto removed = old_node != nullptr;
+            for_each_entry(removed ? old_node : new_node, [&](const Key& key, const Value& value)
+            {
+                removed
+                    ? handler(key, &value, static_cast<const Value*>(nullptr))
+                    : handler(key, static_cast<const Value*>(nullptr), &value);
+            });
+            return;
+        }
+
+        if (is_collision(shift))
+        {
+            for (uint32_t i = 0; i < old_node->m_entry_count; ++i)
+            {
+                auto& entry = old_node->entries()[i];
+                auto found = find_entry(new_node, 0, shift, entry.first);
+                if (found == nullptr)
+                {
+                    handler(entry.first, &entry.second, static_cast<const Value*>(nullptr));
+                }
+                else if (!(entry.second == found->second))
+                {
+                    handler(entry.first, &entry.second, &found->second);
+                }
+            }
+
+            for (uint32_t i = 0; i < new_node->m_entry_count; ++i)
+            {
+                auto& entry = new_node->entries()[i];
+                if (find_entry(old_node, 0, shift, entry.first) == nullptr)
+                {
+                    handler(entry.first, static_cast<const Value*>(nullptr), &entry.second);
+                }
+            }
+            return;
+        }
+
+        auto bits = old_node->m_datamap | old_node->m_nodemap | new_node->m_datamap | new_node->m_nodemap;
+        for (; bits != 0; bits &= bits - 1)
+        {
+            auto bit = bits & (~bits + 1);
+            auto old_entry = old_node->m_datamap & bit
+                ? &old_node->entries()[old_node->data_index(bit)] : nullptr;
+            auto new_entry = new_node->m_datamap & bit
+                ? &new_node->entries()[new_node->data_index(bit)] : nullptr;
+            auto old_child = old_node->m_nodemap & bit
+                ? old_node->children()[old_node->node_index(bit)].get() : nullptr;
+            auto new_child = new_node->m_nodemap & bit
+                ? new_node->children()[new_node->node_index(bit)].get() : nullptr;
+
+            if (old_entry != nullptr && new_entry != nullptr)
+            {
+                if (KeyEqual { }(old_entry->first, new_entry->first))
+                {
+                    if (!(old_entry->second == new_entry->second))
+                    {
+                        handler(old_entry->first, &old_entry->second, &new_entry->second);
+                    }
+                }
+                else
+                {
+                    handler(old_entry->first, &old_entry->second, static_cast<const Value*>(nullptr));
+                    handler(new_entry->first, static_cast<const Value*>(nullptr), &new_entry->second);
+                }
+            }
+            else if (old_entry != nullptr)
+            {
+                diff_entry(*old_entry, new_child, shift + bits_per_level, true, handler);
+            }
+            else if (new_entry != nullptr)
+            {
+                diff_entry(*new_entry, old_child, shift + bits_per_level, false, handler);
+            }
+            else
+            {
+                diff_nodes(old_child, new_child, shift + bits_per_level, handler);
+            }
+        }
+    }
+
+private:
+    node_ptr m_root;
+    size_t m_size { 0 };
+};
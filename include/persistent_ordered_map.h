@@ -0,0 +1,830 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <algorithm>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <optional>
+#include <type_traits>
+#include <utility>
+#include "intrusive_ptr.h"
+
+/// <summary>
+/// A persistent (immutable) ordered map based on the B+ tree.
+/// The nodes of the tree are objects derived from <see cref="RefCountObject"/>,
+/// which are shared between versions of the map through <see cref="intrusive_ptr"/>.
+/// A copy of the map is a snapshot and takes O(1), an update copies only the nodes
+/// on the path from the root that are still shared with other versions, so a batch
+/// of updates applied to one copy (see <see cref="persistent_ordered_map::transact"/>)
+/// copies every node at most once. An old version stays readable while a copy of it exists.
+/// </summary>
+/// <typeparam name="Key">
+/// The type of the keys
+/// </typeparam>
+/// <typeparam name="Value">
+/// The type of the mapped values
+/// </typeparam>
+/// <typeparam name="Compare">
+/// The ordering of the keys
+/// </typeparam>
+template<class Key, class Value, class Compare = std::less<Key>>
+class persistent_ordered_map final
+{
+    // The keys of a node span about four cache lines, which are searched linearly
+    static constexpr uint32_t capacity = static_cast<uint32_t>(
+        std::clamp<size_t>(256 / sizeof(Key), 8, 64));
+    static constexpr uint32_t min_count = capacity / 2;
+    static constexpr unsigned max_height = 32;
+
+    class node : public RefCountObject<node>
+    {
+    public:
+        uint32_t m_count { 0 };
+
+    protected:
+        node() noexcept = default;
+    };
+
+    /// <summary>
+    /// A leaf containing the entries. The keys and the values are kept in separate arrays,
+    /// so the search scans only the keys.
+    /// </summary>
+    class leaf_node final : public node
+    {
+    public:
+        leaf_node() noexcept = default;
+
+        ~leaf_node() override
+        {
+            std::destroy_n(keys(), this->m_count);
+            std::destroy_n(values(), this->m_count);
+        }
+
+        inline Key* keys() noexcept
+        {
+            return std::launder(reinterpret_cast<Key*>(m_keys));
+        }
+
+        inline Value* values() noexcept
+        {
+            return std::launder(reinterpret_cast<Value*>(m_values));
+        }
+
+        template<class K, class V>
+        inline void push_back(K&& key, V&& value)
+        {
+            new (keys() + this->m_count) Key(std::forward<K>(key));
+            try
+            {
+                new (values() + this->m_count) Value(std::forward<V>(value));
+            }
+            catch (...)
+            {
+                std::destroy_at(keys() + this->m_count);
+                throw;
+            }
+            ++this->m_count;
+        }
+
+        inline void insert(uint32_t index, Key&& key, Value&& value)
+        {
+            push_back(std::move(key), std::move(value));
+            std::rotate(keys() + index, keys() + this->m_count - 1, keys() + this->m_count);
+            std::rotate(values() + index, values() + this->m_count - 1, values() + this->m_count);
+        }
+
+        inline void erase(uint32_t index)
+        {
+            std::move(keys() + index + 1, keys() + this->m_count, keys() + index);
+            std::move(values() + index + 1, values() + this->m_count, values() + index);
+            pop_back();
+        }
+
+        inline void pop_back() noexcept
+        {
+            --this->m_count;
+            std::destroy_at(keys() + this->m_count);
+            std::destroy_at(values() + this->m_count);
+        }
+
+    private:
+        alignas(Key) unsigned char m_keys[capacity * sizeof(Key)];
+        alignas(Value) unsigned char m_values[capacity * sizeof(Value)];
+    };
+
+    /// <summary>
+    /// An inner node containing the children and the separating keys:
+    /// the child with index i contains the keys that are not less than the key i - 1
+    /// and less than the key i.
+    /// </summary>
+    class inner_node final : public node
+    {
+    public:
+        inner_node() noexcept = default;
+
+        ~inner_node() override
+        {
+            std::destroy_n(keys(), m_key_count);
+        }
+
+        inline Key* keys() noexcept
+        {
+            return std::launder(reinterpret_cast<Key*>(m_keys));
+        }
+
+        inline void push_first(intrusive_ptr<node> child) noexcept
+        {
+            m_children[this->m_count++] = std::move(child);
+        }
+
+        template<class K>
+        inline void push_back(K&& key, intrusive_ptr<node> child)
+        {
+            new (keys() + m_key_count) Key(std::forward<K>(key));
+            ++m_key_count;
+            m_children[this->m_count++] = std::move(child);
+        }
+
+        inline void insert(uint32_t index, Key&& key, intrusive_ptr<node> child)
+        {
+            new (keys() + m_key_count) Key(std::move(key));
+            ++m_key_count;
+            std::rotate(keys() + index - 1, keys() + m_key_count - 1, keys() + m_key_count);
+            m_children[this->m_count++] = std::move(child);
+            std::rotate(m_children + index, m_children + this->m_count - 1, m_children + this->m_count);
+        }
+
+        inline void erase(uint32_t index)
+        {
+            std::move(keys() + index, keys() + m_key_count, keys() + index - 1);
+            std::destroy_at(keys() + --m_key_count);
+            std::move(m_children + index + 1, m_children + this->m_count, m_children + index);
+            m_children[--this->m_count] = intrusive_ptr<node>();
+        }
+
+        intrusive_ptr<node> m_children[capacity];
+        uint32_t m_key_count { 0 };
+
+    private:
+        alignas(Key) unsigned char m_keys[(capacity - 1) * sizeof(Key)];
+    };
+
+    using node_ptr = intrusive_ptr<node>;
+
+public:
+    using key_type = Key;
+    using mapped_type = Value;
+    using size_type = size_t;
+
+    /// <summary>
+    /// A forward iterator over the entries of <see cref="persistent_ordered_map"/> in key order.
+    /// The iterator borrows the nodes of the map and never changes their reference counts.
+    /// It is valid until the iterated version is changed or destroyed.
+    /// </summary>
+    class const_iterator final
+    {
+        friend class persistent_ordered_map;
+
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = std::pair<const Key&, const Value&>;
+        using difference_type = ptrdiff_t;
+        using reference = value_type;
+
+        const_iterator() noexcept = default;
+
+        inline const Key& key() const noexcept
+        {
+            return m_leaf->keys()[m_index];
+        }
+
+        inline const Value& value() const noexcept
+        {
+            return m_leaf->values()[m_index];
+        }
+
+        inline reference operator*() const noexcept
+        {
+            return reference(key(), value());
+        }
+
+        inline const_iterator& operator++() noexcept
+        {
+            if (++m_index == m_leaf->m_count)
+            {
+                next_leaf();
+            }
+            return *this;
+        }
+
+        inline const_iterator operator++(int) noexcept
+        {
+            auto it = *this;
+            ++(*this);
+            return it;
+        }
+
+        inline bool operator==(const const_iterator& other) const noexcept
+        {
+            return m_leaf == other.m_leaf && m_index == other.m_index;
+        }
+
+        inline bool operator!=(const const_iterator& other) const noexcept
+        {
+            return !(*this == other);
+        }
+
+    private:
+        inline void descend(node* current, unsigned level) noexcept
+        {
+            for (; level < m_height; ++level)
+            {
+                m_path[level] = as_inner(current);
+                m_positions[level] = 0;
+                current = m_path[level]->m_children[0].get();
+            }
+            m_leaf = as_leaf(current);
+            m_index = 0;
+        }
+
+        inline void next_leaf() noexcept
+        {
+            for (auto level = m_height; level > 0; --level)
+            {
+                auto parent = m_path[level - 1];
+                if (++m_positions[level - 1] < parent->m_count)
+                {
+                    descend(parent->m_children[m_positions[level - 1]].get(), level);
+                    return;
+                }
+            }
+            m_leaf = nullptr;
+            m_index = 0;
+        }
+
+    private:
+        inner_node* m_path[max_height] { };
+        uint32_t m_positions[max_height] { };
+        leaf_node* m_leaf { nullptr };
+        uint32_t m_index { 0 };
+        unsigned m_height { 0 };
+    };
+
+    /// <summary>
+    /// Provides a new empty instance of <see cref="persistent_ordered_map"/>
+    /// </summary>
+    persistent_ordered_map() noexcept = default;
+
+    /// <summary>
+    /// Provides a snapshot of the specified map in O(1).
+    /// The snapshot shares all the nodes with the specified map.
+    /// </summary>
+    persistent_ordered_map(const persistent_ordered_map&) noexcept = default;
+    persistent_ordered_map(persistent_ordered_map&& other) noexcept
+        : m_root(std::move(other.m_root))
+        , m_height(std::exchange(other.m_height, 0))
+        , m_size(std::exchange(other.m_size, 0)) { }
+
+    persistent_ordered_map& operator=(const persistent_ordered_map&) noexcept = default;
+    persistent_ordered_map& operator=(persistent_ordered_map&& other) noexcept
+    {
+        m_root = std::move(other.m_root);
+        m_height = std::exchange(other.m_height, 0);
+        m_size = std::exchange(other.m_size, 0);
+        return *this;
+    }
+
+    /// <summary>
+    /// Returns the current number of entries of the map
+    /// </summary>
+    inline size_t size() const noexcept
+    {
+        return m_size;
+    }
+
+    /// <summary>
+    /// Checks whether the map has no entries
+    /// </summary>
+    inline bool empty() const noexcept
+    {
+        return m_size == 0;
+    }
+
+    inline const_iterator begin() const noexcept
+    {
+        auto it = const_iterator();
+        if (m_root)
+        {
+            it.m_height = m_height;
+            it.descend(m_root.get(), 0);
+        }
+        return it;
+    }
+
+    inline const_iterator end() const noexcept
+    {
+        return const_iterator();
+    }
+
+    /// <summary>
+    /// Finds the first entry whose key is not less than the specified one
+    /// </summary>
+    inline const_iterator lower_bound(const Key& key) const noexcept
+    {
+        auto it = const_iterator();
+        if (!m_root)
+        {
+            return it;
+        }
+
+        it.m_height = m_height;
+        auto current = m_root.get();
+        for (unsigned level = 0; level < m_height; ++level)
+        {
+            auto inner = as_inner(current);
+            it.m_path[level] = inner;
+            it.m_positions[level] = child_index(inner, key);
+            current = inner->m_children[it.m_positions[level]].get();
+        }
+
+        it.m_leaf = as_leaf(current);
+        it.m_index = lower_bound_index(it.m_leaf->keys(), it.m_leaf->m_count, key);
+        if (it.m_index == it.m_leaf->m_count)
+        {
+            it.next_leaf();
+        }
+        return it;
+    }
+
+    /// <summary>
+    /// Finds the value mapped to the specified key
+    /// </summary>
+    /// <param name="key">
+    /// - The key of the entry
+    /// </param>
+    /// <returns>
+    /// A pointer to the value, that is valid until the current version is changed or destroyed,
+    /// or <see langword="nullptr"/>, if the map has no such key
+    /// </returns>
+    inline const Value* find(const Key& key) const noexcept
+    {
+        if (!m_root)
+        {
+            return nullptr;
+        }
+
+        auto current = m_root.get();
+        for (unsigned level = 0; level < m_height; ++level)
+        {
+            auto inner = as_inner(current);
+            current = inner->m_children[child_index(inner, key)].get();
+        }
+
+        auto leaf = as_leaf(current);
+        auto index = lower_bound_index(leaf->keys(), leaf->m_count, key);
+        return index < leaf->m_count && !Compare { }(key, leaf->keys()[index])
+            ? &leaf->values()[index]
+            : nullptr;
+    }
+
+    /// <summary>
+    /// Checks whether the map contains the specified key
+    /// </summary>
+    inline bool contains(const Key& key) const noexcept
+    {
+        return find(key) != nullptr;
+    }
+
+    /// <summary>
+    /// Calls the handler for each entry whose key is in the range [first, last) in key order
+    /// </summary>
+    /// <param name="first">
+    /// - The lower bound of the keys
+    /// </param>
+    /// <param name="last">
+    /// - The upper bound of the keys, that is not included
+    /// </param>
+    /// <param name="handler">
+    /// - A callable object that accepts the key and the value of an entry
+    /// </param>
+    template<class Handler>
+    inline void for_each_range(const Key& first, const Key& last, Handler&& handler) const
+    {
+        for (auto it = lower_bound(first); it != end() && Compare { }(it.key(), last); ++it)
+        {
+            handler(it.key(), it.value());
+        }
+    }
+
+    /// <summary>
+    /// Maps the value to the specified key in the current version of the map.
+    /// The nodes shared with other versions are copied, the rest are updated in place.
+    /// </summary>
+    /// <param name="key">
+    /// - The key of the entry
+    /// </param>
+    /// <param name="value">
+    /// - The value of the entry
+    /// </param>
+    /// <returns>
+    /// Returns <see langword="true"/>, if a new entry was inserted,
+    /// otherwise the value of the existing entry was replaced.
+    /// </returns>
+    bool insert_or_assign(Key key, Value value)
+    {
+        if (!m_root)
+        {
+            auto leaf = new leaf_node();
+            m_root = node_ptr(leaf);
+            leaf->push_back(std::move(key), std::move(value));
+            m_size = 1;
+            return true;
+        }
+
+        auto split_key = std::optional<Key>();
+        auto split_node = node_ptr();
+        auto inserted = insert(m_root, m_height, key, value, split_key, split_node);
+        if (split_node)
+        {
+            auto root = new inner_node();
+            auto ptr = node_ptr(root);
+            root->push_first(std::move(m_root));
+            root->push_back(std::move(*split_key), std::move(split_node));
+            m_root = std::move(ptr);
+            ++m_height;
+        }
+
+        m_size += inserted ? 1 : 0;
+        return inserted;
+    }
+
+    /// <summary>
+    /// Removes the entry with the specified key from the current version of the map.
+    /// The nodes shared with other versions are copied, the rest are updated in place.
+    /// </summary>
+    /// <param name="key">
+    /// - The key of the entry
+    /// </param>
+    /// <returns>
+    /// Returns <see langword="true"/>, if the entry was removed,
+    /// otherwise the map has no such key.
+    /// </returns>
+    bool erase(const Key& key)
+    {
+        if (!m_root || !remove(m_root, m_height, key))
+        {
+            return false;
+        }
+
+        if (m_height > 0 && m_root->m_count == 1)
+        {
+            auto child = as_inner(m_root.get())->m_children[0];
+            m_root = std::move(child);
+            --m_height;
+        }
+        else if (m_height == 0 && m_root->m_count == 0)
+        {
+            m_root = node_ptr();
+        }
+
+        --m_size;
+        return true;
+    }
+
+    /// <summary>
+    /// Provides a new version of the map with the value mapped to the specified key.
+    /// The current version is not changed.
+    /// </summary>
+    inline persistent_ordered_map set(Key key, Value value) const
+    {
+        auto version = *this;
+        version.insert_or_assign(std::move(key), std::move(value));
+        return version;
+    }
+
+    /// <summary>
+    /// Provides a new version of the map without the specified key.
+    /// The current version is not changed.
+    /// </summary>
+    inline persistent_ordered_map without(const Key& key) const
+    {
+        auto version = *this;
+        version.erase(key);
+        return version;
+    }
+
+    /// <summary>
+    /// Provides a new version of the map changed by the specified batch of updates.
+    /// Every node shared with the current version is copied at most once
+    /// for the whole batch. The current version is not changed.
+    /// </summary>
+    /// <param name="updates">
+    /// - A callable object that accepts a reference to the new version and updates it
+    /// </param>
+    template<class Updates>
+    inline persistent_ordered_map transact(Updates&& updates) const
+    {
+        auto version = *this;
+        updates(version);
+        return version;
+    }
+
+private:
+    static inline leaf_node* as_leaf(node* ptr) noexcept
+    {
+        return static_cast<leaf_node*>(ptr);
+    }
+
+    static inline inner_node* as_inner(node* ptr) noexcept
+    {
+        return static_cast<inner_node*>(ptr);
+    }
+
+    /// <summary>
+    /// Returns the number of the keys less than the specified one.
+    /// The arithmetic keys are counted by a branchless loop, that the compiler vectorizes.
+    /// </summary>
+    static inline uint32_t lower_bound_index(const Key* keys, uint32_t count, const Key& key) noexcept
+    {
+        if constexpr (std::is_arithmetic_v<Key> && std::is_same_v<Compare, std::less<Key>>)
+        {
+            uint32_t index = 0;
+            for (uint32_t i = 0; i < count; ++i)
+            {
+                index += keys[i] < key ? 1 : 0;
+            }
+            return index;
+        }
+        else
+        {
+            return static_cast<uint32_t>(std::lower_bound(keys, keys + count, key, Compare { }) - keys);
+        }
+    }
+
+    /// <summary>
+    /// Returns the index of the child of the inner node, that may contain the key
+    /// </summary>
+    static inline uint32_t child_index(inner_node* inner, const Key& key) noexcept
+    {
+        auto keys = inner->keys();
+        auto count = inner->m_key_count;
+        if constexpr (std::is_arithmetic_v<Key> && std::is_same_v<Compare, std::less<Key>>)
+        {
+            uint32_t index = 0;
+            for (uint32_t i = 0; i < count; ++i)
+            {
+                index += keys[i] <= key ? 1 : 0;
+            }
+            return index;
+        }
+        else
+        {
+            return static_cast<uint32_t>(std::upper_bound(keys, keys + count, key, Compare { }) - keys);
+        }
+    }
+
+    static node_ptr clone(node* source, unsigned height)
+    {
+        if (height == 0)
+        {
+            auto from = as_leaf(source);
+            auto leaf = new leaf_node();
+            auto ptr = node_ptr(leaf);
+            for (uint32_t i = 0; i < from->m_count; ++i)
+            {
+                leaf->push_back(from->keys()[i], from->values()[i]);
+            }
+            return ptr;
+        }
+
+        auto from = as_inner(source);
+        auto inner = new inner_node();
+        auto ptr = node_ptr(inner);
+        inner->push_first(from->m_children[0]);
+        for (uint32_t i = 1; i < from->m_count; ++i)
+        {
+            inner->push_back(from->keys()[i - 1], from->m_children[i]);
+        }
+        return ptr;
+    }
+
+    /// <summary>
+    /// Makes the node referenced by the slot exclusively owned by the slot
+    /// </summary>
+    static node* make_editable(node_ptr& slot, unsigned height)
+    {
+        if (slot.use_count() != 1)
+        {
+            slot = clone(slot.get(), height);
+        }
+        return slot.get();
+    }
+
+    static bool insert(node_ptr& slot, unsigned height, Key& key, Value& value,
+        std::optional<Key>& split_key, node_ptr& split_node)
+    {
+        if (height == 0)
+        {
+            auto leaf = as_leaf(make_editable(slot, 0));
+            auto index = lower_bound_index(leaf->keys(), leaf->m_count, key);
+            if (index < leaf->m_count && !Compare { }(key, leaf->keys()[index]))
+            {
+                leaf->values()[index] = std::move(value);
+                return false;
+            }
+
+            if (leaf->m_count < capacity)
+            {
+                leaf->insert(index, std::move(key), std::move(value));
+                return true;
+            }
+
+            auto right = new leaf_node();
+            split_node = node_ptr(right);
+            for (auto i = min_count; i < capacity; ++i)
+            {
+                right->push_back(std::move(leaf->keys()[i]), std::move(leaf->values()[i]));
+            }
+            while (leaf->m_count > min_count)
+            {
+                leaf->pop_back();
+            }
+
+            index <= min_count
+                ? leaf->insert(index, std::move(key), std::move(value))
+                : right->insert(index - min_count, std::move(key), std::move(value));
+            split_key.emplace(right->keys()[0]);
+            return true;
+        }
+
+        auto inner = as_inner(make_editable(slot, height));
+        auto index = child_index(inner, key);
+        auto child_key = std::optional<Key>();
+        auto child_node = node_ptr();
+        auto inserted = insert(inner->m_children[index], height - 1, key, value, child_key, child_node);
+        if (!child_node)
+        {
+            return inserted;
+        }
+
+        if (inner->m_count < capacity)
+        {
+            inner->insert(index + 1, std::move(*child_key), std::move(child_node));
+            return inserted;
+        }
+
+        // The full node is split in halves, the separating key is moved to the parent
+        auto right = new inner_node();
+        split_node = node_ptr(right);
+        split_key.emplace(std::move(inner->keys()[min_count - 1]));
+        right->push_first(std::move(inner->m_children[min_count]));
+        for (auto i = min_count + 1; i < capacity; ++i)
+        {
+            right->push_back(std::move(inner->keys()[i - 1]), std::move(inner->m_children[i]));
+        }
+        while (inner->m_count > min_count)
+        {
+            std::destroy_at(inner->keys() + --inner->m_key_count);
+            --inner->m_count;
+        }
+
+        index + 1 <= min_count
+            ? inner->insert(index + 1, std::move(*child_key), std::move(child_node))
+            : right->insert(index + 1 - min_count, std::move(*child_key), std::move(child_node));
+        return inserted;
+    }
+
+    static bool remove(node_ptr& slot, unsigned height, const Key& key)
+    {
+        if (height == 0)
+        {
+            auto leaf = as_leaf(slot.get());
+            auto index = lower_bound_index(leaf->keys(), leaf->m_count, key);
+            if (index == leaf->m_count || Compare { }(key, leaf->keys()[index]))
+            {
+                return false;
+            }
+
+            as_leaf(make_editable(slot, 0))->erase(index);
+            return true;
+        }
+
+        auto index = child_index(as_inner(slot.get()), key);
+        if (!contains_key(as_inner(slot.get())->m_children[index].get(), height - 1, key))
+        {
+            return false;
+        }
+
+        auto inner = as_inner(make_editable(slot, height));
+        remove(inner->m_children[index], height - 1, key);
+        if (inner->m_children[index]->m_count < min_count)
+        {
+            rebalance(inner, index, height - 1);
+        }
+        return true;
+    }
+
+    static bool contains_key(node* current, unsigned height, const Key& key) noexcept
+    {
+        for (; height > 0; --height)
+        {
+            auto inner = as_inner(current);
+            current = inner->m_children[child_index(inner, key)].get();
+        }
+
+        auto leaf = as_leaf(current);
+        auto index = lower_bound_index(leaf->keys(), leaf->m_count, key);
+        return index < leaf->m_count && !Compare { }(key, leaf->keys()[index]);
+    }
+
+    /// <summary>
+    /// Restores the minimal number of entries in the child
+    /// by borrowing them from a sibling or by merging the child with a sibling
+    /// </summary>
+    static void rebalance(inner_node* parent, uint32_t index, unsigned height)
+    {
+        if (index > 0 && parent->m_children[index - 1]->m_count > min_count)
+        {
+            auto left = make_editable(parent->m_children[index - 1], height);
+            auto child = make_editable(parent->m_children[index], height);
+            if (height == 0)
+            {
+                auto from = as_leaf(left);
+                auto last = from->m_count - 1;
+                as_leaf(child)->insert(0, std::move(from->keys()[last]), std::move(from->values()[last]));
+                from->pop_back();
+                parent->keys()[index - 1] = as_leaf(child)->keys()[0];
+            }
+            else
+            {
+                auto from = as_inner(left);
+                auto to = as_inner(child);
+                auto separator = std::move(parent->keys()[index - 1]);
+                parent->keys()[index - 1] = std::move(from->keys()[from->m_key_count - 1]);
+                to->insert(1, std::move(separator), std::move(from->m_children[from->m_count - 1]));
+                std::swap(to->m_children[0], to->m_children[1]);
+                std::destroy_at(from->keys() + --from->m_key_count);
+                --from->m_count;
+            }
+            return;
+        }
+
+        if (index + 1 < parent->m_count && parent->m_children[index + 1]->m_count > min_count)
+        {
+            auto child = make_editable(parent->m_children[index], height);
+            auto right = make_editable(parent->m_children[index + 1], height);
+            if (height == 0)
+            {
+                auto from = as_leaf(right);
+                as_leaf(child)->push_back(std::move(from->keys()[0]), std::move(from->values()[0]));
+                from->erase(0);
+                parent->keys()[index] = from->keys()[0];
+            }
+            else
+            {
+                auto from = as_inner(right);
+                auto to = as_inner(child);
+                to->push_back(std::move(parent->keys()[index]), std::move(from->m_children[0]));
+                parent->keys()[index] = std::move(from->keys()[0]);
+                std::swap(from->m_children[0], from->m_children[1]);
+                from->erase(1);
+            }
+            return;
+        }
+
+        // Neither sibling can lend an entry, so the child is merged with one of them
+        auto left_index = index > 0 ? index - 1 : index;
+        auto left = make_editable(parent->m_children[left_index], height);
+        auto right = parent->m_children[left_index + 1].get();
+        auto unique = parent->m_children[left_index + 1].use_count() == 1;
+        if (height == 0)
+        {
+            auto to = as_leaf(left);
+            auto from = as_leaf(right);
+            for (uint32_t i = 0; i < from->m_count; ++i)
+            {
+                unique
+                    ? to->push_back(std::move(from->keys()[i]), std::move(from->values()[i]))
+                    : to->push_back(from->keys()[i], from->values()[i]);
+            }
+        }
+        else
+        {
+            auto to = as_inner(left);
+            auto from = as_inner(right);
+            to->push_back(parent->keys()[left_index], from->m_children[0]);
+            for (uint32_t i = 1; i < from->m_count; ++i)
+            {
+                to->push_back(from->keys()[i - 1], from->m_children[i]);
+            }
+        }
+        parent->erase(left_index + 1);
+    }
+
+private:
+    node_ptr m_root;
+    unsigned m_height { 0 };
+    size_t m_size { 0 };
+};
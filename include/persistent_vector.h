@@ -0,0 +1,944 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <algorithm>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <utility>
+#include "intrusive_ptr.h"
+
+/// <summary>
+/// A persistent (immutable) vector based on the relaxed radix balanced tree (RRB).
+/// The nodes of the tree are objects derived from <see cref="RefCountObject"/>,
+/// which are shared between versions of the vector through <see cref="intrusive_ptr"/>.
+/// A copy of the vector is a snapshot and takes O(1), the last leaf is kept out of the tree,
+/// so an append is amortized O(1), and the concatenation and the slicing take O(log n).
+/// The nodes that are referenced only by the current version are updated in place.
+/// </summary>
+/// <typeparam name="T">
+/// The type of the elements
+/// </typeparam>
+template<class T>
+class persistent_vector final
+{
+    static constexpr unsigned bits = 5;
+    static constexpr uint32_t branching = 1u << bits;
+
+    // The parameters of the concatenation, that bound the number of extra search steps
+    static constexpr uint32_t search_invariant = 1;
+    static constexpr uint32_t search_extras = 2;
+
+    class node : public RefCountObject<node>
+    {
+    public:
+        uint32_t m_count { 0 };
+
+    protected:
+        node() noexcept = default;
+    };
+
+    /// <summary>
+    /// A node of the lowest level containing up to 32 elements
+    /// </summary>
+    class leaf_node final : public node
+    {
+    public:
+        leaf_node() noexcept = default;
+
+        ~leaf_node() override
+        {
+            std::destroy_n(data(), this->m_count);
+        }
+
+        inline T* data() noexcept
+        {
+            return std::launder(reinterpret_cast<T*>(m_storage));
+        }
+
+        template<class... Args>
+        inline void emplace_back(Args&&... args)
+        {
+            new (data() + this->m_count) T(std::forward<Args>(args)...);
+            ++this->m_count;
+        }
+
+    private:
+        alignas(T) unsigned char m_storage[branching * sizeof(T)];
+    };
+
+    /// <summary>
+    /// A node of the upper levels containing up to 32 children.
+    /// The children of a relaxed node may be not full, so the node keeps
+    /// the cumulative sizes of its children to find the child containing an index.
+    /// </summary>
+    class inner_node final : public node
+    {
+    public:
+        inner_node() noexcept = default;
+
+        intrusive_ptr<node> m_children[branching];
+        size_t m_sizes[branching];
+        bool m_relaxed { false };
+    };
+
+    using node_ptr = intrusive_ptr<node>;
+
+public:
+    using value_type = T;
+    using size_type = size_t;
+
+    /// <summary>
+    /// A forward iterator over the elements of <see cref="persistent_vector"/>.
+    /// The iterator borrows the nodes of the vector and never changes their reference counts.
+    /// It is valid until the iterated version is changed or destroyed.
+    /// </summary>
+    class const_iterator final
+    {
+        friend class persistent_vector;
+
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = T;
+        using difference_type = ptrdiff_t;
+        using pointer = const T*;
+        using reference = const T&;
+
+        const_iterator() noexcept = default;
+
+        inline reference operator*() const noexcept
+        {
+            return m_chunk[m_index - m_chunk_begin];
+        }
+
+        inline pointer operator->() const noexcept
+        {
+            return &m_chunk[m_index - m_chunk_begin];
+        }
+
+        inline const_iterator& operator++() noexcept
+        {
+            if (++m_index == m_chunk_end && m_index < m_vector->m_size)
+            {
+                load_chunk();
+            }
+            return *this;
+        }
+
+        inline const_iterator operator++(int) noexcept
+        {
+            auto it = *this;
+            ++(*this);
+            return it;
+        }
+
+        inline bool operator==(const const_iterator& other) const noexcept
+        {
+            return m_index == other.m_index;
+        }
+
+        inline bool operator!=(const const_iterator& other) const noexcept
+        {
+            return m_index != other.m_index;
+        }
+
+    private:
+        inline const_iterator(const persistent_vector* vector, size_t index) noexcept
+            : m_vector(vector)
+            , m_index(index)
+        {
+            if (m_index < m_vector->m_size)
+            {
+                load_chunk();
+            }
+        }
+
+        inline void load_chunk() noexcept
+        {
+            auto offset = m_index;
+            auto leaf = m_vector->leaf_for(offset);
+            m_chunk = leaf->data();
+            m_chunk_begin = m_index - offset;
+            m_chunk_end = m_chunk_begin + leaf->m_count;
+        }
+
+    private:
+        const persistent_vector* m_vector { nullptr };
+        const T* m_chunk { nullptr };
+        size_t m_index { 0 };
+        size_t m_chunk_begin { 0 };
+        size_t m_chunk_end { 0 };
+    };
+
+    /// <summary>
+    /// Provides a new empty instance of <see cref="persistent_vector"/>
+    /// </summary>
+    persistent_vector() noexcept = default;
+
+    /// <summary>
+    /// Provides a snapshot of the specified vector in O(1).
+    /// The snapshot shares all the nodes with the specified vector.
+    /// </summary>
+    persistent_vector(const persistent_vector&) noexcept = default;
+    persistent_vector(persistent_vector&& other) noexcept
+        : m_root(std::move(other.m_root))
+        , m_tail(std::move(other.m_tail))
+        , m_shift(std::exchange(other.m_shift, 0))
+        , m_size(std::exchange(other.m_size, 0)) { }
+
+    persistent_vector& operator=(const persistent_vector&) noexcept = default;
+    persistent_vector& operator=(persistent_vector&& other) noexcept
+    {
+        m_root = std::move(other.m_root);
+        m_tail = std::move(other.m_tail);
+        m_shift = std::exchange(other.m_shift, 0);
+        m_size = std::exchange(other.m_size, 0);
+        return *this;
+    }
+
+    /// <summary>
+    /// Returns the current number of elements of the vector
+    /// </summary>
+    inline size_t size() const noexcept
+    {
+        return m_size;
+    }
+
+    /// <summary>
+    /// Checks whether the vector has no elements
+    /// </summary>
+    inline bool empty() const noexcept
+    {
+        return m_size == 0;
+    }
+
+    inline const_iterator begin() const noexcept { return const_iterator(this, 0); }
+    inline const_iterator end() const noexcept { return const_iterator(this, m_size); }
+
+    /// <summary>
+    /// Provides the element at the specified index, that must be less than the size
+    /// </summary>
+    inline const T& operator[](size_t index) const noexcept
+    {
+        auto leaf = leaf_for(index);
+        return leaf->data()[index];
+    }
+
+    /// <summary>
+    /// Provides the last element of the vector, that must not be empty
+    /// </summary>
+    inline const T& back() const noexcept
+    {
+        return as_leaf(m_tail.get())->data()[m_tail->m_count - 1];
+    }
+
+    /// <summary>
+    /// Appends the element to the current version of the vector.
+    /// The nodes shared with other versions are copied, the rest are updated in place.
+    /// </summary>
+    /// <param name="value">
+    /// - The value of the new element
+    /// </param>
+    inline void push_back(T value)
+    {
+        if (m_tail && m_tail->m_count == branching)
+        {
+            push_tail();
+        }
+
+        if (!m_tail)
+        {
+            m_tail = node_ptr(new leaf_node());
+        }
+
+        as_leaf(make_editable(m_tail, 0))->emplace_back(std::move(value));
+        ++m_size;
+    }
+
+    /// <summary>
+    /// Removes the last element from the current version of the vector, that must not be empty
+    /// </summary>
+    inline void pop_back()
+    {
+        if (m_tail->m_count == 1)
+        {
+            *this = take(m_size - 1);
+            return;
+        }
+
+        auto tail = as_leaf(make_editable(m_tail, 0));
+        std::destroy_at(tail->data() + --tail->m_count);
+        --m_size;
+    }
+
+    /// <summary>
+    /// Replaces the element at the specified index in the current version of the vector.
+    /// The nodes shared with other versions are copied, the rest are updated in place.
+    /// </summary>
+    /// <param name="index">
+    /// - The index of the element, that must be less than the size
+    /// </param>
+    /// <param name="value">
+    /// - The new value of the element
+    /// </param>
+    inline void assign(size_t index, T value)
+    {
+        auto tail_offset = m_size - m_tail->m_count;
+        if (index >= tail_offset)
+        {
+            as_leaf(make_editable(m_tail, 0))->data()[index - tail_offset] = std::move(value);
+            return;
+        }
+
+        auto slot = &m_root;
+        for (auto shift = m_shift; shift > 0; shift -= bits)
+        {
+            auto inner = as_inner(make_editable(*slot, shift));
+            slot = &inner->m_children[child_index(inner, shift, index)];
+        }
+        as_leaf(make_editable(*slot, 0))->data()[index] = std::move(value);
+    }
+
+    /// <summary>
+    /// Provides a new version of the vector with the element appended.
+    /// The current version is not changed.
+    /// </summary>
+    inline persistent_vector push(T value) const
+    {
+        auto version = *this;
+        version.push_back(std::move(value));
+        return version;
+    }
+
+    /// <summary>
+    /// Provides a new version of the vector with the element at the specified index replaced.
+    /// The current version is not changed.
+    /// </summary>
+    inline persistent_vector set(size_t index, T value) const
+    {
+        auto version = *this;
+        version.assign(index, std::move(value));
+        return version;
+    }
+
+    /// <summary>
+    /// Provides a new version of the vector containing the first elements of the current one
+    /// </summary>
+    /// <param name="count">
+    /// - The number of the elements to keep
+    /// </param>
+    persistent_vector take(size_t count) const
+    {
+        if (count >= m_size)
+        {
+            return *this;
+        }
+
+        auto result = persistent_vector();
+        if (count == 0)
+        {
+            return result;
+        }
+
+        result.m_size = count;
+        auto tail_offset = m_size - m_tail->m_count;
+        if (count > tail_offset)
+        {
+            result.m_root = m_root;
+            result.m_shift = m_shift;
+            result.m_tail = copy_leaf(as_leaf(m_tail.get()), 0, uint32_t(count - tail_offset));
+            return result;
+        }
+
+        // The leaf containing the last kept element becomes the tail
+        auto offset = count - 1;
+        auto leaf = leaf_for(offset);
+        auto leaf_begin = count - 1 - offset;
+        result.m_tail = offset + 1 == leaf->m_count
+            ? node_ptr(leaf)
+            : copy_leaf(leaf, 0, uint32_t(offset + 1));
+
+        if (leaf_begin > 0)
+        {
+            result.m_root = take_tree(m_root.get(), m_shift, leaf_begin);
+            result.m_shift = m_shift;
+            result.collapse_root();
+        }
+        return result;
+    }
+
+    /// <summary>
+    /// Provides a new version of the vector without the first elements of the current one
+    /// </summary>
+    /// <param name="count">
+    /// - The number of the elements to skip
+    /// </param>
+    persistent_vector drop(size_t count) const
+    {
+        if (count == 0)
+        {
+            return *this;
+        }
+
+        auto result = persistent_vector();
+        if (count >= m_size)
+        {
+            return result;
+        }
+
+        result.m_size = m_size - count;
+        auto tail_offset = m_size - m_tail->m_count;
+        if (count >= tail_offset)
+        {
+            result.m_tail = copy_leaf(as_leaf(m_tail.get()),
+                uint32_t(count - tail_offset), m_tail->m_count);
+            return result;
+        }
+
+        result.m_tail = m_tail;
+        result.m_root = drop_tree(m_root.get(), m_shift, count);
+        result.m_shift = m_shift;
+        result.collapse_root();
+        return result;
+    }
+
+    /// <summary>
+    /// Provides a new version of the vector containing the specified range of the current one
+    /// </summary>
+    /// <param name="first">
+    /// - The index of the first element of the range
+    /// </param>
+    /// <param name="last">
+    /// - The index following the last element of the range
+    /// </param>
+    inline persistent_vector slice(size_t first, size_t last) const
+    {
+        return take(last).drop(first);
+    }
+
+    /// <summary>
+    /// Provides a new version of the vector containing the elements of the current one
+    /// followed by the elements of the specified one. Both versions are not changed
+    /// and share their nodes with the result.
+    /// </summary>
+    /// <param name="other">
+    /// - A reference to another vector
+    /// </param>
+    persistent_vector concat(const persistent_vector& other) const
+    {
+        if (other.empty())
+        {
+            return *this;
+        }
+
+        if (empty())
+        {
+            return other;
+        }
+
+        auto result = *this;
+        if (!other.m_root)
+        {
+            auto tail = as_leaf(other.m_tail.get());
+            for (uint32_t i = 0; i < tail->m_count; ++i)
+            {
+                result.push_back(tail->data()[i]);
+            }
+            return result;
+        }
+
+        result.push_tail();
+
+        auto shift = std::max(result.m_shift, other.m_shift);
+        auto merged = concat_trees(result.m_root.get(), result.m_shift,
+            other.m_root.get(), other.m_shift);
+
+        if (merged->m_count == 1)
+        {
+            result.m_root = as_inner(merged.get())->m_children[0];
+            result.m_shift = shift;
+        }
+        else
+        {
+            result.m_root = std::move(merged);
+            result.m_shift = shift + bits;
+        }
+
+        result.m_tail = other.m_tail;
+        result.m_size += other.m_size;
+        return result;
+    }
+
+private:
+    static inline leaf_node* as_leaf(node* ptr) noexcept
+    {
+        return static_cast<leaf_node*>(ptr);
+    }
+
+    static inline inner_node* as_inner(node* ptr) noexcept
+    {
+        return static_cast<inner_node*>(ptr);
+    }
+
+    static node_ptr copy_leaf(leaf_node* source, uint32_t first, uint32_t last)
+    {
+        auto leaf = new leaf_node();
+        auto ptr = node_ptr(leaf);
+        for (auto i = first; i < last; ++i)
+        {
+            leaf->emplace_back(source->data()[i]);
+        }
+        return ptr;
+    }
+
+    static node_ptr copy_inner(inner_node* source)
+    {
+        auto inner = new inner_node();
+        auto ptr = node_ptr(inner);
+        std::copy_n(source->m_children, source->m_count, inner->m_children);
+        std::copy_n(source->m_sizes, source->m_count, inner->m_sizes);
+        inner->m_relaxed = source->m_relaxed;
+        inner->m_count = source->m_count;
+        return ptr;
+    }
+
+    /// <summary>
+    /// Makes the node referenced by the slot exclusively owned by the slot
+    /// </summary>
+    static node* make_editable(node_ptr& slot, unsigned shift)
+    {
+        if (slot.use_count() != 1)
+        {
+            slot = shift == 0
+                ? copy_leaf(as_leaf(slot.get()), 0, slot->m_count)
+                : copy_inner(as_inner(slot.get()));
+        }
+        return slot.get();
+    }
+
+    /// <summary>
+    /// Returns the number of elements in the subtree of the node of the specified level
+    /// </summary>
+    static size_t subtree_size(node* current, unsigned shift) noexcept
+    {
+        size_t size = 0;
+        for (; shift > 0; shift -= bits)
+        {
+            auto inner = as_inner(current);
+            if (inner->m_relaxed)
+            {
+                return size + inner->m_sizes[inner->m_count - 1];
+            }
+
+            size += size_t(inner->m_count - 1) << shift;
+            current = inner->m_children[inner->m_count - 1].get();
+        }
+        return size + current->m_count;
+    }
+
+    /// <summary>
+    /// Computes the cumulative sizes of the children and
+    /// marks the node as relaxed, if any child except the last one is not full
+    /// </summary>
+    static void update_sizes(inner_node* inner, unsigned shift) noexcept
+    {
+        size_t total = 0;
+        inner->m_relaxed = false;
+        for (uint32_t i = 0; i < inner->m_count; ++i)
+        {
+            auto size = subtree_size(inner->m_children[i].get(), shift - bits);
+            total += size;
+            inner->m_sizes[i] = total;
+            inner->m_relaxed |= i + 1 < inner->m_count && size != (size_t(1) << shift);
+        }
+    }
+
+    /// <summary>
+    /// Finds the child of the node containing the index
+    /// and makes the index relative to the child
+    /// </summary>
+    static inline uint32_t child_index(inner_node* inner, unsigned shift, size_t& index) noexcept
+    {
+        auto i = static_cast<uint32_t>(index >> shift);
+        if (!inner->m_relaxed)
+        {
+            index -= size_t(i) << shift;
+            return i;
+        }
+
+        while (inner->m_sizes[i] <= index)
+        {
+            ++i;
+        }
+
+        index -= i > 0 ? inner->m_sizes[i - 1] : 0;
+        return i;
+    }
+
+    /// <summary>
+    /// Finds the leaf containing the index and makes the index relative to the leaf
+    /// </summary>
+    inline leaf_node* leaf_for(size_t& index) const noexcept
+    {
+        auto tail_offset = m_size - m_tail->m_count;
+        if (index >= tail_offset)
+        {
+            index -= tail_offset;
+            return as_leaf(m_tail.get());
+        }
+
+        auto current = m_root.get();
+        for (auto shift = m_shift; shift > 0; shift -= bits)
+        {
+            auto inner = as_inner(current);
+            current = inner->m_children[child_index(inner, shift, index)].get();
+        }
+        return as_leaf(current);
+    }
+
+    static node_ptr new_path(unsigned shift, node_ptr leaf)
+    {
+        for (; shift > 0; shift -= bits)
+        {
+            auto inner = new inner_node();
+            auto ptr = node_ptr(inner);
+            inner->m_children[0] = std::move(leaf);
+            inner->m_count = 1;
+            leaf = std::move(ptr);
+        }
+        return leaf;
+    }
+
+    static node_ptr new_parent(node_ptr first, node_ptr second, unsigned shift)
+    {
+        auto inner = new inner_node();
+        auto ptr = node_ptr(inner);
+        inner->m_children[0] = std::move(first);
+        inner->m_children[1] = std::move(second);
+        inner->m_count = 2;
+        update_sizes(inner, shift);
+        return ptr;
+    }
+
+    static bool has_room(node* current, unsigned shift) noexcept
+    {
+        for (; shift > bits; shift -= bits)
+        {
+            if (current->m_count < branching)
+            {
+                return true;
+            }
+            current = as_inner(current)->m_children[current->m_count - 1].get();
+        }
+        return current->m_count < branching;
+    }
+
+    static void push_leaf(node_ptr& slot, unsigned shift, node_ptr leaf, size_t leaf_size)
+    {
+        auto inner = as_inner(make_editable(slot, shift));
+        auto last = inner->m_count - 1;
+
+        if (shift > bits && has_room(inner->m_children[last].get(), shift - bits))
+        {
+            push_leaf(inner->m_children[last], shift - bits, std::move(leaf), leaf_size);
+            inner->m_sizes[last] += inner->m_relaxed ? leaf_size : 0;
+            return;
+        }
+
+        inner->m_children[inner->m_count++] = new_path(shift - bits, std::move(leaf));
+        if (inner->m_relaxed)
+        {
+            inner->m_sizes[last + 1] = inner->m_sizes[last] + leaf_size;
+        }
+        else if (subtree_size(inner->m_children[last].get(), shift - bits) != (size_t(1) << shift))
+        {
+            update_sizes(inner, shift);
+        }
+    }
+
+    /// <summary>
+    /// Moves the tail leaf into the tree
+    /// </summary>
+    inline void push_tail()
+    {
+        auto leaf_size = size_t(m_tail->m_count);
+        if (!m_root)
+        {
+            m_root = std::move(m_tail);
+            m_shift = 0;
+        }
+        else if (m_shift > 0 && has_room(m_root.get(), m_shift))
+        {
+            push_leaf(m_root, m_shift, std::move(m_tail), leaf_size);
+        }
+        else
+        {
+            m_root = new_parent(std::move(m_root), new_path(m_shift, std::move(m_tail)), m_shift + bits);
+            m_shift += bits;
+        }
+    }
+
+    /// <summary>
+    /// Removes the upper levels of the tree having a single child
+    /// </summary>
+    inline void collapse_root()
+    {
+        while (m_shift > 0 && m_root->m_count == 1)
+        {
+            auto child = as_inner(m_root.get())->m_children[0];
+            m_root = std::move(child);
+            m_shift -= bits;
+        }
+    }
+
+    static node_ptr take_tree(node* current, unsigned shift, size_t count)
+    {
+        if (shift == 0)
+        {
+            return count == current->m_count
+                ? node_ptr(current)
+                : copy_leaf(as_leaf(current), 0, uint32_t(count));
+        }
+
+        auto source = as_inner(current);
+        auto offset = count - 1;
+        auto index = child_index(source, shift, offset);
+
+        auto inner = new inner_node();
+        auto ptr = node_ptr(inner);
+        std::copy_n(source->m_children, index, inner->m_children);
+        std::copy_n(source->m_sizes, index, inner->m_sizes);
+        inner->m_children[index] = take_tree(source->m_children[index].get(), shift - bits, offset + 1);
+        inner->m_sizes[index] = count;
+        inner->m_relaxed = source->m_relaxed;
+        inner->m_count = index + 1;
+        return ptr;
+    }
+
+    static node_ptr drop_tree(node* current, unsigned shift, size_t count)
+    {
+        if (count == 0)
+        {
+            return node_ptr(current);
+        }
+
+        if (shift == 0)
+        {
+            return copy_leaf(as_leaf(current), uint32_t(count), current->m_count);
+        }
+
+        auto source = as_inner(current);
+        auto offset = count;
+        auto index = child_index(source, shift, offset);
+
+        auto inner = new inner_node();
+        auto ptr = node_ptr(inner);
+        inner->m_children[0] = drop_tree(source->m_children[index].get(), shift - bits, offset);
+        for (auto i = index + 1; i < source->m_count; ++i)
+        {
+            inner->m_children[i - index] = source->m_children[i];
+        }
+
+        auto last = source->m_count - 1;
+        for (auto i = index; i < source->m_count; ++i)
+        {
+            auto cumulative = source->m_relaxed ? source->m_sizes[i]
+                : i < last ? size_t(i + 1) << shift
+                : subtree_size(current, shift);
+            inner->m_sizes[i - index] = cumulative - count;
+        }
+        inner->m_relaxed = true;
+        inner->m_count = source->m_count - index;
+        return ptr;
+    }
+
+    /// <summary>
+    /// Concatenates the trees, returns a node of the level above the highest tree
+    /// containing one or two children
+    /// </summary>
+    static node_ptr concat_trees(node* left, unsigned left_shift, node* right, unsigned right_shift)
+    {
+        if (left_shift > right_shift)
+        {
+            auto inner = as_inner(left);
+            auto middle = concat_trees(inner->m_children[inner->m_count - 1].get(),
+                left_shift - bits, right, right_shift);
+            return rebalance(inner, as_inner(middle.get()), nullptr, left_shift);
+        }
+
+        if (left_shift < right_shift)
+        {
+            auto inner = as_inner(right);
+            auto middle = concat_trees(left, left_shift, inner->m_children[0].get(),
+                right_shift - bits);
+            return rebalance(nullptr, as_inner(middle.get()), inner, right_shift);
+        }
+
+        if (left_shift == 0)
+        {
+            if (left->m_count + right->m_count > branching)
+            {
+                return new_parent(node_ptr(left), node_ptr(right), bits);
+            }
+
+            auto leaf = copy_leaf(as_leaf(left), 0, left->m_count);
+            for (uint32_t i = 0; i < right->m_count; ++i)
+            {
+                as_leaf(leaf.get())->emplace_back(as_leaf(right)->data()[i]);
+            }
+            return new_path(bits, std::move(leaf));
+        }
+
+        auto left_inner = as_inner(left);
+        auto right_inner = as_inner(right);
+        auto middle = concat_trees(left_inner->m_children[left_inner->m_count - 1].get(),
+            left_shift - bits, right_inner->m_children[0].get(), right_shift - bits);
+        return rebalance(left_inner, as_inner(middle.get()), right_inner, left_shift);
+    }
+
+    /// <summary>
+    /// Merges the children of the left node except the last one, the children of the middle node
+    /// and the children of the right node except the first one. The children are redistributed,
+    /// so the number of them exceeds the optimal one at most by the allowed extra search steps.
+    /// </summary>
+    static node_ptr rebalance(inner_node* left, inner_node* middle, inner_node* right, unsigned shift)
+    {
+        node* all[2 * branching];
+        uint32_t plan[2 * branching + 1] = { };
+        uint32_t count = 0;
+
+        for (uint32_t i = 0; left != nullptr && i + 1 < left->m_count; ++i)
+        {
+            all[count++] = left->m_children[i].get();
+        }
+
+        for (uint32_t i = 0; i < middle->m_count; ++i)
+        {
+            all[count++] = middle->m_children[i].get();
+        }
+
+        for (uint32_t i = 1; right != nullptr && i < right->m_count; ++i)
+        {
+            all[count++] = right->m_children[i].get();
+        }
+
+        size_t total = 0;
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            plan[i] = all[i]->m_count;
+            total += plan[i];
+        }
+
+        auto optimal = static_cast<uint32_t>((total + branching - 1) / branching);
+        auto planned = count;
+        uint32_t i = 0;
+        while (optimal + search_extras < planned)
+        {
+            while (plan[i] > branching - search_invariant)
+            {
+                ++i;
+            }
+
+            auto remaining = plan[i];
+            do
+            {
+                auto size = std::min(remaining + plan[i + 1], branching);
+                plan[i] = size;
+                remaining = remaining + plan[i + 1] - size;
+                ++i;
+            }
+            while (remaining > 0);
+
+            for (auto j = i; j + 1 < planned; ++j)
+            {
+                plan[j] = plan[j + 1];
+            }
+            --planned;
+            --i;
+        }
+
+        auto child_shift = shift - bits;
+        auto first = new inner_node();
+        auto first_ptr = node_ptr(first);
+        auto second = static_cast<inner_node*>(nullptr);
+        auto second_ptr = node_ptr();
+        if (planned > branching)
+        {
+            second = new inner_node();
+            second_ptr = node_ptr(second);
+        }
+
+        uint32_t source = 0;
+        uint32_t source_offset = 0;
+        for (uint32_t target = 0; target < planned; ++target)
+        {
+            auto parent = target < branching ? first : second;
+            auto& slot = parent->m_children[parent->m_count++];
+
+            if (source_offset == 0 && all[source]->m_count == plan[target])
+            {
+                slot = node_ptr(all[source++]);
+                continue;
+            }
+
+            if (child_shift == 0)
+            {
+                auto leaf = new leaf_node();
+                slot = node_ptr(leaf);
+                while (leaf->m_count < plan[target])
+                {
+                    auto from = as_leaf(all[source]);
+                    auto take = std::min(plan[target] - leaf->m_count, from->m_count - source_offset);
+                    for (auto k = source_offset; k < source_offset + take; ++k)
+                    {
+                        leaf->emplace_back(from->data()[k]);
+                    }
+
+                    source_offset += take;
+                    if (source_offset == from->m_count)
+                    {
+                        ++source;
+                        source_offset = 0;
+                    }
+                }
+            }
+            else
+            {
+                auto inner = new inner_node();
+                slot = node_ptr(inner);
+                while (inner->m_count < plan[target])
+                {
+                    auto from = as_inner(all[source]);
+                    auto take = std::min(plan[target] - inner->m_count, from->m_count - source_offset);
+                    for (auto k = source_offset; k < source_offset + take; ++k)
+                    {
+                        inner->m_children[inner->m_count++] = from->m_children[k];
+                    }
+
+                    source_offset += take;
+                    if (source_offset == from->m_count)
+                    {
+                        ++source;
+                        source_offset = 0;
+                    }
+                }
+                update_sizes(inner, child_shift);
+            }
+        }
+
+        update_sizes(first, shift);
+        if (second == nullptr)
+        {
+            return new_path(bits, std::move(first_ptr));
+        }
+
+        update_sizes(second, shift);
+        return new_parent(std::move(first_ptr), std::move(second_ptr), shift + bits);
+    }
+
+private:
+    node_ptr m_root;
+    node_ptr m_tail;
+    unsigned m_shift { 0 };
+    size_t m_size { 0 };
+};
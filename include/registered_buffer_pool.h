@@ -0,0 +1,709 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <span>
+#include <stdexcept>
+#include <system_error>
+#include <vector>
+#if defined(__linux__)
+#include <errno.h>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
+#include "intrusive_ptr.h"
+
+class registered_buffer;
+
+/// <summary>
+/// An owner of buffers, that takes a buffer back, when its last reference is released
+/// </summary>
+class buffer_recycler
+{
+    friend class registered_buffer;
+
+protected:
+    virtual ~buffer_recycler() = default;
+
+    /// <summary>
+    /// Takes the buffer back. It may be called on any thread.
+    /// </summary>
+    virtual void recycle(registered_buffer& buffer) noexcept = 0;
+};
+
+/// <summary>
+/// A fixed buffer, that is pinned for the asynchronous I/O and shared through <see cref="intrusive_ptr"/>.
+/// A submitted operation carries a reference in its user data, and the completion adopts it,
+/// so the buffer cannot be reused before the kernel has finished with it.
+/// With the last reference the buffer returns to its owner instead of being destroyed.
+/// </summary>
+class registered_buffer final : public RefCountObject<registered_buffer>
+{
+    friend class buffer_block;
+
+public:
+    /// <summary>
+    /// Returns the buffer to its owner, when <see cref="RefCountObject"/> deletes it with the last reference
+    /// </summary>
+    static inline void operator delete(registered_buffer* buffer, std::destroying_delete_t) noexcept
+    {
+        buffer->m_size = 0;
+        buffer->m_owner->recycle(*buffer);
+    }
+
+    ~registered_buffer() override = default;
+
+    inline std::byte* data() noexcept
+    {
+        return m_data;
+    }
+
+    inline size_t capacity() const noexcept
+    {
+        return m_capacity;
+    }
+
+    /// <summary>
+    /// Returns the index of the registered buffer or the identifier of the provided buffer
+    /// </summary>
+    inline uint16_t index() const noexcept
+    {
+        return m_index;
+    }
+
+    /// <summary>
+    /// Returns the number of the valid bytes, that is set by the completion
+    /// </summary>
+    inline size_t size() const noexcept
+    {
+        return m_size;
+    }
+
+    inline void resize(size_t size) noexcept
+    {
+        m_size = size;
+    }
+
+    inline std::span<std::byte> span() noexcept
+    {
+        return std::span<std::byte>(m_data, m_size);
+    }
+
+private:
+    registered_buffer(buffer_recycler& owner, std::byte* data, size_t capacity, uint16_t index) noexcept
+        : m_owner(&owner)
+        , m_data(data)
+        , m_capacity(capacity)
+        , m_index(index) { }
+
+private:
+    buffer_recycler* m_owner;
+    std::byte* const m_data;
+    const size_t m_capacity;
+    size_t m_size { 0 };
+    const uint16_t m_index;
+};
+
+/// <summary>
+/// Moves the reference into the user data of a submitted operation
+/// </summary>
+inline uint64_t to_user_data(intrusive_ptr<registered_buffer> buffer) noexcept
+{
+    return reinterpret_cast<uintptr_t>(buffer.detach());
+}
+
+/// <summary>
+/// Adopts the reference carried by the user data of a completed operation
+/// </summary>
+inline intrusive_ptr<registered_buffer> from_user_data(uint64_t user_data) noexcept
+{
+    return intrusive_ptr<registered_buffer>(reinterpret_cast<registered_buffer*>(static_cast<uintptr_t>(user_data)), false);
+}
+
+/// <summary>
+/// A contiguous page-aligned block of equally sized buffers and their headers, that are allocated once
+/// </summary>
+class buffer_block
+{
+    static constexpr size_t alignment = 4096;
+
+    struct aligned_delete
+    {
+        inline void operator()(std::byte* memory) const noexcept
+        {
+            ::operator delete(memory, std::align_val_t(alignment));
+        }
+    };
+
+public:
+    // The buffers are identified by 16-bit indices. The kernel registers at most 16384 fixed buffers per ring.
+    static constexpr size_t max_count = 65536;
+
+protected:
+    /// <summary>
+    /// Allocates the buffers. Throws <see cref="std::invalid_argument"/>, if the count exceeds <see cref="max_count"/>
+    /// or the total size of the buffers overflows.
+    /// </summary>
+    buffer_block(buffer_recycler& owner, size_t count, size_t buffer_size)
+        : m_count(validate(count))
+        , m_buffer_size(buffer_size)
+        , m_memory(allocate(count, buffer_size))
+        , m_buffers(static_cast<registered_buffer*>(::operator new(count * sizeof(registered_buffer))))
+    {
+        for (size_t i = 0; i < count; ++i)
+        {
+            new (m_buffers + i) registered_buffer(owner, m_memory.get() + i * buffer_size, buffer_size, static_cast<uint16_t>(i));
+        }
+    }
+
+    buffer_block(const buffer_block&) = delete;
+    buffer_block& operator=(const buffer_block&) = delete;
+
+    ~buffer_block()
+    {
+        for (size_t i = 0; i < m_count; ++i)
+        {
+            m_buffers[i].~registered_buffer();
+        }
+        ::operator delete(m_buffers);
+    }
+
+public:
+    inline size_t count() const noexcept
+    {
+        return m_count;
+    }
+
+    inline size_t buffer_size() const noexcept
+    {
+        return m_buffer_size;
+    }
+
+    /// <summary>
+    /// Returns the buffer with the index without taking a reference
+    /// </summary>
+    inline registered_buffer& buffer(size_t index) noexcept
+    {
+        return m_buffers[index];
+    }
+
+private:
+    static inline size_t validate(size_t count)
+    {
+        if (count > max_count)
+        {
+            throw std::invalid_argument("The number of the buffers exceeds the 16-bit indices");
+        }
+        return count;
+    }
+
+    /// <summary>
+    /// Allocates the memory of the buffers, that is released by the owner,
+    /// even if the construction of the block fails later
+    /// </summary>
+    static inline std::unique_ptr<std::byte, aligned_delete> allocate(size_t count, size_t buffer_size)
+    {
+        if (buffer_size != 0 && count > SIZE_MAX / buffer_size)
+        {
+            throw std::invalid_argument("The total size of the buffers overflows");
+        }
+        return std::unique_ptr<std::byte, aligned_delete>(
+            static_cast<std::byte*>(::operator new(count * buffer_size, std::align_val_t(alignment))));
+    }
+
+protected:
+    const size_t m_count;
+    const size_t m_buffer_size;
+    const std::unique_ptr<std::byte, aligned_delete> m_memory;
+    registered_buffer* const m_buffers;
+};
+
+/// <summary>
+/// A pool of fixed buffers for the operations reading into or writing from the registered buffers.
+/// An acquired buffer returns to the pool, when the caller and all submitted operations have released it.
+/// The pool must outlive its buffers.
+/// </summary>
+class registered_buffer_pool final : private buffer_recycler, public buffer_block
+{
+public:
+    /// <summary>
+    /// Allocates the buffers. The pool holds at most <see cref="max_count"/> buffers,
+    /// while registering more than 16384 of them with a ring fails.
+    /// </summary>
+    registered_buffer_pool(size_t count, size_t buffer_size)
+        : buffer_block(*this, count, buffer_size)
+    {
+        m_free.reserve(count);
+        for (size_t i = count; i != 0; --i)
+        {
+            m_free.push_back(static_cast<uint16_t>(i - 1));
+        }
+    }
+
+    /// <summary>
+    /// Provides a free buffer
+    /// </summary>
+    /// <returns>
+    /// The only reference to the buffer, or null, if all buffers are in use
+    /// </returns>
+    inline intrusive_ptr<registered_buffer> try_acquire()
+    {
+        auto lock = std::lock_guard(m_mutex);
+        if (m_free.empty())
+        {
+            return intrusive_ptr<registered_buffer>();
+        }
+        auto index = m_free.back();
+        m_free.pop_back();
+        return intrusive_ptr<registered_buffer>(&buffer(index));
+    }
+
+    /// <summary>
+    /// Returns the number of the free buffers
+    /// </summary>
+    inline size_t available() const
+    {
+        auto lock = std::lock_guard(m_mutex);
+        return m_free.size();
+    }
+
+private:
+    void recycle(registered_buffer& buffer) noexcept override
+    {
+        auto lock = std::lock_guard(m_mutex);
+        m_free.push_back(buffer.index());
+    }
+
+private:
+    mutable std::mutex m_mutex;
+    std::vector<uint16_t> m_free;
+};
+
+#if defined(__linux__)
+
+/// <summary>
+/// A minimal io_uring instance: the submission and the completion queues mapped from the kernel
+/// and the preparation of the operations, that pass the references of the buffers through the user data
+/// </summary>
+class io_ring final
+{
+public:
+    explicit io_ring(unsigned entries = 256)
+    {
+        auto params = io_uring_params();
+        std::memset(&params, 0, sizeof(params));
+        m_fd = static_cast<int>(::syscall(__NR_io_uring_setup, entries, &params));
+        if (m_fd < 0)
+        {
+            throw std::system_error(errno, std::system_category(), "io_uring_setup");
+        }
+
+        m_sq_size = params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+        m_cq_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        m_single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+        if (m_single_mmap)
+        {
+            m_sq_size = m_cq_size = std::max(m_sq_size, m_cq_size);
+        }
+
+        m_sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+        try
+        {
+            m_sq = map(m_sq_size, IORING_OFF_SQ_RING);
+            m_cq = m_single_mmap ? m_sq : map(m_cq_size, IORING_OFF_CQ_RING);
+            m_sqes = static_cast<io_uring_sqe*>(map(m_sqes_size, IORING_OFF_SQES));
+        }
+        catch (...)
+        {
+            unmap();
+            throw;
+        }
+
+        m_sq_head = offset<uint32_t>(m_sq, params.sq_off.head);
+        m_sq_tail = offset<uint32_t>(m_sq, params.sq_off.tail);
+        m_sq_mask = *offset<uint32_t>(m_sq, params.sq_off.ring_mask);
+        m_sq_entries = *offset<uint32_t>(m_sq, params.sq_off.ring_entries);
+        m_sq_array = offset<uint32_t>(m_sq, params.sq_off.array);
+        m_cq_head = offset<uint32_t>(m_cq, params.cq_off.head);
+        m_cq_tail = offset<uint32_t>(m_cq, params.cq_off.tail);
+        m_cq_mask = *offset<uint32_t>(m_cq, params.cq_off.ring_mask);
+        m_cqes = offset<io_uring_cqe>(m_cq, params.cq_off.cqes);
+        m_tail = *m_sq_tail;
+        m_submitted = m_tail;
+    }
+
+    io_ring(const io_ring&) = delete;
+    io_ring& operator=(const io_ring&) = delete;
+
+    ~io_ring()
+    {
+        unmap();
+    }
+
+    inline int fd() const noexcept
+    {
+        return m_fd;
+    }
+
+    /// <summary>
+    /// Registers the buffers of the pool as the fixed buffers of the ring
+    /// </summary>
+    inline void register_buffers(registered_buffer_pool& pool)
+    {
+        auto vectors = std::vector<iovec>(pool.count());
+        for (size_t i = 0; i < vectors.size(); ++i)
+        {
+            vectors[i] = iovec { pool.buffer(i).data(), pool.buffer(i).capacity() };
+        }
+        enroll(IORING_REGISTER_BUFFERS, vectors.data(), static_cast<unsigned>(vectors.size()), "IORING_REGISTER_BUFFERS");
+    }
+
+    inline void unregister_buffers()
+    {
+        enroll(IORING_UNREGISTER_BUFFERS, nullptr, 0, "IORING_UNREGISTER_BUFFERS");
+    }
+
+    /// <summary>
+    /// Calls io_uring_register for the ring. Throws <see cref="std::system_error"/> on failure.
+    /// </summary>
+    inline void enroll(unsigned opcode, const void* argument, unsigned count, const char* operation)
+    {
+        if (::syscall(__NR_io_uring_register, m_fd, opcode, argument, count) < 0)
+        {
+            throw std::system_error(errno, std::system_category(), operation);
+        }
+    }
+
+    /// <summary>
+    /// Provides a cleared submission entry
+    /// </summary>
+    /// <returns>
+    /// The entry, or null, if the submission queue is full
+    /// </returns>
+    inline io_uring_sqe* get_sqe() noexcept
+    {
+        auto head = std::atomic_ref<uint32_t>(*m_sq_head).load(std::memory_order_acquire);
+        if (m_tail - head >= m_sq_entries)
+        {
+            return nullptr;
+        }
+        auto index = m_tail & m_sq_mask;
+        auto sqe = &m_sqes[index];
+        std::memset(sqe, 0, sizeof(*sqe));
+        m_sq_array[index] = index;
+        ++m_tail;
+        return sqe;
+    }
+
+    /// <summary>
+    /// Prepares reading into the registered buffer, that is kept alive until the completion
+    /// adopts the reference by <see cref="from_user_data"/>
+    /// </summary>
+    inline bool prepare_read_fixed(int fd, intrusive_ptr<registered_buffer> buffer, size_t count, uint64_t offset)
+    {
+        return prepare_fixed(IORING_OP_READ_FIXED, fd, std::move(buffer), count, offset);
+    }
+
+    /// <summary>
+    /// Prepares writing the valid bytes of the registered buffer, that is kept alive until the completion
+    /// </summary>
+    inline bool prepare_write_fixed(int fd, intrusive_ptr<registered_buffer> buffer, uint64_t offset)
+    {
+        auto size = buffer->size();
+        return prepare_fixed(IORING_OP_WRITE_FIXED, fd, std::move(buffer), size, offset);
+    }
+
+    /// <summary>
+    /// Prepares a receive, that completes for each message with a buffer selected from the group
+    /// </summary>
+    inline bool prepare_recv_multishot(int fd, uint16_t group, uint64_t user_data) noexcept
+    {
+        auto sqe = get_sqe();
+        if (sqe == nullptr)
+        {
+            return false;
+        }
+        sqe->opcode = IORING_OP_RECV;
+        sqe->fd = fd;
+        sqe->ioprio = IORING_RECV_MULTISHOT;
+        sqe->flags = IOSQE_BUFFER_SELECT;
+        sqe->buf_group = group;
+        sqe->user_data = user_data;
+        return true;
+    }
+
+    /// <summary>
+    /// Submits the prepared entries and waits for the completions
+    /// </summary>
+    /// <returns>
+    /// The number of the submitted entries
+    /// </returns>
+    inline unsigned submit(unsigned wait_count = 0)
+    {
+        std::atomic_ref<uint32_t>(*m_sq_tail).store(m_tail, std::memory_order_release);
+        auto pending = m_tail - m_submitted;
+        auto flags = wait_count != 0 ? IORING_ENTER_GETEVENTS : 0u;
+        auto submitted = ::syscall(__NR_io_uring_enter, m_fd, pending, wait_count, flags, nullptr, 0);
+        if (submitted < 0)
+        {
+            throw std::system_error(errno, std::system_category(), "io_uring_enter");
+        }
+        m_submitted += static_cast<uint32_t>(submitted);
+        return static_cast<unsigned>(submitted);
+    }
+
+    /// <summary>
+    /// Takes the next completion without waiting
+    /// </summary>
+    inline bool peek(io_uring_cqe& completion) noexcept
+    {
+        auto head = *m_cq_head;
+        if (head == std::atomic_ref<uint32_t>(*m_cq_tail).load(std::memory_order_acquire))
+        {
+            return false;
+        }
+        completion = m_cqes[head & m_cq_mask];
+        std::atomic_ref<uint32_t>(*m_cq_head).store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    /// <summary>
+    /// Takes the next completion, waiting for it, if necessary
+    /// </summary>
+    inline void wait(io_uring_cqe& completion)
+    {
+        while (!peek(completion))
+        {
+            submit(1);
+        }
+    }
+
+private:
+    inline bool prepare_fixed(uint8_t opcode, int fd, intrusive_ptr<registered_buffer> buffer, size_t count, uint64_t offset)
+    {
+        auto sqe = get_sqe();
+        if (sqe == nullptr)
+        {
+            return false;
+        }
+        sqe->opcode = opcode;
+        sqe->fd = fd;
+        sqe->addr = reinterpret_cast<uintptr_t>(buffer->data());
+        sqe->len = static_cast<uint32_t>(count);
+        sqe->off = offset;
+        sqe->buf_index = buffer->index();
+        sqe->user_data = to_user_data(std::move(buffer));
+        return true;
+    }
+
+    inline void* map(size_t size, uint64_t offset)
+    {
+        auto mapped = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_fd, static_cast<off_t>(offset));
+        if (mapped == MAP_FAILED)
+        {
+            throw std::system_error(errno, std::system_category(), "mmap");
+        }
+        return mapped;
+    }
+
+    inline void unmap() noexcept
+    {
+        if (m_sqes != nullptr)
+        {
+            ::munmap(m_sqes, m_sqes_size);
+        }
+        if (m_cq != nullptr && m_cq != m_sq)
+        {
+            ::munmap(m_cq, m_cq_size);
+        }
+        if (m_sq != nullptr)
+        {
+            ::munmap(m_sq, m_sq_size);
+        }
+        ::close(m_fd);
+    }
+
+    template<class T>
+    static inline T* offset(void* base, uint32_t offset) noexcept
+    {
+        return reinterpret_cast<T*>(static_cast<std::byte*>(base) + offset);
+    }
+
+private:
+    int m_fd;
+    bool m_single_mmap;
+    void* m_sq { nullptr };
+    void* m_cq { nullptr };
+    size_t m_sq_size;
+    size_t m_cq_size;
+    io_uring_sqe* m_sqes { nullptr };
+    size_t m_sqes_size;
+    uint32_t* m_sq_head;
+    uint32_t* m_sq_tail;
+    uint32_t m_sq_mask;
+    uint32_t m_sq_entries;
+    uint32_t* m_sq_array;
+    uint32_t* m_cq_head;
+    uint32_t* m_cq_tail;
+    uint32_t m_cq_mask;
+    io_uring_cqe* m_cqes;
+    // The tail of the prepared entries and the tail of the entries consumed by the kernel
+    uint32_t m_tail;
+    uint32_t m_submitted;
+};
+
+/// <summary>
+/// A group of buffers provided to the kernel through a registered buffer ring,
+/// that the receives with the buffer selection take from.
+/// A buffer taken by a completion is published to the ring again, when its last reference is released,
+/// so the recycling takes no submission entries and may happen on any thread.
+/// The group must outlive its buffers and the operations selecting from it.
+/// </summary>
+class provided_buffer_group final : private buffer_recycler, public buffer_block
+{
+    static constexpr size_t page_size = 4096;
+
+public:
+    // The kernel limits a buffer ring to 32768 entries
+    static constexpr size_t max_count = 32768;
+
+    /// <summary>
+    /// Registers the buffer ring of the group and publishes all buffers to it.
+    /// Throws <see cref="std::system_error"/>, if the registration fails.
+    /// </summary>
+    /// <param name="ring">
+    /// - The ring, that must outlive the group
+    /// </param>
+    /// <param name="group">
+    /// - The identifier of the buffer group used by the operations
+    /// </param>
+    /// <param name="count">
+    /// - The number of the buffers, that must not exceed <see cref="max_count"/>
+    /// </param>
+    /// <param name="buffer_size">
+    /// - The capacity of each buffer
+    /// </param>
+    provided_buffer_group(io_ring& ring, uint16_t group, uint16_t count, size_t buffer_size)
+        : buffer_block(*this, validate(count), buffer_size)
+        , m_ring(ring)
+        , m_group(group)
+        , m_entries(std::bit_ceil(std::max<size_t>(count, 1)))
+        , m_ring_size((m_entries * sizeof(io_uring_buf) + page_size - 1) & ~(page_size - 1))
+    {
+        auto mapped = ::mmap(nullptr, m_ring_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_POPULATE, -1, 0);
+        if (mapped == MAP_FAILED)
+        {
+            throw std::system_error(errno, std::system_category(), "mmap");
+        }
+        m_entry_ring = static_cast<io_uring_buf*>(mapped);
+
+        auto registration = io_uring_buf_reg();
+        std::memset(&registration, 0, sizeof(registration));
+        registration.ring_addr = reinterpret_cast<uintptr_t>(mapped);
+        registration.ring_entries = static_cast<uint32_t>(m_entries);
+        registration.bgid = m_group;
+        try
+        {
+            m_ring.enroll(IORING_REGISTER_PBUF_RING, &registration, 1, "IORING_REGISTER_PBUF_RING");
+        }
+        catch (...)
+        {
+            ::munmap(mapped, m_ring_size);
+            throw;
+        }
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            recycle(buffer(i));
+        }
+    }
+
+    ~provided_buffer_group()
+    {
+        auto registration = io_uring_buf_reg();
+        std::memset(&registration, 0, sizeof(registration));
+        registration.bgid = m_group;
+        try
+        {
+            m_ring.enroll(IORING_UNREGISTER_PBUF_RING, &registration, 1, "IORING_UNREGISTER_PBUF_RING");
+        }
+        catch (const std::system_error&)
+        {
+        }
+        ::munmap(m_entry_ring, m_ring_size);
+    }
+
+    inline uint16_t group() const noexcept
+    {
+        return m_group;
+    }
+
+    /// <summary>
+    /// Takes the buffer selected by the completion of a receive
+    /// </summary>
+    /// <param name="flags">
+    /// - The flags of the completion, that must contain <c>IORING_CQE_F_BUFFER</c>
+    /// </param>
+    /// <param name="size">
+    /// - The number of the received bytes
+    /// </param>
+    /// <returns>
+    /// The only reference to the buffer, that publishes it to the ring again on release
+    /// </returns>
+    inline intrusive_ptr<registered_buffer> take(uint32_t flags, size_t size) noexcept
+    {
+        auto& selected = buffer(flags >> IORING_CQE_BUFFER_SHIFT);
+        selected.resize(size);
+        return intrusive_ptr<registered_buffer>(&selected);
+    }
+
+private:
+    static inline size_t validate(size_t count)
+    {
+        if (count > max_count)
+        {
+            throw std::invalid_argument("The number of the buffers exceeds the size of a buffer ring");
+        }
+        return count;
+    }
+
+    /// <summary>
+    /// Fills the next entry of the ring and publishes it by the release store of the tail.
+    /// The ring has an entry for each buffer, so it never overflows.
+    /// </summary>
+    void recycle(registered_buffer& buffer) noexcept override
+    {
+        auto lock = std::lock_guard(m_mutex);
+        auto& entry = m_entry_ring[m_tail & (m_entries - 1)];
+        entry.addr = reinterpret_cast<uintptr_t>(buffer.data());
+        entry.len = static_cast<uint32_t>(buffer.capacity());
+        entry.bid = buffer.index();
+        ++m_tail;
+
+        // The tail overlays the reserved field of the first entry. The entries are not accessed
+        // through io_uring_buf_ring::bufs, since the empty struct of __DECLARE_FLEX_ARRAY
+        // in the older kernel headers moves the array by 8 bytes in C++.
+        std::atomic_ref<uint16_t>(m_entry_ring[0].resv).store(m_tail, std::memory_order_release);
+    }
+
+private:
+    io_ring& m_ring;
+    const uint16_t m_group;
+    const size_t m_entries;
+    const size_t m_ring_size;
+    io_uring_buf* m_entry_ring { nullptr };
+    std::mutex m_mutex;
+    uint16_t m_tail { 0 };
+};
+
+#endif
@@ -0,0 +1,538 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <algorithm>
+#include <iterator>
+#include <new>
+#include <string>
+#include <string_view>
+#include <utility>
+#include "intrusive_ptr.h"
+
+/// <summary>
+/// A rope: a string represented by a balanced tree of objects derived from
+/// <see cref="RefCountObject"/>, whose leaves reference ranges of immutable chunks.
+/// The chunks and the subtrees are shared between ropes through <see cref="intrusive_ptr"/>,
+/// so the concatenation, the substring, the insertion and the removal take O(log n)
+/// and never copy the characters, except of merging adjacent small leaves.
+/// </summary>
+class rope final
+{
+    // The maximal length of a leaf created from a string
+    static constexpr size_t leaf_size = 4096;
+
+    // The adjacent leaves are merged into a new chunk, if their total length does not exceed it
+    static constexpr size_t merge_size = 256;
+
+    static constexpr unsigned max_depth = 96;
+
+    /// <summary>
+    /// An immutable array of characters stored in the same allocation as its header
+    /// </summary>
+    class chunk final : public RefCountObject<chunk>
+    {
+        struct trailing_t { };
+
+    public:
+        static void* operator new(size_t size, trailing_t, size_t extra)
+        {
+            return ::operator new(size + extra);
+        }
+
+        static void operator delete(void* ptr, trailing_t, size_t) noexcept
+        {
+            ::operator delete(ptr);
+        }
+
+        static void operator delete(void* ptr) noexcept
+        {
+            ::operator delete(ptr);
+        }
+
+        static auto create(std::string_view first, std::string_view second = { })
+        {
+            auto ptr = new (trailing_t { }, first.size() + second.size()) chunk();
+            std::copy(first.begin(), first.end(), ptr->data());
+            std::copy(second.begin(), second.end(), ptr->data() + first.size());
+            return intrusive_ptr<chunk>(ptr);
+        }
+
+        inline char* data() noexcept
+        {
+            return reinterpret_cast<char*>(this + 1);
+        }
+
+    private:
+        chunk() noexcept = default;
+    };
+
+    class node : public RefCountObject<node>
+    {
+    public:
+        inline bool is_leaf() const noexcept
+        {
+            return m_depth == 0;
+        }
+
+        size_t m_length { 0 };
+        unsigned m_depth { 0 };
+
+    protected:
+        node() noexcept = default;
+    };
+
+    /// <summary>
+    /// A leaf referencing a range of a chunk
+    /// </summary>
+    class leaf_node final : public node
+    {
+    public:
+        inline leaf_node(intrusive_ptr<chunk> data, size_t offset, size_t length) noexcept
+            : m_chunk(std::move(data))
+            , m_offset(offset)
+        {
+            this->m_length = length;
+        }
+
+        inline std::string_view view() const noexcept
+        {
+            return std::string_view(m_chunk->data() + m_offset, this->m_length);
+        }
+
+        intrusive_ptr<chunk> m_chunk;
+        size_t m_offset;
+    };
+
+    /// <summary>
+    /// A concatenation of two subtrees, whose depths differ at most by one
+    /// </summary>
+    class concat_node final : public node
+    {
+    public:
+        inline concat_node(intrusive_ptr<node> left, intrusive_ptr<node> right) noexcept
+            : m_left(std::move(left))
+            , m_right(std::move(right))
+        {
+            this->m_length = m_left->m_length + m_right->m_length;
+            this->m_depth = std::max(m_left->m_depth, m_right->m_depth) + 1;
+        }
+
+        intrusive_ptr<node> m_left;
+        intrusive_ptr<node> m_right;
+    };
+
+    using node_ptr = intrusive_ptr<node>;
+
+public:
+    /// <summary>
+    /// A forward iterator over the chunks of <see cref="rope"/> in order.
+    /// The iterator borrows the nodes of the rope and never changes their reference counts.
+    /// It is valid until the iterated rope is changed or destroyed.
+    /// </summary>
+    class chunk_iterator final
+    {
+        friend class rope;
+
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = std::string_view;
+        using difference_type = ptrdiff_t;
+        using pointer = const std::string_view*;
+        using reference = std::string_view;
+
+        chunk_iterator() noexcept = default;
+
+        inline std::string_view operator*() const noexcept
+        {
+            return m_leaf->view();
+        }
+
+        inline chunk_iterator& operator++() noexcept
+        {
+            if (m_count == 0)
+            {
+                m_leaf = nullptr;
+                return *this;
+            }
+            descend(m_stack[--m_count]);
+            return *this;
+        }
+
+        inline chunk_iterator operator++(int) noexcept
+        {
+            auto it = *this;
+            ++(*this);
+            return it;
+        }
+
+        inline bool operator==(const chunk_iterator& other) const noexcept
+        {
+            return m_leaf == other.m_leaf;
+        }
+
+        inline bool operator!=(const chunk_iterator& other) const noexcept
+        {
+            return m_leaf != other.m_leaf;
+        }
+
+    private:
+        inline void descend(node* current) noexcept
+        {
+            while (!current->is_leaf())
+            {
+                auto concat = static_cast<concat_node*>(current);
+                m_stack[m_count++] = concat->m_right.get();
+                current = concat->m_left.get();
+            }
+            m_leaf = static_cast<leaf_node*>(current);
+        }
+
+    private:
+        node* m_stack[max_depth] { };
+        unsigned m_count { 0 };
+        leaf_node* m_leaf { nullptr };
+    };
+
+    /// <summary>
+    /// Provides a new empty instance of <see cref="rope"/>
+    /// </summary>
+    rope() noexcept = default;
+
+    /// <summary>
+    /// Provides a new instance of <see cref="rope"/> containing a copy of the string.
+    /// The characters are copied into a single chunk, that is shared by the leaves.
+    /// </summary>
+    /// <param name="text">
+    /// - The characters of the rope
+    /// </param>
+    explicit rope(std::string_view text)
+    {
+        if (!text.empty())
+        {
+            m_root = build(chunk::create(text), 0, text.size());
+        }
+    }
+
+    /// <summary>
+    /// Returns the number of characters of the rope
+    /// </summary>
+    inline size_t size() const noexcept
+    {
+        return m_root ? m_root->m_length : 0;
+    }
+
+    /// <summary>
+    /// Checks whether the rope has no characters
+    /// </summary>
+    inline bool empty() const noexcept
+    {
+        return !m_root;
+    }
+
+    inline chunk_iterator chunk_begin() const noexcept
+    {
+        auto it = chunk_iterator();
+        if (m_root)
+        {
+            it.descend(m_root.get());
+        }
+        return it;
+    }
+
+    inline chunk_iterator chunk_end() const noexcept
+    {
+        return chunk_iterator();
+    }
+
+    /// <summary>
+    /// Provides the character at the specified position, that must be less than the size
+    /// </summary>
+    inline char operator[](size_t position) const noexcept
+    {
+        auto current = m_root.get();
+        while (!current->is_leaf())
+        {
+            auto concat = static_cast<const concat_node*>(current);
+            auto left_length = concat->m_left->m_length;
+            if (position < left_length)
+            {
+                current = concat->m_left.get();
+            }
+            else
+            {
+                position -= left_length;
+                current = concat->m_right.get();
+            }
+        }
+        return static_cast<const leaf_node*>(current)->view()[position];
+    }
+
+    /// <summary>
+    /// Copies the characters of the rope to a string
+    /// </summary>
+    inline std::string to_string() const
+    {
+        auto result = std::string();
+        result.reserve(size());
+        for (auto it = chunk_begin(); it != chunk_end(); ++it)
+        {
+            result.append(*it);
+        }
+        return result;
+    }
+
+    /// <summary>
+    /// Appends the characters of the specified rope to the current one
+    /// </summary>
+    inline void append(const rope& other)
+    {
+        m_root = join(m_root, other.m_root);
+    }
+
+    /// <summary>
+    /// Inserts the characters of the specified rope at the position of the current one
+    /// </summary>
+    /// <param name="position">
+    /// - The position of the insertion, that must not exceed the size
+    /// </param>
+    /// <param name="other">
+    /// - The inserted rope
+    /// </param>
+    inline void insert(size_t position, const rope& other)
+    {
+        auto [left, right] = split(m_root, position);
+        m_root = join(join(left, other.m_root), right);
+    }
+
+    /// <summary>
+    /// Removes the range of characters from the current rope
+    /// </summary>
+    /// <param name="position">
+    /// - The position of the first removed character
+    /// </param>
+    /// <param name="count">
+    /// - The number of removed characters
+    /// </param>
+    inline void erase(size_t position, size_t count)
+    {
+        auto [left, rest] = split(m_root, position);
+        auto [removed, right] = split(rest, std::min(count, size() - position));
+        m_root = join(left, right);
+    }
+
+    /// <summary>
+    /// Provides a new rope containing the characters of the current one
+    /// followed by the characters of the specified one
+    /// </summary>
+    inline rope concat(const rope& other) const
+    {
+        auto result = *this;
+        result.append(other);
+        return result;
+    }
+
+    /// <summary>
+    /// Provides a new rope containing the range of characters of the current one
+    /// </summary>
+    /// <param name="position">
+    /// - The position of the first character of the range
+    /// </param>
+    /// <param name="count">
+    /// - The number of characters of the range
+    /// </param>
+    inline rope substr(size_t position, size_t count) const
+    {
+        auto [left, rest] = split(m_root, position);
+        auto result = rope();
+        result.m_root = split(rest, std::min(count, size() - position)).first;
+        return result;
+    }
+
+    /// <summary>
+    /// Rebuilds the rope from leaves of the default size, that are copied to a single chunk.
+    /// Reduces the depth of a rope fragmented by many edits.
+    /// </summary>
+    inline void compact()
+    {
+        if (m_root)
+        {
+            m_root = build(chunk::create(to_string()), 0, size());
+        }
+    }
+
+private:
+    static unsigned depth(const node_ptr& ptr) noexcept
+    {
+        return ptr ? ptr->m_depth : 0;
+    }
+
+    static const leaf_node* as_leaf(const node_ptr& ptr) noexcept
+    {
+        return static_cast<const leaf_node*>(ptr.get());
+    }
+
+    static const concat_node* as_concat(const node_ptr& ptr) noexcept
+    {
+        return static_cast<const concat_node*>(ptr.get());
+    }
+
+    static node_ptr make_leaf(intrusive_ptr<chunk> data, size_t offset, size_t length)
+    {
+        return length != 0
+            ? node_ptr(new leaf_node(std::move(data), offset, length))
+            : node_ptr();
+    }
+
+    static node_ptr make_node(node_ptr left, node_ptr right)
+    {
+        return node_ptr(new concat_node(std::move(left), std::move(right)));
+    }
+
+    /// <summary>
+    /// Builds a perfectly balanced tree referencing the range of the chunk
+    /// </summary>
+    static node_ptr build(const intrusive_ptr<chunk>& data, size_t offset, size_t length)
+    {
+        if (length <= leaf_size)
+        {
+            return make_leaf(data, offset, length);
+        }
+
+        auto leaves = (length + leaf_size - 1) / leaf_size;
+        auto left_length = (leaves / 2) * leaf_size;
+        return make_node(build(data, offset, left_length),
+            build(data, offset + left_length, length - left_length));
+    }
+
+    static node_ptr rotate_left(const node_ptr& current)
+    {
+        auto concat = as_concat(current);
+        auto right = as_concat(concat->m_right);
+        return make_node(make_node(concat->m_left, right->m_left), right->m_right);
+    }
+
+    static node_ptr rotate_right(const node_ptr& current)
+    {
+        auto concat = as_concat(current);
+        auto left = as_concat(concat->m_left);
+        return make_node(left->m_left, make_node(left->m_right, concat->m_right));
+    }
+
+    /// <summary>
+    /// Joins the trees, if the left one is deeper than the right one by more than one level
+    /// </summary>
+    static node_ptr join_right(const node_ptr& left, const node_ptr& right)
+    {
+        auto& outer = as_concat(left)->m_left;
+        auto& inner = as_concat(left)->m_right;
+        if (depth(inner) <= depth(right) + 1)
+        {
+            auto joined = make_node(inner, right);
+            return depth(joined) <= depth(outer) + 1
+                ? make_node(outer, joined)
+                : rotate_left(make_node(outer, rotate_right(joined)));
+        }
+
+        auto joined = join_right(inner, right);
+        auto result = make_node(outer, joined);
+        return depth(joined) <= depth(outer) + 1
+            ? result
+            : rotate_left(result);
+    }
+
+    /// <summary>
+    /// Joins the trees, if the right one is deeper than the left one by more than one level
+    /// </summary>
+    static node_ptr join_left(const node_ptr& left, const node_ptr& right)
+    {
+        auto& outer = as_concat(right)->m_right;
+        auto& inner = as_concat(right)->m_left;
+        if (depth(inner) <= depth(left) + 1)
+        {
+            auto joined = make_node(left, inner);
+            return depth(joined) <= depth(outer) + 1
+                ? make_node(joined, outer)
+                : rotate_right(make_node(rotate_left(joined), outer));
+        }
+
+        auto joined = join_left(left, inner);
+        auto result = make_node(joined, outer);
+        return depth(joined) <= depth(outer) + 1
+            ? result
+            : rotate_right(result);
+    }
+
+    /// <summary>
+    /// Concatenates the trees keeping the difference of the depths of siblings at most one
+    /// </summary>
+    static node_ptr join(const node_ptr& left, const node_ptr& right)
+    {
+        if (!left || !right)
+        {
+            return left ? left : right;
+        }
+
+        if (left->is_leaf() && right->is_leaf() && left->m_length + right->m_length <= merge_size)
+        {
+            return make_leaf(chunk::create(as_leaf(left)->view(), as_leaf(right)->view()), 0,
+                left->m_length + right->m_length);
+        }
+
+        if (depth(left) > depth(right) + 1)
+        {
+            return join_right(left, right);
+        }
+
+        if (depth(right) > depth(left) + 1)
+        {
+            return join_left(left, right);
+        }
+
+        return make_node(left, right);
+    }
+
+    /// <summary>
+    /// Splits the tree into the trees containing the characters before
+    /// and after the specified position
+    /// </summary>
+    static std::pair<node_ptr, node_ptr> split(const node_ptr& current, size_t position)
+    {
+        if (!current || position == 0)
+        {
+            return { node_ptr(), current };
+        }
+
+        if (position >= current->m_length)
+        {
+            return { current, node_ptr() };
+        }
+
+        if (current->is_leaf())
+        {
+            auto leaf = as_leaf(current);
+            return {
+                make_leaf(leaf->m_chunk, leaf->m_offset, position),
+                make_leaf(leaf->m_chunk, leaf->m_offset + position, leaf->m_length - position)
+            };
+        }
+
+        auto concat = as_concat(current);
+        auto left_length = concat->m_left->m_length;
+        if (position < left_length)
+        {
+            auto [left, right] = split(concat->m_left, position);
+            return { std::move(left), join(right, concat->m_right) };
+        }
+
+        if (position > left_length)
+        {
+            auto [left, right] = split(concat->m_right, position - left_length);
+            return { join(concat->m_left, left), std::move(right) };
+        }
+
+        return { concat->m_left, concat->m_right };
+    }
+
+private:
+    node_ptr m_root;
+};
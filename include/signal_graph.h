@@ -0,0 +1,647 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <algorithm>
+#include <concepts>
+#include <exception>
+#include <initializer_list>
+#include <optional>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "intrusive_ptr.h"
+
+class signal_batch;
+
+/// <summary>
+/// A node of an incremental computation graph: a source, a computed value or an effect.
+/// A node holds the references to its sources and only the raw pointers to its observers,
+/// so the part of the graph, that is not reachable from a handle or an effect, is freed automatically.
+/// A change of a source marks the observers stale, and a stale node is recomputed in the topological order
+/// only when its value is requested or when an effect observes it. A graph must be used by one thread at a time.
+/// </summary>
+class signal_node : public RefCountObject<signal_node>
+{
+    friend class signal_batch;
+
+public:
+    ~signal_node() override
+    {
+        for (auto& link : m_sources)
+        {
+            auto& observers = link.m_node->m_observers;
+            auto position = std::find(observers.begin(), observers.end(), this);
+            *position = observers.back();
+            observers.pop_back();
+            t_released.push_back(link.m_node);
+        }
+
+        // The sources freed by the releases are destroyed by the outermost destructor,
+        // so a long chain of nodes does not recurse
+        if (t_releasing)
+        {
+            return;
+        }
+        t_releasing = true;
+        while (!t_released.empty())
+        {
+            auto source = t_released.back();
+            t_released.pop_back();
+            intrusive_ptr_release(source);
+        }
+        t_releasing = false;
+    }
+
+    /// <summary>
+    /// Returns the version of the value, that is incremented, when the value changes
+    /// </summary>
+    inline uint64_t version() const noexcept
+    {
+        return m_version;
+    }
+
+    /// <summary>
+    /// Checks whether the value must be brought up to date before the next access
+    /// </summary>
+    inline bool is_stale() const noexcept
+    {
+        return m_stale;
+    }
+
+    /// <summary>
+    /// Brings the sources and the node up to date. The node is recomputed only if a source has changed.
+    /// The stale nodes are visited by an explicit stack in the topological order, so a deep graph does not recurse.
+    /// A node stays stale, if its computation throws, and is recomputed by the next access.
+    /// The nodes, that failed to refresh, are marked, so the next change of a source schedules their effects again.
+    /// </summary>
+    inline void refresh()
+    {
+        if (!m_stale)
+        {
+            return;
+        }
+
+        // A computation may access other nodes, so the nested calls use the stack above their base
+        auto& stack = t_refreshing;
+        auto base = stack.size();
+        stack.push_back({ this, 0, false });
+        try
+        {
+            while (stack.size() > base)
+            {
+                auto& top = stack.back();
+                auto node = top.m_node;
+                if (top.m_next < node->m_sources.size())
+                {
+                    auto& link = node->m_sources[top.m_next];
+                    if (link.m_node->m_stale)
+                    {
+                        stack.push_back({ link.m_node, 0, false });
+                        continue;
+                    }
+                    top.m_changed |= link.m_node->m_version != link.m_seen;
+                    ++top.m_next;
+                    continue;
+                }
+
+                // The version 0 marks a node, that has never been computed
+                if ((top.m_changed || node->m_version == 0) && (node->recompute() || node->m_version == 0))
+                {
+                    ++node->m_version;
+                }
+                for (auto& link : node->m_sources)
+                {
+                    link.m_seen = link.m_node->m_version;
+                }
+                node->m_stale = false;
+                node->m_failed = false;
+                stack.pop_back();
+            }
+        }
+        catch (...)
+        {
+            for (auto i = base; i < stack.size(); ++i)
+            {
+                stack[i].m_node->m_failed = true;
+            }
+            stack.resize(base);
+            throw;
+        }
+    }
+
+protected:
+    signal_node(std::initializer_list<signal_node*> sources, bool stale)
+        : m_version(stale ? 0 : 1)
+        , m_stale(stale)
+    {
+        m_sources.reserve(sources.size());
+        for (auto source : sources)
+        {
+            intrusive_ptr_add_ref(source);
+            m_sources.push_back({ source, 0 });
+            source->m_observers.push_back(this);
+        }
+    }
+
+    /// <summary>
+    /// Computes the value from the sources, that are up to date
+    /// </summary>
+    /// <returns>
+    /// True, if the value has changed and the observers must be recomputed
+    /// </returns>
+    virtual bool recompute() = 0;
+
+    /// <summary>
+    /// Called, when the node becomes stale. Effects schedule themselves here.
+    /// </summary>
+    virtual void on_stale() { }
+
+    inline signal_node& source(size_t index) const noexcept
+    {
+        return *m_sources[index].m_node;
+    }
+
+    /// <summary>
+    /// Publishes a new value of a source: increments the version and marks the observers stale
+    /// </summary>
+    inline void changed();
+
+private:
+    struct link
+    {
+        signal_node* m_node;
+        // The version of the source, that the value has been computed from
+        uint64_t m_seen;
+    };
+
+    /// <summary>
+    /// A node being refreshed and the index of its next source to check
+    /// </summary>
+    struct frame
+    {
+        signal_node* m_node;
+        size_t m_next;
+        bool m_changed;
+    };
+
+    // The sources hold the references, since intrusive_ptr requires the complete type
+    std::vector<link> m_sources;
+    std::vector<signal_node*> m_observers;
+    uint64_t m_version;
+    bool m_stale;
+    // The node has stayed stale, since its refresh has thrown, so its observers may not be stale anymore
+    bool m_failed { false };
+
+    static inline thread_local std::vector<frame> t_refreshing;
+    static inline thread_local std::vector<signal_node*> t_released;
+    static inline thread_local bool t_releasing { false };
+};
+
+/// <summary>
+/// Defers the effects scheduled by the changes of the sources until the outermost batch is committed,
+/// so the effects observing several changed sources run once. Each change of a source opens and commits its own batch.
+/// A batch, that is destroyed without the commit, keeps its effects scheduled until the next outermost commit.
+/// </summary>
+class signal_batch final
+{
+public:
+    signal_batch() noexcept
+    {
+        ++t_depth;
+    }
+
+    signal_batch(const signal_batch&) = delete;
+    signal_batch& operator=(const signal_batch&) = delete;
+
+    ~signal_batch()
+    {
+        if (!m_committed)
+        {
+            --t_depth;
+        }
+    }
+
+    /// <summary>
+    /// Ends the batch. The outermost batch runs the scheduled effects, that may change the sources
+    /// and schedule more effects. An effect, that throws, does not stop the others,
+    /// and the first exception is rethrown after all of them have run.
+    /// </summary>
+    inline void commit()
+    {
+        if (m_committed)
+        {
+            return;
+        }
+        m_committed = true;
+
+        auto error = std::exception_ptr();
+        if (t_depth == 1)
+        {
+            error = run_effects();
+        }
+        --t_depth;
+        if (error)
+        {
+            std::rethrow_exception(error);
+        }
+    }
+
+    /// <summary>
+    /// Schedules the effect, that is kept alive until it runs
+    /// </summary>
+    static inline void schedule(signal_node& effect)
+    {
+        intrusive_ptr_add_ref(&effect);
+        t_effects.push_back(&effect);
+    }
+
+    /// <summary>
+    /// Marks the transitive observers of the node stale. A stale node is skipped,
+    /// since its observers have been marked, when it became stale, unless its refresh has failed.
+    /// </summary>
+    static inline void invalidate(signal_node& node)
+    {
+        auto& pending = t_pending;
+        pending.assign(node.m_observers.begin(), node.m_observers.end());
+        while (!pending.empty())
+        {
+            auto observer = pending.back();
+            pending.pop_back();
+            if (!observer->m_stale || observer->m_failed)
+            {
+                observer->m_stale = true;
+                observer->m_failed = false;
+                observer->on_stale();
+                pending.insert(pending.end(), observer->m_observers.begin(), observer->m_observers.end());
+            }
+        }
+    }
+
+private:
+    static std::exception_ptr run_effects() noexcept
+    {
+        auto error = std::exception_ptr();
+        for (size_t i = 0; i < t_effects.size(); ++i)
+        {
+            try
+            {
+                t_effects[i]->refresh();
+            }
+            catch (...)
+            {
+                if (!error)
+                {
+                    error = std::current_exception();
+                }
+            }
+        }
+        for (auto effect : t_effects)
+        {
+            intrusive_ptr_release(effect);
+        }
+        t_effects.clear();
+        return error;
+    }
+
+private:
+    bool m_committed { false };
+
+    static inline thread_local size_t t_depth { 0 };
+    static inline thread_local std::vector<signal_node*> t_effects;
+    static inline thread_local std::vector<signal_node*> t_pending;
+};
+
+inline void signal_node::changed()
+{
+    ++m_version;
+    signal_batch::invalidate(*this);
+}
+
+/// <summary>
+/// A node, that stores a value of the specified type
+/// </summary>
+template<class T>
+class value_node : public signal_node
+{
+public:
+    /// <summary>
+    /// Returns the value, that is recomputed first, if it is stale
+    /// </summary>
+    inline const T& get()
+    {
+        refresh();
+        return *m_value;
+    }
+
+protected:
+    using signal_node::signal_node;
+
+    /// <summary>
+    /// Stores the value and reports, whether it differs from the previous one.
+    /// The equal values stop the propagation to the observers.
+    /// </summary>
+    inline bool store(T&& value)
+    {
+        if constexpr (std::equality_comparable<T>)
+        {
+            if (m_value && *m_value == value)
+            {
+                return false;
+            }
+        }
+        m_value = std::move(value);
+        return true;
+    }
+
+private:
+    std::optional<T> m_value;
+};
+
+/// <summary>
+/// A node, that is changed by the caller
+/// </summary>
+template<class T>
+class source_node final : public value_node<T>
+{
+public:
+    explicit source_node(T value) : value_node<T>({ }, false)
+    {
+        this->store(std::move(value));
+    }
+
+    /// <summary>
+    /// Changes the value and runs the effects, that depend on it, unless a batch is open
+    /// </summary>
+    inline void set(T value)
+    {
+        auto batch = signal_batch();
+        if (this->store(std::move(value)))
+        {
+            this->changed();
+        }
+        batch.commit();
+    }
+
+protected:
+    bool recompute() override
+    {
+        return false;
+    }
+};
+
+/// <summary>
+/// A node, whose value is computed by the function from the values of the sources
+/// </summary>
+template<class T, class Function, class... Sources>
+class computed_node final : public value_node<T>
+{
+public:
+    computed_node(Function function, Sources&... sources)
+        : value_node<T>({ &sources... }, true)
+        , m_function(std::move(function)) { }
+
+protected:
+    bool recompute() override
+    {
+        return this->store(invoke(std::index_sequence_for<Sources...>()));
+    }
+
+private:
+    template<size_t... Indexes>
+    inline T invoke(std::index_sequence<Indexes...>)
+    {
+        return m_function(static_cast<Sources&>(this->source(Indexes)).get()...);
+    }
+
+private:
+    Function m_function;
+};
+
+/// <summary>
+/// A node, that invokes the function with the values of the sources, when any of them changes
+/// </summary>
+template<class Function, class... Sources>
+class effect_node final : public signal_node
+{
+public:
+    effect_node(Function function, Sources&... sources)
+        : signal_node({ &sources... }, true)
+        , m_function(std::move(function)) { }
+
+    /// <summary>
+    /// Stops the effect from running. The node is freed, when the scheduled runs have been skipped.
+    /// </summary>
+    inline void dispose() noexcept
+    {
+        m_disposed = true;
+    }
+
+protected:
+    bool recompute() override
+    {
+        if (!m_disposed)
+        {
+            invoke(std::index_sequence_for<Sources...>());
+        }
+        return false;
+    }
+
+    void on_stale() override
+    {
+        signal_batch::schedule(*this);
+    }
+
+private:
+    template<size_t... Indexes>
+    inline void invoke(std::index_sequence<Indexes...>)
+    {
+        m_function(static_cast<Sources&>(this->source(Indexes)).get()...);
+    }
+
+private:
+    Function m_function;
+    bool m_disposed { false };
+};
+
+/// <summary>
+/// A shared handle of a node with a value. The node and its sources live as long as a handle
+/// or an observer refers to it.
+/// </summary>
+/// <typeparam name="T">
+/// The type of the value
+/// </typeparam>
+template<class T>
+class signal
+{
+public:
+    using element_type = T;
+
+    signal() noexcept = default;
+
+    explicit signal(intrusive_ptr<signal_node> node) noexcept : m_node(std::move(node)) { }
+
+    inline explicit operator bool() const noexcept
+    {
+        return static_cast<bool>(m_node);
+    }
+
+    /// <summary>
+    /// Returns the value, recomputing the stale nodes, that it depends on
+    /// </summary>
+    inline const T& get() const
+    {
+        return node().get();
+    }
+
+    inline const T& operator*() const
+    {
+        return get();
+    }
+
+    inline const T* operator->() const
+    {
+        return &get();
+    }
+
+    inline bool is_stale() const noexcept
+    {
+        return m_node->is_stale();
+    }
+
+    inline uint64_t version() const noexcept
+    {
+        return m_node->version();
+    }
+
+    /// <summary>
+    /// Returns the number of the handles and the observers, that refer to the node
+    /// </summary>
+    inline uint32_t use_count() const noexcept
+    {
+        return m_node.use_count();
+    }
+
+    inline value_node<T>& node() const noexcept
+    {
+        return static_cast<value_node<T>&>(*m_node);
+    }
+
+protected:
+    intrusive_ptr<signal_node> m_node;
+};
+
+/// <summary>
+/// A handle of a source, that can be changed
+/// </summary>
+template<class T>
+class signal_source final : public signal<T>
+{
+public:
+    signal_source() noexcept = default;
+
+    explicit signal_source(intrusive_ptr<signal_node> node) noexcept : signal<T>(std::move(node)) { }
+
+    /// <summary>
+    /// Changes the value. The observers are marked stale, if the value differs from the previous one,
+    /// and the effects run, when the outermost <see cref="signal_batch"/> is committed.
+    /// An exception thrown by an effect is rethrown here after the other effects have run.
+    /// </summary>
+    inline void set(T value) const
+    {
+        static_cast<source_node<T>&>(*this->m_node).set(std::move(value));
+    }
+};
+
+/// <summary>
+/// An owning handle of an effect. The effect stops running, when the handle is destroyed.
+/// </summary>
+class signal_effect final
+{
+public:
+    signal_effect() noexcept = default;
+
+    template<class Node>
+    explicit signal_effect(intrusive_ptr<signal_node> node, Node&) noexcept
+        : m_node(std::move(node))
+        , m_dispose([](signal_node& node) noexcept { static_cast<Node&>(node).dispose(); }) { }
+
+    signal_effect(signal_effect&&) noexcept = default;
+    signal_effect& operator=(signal_effect&& other) noexcept
+    {
+        dispose();
+        m_node = std::move(other.m_node);
+        m_dispose = other.m_dispose;
+        return *this;
+    }
+
+    ~signal_effect()
+    {
+        dispose();
+    }
+
+private:
+    inline void dispose() noexcept
+    {
+        if (m_node)
+        {
+            m_dispose(*m_node);
+            m_node = nullptr;
+        }
+    }
+
+private:
+    intrusive_ptr<signal_node> m_node;
+    void (*m_dispose)(signal_node& node) noexcept { nullptr };
+};
+
+/// <summary>
+/// Creates a source with the initial value
+/// </summary>
+template<class T>
+inline signal_source<std::decay_t<T>> make_source(T&& value)
+{
+    using value_type = std::decay_t<T>;
+    return signal_source<value_type>(intrusive_ptr<signal_node>(new source_node<value_type>(std::forward<T>(value))));
+}
+
+/// <summary>
+/// Creates a node, whose value is computed by the function on the first access
+/// and recomputed on an access after a change of the sources
+/// </summary>
+/// <param name="function">
+/// - A callable object that accepts constant references to the values of the sources
+/// </param>
+/// <param name="sources">
+/// - The handles of the nodes, that the value depends on
+/// </param>
+template<class Function, class... Sources>
+inline auto make_computed(Function&& function, const signal<Sources>&... sources)
+{
+    using function_type = std::decay_t<Function>;
+    using value_type = std::decay_t<std::invoke_result_t<function_type&, const Sources&...>>;
+    using node_type = computed_node<value_type, function_type, value_node<Sources>...>;
+
+    auto node = new node_type(std::forward<Function>(function), sources.node()...);
+    return signal<value_type>(intrusive_ptr<signal_node>(node));
+}
+
+/// <summary>
+/// Creates an effect, that runs now and after every change of the sources
+/// </summary>
+/// <param name="function">
+/// - A callable object that accepts constant references to the values of the sources
+/// </param>
+/// <param name="sources">
+/// - The handles of the nodes, that the effect observes
+/// </param>
+template<class Function, class... Sources>
+inline signal_effect make_effect(Function&& function, const signal<Sources>&... sources)
+{
+    using function_type = std::decay_t<Function>;
+    using node_type = effect_node<function_type, value_node<Sources>...>;
+
+    auto node = new node_type(std::forward<Function>(function), sources.node()...);
+    auto effect = signal_effect(intrusive_ptr<signal_node>(node), *node);
+    node->refresh();
+    return effect;
+}
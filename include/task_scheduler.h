@@ -0,0 +1,432 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "intrusive_channel.h"
+#include "intrusive_ptr.h"
+#include "work_stealing_deque.h"
+
+class task_scheduler;
+
+/// <summary>
+/// A node of a task graph executed by <see cref="task_scheduler"/>.
+/// The task embeds the count of its unfinished dependencies and the list of its successors,
+/// so the graph is kept alive only by the references of the predecessors,
+/// the scheduler and the caller, without any separate control blocks.
+/// </summary>
+class graph_task : public RefCountObject<graph_task>
+{
+    friend class task_scheduler;
+
+public:
+    ~graph_task() override
+    {
+        for (auto successor : m_successors)
+        {
+            intrusive_ptr_release(successor);
+        }
+    }
+
+    /// <summary>
+    /// Makes the successor wait for the completion of the current task.
+    /// Both tasks must not be submitted yet.
+    /// </summary>
+    /// <param name="successor">
+    /// - A reference to the successor, that is kept by the current task until its completion
+    /// </param>
+    inline void precede(graph_task& successor)
+    {
+        m_successors.push_back(&successor);
+        intrusive_ptr_add_ref(&successor);
+        successor.m_pending.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    /// <summary>
+    /// Checks whether the task has been executed
+    /// </summary>
+    inline bool is_done() const noexcept
+    {
+        return m_done.load(std::memory_order_acquire);
+    }
+
+    /// <summary>
+    /// Blocks until the task has been executed
+    /// </summary>
+    inline void wait() const noexcept
+    {
+        m_done.wait(false, std::memory_order_acquire);
+    }
+
+protected:
+    graph_task() noexcept = default;
+
+    /// <summary>
+    /// Runs the work of the task on a worker thread. The function must not throw.
+    /// </summary>
+    virtual void execute() noexcept = 0;
+
+private:
+    // The unfinished predecessors and the submission, that has not happened yet
+    std::atomic<uint32_t> m_pending { 1 };
+    std::atomic<bool> m_done { false };
+    // The successors hold the references, since intrusive_ptr requires the complete type
+    std::vector<graph_task*> m_successors;
+};
+
+/// <summary>
+/// A task that invokes the stored callable object
+/// </summary>
+template<class Function>
+class function_task final : public graph_task
+{
+public:
+    explicit function_task(Function function) : m_function(std::move(function)) { }
+
+protected:
+    void execute() noexcept override
+    {
+        m_function();
+    }
+
+private:
+    Function m_function;
+};
+
+/// <summary>
+/// Creates a new task that invokes the callable object
+/// </summary>
+template<class Function>
+inline intrusive_ptr<graph_task> make_task(Function&& function)
+{
+    return intrusive_ptr<graph_task>(new function_task<std::decay_t<Function>>(std::forward<Function>(function)));
+}
+
+/// <summary>
+/// A work-stealing scheduler of task graphs. Each worker thread owns a Chase-Lev deque:
+/// the successors that become ready on a worker are pushed to its own deque,
+/// the idle workers steal from the deques of the others, and the tasks submitted
+/// from the other threads are taken from a shared injection queue.
+/// The idle workers sleep on a futex until a task is pushed.
+/// </summary>
+class task_scheduler final
+{
+    struct worker
+    {
+        work_stealing_deque<graph_task> m_deque;
+        std::thread m_thread;
+        uint64_t m_random;
+    };
+
+public:
+    /// <summary>
+    /// Provides a new instance of <see cref="task_scheduler"/> and starts its workers
+    /// </summary>
+    /// <param name="worker_count">
+    /// - The number of the worker threads. Zero means the number of the hardware threads.
+    /// </param>
+    /// <exception cref="std::system_error">
+    /// Thrown, if a worker thread cannot be started. The workers started before are stopped.
+    /// </exception>
+    explicit task_scheduler(size_t worker_count = 0)
+    {
+        if (worker_count == 0)
+        {
+            worker_count = std::thread::hardware_concurrency();
+            if (worker_count == 0)
+            {
+                worker_count = 1;
+            }
+        }
+
+        for (auto i = size_t(0); i < worker_count; ++i)
+        {
+            m_workers.push_back(std::make_unique<worker>());
+            m_workers.back()->m_random = 0x9e3779b97f4a7c15ull * (i + 1);
+        }
+        try
+        {
+            for (auto& current : m_workers)
+            {
+                current->m_thread = std::thread([this, target = current.get()] { run(*target); });
+            }
+        }
+        catch (...)
+        {
+            // The destructor does not run for a partially constructed scheduler
+            stop();
+            throw;
+        }
+    }
+
+    task_scheduler(const task_scheduler&) = delete;
+    task_scheduler& operator=(const task_scheduler&) = delete;
+
+    /// <summary>
+    /// Waits for all submitted tasks and stops the workers.
+    /// Every predecessor of a submitted task must be submitted as well.
+    /// </summary>
+    ~task_scheduler()
+    {
+        wait_idle();
+        stop();
+    }
+
+    inline size_t worker_count() const noexcept
+    {
+        return m_workers.size();
+    }
+
+    /// <summary>
+    /// Submits the task, that is executed after all its predecessors.
+    /// Each task of a graph must be submitted exactly once, after its edges have been added.
+    /// </summary>
+    /// <param name="ptr">
+    /// - A pointer to the task. The scheduler keeps its own reference until the task is executed.
+    /// </param>
+    /// <exception cref="std::bad_alloc">
+    /// Thrown, if the ready task cannot be queued. The task is left unsubmitted.
+    /// </exception>
+    inline void submit(intrusive_ptr<graph_task> ptr)
+    {
+        enqueue(ptr, false);
+    }
+
+    /// <summary>
+    /// Submits the task like <see cref="submit"/>, but the task, that is ready, is always queued
+    /// to the shared injection queue, so it runs after the tasks already waiting there
+    /// instead of the next one on the current worker. It lets a long-running producer yield.
+    /// </summary>
+    inline void post(intrusive_ptr<graph_task> ptr)
+    {
+        enqueue(ptr, true);
+    }
+
+    /// <summary>
+    /// Blocks until all submitted tasks have been executed
+    /// </summary>
+    /// <exception cref="std::logic_error">
+    /// Thrown, if it is called by a task on a worker of the scheduler,
+    /// since the task itself keeps the scheduler busy and the wait would never end
+    /// </exception>
+    inline void wait_idle()
+    {
+        if (t_current_scheduler == this)
+        {
+            throw std::logic_error("A worker cannot wait for its own scheduler to become idle");
+        }
+
+        auto unfinished = m_unfinished.load(std::memory_order_acquire);
+        while (unfinished != 0)
+        {
+            m_unfinished.wait(unfinished, std::memory_order_acquire);
+            unfinished = m_unfinished.load(std::memory_order_acquire);
+        }
+    }
+
+private:
+    /// <summary>
+    /// Stops the workers and joins the started ones
+    /// </summary>
+    inline void stop() noexcept
+    {
+        m_stopping.store(true, std::memory_order_seq_cst);
+        m_work_available.notify(true);
+        for (auto& current : m_workers)
+        {
+            if (current->m_thread.joinable())
+            {
+                current->m_thread.join();
+            }
+        }
+    }
+
+    /// <summary>
+    /// Counts the submitted task and schedules it, if it is ready.
+    /// If the scheduling throws, the submission is rolled back.
+    /// </summary>
+    inline void enqueue(intrusive_ptr<graph_task>& ptr, bool shared)
+    {
+        m_unfinished.fetch_add(1, std::memory_order_relaxed);
+        if (ptr->m_pending.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        {
+            try
+            {
+                schedule(ptr, shared);
+            }
+            catch (...)
+            {
+                // No predecessor is left to touch the counter of the ready task
+                ptr->m_pending.store(1, std::memory_order_relaxed);
+                finish();
+                throw;
+            }
+        }
+    }
+
+    /// <summary>
+    /// Pushes the ready task to the deque of the current worker,
+    /// or to the injection queue, if it is shared or called outside of the workers.
+    /// The pointer keeps the reference, if the queue cannot grow.
+    /// </summary>
+    inline void schedule(intrusive_ptr<graph_task>& ptr, bool shared)
+    {
+        if (!shared && t_current_scheduler == this)
+        {
+            t_current_worker->m_deque.push(std::move(ptr));
+        }
+        else
+        {
+            auto lock = std::lock_guard(m_injected_lock);
+            m_injected.push_back(ptr.get());
+            ptr.detach();
+            m_injected_count.fetch_add(1, std::memory_order_relaxed);
+        }
+        m_work_available.notify(false);
+    }
+
+    inline void finish() noexcept
+    {
+        if (m_unfinished.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        {
+            m_unfinished.notify_all();
+        }
+    }
+
+    inline void run(worker& current)
+    {
+        t_current_scheduler = this;
+        t_current_worker = &current;
+        while (true)
+        {
+            if (auto ready = find(current))
+            {
+                complete(std::move(ready));
+                continue;
+            }
+
+            auto key = m_work_available.prepare_wait();
+            if (m_stopping.load(std::memory_order_acquire))
+            {
+                m_work_available.cancel_wait();
+                break;
+            }
+            if (has_work())
+            {
+                m_work_available.cancel_wait();
+                continue;
+            }
+            m_work_available.wait(key);
+        }
+        t_current_scheduler = nullptr;
+        t_current_worker = nullptr;
+    }
+
+    /// <summary>
+    /// Takes a ready task from the own deque, the injection queue or a random victim
+    /// </summary>
+    inline intrusive_ptr<graph_task> find(worker& current)
+    {
+        if (auto ready = current.m_deque.pop())
+        {
+            return ready;
+        }
+
+        if (m_injected_count.load(std::memory_order_relaxed) != 0)
+        {
+            auto lock = std::lock_guard(m_injected_lock);
+            if (!m_injected.empty())
+            {
+                auto ready = intrusive_ptr<graph_task>(m_injected.front(), false);
+                m_injected.pop_front();
+                m_injected_count.fetch_sub(1, std::memory_order_relaxed);
+                return ready;
+            }
+        }
+
+        auto count = m_workers.size();
+        current.m_random ^= current.m_random << 13;
+        current.m_random ^= current.m_random >> 7;
+        current.m_random ^= current.m_random << 17;
+        auto start = static_cast<size_t>(current.m_random % count);
+        for (auto i = size_t(0); i < count; ++i)
+        {
+            auto& victim = *m_workers[(start + i) % count];
+            if (&victim == &current)
+            {
+                continue;
+            }
+            if (auto ready = victim.m_deque.steal())
+            {
+                return ready;
+            }
+        }
+        return intrusive_ptr<graph_task>();
+    }
+
+    inline bool has_work() const noexcept
+    {
+        if (m_injected_count.load(std::memory_order_seq_cst) != 0)
+        {
+            return true;
+        }
+        for (auto& current : m_workers)
+        {
+            if (!current->m_deque.empty())
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /// <summary>
+    /// Executes the task and releases its successors, the ready ones are pushed to the own deque.
+    /// A ready successor, that cannot be pushed since the deque cannot grow, is executed at once.
+    /// </summary>
+    inline void complete(intrusive_ptr<graph_task> ready) noexcept
+    {
+        ready->execute();
+
+        auto successors = std::move(ready->m_successors);
+        for (auto successor : successors)
+        {
+            auto ptr = intrusive_ptr<graph_task>(successor, false);
+            if (successor->m_pending.fetch_sub(1, std::memory_order_acq_rel) == 1)
+            {
+                try
+                {
+                    schedule(ptr, false);
+                }
+                catch (...)
+                {
+                    complete(std::move(ptr));
+                }
+            }
+        }
+
+        ready->m_done.store(true, std::memory_order_release);
+        ready->m_done.notify_all();
+        ready.reset(nullptr);
+        finish();
+    }
+
+private:
+    static inline thread_local task_scheduler* t_current_scheduler { nullptr };
+    static inline thread_local worker* t_current_worker { nullptr };
+
+    std::vector<std::unique_ptr<worker>> m_workers;
+    std::mutex m_injected_lock;
+    std::deque<graph_task*> m_injected;
+    std::atomic<size_t> m_injected_count { 0 };
+    std::atomic<size_t> m_unfinished { 0 };
+    std::atomic<bool> m_stopping { false };
+    channel_event m_work_available;
+};
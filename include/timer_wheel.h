@@ -0,0 +1,377 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <bit>
+#include <type_traits>
+#include "intrusive_list.h"
+#include "intrusive_ptr.h"
+
+template<class Tag>
+struct timer_wheel_list_tag { };
+
+/// <summary>
+/// A timer hook embedded into an object next to <see cref="RefCountObject"/>.
+/// The hook holds the links of the object in a slot of <see cref="timer_wheel"/>
+/// and the tick of its expiration, so arming the timer never allocates memory.
+/// </summary>
+/// <typeparam name="Tag">
+/// A tag type that distinguishes several timer hooks of the same object
+/// </typeparam>
+template<class Tag = void>
+class timer_wheel_hook : public intrusive_list_hook<timer_wheel_list_tag<Tag>>
+{
+    template<intrusive_counter_type T, class WheelTag>
+    friend class timer_wheel;
+
+public:
+    timer_wheel_hook() noexcept = default;
+
+    /// <summary>
+    /// Provides a new disarmed instance of <see cref="timer_wheel_hook"/>.
+    /// The state of the copied timer is never copied.
+    /// </summary>
+    timer_wheel_hook(const timer_wheel_hook&) noexcept { }
+
+    timer_wheel_hook& operator=(const timer_wheel_hook&) noexcept
+    {
+        return *this;
+    }
+
+    /// <summary>
+    /// Checks whether the timer is scheduled in a wheel
+    /// </summary>
+    inline bool is_armed() const noexcept
+    {
+        return this->is_linked();
+    }
+
+    /// <summary>
+    /// Returns the tick of the expiration of the armed timer
+    /// </summary>
+    inline uint64_t expiry() const noexcept
+    {
+        return m_expiry;
+    }
+
+private:
+    uint64_t m_expiry { 0 };
+    uint8_t m_level { 0 };
+    uint8_t m_slot { 0 };
+};
+
+/// <summary>
+/// A type concept that allows you to schedule only the objects that contain
+/// <see cref="timer_wheel_hook"/> with the specified tag
+/// </summary>
+template<typename T, class Tag>
+concept timer_wheel_type =
+    intrusive_counter_type<T> && std::is_base_of_v<timer_wheel_hook<Tag>, T>;
+
+/// <summary>
+/// A hashed hierarchical timer wheel of objects derived from <see cref="RefCountObject"/>.
+/// The wheel has 6 levels of 64 slots, a slot of the level L covers 64^L ticks.
+/// A timer is placed at the lowest level, whose slot range still separates its expiration
+/// from the current tick, and moves to the lower levels when the wheel reaches its slot.
+/// The scheduling and the cancellation take O(1) and never allocate memory,
+/// the wheel holds one reference to each armed timer.
+/// The wheel is not thread-safe.
+/// </summary>
+/// <typeparam name="T">
+/// The type of the timers
+/// </typeparam>
+/// <typeparam name="Tag">
+/// The tag of the hook, through which the timers are linked
+/// </typeparam>
+template<intrusive_counter_type T, class Tag = void>
+class timer_wheel final
+{
+    static_assert(timer_wheel_type<T, Tag>,
+        "The type must be derived from RefCountObject and timer_wheel_hook with the same tag");
+
+    static constexpr unsigned slot_bits = 6;
+    static constexpr unsigned slot_count = 1u << slot_bits;
+    static constexpr unsigned level_count = 6;
+
+    // The level of the timers, that are being fired by the current call of advance()
+    static constexpr uint8_t expiring_level = 0xff;
+
+    using hook_type = timer_wheel_hook<Tag>;
+    using list_type = intrusive_list<T, timer_wheel_list_tag<Tag>>;
+
+public:
+    /// <summary>
+    /// Provides a new empty instance of <see cref="timer_wheel"/>
+    /// </summary>
+    /// <param name="now">
+    /// - The current tick
+    /// </param>
+    explicit timer_wheel(uint64_t now = 0) noexcept : m_now(now) { }
+
+    timer_wheel(const timer_wheel&) = delete;
+    timer_wheel& operator=(const timer_wheel&) = delete;
+
+    /// <summary>
+    /// Returns the last processed tick
+    /// </summary>
+    inline uint64_t now() const noexcept
+    {
+        return m_now;
+    }
+
+    /// <summary>
+    /// Returns the number of armed timers
+    /// </summary>
+    inline size_t size() const noexcept
+    {
+        return m_size;
+    }
+
+    inline bool empty() const noexcept
+    {
+        return m_size == 0;
+    }
+
+    /// <summary>
+    /// Arms the timer or moves the armed timer to the new expiration
+    /// </summary>
+    /// <param name="timer">
+    /// - A pointer to the timer. An empty pointer is ignored.
+    /// </param>
+    /// <param name="expiry">
+    /// - The tick of the expiration. The timers expired in the past fire on the next tick.
+    /// </param>
+    inline void schedule(intrusive_ptr<T> timer, uint64_t expiry) noexcept
+    {
+        if (!timer)
+        {
+            return;
+        }
+
+        if (static_cast<hook_type&>(*timer).is_armed())
+        {
+            cancel(*timer);
+        }
+
+        static_cast<hook_type&>(*timer).m_expiry = expiry > m_now ? expiry : m_now + 1;
+        place(std::move(timer));
+        ++m_size;
+    }
+
+    /// <summary>
+    /// Arms the timer to fire after the specified number of ticks
+    /// </summary>
+    inline void schedule_after(intrusive_ptr<T> timer, uint64_t delay) noexcept
+    {
+        schedule(std::move(timer), m_now + delay);
+    }
+
+    /// <summary>
+    /// Disarms the timer and releases the reference held by the wheel
+    /// </summary>
+    /// <param name="timer">
+    /// - A reference to the timer
+    /// </param>
+    /// <returns>
+    /// Returns <see langword="true"/>, if the timer was armed in the wheel,
+    /// otherwise it returns <see langword="false"/>.
+    /// </returns>
+    inline bool cancel(T& timer) noexcept
+    {
+        auto& hook = static_cast<hook_type&>(timer);
+        if (!hook.is_armed())
+        {
+            return false;
+        }
+
+        if (hook.m_level == expiring_level)
+        {
+            m_expiring->erase(timer);
+        }
+        else
+        {
+            m_slots[hook.m_level][hook.m_slot].erase(timer);
+            --m_counts[hook.m_level];
+        }
+        --m_size;
+        return true;
+    }
+
+    /// <summary>
+    /// Processes the ticks up to the specified one and fires the expired timers.
+    /// The timers of a slot are detached from the wheel at once and fired in a batch.
+    /// </summary>
+    /// <param name="now">
+    /// - The new current tick
+    /// </param>
+    /// <param name="handler">
+    /// - The function called with the pointer to each fired timer, that is disarmed already,
+    /// so it may be scheduled again. The handler may cancel the timers of the same batch.
+    /// If the handler throws, the rest of the batch stays armed and fires on the next tick.
+    /// </param>
+    /// <returns>
+    /// The number of fired timers
+    /// </returns>
+    template<class Handler>
+    size_t advance(uint64_t now, Handler&& handler)
+    {
+        auto fired = size_t(0);
+        while (m_now < now)
+        {
+            if (m_size == 0)
+            {
+                m_now = now;
+                break;
+            }
+
+            // Nothing fires or cascades before the next range of the lowest non-empty level
+            auto lowest = 0u;
+            while (lowest + 1 < level_count && m_counts[lowest] == 0)
+            {
+                ++lowest;
+            }
+            if (lowest > 0)
+            {
+                auto last = m_now | ((uint64_t(1) << (lowest * slot_bits)) - 1);
+                m_now = last < now ? last : now;
+                if (m_now == now)
+                {
+                    break;
+                }
+            }
+
+            ++m_now;
+            cascade();
+
+            auto& slot = m_slots[0][m_now & (slot_count - 1)];
+            if (slot.empty())
+            {
+                continue;
+            }
+
+            auto expiring = list_type();
+            m_counts[0] -= slot.size();
+            expiring.splice_back(slot);
+            for (auto& timer : expiring)
+            {
+                static_cast<hook_type&>(timer).m_level = expiring_level;
+            }
+
+            m_expiring = &expiring;
+            auto guard = expiring_guard { *this, expiring };
+            while (auto timer = expiring.pop_front())
+            {
+                --m_size;
+                ++fired;
+                handler(std::move(timer));
+            }
+        }
+        return fired;
+    }
+
+    /// <summary>
+    /// Disarms all timers and releases the references to them.
+    /// Called from a handler of <see cref="advance"/>, it also drops the rest of the firing batch.
+    /// </summary>
+    inline void clear() noexcept
+    {
+        if (m_expiring != nullptr)
+        {
+            m_expiring->clear();
+        }
+        for (auto& level : m_slots)
+        {
+            for (auto& slot : level)
+            {
+                slot.clear();
+            }
+        }
+        for (auto& count : m_counts)
+        {
+            count = 0;
+        }
+        m_size = 0;
+    }
+
+private:
+    /// <summary>
+    /// Detaches the firing batch from the wheel, when advance() leaves the slot.
+    /// If a handler throws, the timers that did not fire yet are returned to the slot
+    /// of the next tick, so they stay armed and fire on the next call of advance().
+    /// </summary>
+    struct expiring_guard
+    {
+        timer_wheel& wheel;
+        list_type& expiring;
+
+        ~expiring_guard() noexcept
+        {
+            wheel.m_expiring = nullptr;
+            if (expiring.empty())
+            {
+                return;
+            }
+
+            auto slot = static_cast<uint8_t>((wheel.m_now + 1) & (slot_count - 1));
+            for (auto& timer : expiring)
+            {
+                static_cast<hook_type&>(timer).m_level = 0;
+                static_cast<hook_type&>(timer).m_slot = slot;
+            }
+            wheel.m_counts[0] += expiring.size();
+            wheel.m_slots[0][slot].splice_back(expiring);
+        }
+    };
+
+    /// <summary>
+    /// Links the timer to the slot of the level, that is selected
+    /// by the highest 6-bit group of the tick differing from the current one
+    /// </summary>
+    inline void place(intrusive_ptr<T> timer) noexcept
+    {
+        auto& hook = static_cast<hook_type&>(*timer);
+        auto difference = hook.m_expiry ^ m_now;
+        auto level = difference != 0
+            ? static_cast<unsigned>((std::bit_width(difference) - 1) / slot_bits)
+            : 0u;
+        if (level >= level_count)
+        {
+            level = level_count - 1;
+        }
+
+        hook.m_level = static_cast<uint8_t>(level);
+        hook.m_slot = static_cast<uint8_t>((hook.m_expiry >> (level * slot_bits)) & (slot_count - 1));
+        m_slots[level][hook.m_slot].push_back(std::move(timer));
+        ++m_counts[level];
+    }
+
+    /// <summary>
+    /// Moves the timers of the upper slots, whose ranges start at the current tick, to the lower levels
+    /// </summary>
+    inline void cascade() noexcept
+    {
+        auto level = 0u;
+        while (level + 1 < level_count && (m_now & ((uint64_t(1) << ((level + 1) * slot_bits)) - 1)) == 0)
+        {
+            ++level;
+        }
+
+        for (; level > 0; --level)
+        {
+            auto& slot = m_slots[level][(m_now >> (level * slot_bits)) & (slot_count - 1)];
+            auto moved = list_type();
+            m_counts[level] -= slot.size();
+            moved.splice_back(slot);
+            while (auto timer = moved.pop_front())
+            {
+                place(std::move(timer));
+            }
+        }
+    }
+
+private:
+    list_type m_slots[level_count][slot_count];
+    size_t m_counts[level_count] { };
+    list_type* m_expiring { nullptr };
+    uint64_t m_now;
+    size_t m_size { 0 };
+};
@@ -0,0 +1,197 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+#include <memory>
+#include <vector>
+#include "intrusive_ptr.h"
+
+/// <summary>
+/// A lock-free work-stealing deque of objects derived from <see cref="RefCountObject"/>
+/// (the Chase-Lev deque). The owner thread pushes and pops at the bottom in LIFO order,
+/// any other thread steals from the top in FIFO order.
+/// The deque keeps the raw pointers with the references transferred from the pushed pointers,
+/// so the objects move through it without any change of the reference count.
+/// The ring grows when it is full, the replaced rings are kept until the destruction,
+/// since a thief may still read them.
+/// </summary>
+/// <typeparam name="T">
+/// The type of the objects
+/// </typeparam>
+template<intrusive_counter_type T>
+class work_stealing_deque final
+{
+    static constexpr size_t cache_line_size = 64;
+
+    struct ring
+    {
+        explicit ring(size_t capacity)
+            : m_mask(capacity - 1)
+            , m_slots(std::make_unique<std::atomic<T*>[]>(capacity)) { }
+
+        inline T* get(int64_t index) const noexcept
+        {
+            return m_slots[static_cast<size_t>(index) & m_mask].load(std::memory_order_relaxed);
+        }
+
+        inline void put(int64_t index, T* object) noexcept
+        {
+            m_slots[static_cast<size_t>(index) & m_mask].store(object, std::memory_order_relaxed);
+        }
+
+        const size_t m_mask;
+        const std::unique_ptr<std::atomic<T*>[]> m_slots;
+    };
+
+public:
+    /// <summary>
+    /// Provides a new empty instance of <see cref="work_stealing_deque"/>
+    /// </summary>
+    /// <param name="capacity">
+    /// - The initial capacity of the ring, rounded up to a power of two
+    /// </param>
+    explicit work_stealing_deque(size_t capacity = 256)
+    {
+        auto size = size_t(2);
+        while (size < capacity)
+        {
+            size <<= 1;
+        }
+        m_rings.push_back(std::make_unique<ring>(size));
+        m_ring.store(m_rings.back().get(), std::memory_order_relaxed);
+    }
+
+    work_stealing_deque(const work_stealing_deque&) = delete;
+    work_stealing_deque& operator=(const work_stealing_deque&) = delete;
+
+    /// <summary>
+    /// Destroys a current instance of <see cref="work_stealing_deque"/>
+    /// and releases the references to all objects left in the deque.
+    /// No thread may use the deque concurrently with the destruction.
+    /// </summary>
+    ~work_stealing_deque()
+    {
+        while (auto object = pop())
+        {
+        }
+    }
+
+    /// <summary>
+    /// Pushes the object to the bottom. Must be called only from the owner thread.
+    /// </summary>
+    /// <param name="ptr">
+    /// - A pointer to the object. The reference is transferred to the deque,
+    /// the pointer keeps it, if the growth of the ring throws.
+    /// </param>
+    inline void push(intrusive_ptr<T>&& ptr)
+    {
+        auto bottom = m_bottom.load(std::memory_order_relaxed);
+        auto top = m_top.load(std::memory_order_acquire);
+        auto current = m_ring.load(std::memory_order_relaxed);
+        if (bottom - top > static_cast<int64_t>(current->m_mask))
+        {
+            current = grow(current, top, bottom);
+        }
+
+        current->put(bottom, ptr.detach());
+        m_bottom.store(bottom + 1, std::memory_order_release);
+    }
+
+    /// <summary>
+    /// Pushes a new reference to the object to the bottom. Must be called only from the owner thread.
+    /// </summary>
+    inline void push(const intrusive_ptr<T>& ptr)
+    {
+        push(intrusive_ptr<T>(ptr));
+    }
+
+    /// <summary>
+    /// Pops the object from the bottom. Must be called only from the owner thread.
+    /// </summary>
+    /// <returns>
+    /// A pointer to the object, that takes the reference held by the deque,
+    /// or an empty pointer, if the deque is empty
+    /// </returns>
+    inline intrusive_ptr<T> pop() noexcept
+    {
+        auto bottom = m_bottom.load(std::memory_order_relaxed) - 1;
+        auto current = m_ring.load(std::memory_order_relaxed);
+        m_bottom.store(bottom, std::memory_order_seq_cst);
+        auto top = m_top.load(std::memory_order_seq_cst);
+        if (top > bottom)
+        {
+            m_bottom.store(bottom + 1, std::memory_order_relaxed);
+            return intrusive_ptr<T>();
+        }
+
+        auto object = current->get(bottom);
+        if (top == bottom)
+        {
+            // The last object is raced for with the thieves
+            if (!m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+            {
+                object = nullptr;
+            }
+            m_bottom.store(bottom + 1, std::memory_order_relaxed);
+        }
+        return intrusive_ptr<T>(object, false);
+    }
+
+    /// <summary>
+    /// Steals the object from the top. Can be called from any number of threads concurrently.
+    /// </summary>
+    /// <returns>
+    /// A pointer to the object, that takes the reference held by the deque, or an empty pointer,
+    /// if the deque is empty or another thread has taken the top object concurrently
+    /// </returns>
+    inline intrusive_ptr<T> steal() noexcept
+    {
+        auto top = m_top.load(std::memory_order_seq_cst);
+        auto bottom = m_bottom.load(std::memory_order_seq_cst);
+        if (top >= bottom)
+        {
+            return intrusive_ptr<T>();
+        }
+
+        auto object = m_ring.load(std::memory_order_acquire)->get(top);
+        if (!m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+        {
+            return intrusive_ptr<T>();
+        }
+        return intrusive_ptr<T>(object, false);
+    }
+
+    /// <summary>
+    /// Returns the approximate number of objects in the deque
+    /// </summary>
+    inline size_t size() const noexcept
+    {
+        auto bottom = m_bottom.load(std::memory_order_relaxed);
+        auto top = m_top.load(std::memory_order_relaxed);
+        return bottom > top ? static_cast<size_t>(bottom - top) : 0;
+    }
+
+    inline bool empty() const noexcept
+    {
+        return size() == 0;
+    }
+
+private:
+    inline ring* grow(ring* current, int64_t top, int64_t bottom)
+    {
+        m_rings.push_back(std::make_unique<ring>((current->m_mask + 1) * 2));
+        auto replacement = m_rings.back().get();
+        for (auto index = top; index < bottom; ++index)
+        {
+            replacement->put(index, current->get(index));
+        }
+        m_ring.store(replacement, std::memory_order_release);
+        return replacement;
+    }
+
+private:
+    alignas(cache_line_size) std::atomic<int64_t> m_top { 0 };
+    alignas(cache_line_size) std::atomic<int64_t> m_bottom { 0 };
+    std::atomic<ring*> m_ring { nullptr };
+    std::vector<std::unique_ptr<ring>> m_rings;
+};
@@ -0,0 +1,241 @@
+#include <atomic>
+#include <thread>
+#include <vector>
+#include "CppUnitTest.h"
+#include "include/actor.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+struct Envelope : public RefCountObject<Envelope>, public intrusive_mpsc_hook<>
+{
+	Envelope(int value) : Value(value) { }
+	virtual ~Envelope() = default;
+
+	int Value;
+};
+
+class Counter final : public actor<Counter, Envelope>
+{
+public:
+	Counter(task_scheduler& scheduler, std::atomic<int>& destroyed, size_t batch_size = 64)
+		: actor(scheduler, batch_size), Destroyed(destroyed) { }
+
+	~Counter() override
+	{
+		Destroyed.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	void receive(intrusive_ptr<Envelope> message) noexcept
+	{
+		Sum += message->Value;
+		Received.push_back(message->Value);
+		if (Log != nullptr)
+		{
+			Log->push_back(message->Value);
+		}
+		Count.fetch_add(1, std::memory_order_release);
+	}
+
+	std::atomic<int>& Destroyed;
+	std::atomic<int> Count { 0 };
+	long long Sum { 0 };
+	std::vector<int> Received;
+	std::vector<int>* Log { nullptr };
+};
+
+class Player final : public actor<Player, Envelope>
+{
+public:
+	Player(task_scheduler& scheduler, std::atomic<bool>& finished)
+		: actor(scheduler), Finished(finished) { }
+
+	void receive(intrusive_ptr<Envelope> message) noexcept
+	{
+		if (message->Value == 0)
+		{
+			Finished.store(true, std::memory_order_release);
+			Finished.notify_all();
+			return;
+		}
+
+		// The ball is passed back without a new allocation
+		--message->Value;
+		Partner->send(std::move(message));
+	}
+
+	std::atomic<bool>& Finished;
+	Player* Partner { nullptr };
+};
+
+
+TEST_CLASS(ActorTests)
+{
+public:
+
+	TEST_METHOD(Send_ProcessesMessagesInOrder)
+	{
+		// Arrange
+		auto scheduler = task_scheduler(2);
+		auto destroyed = std::atomic<int>(0);
+		auto counter = intrusive_ptr<Counter>(new Counter(scheduler, destroyed));
+		auto message = make_intrusive<Envelope>(5);
+
+		// Act
+		counter->send(message);
+		for (auto i = 0; i < 99; ++i)
+		{
+			counter->send(make_intrusive<Envelope>(i));
+		}
+		scheduler.wait_idle();
+
+		// Assert
+		Assert::AreEqual(100, counter->Count.load(std::memory_order_acquire));
+		Assert::AreEqual(5ll + 99 * 98 / 2, counter->Sum);
+		Assert::AreEqual(5, counter->Received.front());
+		Assert::AreEqual(98, counter->Received.back());
+		Assert::AreEqual(1u, message.use_count());
+	}
+
+	TEST_METHOD(Send_IgnoresEmptyMessage)
+	{
+		// Arrange
+		auto scheduler = task_scheduler(1);
+		auto destroyed = std::atomic<int>(0);
+		auto counter = intrusive_ptr<Counter>(new Counter(scheduler, destroyed));
+
+		// Act
+		counter->send(intrusive_ptr<Envelope>());
+		counter->send(make_intrusive<Envelope>(3));
+		counter->send(intrusive_ptr<Envelope>());
+		scheduler.wait_idle();
+
+		// Assert
+		Assert::AreEqual(1, counter->Count.load(std::memory_order_acquire));
+		Assert::AreEqual(3ll, counter->Sum);
+		Assert::AreEqual(1u, counter.use_count());
+	}
+
+	TEST_METHOD(PendingMessages_KeepActorAlive)
+	{
+		// Arrange
+		auto destroyed = std::atomic<int>(0);
+		auto scheduler = task_scheduler(1);
+		auto started = std::atomic<bool>(false);
+		auto gate = std::atomic<bool>(false);
+		scheduler.submit(make_task([&]
+		{
+			started.store(true, std::memory_order_release);
+			started.notify_all();
+			gate.wait(false, std::memory_order_acquire);
+		}));
+		started.wait(false, std::memory_order_acquire);
+
+		// Act
+		intrusive_ptr<Counter>(new Counter(scheduler, destroyed))->send(make_intrusive<Envelope>(1));
+		auto destroyed_before = destroyed.load();
+		gate.store(true, std::memory_order_release);
+		gate.notify_all();
+		scheduler.wait_idle();
+
+		// Assert
+		Assert::AreEqual(0, destroyed_before);
+		Assert::AreEqual(1, destroyed.load());
+	}
+
+	TEST_METHOD(Batch_YieldsToOtherActors)
+	{
+		// Arrange
+		auto destroyed = std::atomic<int>(0);
+		auto scheduler = task_scheduler(1);
+		auto order = std::vector<int>();
+		auto first = intrusive_ptr<Counter>(new Counter(scheduler, destroyed, 2));
+		auto second = intrusive_ptr<Counter>(new Counter(scheduler, destroyed, 2));
+		first->Log = &order;
+		second->Log = &order;
+		auto started = std::atomic<bool>(false);
+		auto gate = std::atomic<bool>(false);
+		scheduler.submit(make_task([&]
+		{
+			started.store(true, std::memory_order_release);
+			started.notify_all();
+			gate.wait(false, std::memory_order_acquire);
+		}));
+		started.wait(false, std::memory_order_acquire);
+
+		// Act
+		for (auto i = 0; i < 6; ++i)
+		{
+			first->send(make_intrusive<Envelope>(100 + i));
+			second->send(make_intrusive<Envelope>(200 + i));
+		}
+		gate.store(true, std::memory_order_release);
+		gate.notify_all();
+		scheduler.wait_idle();
+
+		// Assert
+		auto expected = std::vector<int> { 100, 101, 200, 201, 102, 103, 202, 203, 104, 105, 204, 205 };
+		Assert::IsTrue(expected == order);
+	}
+
+	TEST_METHOD(PingPong_PassesMessageBetweenActors)
+	{
+		// Arrange
+		auto scheduler = task_scheduler(2);
+		auto finished = std::atomic<bool>(false);
+		auto ping = intrusive_ptr<Player>(new Player(scheduler, finished));
+		auto pong = intrusive_ptr<Player>(new Player(scheduler, finished));
+		ping->Partner = pong.get();
+		pong->Partner = ping.get();
+		auto ball = make_intrusive<Envelope>(10000);
+
+		// Act
+		ping->send(ball);
+		finished.wait(false, std::memory_order_acquire);
+		scheduler.wait_idle();
+
+		// Assert
+		Assert::AreEqual(0, ball->Value);
+		Assert::AreEqual(1u, ball.use_count());
+	}
+
+	TEST_METHOD(ManySenders_DeliverAllMessages)
+	{
+		// Arrange
+		constexpr auto actor_count = 16;
+		constexpr auto sender_count = 4;
+		constexpr auto message_count = 2000;
+		auto destroyed = std::atomic<int>(0);
+		auto scheduler = task_scheduler(4);
+		auto counters = std::vector<intrusive_ptr<Counter>>();
+		for (auto i = 0; i < actor_count; ++i)
+		{
+			counters.push_back(intrusive_ptr<Counter>(new Counter(scheduler, destroyed, 8)));
+		}
+
+		// Act
+		auto senders = std::vector<std::thread>();
+		for (auto s = 0; s < sender_count; ++s)
+		{
+			senders.emplace_back([&, s]
+			{
+				for (auto i = 0; i < message_count; ++i)
+				{
+					counters[(s + i) % actor_count]->send(make_intrusive<Envelope>(1));
+				}
+			});
+		}
+		for (auto& sender : senders)
+		{
+			sender.join();
+		}
+		scheduler.wait_idle();
+
+		// Assert
+		auto total = 0;
+		for (auto& counter : counters)
+		{
+			total += counter->Count.load(std::memory_order_acquire);
+		}
+		Assert::AreEqual(sender_count * message_count, total);
+	}
+};
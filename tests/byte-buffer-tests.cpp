@@ -0,0 +1,120 @@
+#include <cstddef>
+#include <string_view>
+#include <vector>
+#include "CppUnitTest.h"
+#include "include/byte_buffer.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+static std::span<const std::byte> AsBytes(std::string_view text)
+{
+	return std::as_bytes(std::span<const char>(text.data(), text.size()));
+}
+
+static std::string_view AsText(const byte_slice& slice)
+{
+	return std::string_view(reinterpret_cast<const char*>(slice.data()), slice.size());
+}
+
+
+TEST_CLASS(ByteBufferTests)
+{
+public:
+
+	TEST_METHOD(Slice_SharesBuffer)
+	{
+		// Arrange
+		auto message = byte_slice::copy_from(AsBytes("header:payload"));
+
+		// Act
+		auto header = message.slice(0, 6);
+		auto payload = message.slice(7);
+		auto clamped = message.slice(10, 100);
+
+		// Assert
+		Assert::IsTrue(AsText(header) == "header");
+		Assert::IsTrue(AsText(payload) == "payload");
+		Assert::IsTrue(AsText(clamped) == "load");
+		Assert::IsTrue(payload.data() == message.data() + 7);
+		Assert::AreEqual(4u, message.use_count());
+	}
+
+	TEST_METHOD(Split_DividesSlice)
+	{
+		// Arrange
+		auto rest = byte_slice::copy_from(AsBytes("one,two,three"));
+
+		// Act
+		auto first = rest.split_to(3);
+		rest.advance(1);
+		auto last = rest.split_off(3);
+		last.advance(1);
+
+		// Assert
+		Assert::IsTrue(AsText(first) == "one");
+		Assert::IsTrue(AsText(rest) == "two");
+		Assert::IsTrue(AsText(last) == "three");
+		Assert::IsTrue(first == byte_slice::copy_from(AsBytes("one")));
+	}
+
+	TEST_METHOD(Freeze_KeepsWritingIntoSameBuffer)
+	{
+		// Arrange
+		auto builder = byte_builder(64);
+		builder.append(AsBytes("first"));
+
+		// Act
+		auto first = builder.freeze();
+		builder.append(AsBytes("second"));
+		auto second = builder.freeze();
+
+		// Assert
+		Assert::IsTrue(AsText(first) == "first");
+		Assert::IsTrue(AsText(second) == "second");
+		Assert::IsTrue(second.data() == first.data() + 5);
+		Assert::AreEqual(size_t(53), builder.capacity());
+		Assert::IsTrue(builder.empty());
+	}
+
+	TEST_METHOD(Reserve_ReusesReleasedBuffer)
+	{
+		// Arrange
+		auto builder = byte_builder(16);
+		builder.append(AsBytes("0123456789"));
+		auto buffer = builder.freeze().data();
+		builder.append(AsBytes("abc"));
+
+		// Act
+		builder.append(AsBytes("defghi"));
+		auto reused = builder.freeze();
+		builder.append(AsBytes("0123456789abcdef"));
+		auto grown = builder.freeze();
+
+		// Assert
+		Assert::IsTrue(reused.data() == buffer);
+		Assert::IsTrue(AsText(reused) == "abcdefghi");
+		Assert::IsTrue(grown.data() != buffer);
+		Assert::IsTrue(AsText(grown) == "0123456789abcdef");
+	}
+
+	TEST_METHOD(TryReclaim_RequiresUniqueOwner)
+	{
+		// Arrange
+		auto builder = byte_builder(32);
+		builder.append(AsBytes("message"));
+		auto message = builder.freeze();
+		builder = byte_builder();
+		auto field = message.slice(0, 3);
+
+		// Act
+		auto shared = message.try_reclaim();
+		field = byte_slice();
+		auto reclaimed = message.try_reclaim();
+
+		// Assert
+		Assert::IsFalse(shared.has_value());
+		Assert::IsTrue(reclaimed.has_value());
+		Assert::AreEqual(size_t(32), reclaimed->capacity());
+		Assert::IsTrue(message.empty());
+	}
+};
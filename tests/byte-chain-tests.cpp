@@ -0,0 +1,194 @@
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include "CppUnitTest.h"
+#include "include/byte_chain.h"
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+static byte_slice ChainSlice(std::string_view text)
+{
+	return byte_slice::copy_from(std::as_bytes(std::span<const char>(text.data(), text.size())));
+}
+
+static std::string ChainText(const byte_chain& chain)
+{
+	auto text = std::string(chain.size(), '\0');
+	chain.copy_to(std::as_writable_bytes(std::span<char>(text.data(), text.size())));
+	return text;
+}
+
+
+TEST_CLASS(ByteChainTests)
+{
+public:
+
+	TEST_METHOD(AppendAndPrepend_KeepOrder)
+	{
+		// Arrange
+		auto chain = byte_chain();
+		auto tail = byte_chain();
+		tail.append(ChainSlice("tail"));
+
+		// Act
+		chain.append(ChainSlice("body,"));
+		chain.prepend(ChainSlice("head,"));
+		chain.append(std::move(tail));
+		chain.append(byte_slice());
+
+		// Assert
+		Assert::AreEqual(std::string("head,body,tail"), ChainText(chain));
+		Assert::AreEqual(size_t(3), chain.slice_count());
+		Assert::IsTrue(tail.empty());
+	}
+
+	TEST_METHOD(Consume_ReleasesConsumedSlices)
+	{
+		// Arrange
+		auto chain = byte_chain();
+		auto first = ChainSlice("first");
+		chain.append(first);
+		chain.append(ChainSlice("second"));
+		auto shared_before = first.use_count();
+
+		// Act
+		chain.consume(7);
+
+		// Assert
+		Assert::AreEqual(2u, shared_before);
+		Assert::AreEqual(1u, first.use_count());
+		Assert::AreEqual(std::string("cond"), ChainText(chain));
+		Assert::AreEqual(size_t(1), chain.slice_count());
+	}
+
+	TEST_METHOD(SplitTo_SplitsBoundarySlice)
+	{
+		// Arrange
+		auto chain = byte_chain();
+		chain.append(ChainSlice("abc"));
+		chain.append(ChainSlice("defg"));
+		chain.append(ChainSlice("hi"));
+
+		// Act
+		auto front = chain.split_to(5);
+
+		// Assert
+		Assert::AreEqual(std::string("abcde"), ChainText(front));
+		Assert::AreEqual(std::string("fghi"), ChainText(chain));
+		Assert::AreEqual(size_t(2), front.slice_count());
+		Assert::AreEqual(size_t(2), chain.slice_count());
+	}
+
+	TEST_METHOD(Gather_ExportsSlicesWithoutCopying)
+	{
+		// Arrange
+		auto chain = byte_chain();
+		auto first = ChainSlice("first");
+		auto second = ChainSlice("second");
+		chain.append(first);
+		chain.append(second);
+		byte_chain::io_vector vectors[4];
+
+		// Act
+		auto count = chain.gather(vectors);
+
+		// Assert
+		Assert::AreEqual(size_t(2), count);
+#if defined(_WIN32)
+		Assert::IsTrue(reinterpret_cast<const std::byte*>(vectors[1].buf) == second.data());
+		Assert::AreEqual(ULONG(6), vectors[1].len);
+#else
+		Assert::IsTrue(vectors[1].iov_base == second.data());
+		Assert::AreEqual(size_t(6), vectors[1].iov_len);
+#endif
+	}
+
+	TEST_METHOD(BufferPool_ReusesReleasedBuffers)
+	{
+		// Arrange
+		auto pool = byte_buffer_pool(64, 2);
+		auto first = pool.acquire();
+		auto second = pool.acquire();
+		auto first_buffer = first.get();
+
+		// Act
+		auto third = pool.acquire();
+		first = nullptr;
+		auto reused = pool.acquire();
+
+		// Assert
+		Assert::AreEqual(size_t(2), pool.size());
+		Assert::IsTrue(third.get() != first_buffer);
+		Assert::IsTrue(reused.get() == first_buffer);
+	}
+
+#if !defined(_WIN32)
+	TEST_METHOD(Pipe_ForwardsChain)
+	{
+		// Arrange
+		int fds[2];
+		Assert::AreEqual(0, ::pipe(fds));
+		::fcntl(fds[0], F_SETFL, O_NONBLOCK);
+		auto pool = byte_buffer_pool(4);
+		auto output = byte_chain();
+		output.append(ChainSlice("scatter/"));
+		output.append(ChainSlice("gather"));
+		auto input = byte_chain();
+
+		// Act
+		auto empty = input.read_from(fds[0], pool, 16);
+		auto written = output.write_to(fds[1]);
+		auto received = input.read_from(fds[0], pool, 10);
+		auto rest = input.read_from(fds[0], pool, 10);
+		::close(fds[1]);
+		auto end = input.read_from(fds[0], pool, 10);
+		::close(fds[0]);
+
+		// Assert
+		Assert::IsFalse(empty.has_value());
+		Assert::AreEqual(size_t(14), *written);
+		Assert::IsTrue(output.empty());
+		Assert::AreEqual(size_t(10), *received);
+		Assert::AreEqual(size_t(4), *rest);
+		Assert::AreEqual(size_t(0), *end);
+		Assert::AreEqual(std::string("scatter/gather"), ChainText(input));
+		Assert::AreEqual(size_t(4), input.slice_count());
+	}
+
+	TEST_METHOD(ReadFrom_HandlesExtremeSizes)
+	{
+		// Arrange
+		int fds[2];
+		Assert::AreEqual(0, ::pipe(fds));
+		auto pool = byte_buffer_pool(4);
+		auto output = byte_chain();
+		output.append(ChainSlice("unbounded"));
+		auto input = byte_chain();
+		auto thrown = false;
+
+		// Act
+		try
+		{
+			input.read_from(fds[0], pool, 0);
+		}
+		catch (const std::invalid_argument&)
+		{
+			thrown = true;
+		}
+		output.write_to(fds[1]);
+		auto received = input.read_from(fds[0], pool, SIZE_MAX);
+		::close(fds[1]);
+		::close(fds[0]);
+
+		// Assert
+		Assert::IsTrue(thrown);
+		Assert::AreEqual(size_t(9), *received);
+		Assert::AreEqual(std::string("unbounded"), ChainText(input));
+	}
+#endif
+};
@@ -0,0 +1,315 @@
+#include <atomic>
+#include <functional>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include "CppUnitTest.h"
+#include "include/concurrent_hash_map.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+struct Registered : public RefCountObject<Registered>
+{
+	Registered(int value) : Value(value) { ++Alive; }
+	virtual ~Registered() { --Alive; }
+
+	int Value;
+	static inline std::atomic<int> Alive { 0 };
+};
+
+struct Unregistering : public RefCountObject<Unregistering>
+{
+	Unregistering(int value) : Value(value) { }
+	virtual ~Unregistering() { if (Released) Released(Value); }
+
+	int Value;
+	static inline std::function<void(int)> Released;
+};
+
+struct ThrowingKey
+{
+	ThrowingKey(int value) : Value(value) { }
+	ThrowingKey(const ThrowingKey& other) : Value(other.Value)
+	{
+		if (Failing)
+		{
+			throw std::runtime_error("copy failed");
+		}
+	}
+
+	bool operator==(const ThrowingKey& other) const noexcept { return Value == other.Value; }
+
+	int Value;
+	static inline bool Failing { false };
+};
+
+struct ThrowingKeyHash
+{
+	size_t operator()(const ThrowingKey& key) const noexcept { return static_cast<size_t>(key.Value); }
+};
+
+
+TEST_CLASS(ConcurrentHashMapTests)
+{
+public:
+
+	TEST_METHOD(InsertFindErase_Success)
+	{
+		// Arrange
+		auto map = concurrent_hash_map<std::string, Registered>(4);
+
+		// Act
+		for (auto i = 0; i < 1000; ++i)
+		{
+			map.insert(std::to_string(i), make_intrusive<Registered>(i));
+		}
+		auto duplicate = map.insert("10", make_intrusive<Registered>(-1));
+		auto removed = map.erase("10");
+		auto missing = map.erase("1000");
+
+		// Assert
+		Assert::IsFalse(duplicate);
+		Assert::AreEqual(10, removed->Value);
+		Assert::IsNull(missing.get());
+		Assert::AreEqual(size_t(999), map.size());
+		Assert::AreEqual(999, map.find("999")->Value);
+		Assert::IsNull(map.find("10").get());
+		Assert::IsTrue(map.contains("0"));
+	}
+
+	TEST_METHOD(InsertOrAssign_ReplacesValue)
+	{
+		// Arrange
+		auto map = concurrent_hash_map<int, Registered>();
+		map.insert(1, make_intrusive<Registered>(1));
+		auto held = map.find(1);
+
+		// Act
+		auto inserted = map.insert_or_assign(1, make_intrusive<Registered>(100));
+		epoch_domain::instance().flush();
+
+		// Assert
+		Assert::IsFalse(inserted);
+		Assert::AreEqual(100, map.find(1)->Value);
+		Assert::AreEqual(1, held->Value);
+		Assert::AreEqual(1u, held.use_count());
+	}
+
+	TEST_METHOD(Insert_RejectsEmptyValue)
+	{
+		// Arrange
+		auto map = concurrent_hash_map<int, Registered>();
+		map.insert(1, make_intrusive<Registered>(1));
+
+		// Act
+		auto inserted = map.insert(2, intrusive_ptr<Registered>());
+		auto assigned = map.insert_or_assign(1, intrusive_ptr<Registered>());
+		for (auto i = 3; i < 1000; ++i)
+		{
+			map.insert(i, make_intrusive<Registered>(i));
+		}
+
+		// Assert
+		Assert::IsFalse(inserted);
+		Assert::IsFalse(assigned);
+		Assert::IsFalse(map.contains(2));
+		Assert::AreEqual(1, map.find(1)->Value);
+		Assert::AreEqual(size_t(998), map.size());
+	}
+
+	TEST_METHOD(ReleasedValue_CanChangeMap)
+	{
+		// Arrange
+		auto& domain = epoch_domain::instance();
+		domain.flush();
+		auto map = concurrent_hash_map<int, Unregistering>(1);
+		auto released = 0;
+		Unregistering::Released = [&](int value)
+		{
+			if (value >= 0)
+			{
+				++released;
+				map.erase(-value - 1);
+			}
+		};
+
+		// Act
+		for (auto i = 0; i < 1000; ++i)
+		{
+			map.insert(-i - 1, make_intrusive<Unregistering>(-1));
+			map.insert_or_assign(0, make_intrusive<Unregistering>(i));
+		}
+		map.erase(0);
+		domain.flush();
+		auto size = map.size();
+		Unregistering::Released = nullptr;
+
+		// Assert
+		Assert::AreEqual(1000, released);
+		Assert::AreEqual(size_t(0), size);
+	}
+
+	TEST_METHOD(Visit_BorrowsValue)
+	{
+		// Arrange
+		auto map = concurrent_hash_map<int, Registered>();
+		auto value = make_intrusive<Registered>(7);
+		map.insert(7, value);
+		auto count = 0u;
+
+		// Act
+		auto found = map.visit(7, [&](Registered&) { count = value.use_count(); });
+		auto missing = map.visit(8, [&](Registered&) { count = 0; });
+
+		// Assert
+		Assert::IsTrue(found);
+		Assert::IsFalse(missing);
+		Assert::AreEqual(2u, count);
+	}
+
+	TEST_METHOD(Growth_KeepsAllEntries)
+	{
+		// Arrange
+		auto& domain = epoch_domain::instance();
+		domain.flush();
+		auto alive = Registered::Alive.load();
+		auto count = 0;
+
+		// Act
+		{
+			auto map = concurrent_hash_map<int, Registered>(2);
+			for (auto i = 0; i < 20000; ++i)
+			{
+				map.insert(i, make_intrusive<Registered>(i));
+			}
+			for (auto i = 0; i < 20000; i += 2)
+			{
+				map.erase(i);
+			}
+			map.for_each([&](int key, Registered& item)
+			{
+				count += key == item.Value && key % 2 == 1 ? 1 : 0;
+			});
+			for (auto i = 1; i < 20000; i += 2)
+			{
+				Assert::AreEqual(i, map.find(i)->Value);
+			}
+		}
+		domain.flush();
+
+		// Assert
+		Assert::AreEqual(10000, count);
+		Assert::AreEqual(alive, Registered::Alive.load());
+	}
+
+	TEST_METHOD(ThrowingKeyCopy_LeavesMapUnchanged)
+	{
+		// Arrange
+		auto map = concurrent_hash_map<ThrowingKey, Registered, ThrowingKeyHash>(1);
+		for (auto i = 0; i < 17; ++i)
+		{
+			map.insert(ThrowingKey(i), make_intrusive<Registered>(i));
+		}
+		auto value = make_intrusive<Registered>(100);
+		auto migration_thrown = false;
+		auto insert_thrown = false;
+
+		// Act
+		ThrowingKey::Failing = true;
+		try
+		{
+			map.insert(ThrowingKey(100), value);
+		}
+		catch (const std::runtime_error&)
+		{
+			migration_thrown = true;
+		}
+		ThrowingKey::Failing = false;
+		for (auto i = 0; i < 8; ++i)
+		{
+			// Every write moves a few buckets, so the growth finishes before the next insert
+			map.erase(ThrowingKey(1000 + i));
+		}
+		ThrowingKey::Failing = true;
+		try
+		{
+			map.insert(ThrowingKey(100), value);
+		}
+		catch (const std::runtime_error&)
+		{
+			insert_thrown = true;
+		}
+		ThrowingKey::Failing = false;
+
+		// Assert
+		Assert::IsTrue(migration_thrown);
+		Assert::IsTrue(insert_thrown);
+		Assert::AreEqual(1u, value.use_count());
+		Assert::AreEqual(size_t(17), map.size());
+		for (auto i = 0; i < 17; ++i)
+		{
+			Assert::AreEqual(i, map.find(ThrowingKey(i))->Value);
+		}
+		Assert::IsTrue(map.insert(ThrowingKey(100), value));
+		Assert::AreEqual(2u, value.use_count());
+	}
+
+	TEST_METHOD(ConcurrentReadsDuringWrites_Success)
+	{
+		// Arrange
+		const auto writers = 4;
+		const auto count = 5000;
+		auto map = concurrent_hash_map<int, Registered>(4);
+		for (auto i = 0; i < 1000; ++i)
+		{
+			map.insert(-1 - i, make_intrusive<Registered>(-1 - i));
+		}
+		auto done = std::atomic<bool>(false);
+		auto misses = std::atomic<int>(0);
+		auto threads = std::vector<std::thread>();
+
+		// Act
+		for (auto r = 0; r < 2; ++r)
+		{
+			threads.emplace_back([&]()
+			{
+				while (!done)
+				{
+					for (auto i = 0; i < 1000; ++i)
+					{
+						auto found = map.find(-1 - i);
+						misses += !found || found->Value != -1 - i ? 1 : 0;
+					}
+				}
+			});
+		}
+		for (auto w = 0; w < writers; ++w)
+		{
+			threads.emplace_back([&map, w]()
+			{
+				for (auto i = 0; i < count; ++i)
+				{
+					auto key = i * writers + w;
+					map.insert(key, make_intrusive<Registered>(key));
+					map.insert_or_assign(key, make_intrusive<Registered>(key));
+					if (i % 2 == 1)
+					{
+						map.erase(key - writers);
+					}
+				}
+			});
+		}
+		for (auto w = 0; w < writers; ++w)
+		{
+			threads[2 + w].join();
+		}
+		done = true;
+		threads[0].join();
+		threads[1].join();
+
+		// Assert
+		Assert::AreEqual(0, misses.load());
+		Assert::AreEqual(size_t(1000 + writers * count / 2), map.size());
+	}
+};
@@ -0,0 +1,183 @@
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+#include "CppUnitTest.h"
+#include "include/concurrent_skip_list.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+struct SkipItem : public RefCountObject<SkipItem>
+{
+	SkipItem(int value) : Value(value) { ++Alive; }
+	virtual ~SkipItem() { --Alive; }
+
+	int Value;
+	static inline std::atomic<int> Alive { 0 };
+};
+
+
+TEST_CLASS(ConcurrentSkipListTests)
+{
+public:
+
+	TEST_METHOD(InsertFindErase_Success)
+	{
+		// Arrange
+		auto list = concurrent_skip_list<int, SkipItem>();
+
+		// Act
+		for (auto i = 0; i < 1000; ++i)
+		{
+			list.insert(i * 2, make_intrusive<SkipItem>(i));
+		}
+		auto duplicate = list.insert(10, make_intrusive<SkipItem>(-1));
+		auto removed = list.erase(10);
+		auto missing = list.erase(11);
+
+		// Assert
+		Assert::IsFalse(duplicate);
+		Assert::AreEqual(5, removed->Value);
+		Assert::IsNull(missing.get());
+		Assert::AreEqual(size_t(999), list.size());
+		Assert::AreEqual(7, list.find(14)->Value);
+		Assert::IsNull(list.find(10).get());
+		Assert::IsFalse(list.contains(15));
+	}
+
+	TEST_METHOD(Insert_RejectsEmptyValue)
+	{
+		// Arrange
+		auto list = concurrent_skip_list<int, SkipItem>();
+		list.insert(1, make_intrusive<SkipItem>(1));
+		auto visited = 0;
+
+		// Act
+		auto inserted = list.insert(2, intrusive_ptr<SkipItem>());
+		list.for_each_range(0, 10, [&](int, SkipItem& item) { visited += item.Value; });
+
+		// Assert
+		Assert::IsFalse(inserted);
+		Assert::IsFalse(list.contains(2));
+		Assert::AreEqual(size_t(1), list.size());
+		Assert::AreEqual(1, visited);
+	}
+
+	TEST_METHOD(Iterators_VisitKeysInOrder)
+	{
+		// Arrange
+		auto list = concurrent_skip_list<std::string, SkipItem>();
+		for (auto i = 9; i >= 0; --i)
+		{
+			list.insert("key" + std::to_string(i), make_intrusive<SkipItem>(i));
+		}
+		list.erase("key3");
+
+		// Act
+		auto all = std::vector<int>();
+		for (auto it = list.begin(); it != list.end(); ++it)
+		{
+			all.push_back(it.value()->Value);
+		}
+		auto range = std::vector<int>();
+		list.for_each_range("key2", "key6", [&](const std::string&, SkipItem& item)
+		{
+			range.push_back(item.Value);
+		});
+		auto from = list.lower_bound("key35");
+
+		// Assert
+		Assert::AreEqual(size_t(9), all.size());
+		Assert::AreEqual(0, all.front());
+		Assert::AreEqual(9, all.back());
+		Assert::AreEqual(size_t(3), range.size());
+		Assert::AreEqual(2, range[0]);
+		Assert::AreEqual(4, range[1]);
+		Assert::AreEqual(std::string("key4"), from.key());
+	}
+
+	TEST_METHOD(ErasedValue_IsReleasedAfterReaders)
+	{
+		// Arrange
+		auto& domain = epoch_domain::instance();
+		domain.flush();
+		auto alive = SkipItem::Alive.load();
+		auto list = concurrent_skip_list<int, SkipItem>();
+		list.insert(1, make_intrusive<SkipItem>(1));
+		list.insert(2, make_intrusive<SkipItem>(2));
+
+		// Act
+		auto held = list.find(1);
+		list.erase(1);
+		list.erase(2);
+		list.flush();
+
+		// Assert
+		Assert::AreEqual(alive + 1, SkipItem::Alive.load());
+		Assert::AreEqual(1u, held.use_count());
+		Assert::IsTrue(list.empty());
+	}
+
+	TEST_METHOD(ConcurrentInsertEraseAndScan_Success)
+	{
+		// Arrange
+		const auto writers = 4;
+		const auto count = 5000;
+		auto list = concurrent_skip_list<int, SkipItem>();
+		auto done = std::atomic<bool>(false);
+		auto unordered = std::atomic<int>(0);
+		auto threads = std::vector<std::thread>();
+
+		// Act
+		auto reader = std::thread([&]()
+		{
+			while (!done)
+			{
+				auto previous = -1;
+				for (auto it = list.begin(); it != list.end(); ++it)
+				{
+					if (it.key() <= previous || it.value()->Value != it.key())
+					{
+						++unordered;
+					}
+					previous = it.key();
+				}
+			}
+		});
+		for (auto w = 0; w < writers; ++w)
+		{
+			threads.emplace_back([&list, w]()
+			{
+				for (auto i = 0; i < count; ++i)
+				{
+					auto key = i * writers + w;
+					list.insert(key, make_intrusive<SkipItem>(key));
+					if (i % 2 == 1)
+					{
+						list.erase(key - writers);
+					}
+				}
+			});
+		}
+		for (auto& thread : threads)
+		{
+			thread.join();
+		}
+		done = true;
+		reader.join();
+
+		// Assert
+		Assert::AreEqual(0, unordered.load());
+		Assert::AreEqual(size_t(writers * count / 2), list.size());
+		auto expected = 0;
+		for (auto it = list.begin(); it != list.end(); ++it)
+		{
+			while (expected / writers % 2 == 0)
+			{
+				++expected;
+			}
+			Assert::AreEqual(expected, it.key());
+			++expected;
+		}
+	}
+};
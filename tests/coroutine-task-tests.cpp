@@ -0,0 +1,188 @@
+#include <atomic>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include "CppUnitTest.h"
+#include "include/coroutine_task.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+struct FrameGuard
+{
+	FrameGuard(std::atomic<int>& destroyed) : Destroyed(&destroyed) { }
+	FrameGuard(FrameGuard&& other) noexcept : Destroyed(std::exchange(other.Destroyed, nullptr)) { }
+
+	~FrameGuard()
+	{
+		if (Destroyed != nullptr)
+		{
+			Destroyed->fetch_add(1, std::memory_order_relaxed);
+		}
+	}
+
+	std::atomic<int>* Destroyed;
+};
+
+struct resume_on_new_thread
+{
+	bool await_ready() const noexcept
+	{
+		return false;
+	}
+
+	void await_suspend(std::coroutine_handle<> awaiting)
+	{
+		std::thread([awaiting] { awaiting.resume(); }).detach();
+	}
+
+	void await_resume() const noexcept { }
+};
+
+static task<int> Leaf(int value)
+{
+	co_return value;
+}
+
+static task<long long> SumLeaves(int count)
+{
+	auto sum = 0ll;
+	for (auto i = 0; i < count; ++i)
+	{
+		sum += co_await Leaf(i);
+	}
+	co_return sum;
+}
+
+static task<std::string> Throwing()
+{
+	throw std::runtime_error("failed");
+	co_return std::string();
+}
+
+static task<> Guarded([[maybe_unused]] FrameGuard guard, bool& started)
+{
+	started = true;
+	co_return;
+}
+
+static task<std::thread::id> SwitchThread()
+{
+	co_await resume_on_new_thread();
+	co_return std::this_thread::get_id();
+}
+
+static shared_task<int> Shared(std::atomic<int>& runs)
+{
+	runs.fetch_add(1, std::memory_order_relaxed);
+	co_await resume_on_new_thread();
+	co_return 42;
+}
+
+static task<int> AwaitShared(shared_task<int> shared)
+{
+	co_return co_await shared + co_await shared;
+}
+
+
+TEST_CLASS(CoroutineTaskTests)
+{
+public:
+
+	TEST_METHOD(SyncWait_ReturnsResultOfNestedTasks)
+	{
+		// Act
+		auto sum = sync_wait(SumLeaves(1000));
+
+		// Assert
+		Assert::AreEqual(1000ll * 999 / 2, sum);
+	}
+
+	TEST_METHOD(SyncWait_RethrowsException)
+	{
+		// Arrange
+		auto thrown = false;
+
+		// Act
+		try
+		{
+			sync_wait(Throwing());
+		}
+		catch (const std::runtime_error&)
+		{
+			thrown = true;
+		}
+
+		// Assert
+		Assert::IsTrue(thrown);
+	}
+
+	TEST_METHOD(LastReference_DestroysFrame)
+	{
+		// Arrange
+		auto destroyed = std::atomic<int>(0);
+		auto started = false;
+		auto created = Guarded(FrameGuard(destroyed), started);
+		auto destroyed_before = destroyed.load();
+
+		// Act
+		created = task<>();
+
+		// Assert
+		Assert::AreEqual(0, destroyed_before);
+		Assert::AreEqual(1, destroyed.load());
+		Assert::IsFalse(started);
+	}
+
+	TEST_METHOD(FramePool_RecyclesFrames)
+	{
+		// Arrange
+		auto first = coroutine_frame_pool::allocate(100);
+		coroutine_frame_pool::deallocate(first, 100);
+
+		// Act
+		auto second = coroutine_frame_pool::allocate(120);
+		coroutine_frame_pool::deallocate(second, 120);
+
+		// Assert
+		Assert::IsTrue(first == second);
+	}
+
+	TEST_METHOD(Await_ResumesOnAnotherThread)
+	{
+		// Act
+		auto resumed_on = sync_wait(SwitchThread());
+
+		// Assert
+		Assert::IsTrue(resumed_on != std::this_thread::get_id());
+	}
+
+	TEST_METHOD(SharedTask_RunsOnceForAllAwaiters)
+	{
+		// Arrange
+		auto runs = std::atomic<int>(0);
+		auto shared = Shared(runs);
+		auto results = std::vector<int>(4);
+		auto threads = std::vector<std::thread>();
+
+		// Act
+		for (auto i = 0; i < 4; ++i)
+		{
+			threads.emplace_back([&, i] { results[i] = sync_wait(AwaitShared(shared)); });
+		}
+		for (auto& thread : threads)
+		{
+			thread.join();
+		}
+		auto again = sync_wait(shared);
+
+		// Assert
+		Assert::AreEqual(1, runs.load());
+		for (auto result : results)
+		{
+			Assert::AreEqual(84, result);
+		}
+		Assert::AreEqual(42, again);
+		Assert::IsTrue(shared.is_ready());
+	}
+};
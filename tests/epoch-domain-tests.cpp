@@ -0,0 +1,113 @@
+#include <atomic>
+#include <thread>
+#include "CppUnitTest.h"
+#include "include/epoch_domain.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+struct EpochItem : public RefCountObject<EpochItem>
+{
+	EpochItem(std::atomic<int>& destroyed) : Destroyed(destroyed) { }
+	virtual ~EpochItem() { ++Destroyed; }
+
+	std::atomic<int>& Destroyed;
+};
+
+
+TEST_CLASS(EpochDomainTests)
+{
+public:
+
+	TEST_METHOD(Retire_ReleasesAfterFlush)
+	{
+		// Arrange
+		auto destroyed = std::atomic<int>(0);
+		auto ptr = make_intrusive<EpochItem>(std::ref(destroyed));
+		auto& domain = epoch_domain::instance();
+
+		// Act
+		domain.retire(ptr.detach());
+		domain.flush();
+
+		// Assert
+		Assert::AreEqual(1, destroyed.load());
+	}
+
+	TEST_METHOD(Retire_ReleasesAfterNextUnpin)
+	{
+		// Arrange
+		auto destroyed = std::atomic<int>(0);
+		auto& domain = epoch_domain::instance();
+		domain.flush();
+
+		// Act
+		{
+			auto guard = domain.pin();
+			domain.retire(make_intrusive<EpochItem>(std::ref(destroyed)).detach());
+		}
+		{
+			auto guard = domain.pin();
+		}
+
+		// Assert
+		Assert::AreEqual(1, destroyed.load());
+	}
+
+	TEST_METHOD(Retire_IsDelayedByPinnedThread)
+	{
+		// Arrange
+		auto destroyed = std::atomic<int>(0);
+		auto pinned = std::atomic<bool>(false);
+		auto release = std::atomic<bool>(false);
+		auto& domain = epoch_domain::instance();
+		auto reader = std::thread([&]()
+		{
+			auto guard = domain.pin();
+			pinned = true;
+			while (!release)
+			{
+				std::this_thread::yield();
+			}
+		});
+		while (!pinned)
+		{
+			std::this_thread::yield();
+		}
+
+		// Act
+		domain.retire(make_intrusive<EpochItem>(std::ref(destroyed)).detach());
+		domain.flush();
+		auto destroyed_while_pinned = destroyed.load();
+		release = true;
+		reader.join();
+		domain.flush();
+
+		// Assert
+		Assert::AreEqual(0, destroyed_while_pinned);
+		Assert::AreEqual(1, destroyed.load());
+	}
+
+	TEST_METHOD(NestedGuards_KeepThreadPinned)
+	{
+		// Arrange
+		auto destroyed = std::atomic<int>(0);
+		auto& domain = epoch_domain::instance();
+		auto destroyed_while_pinned = 0;
+
+		// Act
+		{
+			auto outer = domain.pin();
+			{
+				auto inner = domain.pin();
+				domain.retire(make_intrusive<EpochItem>(std::ref(destroyed)).detach());
+			}
+			domain.flush();
+			destroyed_while_pinned = destroyed.load();
+		}
+		domain.flush();
+
+		// Assert
+		Assert::AreEqual(0, destroyed_while_pinned);
+		Assert::AreEqual(1, destroyed.load());
+	}
+};
@@ -0,0 +1,265 @@
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include "CppUnitTest.h"
+#include "include/intrusive_cache.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+struct CachedItem : public RefCountObject<CachedItem>, public intrusive_cache_hook<>
+{
+	CachedItem(int key) : Key(key) { }
+	virtual ~CachedItem() = default;
+
+	inline const int& key() const noexcept { return Key; }
+
+	int Key;
+};
+
+struct ReentrantItem : public RefCountObject<ReentrantItem>, public intrusive_cache_hook<>
+{
+	ReentrantItem(int key, sharded_cache<int, ReentrantItem>* cache) : Key(key), Cache(cache) { }
+
+	~ReentrantItem()
+	{
+		// Looks up the shard, that released the item
+		Cache->find(Key);
+	}
+
+	inline const int& key() const noexcept { return Key; }
+
+	int Key;
+	sharded_cache<int, ReentrantItem>* Cache;
+};
+
+TEST_CLASS(IntrusiveCacheTests)
+{
+public:
+
+	TEST_METHOD(Lru_EvictsLeastRecentlyUsed)
+	{
+		// Arrange
+		auto cache = intrusive_cache<int, CachedItem>(3);
+		auto first = make_intrusive<CachedItem>(1);
+		cache.insert(first);
+		cache.insert(make_intrusive<CachedItem>(2));
+		cache.insert(make_intrusive<CachedItem>(3));
+
+		// Act
+		auto touched = cache.find(1);
+		auto duplicate = cache.insert(make_intrusive<CachedItem>(1));
+		cache.insert(make_intrusive<CachedItem>(4));
+
+		// Assert
+		Assert::IsTrue(touched == first);
+		Assert::IsFalse(duplicate);
+		Assert::AreEqual(size_t(3), cache.size());
+		Assert::IsTrue(cache.contains(1));
+		Assert::IsFalse(cache.contains(2));
+		Assert::IsTrue(cache.contains(3));
+		Assert::IsTrue(cache.contains(4));
+	}
+
+	TEST_METHOD(Eviction_ReleasesCacheReference)
+	{
+		// Arrange
+		auto cache = intrusive_cache<int, CachedItem>(1);
+		auto first = make_intrusive<CachedItem>(1);
+		cache.insert(first);
+		auto cached_count = first.use_count();
+
+		// Act
+		cache.insert(make_intrusive<CachedItem>(2));
+		auto removed = cache.erase(2);
+
+		// Assert
+		Assert::AreEqual(2u, cached_count);
+		Assert::AreEqual(1u, first.use_count());
+		Assert::AreEqual(1u, removed.use_count());
+		Assert::IsTrue(cache.empty());
+	}
+
+	TEST_METHOD(PinAware_SkipsReferencedEntries)
+	{
+		// Arrange
+		auto cache = intrusive_cache<int, CachedItem, pin_aware_policy<lru_policy>>(2);
+		auto pinned = make_intrusive<CachedItem>(1);
+		cache.insert(pinned);
+		cache.insert(make_intrusive<CachedItem>(2));
+
+		// Act
+		cache.insert(make_intrusive<CachedItem>(3));
+		auto size_with_pin = cache.size();
+		pinned = intrusive_ptr<CachedItem>();
+		auto held = cache.find(3);
+		cache.insert(make_intrusive<CachedItem>(4));
+
+		// Assert
+		Assert::AreEqual(size_t(2), size_with_pin);
+		Assert::IsFalse(cache.contains(1));
+		Assert::IsTrue(cache.contains(3));
+		Assert::IsTrue(cache.contains(4));
+		Assert::IsFalse(cache.contains(2));
+	}
+
+	TEST_METHOD(PinAware_ExceedsCapacityWhenAllPinned)
+	{
+		// Arrange
+		auto cache = intrusive_cache<int, CachedItem, pin_aware_policy<two_queue_policy>>(2);
+		auto pins = std::vector<intrusive_ptr<CachedItem>>();
+
+		// Act
+		for (auto i = 0; i < 20; ++i)
+		{
+			pins.push_back(make_intrusive<CachedItem>(i));
+			cache.insert(pins.back());
+		}
+		auto size_with_pins = cache.size();
+		pins.clear();
+		cache.insert(make_intrusive<CachedItem>(100));
+
+		// Assert
+		Assert::AreEqual(size_t(20), size_with_pins);
+		Assert::AreEqual(size_t(2), cache.size());
+		Assert::IsTrue(cache.contains(0) || cache.contains(100));
+	}
+
+	TEST_METHOD(TwoQueue_ScanDoesNotEvictHotEntries)
+	{
+		// Arrange
+		auto cache = intrusive_cache<int, CachedItem, two_queue_policy>(100);
+		auto next_key = 1000;
+		auto access = [&cache](int key)
+		{
+			if (!cache.find(key))
+			{
+				cache.insert(make_intrusive<CachedItem>(key));
+			}
+		};
+		for (auto round = 0; round < 5; ++round)
+		{
+			for (auto i = 0; i < 20; ++i)
+			{
+				access(i);
+			}
+			for (auto i = 0; i < 30; ++i)
+			{
+				access(next_key++);
+			}
+		}
+
+		// Act
+		for (auto i = 0; i < 1000; ++i)
+		{
+			access(next_key++);
+		}
+		auto hits = 0;
+		for (auto i = 0; i < 20; ++i)
+		{
+			hits += cache.contains(i) ? 1 : 0;
+		}
+
+		// Assert
+		Assert::AreEqual(size_t(100), cache.size());
+		Assert::AreEqual(20, hits);
+	}
+
+	TEST_METHOD(ZeroCapacity_Throws)
+	{
+		// Arrange
+		auto thrown = false;
+
+		// Act
+		try
+		{
+			auto cache = intrusive_cache<int, CachedItem>(0);
+		}
+		catch (const std::invalid_argument&)
+		{
+			thrown = true;
+		}
+
+		// Assert
+		Assert::IsTrue(thrown);
+	}
+
+	TEST_METHOD(Sharded_FindOrInsert_ChecksCreatedObject)
+	{
+		// Arrange
+		auto cache = sharded_cache<int, CachedItem>(16, 4);
+		auto other = make_intrusive<CachedItem>(2);
+		auto thrown = false;
+
+		// Act
+		auto nothing = cache.find_or_insert(1, []() { return intrusive_ptr<CachedItem>(); });
+		try
+		{
+			cache.find_or_insert(1, [&]() { return other; });
+		}
+		catch (const std::invalid_argument&)
+		{
+			thrown = true;
+		}
+		auto inserted_empty = cache.insert(intrusive_ptr<CachedItem>());
+
+		// Assert
+		Assert::IsFalse(static_cast<bool>(nothing));
+		Assert::IsTrue(thrown);
+		Assert::IsFalse(inserted_empty);
+		Assert::AreEqual(size_t(0), cache.size());
+		Assert::AreEqual(1u, other.use_count());
+	}
+
+	TEST_METHOD(Sharded_ReleasesEntriesOutsideOfLock)
+	{
+		// Arrange
+		auto cache = sharded_cache<int, ReentrantItem>(2, 1);
+
+		// Act
+		for (auto key = 0; key < 4; ++key)
+		{
+			cache.insert(make_intrusive<ReentrantItem>(key, &cache));
+		}
+		auto size = cache.size();
+		cache.clear();
+
+		// Assert
+		Assert::AreEqual(size_t(2), size);
+		Assert::AreEqual(size_t(0), cache.size());
+	}
+
+	TEST_METHOD(Sharded_ConcurrentAccess_Success)
+	{
+		// Arrange
+		auto cache = sharded_cache<int, CachedItem>(256, 8);
+		auto threads = std::vector<std::thread>();
+		auto mismatches = std::atomic<int>(0);
+
+		// Act
+		for (auto t = 0; t < 4; ++t)
+		{
+			threads.emplace_back([&, t]()
+			{
+				for (auto i = 0; i < 20000; ++i)
+				{
+					auto key = (i * 7 + t) % 1000;
+					auto found = cache.find_or_insert(key, [key]() { return make_intrusive<CachedItem>(key); });
+					mismatches += found->Key != key ? 1 : 0;
+					if (i % 5 == 0)
+					{
+						cache.erase((key + 1) % 1000);
+					}
+				}
+			});
+		}
+		for (auto& thread : threads)
+		{
+			thread.join();
+		}
+
+		// Assert
+		Assert::AreEqual(0, mismatches.load());
+		Assert::IsTrue(cache.size() <= 256);
+	}
+};
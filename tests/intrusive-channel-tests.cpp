@@ -0,0 +1,398 @@
+#include <atomic>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#include "CppUnitTest.h"
+#include "include/intrusive_channel.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+struct ChannelMessage : public RefCountObject<ChannelMessage>
+{
+	ChannelMessage(int value) : Value(value) { }
+	virtual ~ChannelMessage() = default;
+
+	int Value;
+};
+
+
+TEST_CLASS(IntrusiveChannelTests)
+{
+public:
+
+	TEST_METHOD(Receive_TransfersReferenceInOrder)
+	{
+		// Arrange
+		auto channel = intrusive_channel<ChannelMessage>(4);
+		auto first = make_intrusive<ChannelMessage>(1);
+		auto second = make_intrusive<ChannelMessage>(2);
+
+		// Act
+		auto sent_first = channel.try_send(intrusive_ptr<ChannelMessage>(first));
+		auto sent_second = channel.try_send(intrusive_ptr<ChannelMessage>(second));
+		auto queued_count = first.use_count();
+		auto received_first = channel.try_receive();
+		auto received_second = channel.try_receive();
+		auto received_third = channel.try_receive();
+
+		// Assert
+		Assert::IsTrue(sent_first);
+		Assert::IsTrue(sent_second);
+		Assert::AreEqual(2u, queued_count);
+		Assert::IsTrue(received_first == first);
+		Assert::IsTrue(received_second == second);
+		Assert::IsFalse(static_cast<bool>(received_third));
+		Assert::AreEqual(2u, first.use_count());
+	}
+
+	TEST_METHOD(TrySend_KeepsReferenceWhenFull)
+	{
+		// Arrange
+		auto channel = intrusive_channel<ChannelMessage>(2);
+		channel.try_send(make_intrusive<ChannelMessage>(1));
+		channel.try_send(make_intrusive<ChannelMessage>(2));
+		auto message = make_intrusive<ChannelMessage>(3);
+
+		// Act
+		auto sent = channel.try_send(std::move(message));
+
+		// Assert
+		Assert::IsFalse(sent);
+		Assert::IsTrue(static_cast<bool>(message));
+		Assert::AreEqual(1u, message.use_count());
+		Assert::AreEqual(size_t(2), channel.capacity());
+	}
+
+	TEST_METHOD(Batch_SendsPrefixAndConsumesInOrder)
+	{
+		// Arrange
+		auto channel = intrusive_channel<ChannelMessage>(8);
+		auto messages = std::vector<intrusive_ptr<ChannelMessage>>();
+		for (auto i = 0; i < 10; ++i)
+		{
+			messages.push_back(make_intrusive<ChannelMessage>(i));
+		}
+
+		// Act
+		auto sent = channel.try_send(std::span<intrusive_ptr<ChannelMessage>>(messages));
+		auto kept = static_cast<bool>(messages[8]);
+		auto values = std::vector<int>();
+		auto consumed = channel.try_consume([&](intrusive_ptr<ChannelMessage> message)
+		{
+			values.push_back(message->Value);
+		}, 5);
+		auto sent_rest = channel.try_send(std::span<intrusive_ptr<ChannelMessage>>(messages).subspan(sent));
+
+		// Assert
+		Assert::AreEqual(size_t(8), sent);
+		Assert::IsFalse(static_cast<bool>(messages[0]));
+		Assert::IsTrue(kept);
+		Assert::AreEqual(size_t(5), consumed);
+		Assert::IsTrue(std::vector<int> { 0, 1, 2, 3, 4 } == values);
+		Assert::AreEqual(size_t(2), sent_rest);
+		Assert::IsFalse(static_cast<bool>(messages[9]));
+	}
+
+	TEST_METHOD(EmptyMessages_AreSkipped)
+	{
+		// Arrange
+		auto first = make_intrusive<ChannelMessage>(1);
+		auto second = make_intrusive<ChannelMessage>(2);
+		auto messages = std::vector<intrusive_ptr<ChannelMessage>>
+		{
+			intrusive_ptr<ChannelMessage>(first),
+			intrusive_ptr<ChannelMessage>(),
+			intrusive_ptr<ChannelMessage>(second)
+		};
+		auto sent_empty = false;
+		auto sent = size_t(0);
+		auto received = intrusive_ptr<ChannelMessage>();
+		auto queued_count = 0u;
+
+		// Act
+		{
+			auto channel = intrusive_channel<ChannelMessage>(4);
+			sent_empty = channel.try_send(intrusive_ptr<ChannelMessage>());
+			sent = channel.try_send(std::span<intrusive_ptr<ChannelMessage>>(messages));
+			received = channel.try_receive();
+			queued_count = second.use_count();
+		}
+
+		// Assert
+		Assert::IsTrue(sent_empty);
+		Assert::AreEqual(size_t(3), sent);
+		Assert::IsTrue(received == first);
+		Assert::AreEqual(2u, queued_count);
+		Assert::AreEqual(1u, second.use_count());
+	}
+
+	TEST_METHOD(ThrowingHandler_ReleasesRestOfReceivedMessages)
+	{
+		// Arrange
+		auto channel = intrusive_channel<ChannelMessage>(4);
+		auto messages = std::vector<intrusive_ptr<ChannelMessage>>();
+		for (auto i = 0; i < 4; ++i)
+		{
+			messages.push_back(make_intrusive<ChannelMessage>(i));
+			channel.try_send(intrusive_ptr<ChannelMessage>(messages.back()));
+		}
+		auto thrown = false;
+		auto handled = 0;
+
+		// Act
+		try
+		{
+			channel.try_consume([&](intrusive_ptr<ChannelMessage>)
+			{
+				++handled;
+				throw std::runtime_error("failed");
+			});
+		}
+		catch (const std::runtime_error&)
+		{
+			thrown = true;
+		}
+		auto received_after = channel.try_consume([](intrusive_ptr<ChannelMessage>) { });
+		auto sent_after = channel.try_send(make_intrusive<ChannelMessage>(4));
+
+		// Assert
+		Assert::IsTrue(thrown);
+		Assert::AreEqual(1, handled);
+		Assert::AreEqual(size_t(0), received_after);
+		Assert::IsTrue(sent_after);
+		for (auto& message : messages)
+		{
+			Assert::AreEqual(1u, message.use_count());
+		}
+	}
+
+	TEST_METHOD(Close_WakesBlockedReceiver)
+	{
+		// Arrange
+		auto channel = intrusive_channel<ChannelMessage>(4);
+		auto received = std::vector<int>();
+		auto receiver = std::thread([&]
+		{
+			while (auto message = channel.receive())
+			{
+				received.push_back(message->Value);
+			}
+		});
+
+		// Act
+		channel.send(make_intrusive<ChannelMessage>(1));
+		channel.send(make_intrusive<ChannelMessage>(2));
+		channel.close();
+		receiver.join();
+		auto sent_after_close = channel.send(make_intrusive<ChannelMessage>(3));
+
+		// Assert
+		Assert::IsTrue(std::vector<int> { 1, 2 } == received);
+		Assert::IsFalse(sent_after_close);
+	}
+
+	TEST_METHOD(ConcurrentProducersAndConsumers_DeliverEachMessageOnce)
+	{
+		// Arrange
+		constexpr auto producer_count = 4;
+		constexpr auto consumer_count = 4;
+		constexpr auto message_count = 20000;
+		auto channel = intrusive_channel<ChannelMessage>(64);
+		auto sum = std::atomic<long long>(0);
+		auto received = std::atomic<int>(0);
+		auto threads = std::vector<std::thread>();
+
+		// Act
+		for (auto c = 0; c < consumer_count; ++c)
+		{
+			threads.emplace_back([&]
+			{
+				while (channel.consume([&](intrusive_ptr<ChannelMessage> message)
+				{
+					sum.fetch_add(message->Value, std::memory_order_relaxed);
+					received.fetch_add(1, std::memory_order_relaxed);
+				}, 16) != 0)
+				{
+				}
+			});
+		}
+
+		auto producers = std::vector<std::thread>();
+		for (auto p = 0; p < producer_count; ++p)
+		{
+			producers.emplace_back([&, p]
+			{
+				for (auto i = 0; i < message_count; i += 4)
+				{
+					intrusive_ptr<ChannelMessage> batch[4];
+					for (auto j = 0; j < 4; ++j)
+					{
+						batch[j] = make_intrusive<ChannelMessage>(p * message_count + i + j);
+					}
+					channel.send(std::span<intrusive_ptr<ChannelMessage>>(batch));
+				}
+			});
+		}
+		for (auto& producer : producers)
+		{
+			producer.join();
+		}
+		channel.close();
+		for (auto& thread : threads)
+		{
+			thread.join();
+		}
+
+		// Assert
+		auto total = static_cast<long long>(producer_count) * message_count;
+		Assert::AreEqual(static_cast<int>(total), received.load());
+		Assert::AreEqual(total * (total - 1) / 2, sum.load());
+	}
+
+	TEST_METHOD(Broadcast_DeliversEachMessageToAllReceivers)
+	{
+		// Arrange
+		auto channel = broadcast_channel<ChannelMessage>(4);
+		auto first_receiver = broadcast_channel<ChannelMessage>::receiver(channel);
+		auto second_receiver = broadcast_channel<ChannelMessage>::receiver(channel);
+		auto message = make_intrusive<ChannelMessage>(7);
+
+		// Act
+		channel.try_send(intrusive_ptr<ChannelMessage>(message));
+		auto sent_count = message.use_count();
+		auto visited = 0;
+		first_receiver.try_visit([&](ChannelMessage& received) { visited = received.Value; });
+		auto visited_count = message.use_count();
+		auto received = second_receiver.try_receive();
+		auto received_count = message.use_count();
+		auto nothing = first_receiver.try_receive();
+
+		// Assert
+		Assert::AreEqual(2u, sent_count);
+		Assert::AreEqual(7, visited);
+		Assert::AreEqual(2u, visited_count);
+		Assert::IsTrue(received == message);
+		Assert::AreEqual(2u, received_count);
+		Assert::IsFalse(static_cast<bool>(nothing));
+	}
+
+	TEST_METHOD(Broadcast_EmptyMessageIsSkipped)
+	{
+		// Arrange
+		auto message = make_intrusive<ChannelMessage>(5);
+		auto sent_empty = false;
+		auto visited = std::vector<int>();
+		auto read_count = 0u;
+
+		// Act
+		{
+			auto channel = broadcast_channel<ChannelMessage>(4);
+			auto receiver = broadcast_channel<ChannelMessage>::receiver(channel);
+			sent_empty = channel.try_send(intrusive_ptr<ChannelMessage>());
+			channel.try_send(intrusive_ptr<ChannelMessage>(message));
+			receiver.try_visit([&](ChannelMessage& received) { visited.push_back(received.Value); });
+			read_count = message.use_count();
+		}
+
+		// Assert
+		Assert::IsTrue(sent_empty);
+		Assert::IsTrue(std::vector<int> { 5 } == visited);
+		Assert::AreEqual(1u, read_count);
+		Assert::AreEqual(1u, message.use_count());
+	}
+
+	TEST_METHOD(Broadcast_SlowReceiverBlocksSender)
+	{
+		// Arrange
+		auto channel = broadcast_channel<ChannelMessage>(2);
+		auto fast = broadcast_channel<ChannelMessage>::receiver(channel);
+		auto slow = broadcast_channel<ChannelMessage>::receiver(channel);
+		channel.try_send(make_intrusive<ChannelMessage>(1));
+		channel.try_send(make_intrusive<ChannelMessage>(2));
+		fast.try_visit([](ChannelMessage&) { });
+
+		// Act
+		auto sent_while_slow = channel.try_send(make_intrusive<ChannelMessage>(3));
+		slow.try_visit([](ChannelMessage&) { }, 1);
+		auto sent_after_slow = channel.try_send(make_intrusive<ChannelMessage>(3));
+
+		// Assert
+		Assert::IsFalse(sent_while_slow);
+		Assert::IsTrue(sent_after_slow);
+	}
+
+	TEST_METHOD(Broadcast_DestroyedReceiverReleasesUnreadMessages)
+	{
+		// Arrange
+		auto channel = broadcast_channel<ChannelMessage>(2);
+		auto staying = broadcast_channel<ChannelMessage>::receiver(channel);
+		auto message = make_intrusive<ChannelMessage>(1);
+		auto unsubscribed_count = 0u;
+		auto sent_without_receivers = false;
+
+		// Act
+		{
+			auto leaving = broadcast_channel<ChannelMessage>::receiver(channel);
+			channel.try_send(intrusive_ptr<ChannelMessage>(message));
+			channel.try_send(make_intrusive<ChannelMessage>(2));
+		}
+		staying.try_visit([](ChannelMessage&) { });
+		unsubscribed_count = message.use_count();
+		auto sent_after_leave = channel.try_send(make_intrusive<ChannelMessage>(3))
+			&& channel.try_send(make_intrusive<ChannelMessage>(4));
+		{
+			auto unused = broadcast_channel<ChannelMessage>(2);
+			sent_without_receivers = unused.try_send(make_intrusive<ChannelMessage>(5))
+				&& unused.try_send(make_intrusive<ChannelMessage>(6))
+				&& unused.try_send(make_intrusive<ChannelMessage>(7));
+		}
+
+		// Assert
+		Assert::AreEqual(1u, unsubscribed_count);
+		Assert::IsTrue(sent_after_leave);
+		Assert::IsTrue(sent_without_receivers);
+	}
+
+	TEST_METHOD(Broadcast_ConcurrentReceiversSeeAllMessages)
+	{
+		// Arrange
+		constexpr auto receiver_count = 3;
+		constexpr auto message_count = 10000;
+		auto channel = broadcast_channel<ChannelMessage>(32);
+		auto sums = std::vector<long long>(receiver_count);
+		auto threads = std::vector<std::thread>();
+		auto subscribed = std::atomic<int>(0);
+
+		// Act
+		for (auto r = 0; r < receiver_count; ++r)
+		{
+			threads.emplace_back([&, r]
+			{
+				auto receiver = broadcast_channel<ChannelMessage>::receiver(channel);
+				++subscribed;
+				while (receiver.visit([&](ChannelMessage& message) { sums[r] += message.Value; }) != 0)
+				{
+				}
+			});
+		}
+		while (subscribed.load() != receiver_count)
+		{
+			std::this_thread::yield();
+		}
+		for (auto i = 0; i < message_count; ++i)
+		{
+			channel.send(make_intrusive<ChannelMessage>(i));
+		}
+		channel.close();
+		for (auto& thread : threads)
+		{
+			thread.join();
+		}
+
+		// Assert
+		for (auto sum : sums)
+		{
+			Assert::AreEqual(static_cast<long long>(message_count) * (message_count - 1) / 2, sum);
+		}
+	}
+};
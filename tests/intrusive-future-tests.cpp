@@ -0,0 +1,267 @@
+#include <array>
+#include <atomic>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include "CppUnitTest.h"
+#include "include/intrusive_future.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+TEST_CLASS(IntrusiveFutureTests)
+{
+public:
+
+	TEST_METHOD(Get_WaitsForValueFromAnotherThread)
+	{
+		// Arrange
+		auto promise = intrusive_promise<std::string>();
+		auto future = promise.get_future();
+
+		// Act
+		auto producer = std::thread([&] { promise.set_value("done"); });
+		auto value = future.get();
+		producer.join();
+
+		// Assert
+		Assert::AreEqual(std::string("done"), value);
+		Assert::IsFalse(future.valid());
+	}
+
+	TEST_METHOD(Get_RethrowsException)
+	{
+		// Arrange
+		auto promise = intrusive_promise<int>();
+		auto future = promise.get_future();
+		promise.set_exception(std::make_exception_ptr(std::runtime_error("failed")));
+		auto thrown = false;
+
+		// Act
+		try
+		{
+			future.get();
+		}
+		catch (const std::runtime_error&)
+		{
+			thrown = true;
+		}
+
+		// Assert
+		Assert::IsTrue(thrown);
+	}
+
+	TEST_METHOD(DestroyedPromise_BreaksFuture)
+	{
+		// Arrange
+		auto future = intrusive_future<int>();
+		auto error = std::error_code();
+		{
+			auto promise = intrusive_promise<int>();
+			future = promise.get_future();
+		}
+
+		// Act
+		try
+		{
+			future.get();
+		}
+		catch (const std::future_error& e)
+		{
+			error = e.code();
+		}
+
+		// Assert
+		Assert::IsTrue(error == std::future_errc::broken_promise);
+	}
+
+	TEST_METHOD(SetValue_ThrowsWhenSatisfied)
+	{
+		// Arrange
+		auto promise = intrusive_promise<void>();
+		promise.set_value();
+		auto error = std::error_code();
+
+		// Act
+		try
+		{
+			promise.set_value();
+		}
+		catch (const std::future_error& e)
+		{
+			error = e.code();
+		}
+
+		// Assert
+		Assert::IsTrue(error == std::future_errc::promise_already_satisfied);
+		Assert::IsTrue(promise.get_future().is_ready());
+	}
+
+	TEST_METHOD(GetFuture_ThrowsWhenRetrieved)
+	{
+		// Arrange
+		auto promise = intrusive_promise<int>();
+		auto future = promise.get_future();
+		auto error = std::error_code();
+
+		// Act
+		try
+		{
+			promise.get_future();
+		}
+		catch (const std::future_error& e)
+		{
+			error = e.code();
+		}
+		promise.set_value(1);
+
+		// Assert
+		Assert::IsTrue(error == std::future_errc::future_already_retrieved);
+		Assert::AreEqual(1, future.get());
+	}
+
+	TEST_METHOD(Continuation_IsDestroyedWhenItThrows)
+	{
+		// Arrange
+		auto owned = std::make_shared<int>(1);
+		auto continuation = future_continuation<int>();
+		continuation.emplace([owned](int&) { throw std::runtime_error("failed"); });
+		auto argument = 0;
+		auto thrown = false;
+
+		// Act
+		try
+		{
+			continuation(argument);
+		}
+		catch (const std::runtime_error&)
+		{
+			thrown = true;
+		}
+
+		// Assert
+		Assert::IsTrue(thrown);
+		Assert::AreEqual(1L, owned.use_count());
+	}
+
+	TEST_METHOD(SetValue_PropagatesConstructorException)
+	{
+		// Arrange
+		struct ThrowingValue
+		{
+			ThrowingValue(bool fail)
+			{
+				if (fail)
+				{
+					throw std::runtime_error("failed");
+				}
+			}
+		};
+		auto promise = intrusive_promise<ThrowingValue>();
+		auto future = promise.get_future();
+		auto thrown = false;
+
+		// Act
+		try
+		{
+			promise.set_value(true);
+		}
+		catch (const std::runtime_error&)
+		{
+			thrown = true;
+		}
+		auto ready_after_failure = future.is_ready();
+		promise.set_value(false);
+
+		// Assert
+		Assert::IsTrue(thrown);
+		Assert::IsFalse(ready_after_failure);
+		Assert::IsTrue(future.is_ready());
+	}
+
+	TEST_METHOD(Then_ChainsContinuationsBeforeAndAfterValue)
+	{
+		// Arrange
+		auto promise = intrusive_promise<int>();
+		auto future = promise.get_future()
+			.then([](int value) { return value * 2; })
+			.then([](int value) { return std::to_string(value); });
+
+		// Act
+		promise.set_value(21);
+		auto chained = future.get();
+		auto ready = make_ready_future(5).then([](int value) { return value + 1; }).get();
+
+		// Assert
+		Assert::AreEqual(std::string("42"), chained);
+		Assert::AreEqual(6, ready);
+	}
+
+	TEST_METHOD(Then_SkipsContinuationOnException)
+	{
+		// Arrange
+		auto promise = intrusive_promise<int>();
+		auto invoked = false;
+		auto future = promise.get_future()
+			.then([&](int value) { invoked = true; return value; })
+			.then([](int) { });
+		auto thrown = false;
+
+		// Act
+		promise.set_exception(std::make_exception_ptr(std::runtime_error("failed")));
+		try
+		{
+			future.get();
+		}
+		catch (const std::runtime_error&)
+		{
+			thrown = true;
+		}
+
+		// Assert
+		Assert::IsFalse(invoked);
+		Assert::IsTrue(thrown);
+	}
+
+	TEST_METHOD(Then_StoresLargeContinuation)
+	{
+		// Arrange
+		auto promise = intrusive_promise<int>();
+		auto payload = std::vector<int>(100, 1);
+		auto big = std::array<int, 64>();
+		big.fill(2);
+		auto owned = std::make_unique<int>(3);
+		auto future = promise.get_future().then([big, owned = std::move(owned)](int value)
+		{
+			return value + big[63] + *owned;
+		});
+
+		// Act
+		promise.set_value(1);
+
+		// Assert
+		Assert::AreEqual(6, future.get());
+	}
+
+	TEST_METHOD(ConcurrentThen_RunsContinuationOnce)
+	{
+		for (auto i = 0; i < 200; ++i)
+		{
+			// Arrange
+			auto promise = intrusive_promise<int>();
+			auto future = promise.get_future();
+			auto runs = std::atomic<int>(0);
+
+			// Act
+			auto producer = std::thread([&] { promise.set_value(i); });
+			auto chained = future.then([&](int value) { runs.fetch_add(1); return value; });
+			auto value = chained.get();
+			producer.join();
+
+			// Assert
+			Assert::AreEqual(i, value);
+			Assert::AreEqual(1, runs.load());
+		}
+	}
+};
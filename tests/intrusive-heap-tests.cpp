@@ -0,0 +1,308 @@
+#include <algorithm>
+#include <random>
+#include <stdexcept>
+#include <vector>
+#include "CppUnitTest.h"
+#include "include/intrusive_heap.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+struct Job : public RefCountObject<Job>, public intrusive_heap_hook<>
+{
+	Job(int id, int priority) : Id(id), Priority(priority) { }
+	virtual ~Job() = default;
+
+	bool operator<(const Job& other) const noexcept
+	{
+		return Priority < other.Priority;
+	}
+
+	int Id;
+	int Priority;
+};
+
+struct ReentrantJob : public Job
+{
+	ReentrantJob(intrusive_heap<Job>& heap, int priority) : Job(priority, priority), Heap(heap) { }
+
+	~ReentrantJob() override
+	{
+		Heap.push(make_intrusive<Job>(-1, -1));
+	}
+
+	intrusive_heap<Job>& Heap;
+};
+
+struct ThrowingOrder
+{
+	bool operator()(const Job& left, const Job& right) const
+	{
+		if (Budget >= 0 && Budget-- == 0)
+		{
+			throw std::runtime_error("The comparison failed");
+		}
+		return left.Priority < right.Priority;
+	}
+
+	// The number of the comparisons before the one, that throws. A negative value never throws.
+	static inline int Budget { -1 };
+};
+
+
+TEST_CLASS(IntrusiveHeapTests)
+{
+public:
+
+	TEST_METHOD(Pop_ReturnsItemsInOrder)
+	{
+		// Arrange
+		auto heap = intrusive_heap<Job>();
+		auto priorities = std::vector<int> { 7, 3, 9, 1, 5, 8, 2, 6, 4, 0 };
+		for (auto priority : priorities)
+		{
+			heap.push(make_intrusive<Job>(priority, priority));
+		}
+
+		// Act
+		auto popped = std::vector<int>();
+		while (!heap.empty())
+		{
+			popped.push_back(heap.pop()->Priority);
+		}
+
+		// Assert
+		std::sort(priorities.begin(), priorities.end());
+		Assert::IsTrue(priorities == popped);
+	}
+
+	TEST_METHOD(Push_TakesReferenceWithoutCopies)
+	{
+		// Arrange
+		auto heap = intrusive_heap<Job>();
+		auto job = make_intrusive<Job>(1, 10);
+		for (auto i = 0; i < 100; ++i)
+		{
+			heap.push(make_intrusive<Job>(i + 2, 100 - i));
+		}
+
+		// Act
+		heap.push(job);
+		auto pushed_count = job.use_count();
+		job->Priority = 0;
+		heap.decrease(*job);
+		auto updated_count = job.use_count();
+		heap.clear();
+
+		// Assert
+		Assert::AreEqual(2u, pushed_count);
+		Assert::AreEqual(2u, updated_count);
+		Assert::AreEqual(1u, job.use_count());
+		Assert::IsFalse(job->is_linked());
+	}
+
+	TEST_METHOD(Push_IgnoresEmptyPointer)
+	{
+		// Arrange
+		auto heap = intrusive_heap<Job>();
+
+		// Act
+		heap.push(intrusive_ptr<Job>());
+
+		// Assert
+		Assert::IsTrue(heap.empty());
+	}
+
+	TEST_METHOD(Clear_ReleasesMembersAfterEmptyingHeap)
+	{
+		// Arrange
+		auto heap = intrusive_heap<Job>();
+		auto job = make_intrusive<Job>(1, 1);
+		heap.push(job);
+		heap.push(intrusive_ptr<Job>(new ReentrantJob(heap, 2)));
+		heap.push(intrusive_ptr<Job>(new ReentrantJob(heap, 3)));
+
+		// Act
+		heap.clear();
+
+		// Assert
+		Assert::AreEqual(size_t(2), heap.size());
+		Assert::AreEqual(-1, heap.top().Priority);
+		Assert::IsFalse(job->is_linked());
+		Assert::AreEqual(1u, job.use_count());
+	}
+
+	TEST_METHOD(Update_MovesItemInBothDirections)
+	{
+		// Arrange
+		auto heap = intrusive_heap<Job>();
+		auto first = make_intrusive<Job>(1, 10);
+		auto second = make_intrusive<Job>(2, 20);
+		auto third = make_intrusive<Job>(3, 30);
+		heap.push(first);
+		heap.push(second);
+		heap.push(third);
+
+		// Act
+		third->Priority = 5;
+		heap.update(*third);
+		auto raised = heap.top().Id;
+		third->Priority = 50;
+		heap.update(*third);
+		auto lowered = heap.top().Id;
+
+		// Assert
+		Assert::AreEqual(3, raised);
+		Assert::AreEqual(1, lowered);
+		Assert::AreEqual(size_t(3), heap.size());
+	}
+
+	TEST_METHOD(Erase_RemovesItemByReference)
+	{
+		// Arrange
+		auto heap = intrusive_heap<Job>();
+		auto jobs = std::vector<intrusive_ptr<Job>>();
+		for (auto i = 0; i < 20; ++i)
+		{
+			jobs.push_back(make_intrusive<Job>(i, i));
+			heap.push(jobs.back());
+		}
+
+		// Act
+		auto erased = heap.erase(*jobs[7]);
+		auto top = heap.erase(*jobs[0]);
+		auto popped = std::vector<int>();
+		while (!heap.empty())
+		{
+			popped.push_back(heap.pop()->Id);
+		}
+
+		// Assert
+		Assert::IsTrue(erased == jobs[7]);
+		Assert::IsTrue(top == jobs[0]);
+		Assert::IsFalse(heap.contains(*jobs[7]));
+		Assert::AreEqual(size_t(18), popped.size());
+		Assert::IsTrue(std::is_sorted(popped.begin(), popped.end()));
+		Assert::IsTrue(std::find(popped.begin(), popped.end(), 7) == popped.end());
+		Assert::AreEqual(2u, jobs[7].use_count());
+	}
+
+	TEST_METHOD(RandomOperations_KeepHeapOrder)
+	{
+		// Arrange
+		auto heap = intrusive_heap<Job, std::less<Job>, 8>();
+		auto jobs = std::vector<intrusive_ptr<Job>>();
+		auto random = std::mt19937(42);
+		for (auto i = 0; i < 1000; ++i)
+		{
+			jobs.push_back(make_intrusive<Job>(i, static_cast<int>(random() % 10000)));
+			heap.push(jobs.back());
+		}
+
+		// Act
+		for (auto i = 0; i < 5000; ++i)
+		{
+			auto& job = *jobs[random() % jobs.size()];
+			if (i % 3 == 0)
+			{
+				if (heap.contains(job))
+				{
+					heap.erase(job);
+				}
+				else
+				{
+					heap.push(intrusive_ptr<Job>(&job));
+				}
+			}
+			else if (heap.contains(job))
+			{
+				job.Priority = static_cast<int>(random() % 10000);
+				heap.update(job);
+			}
+		}
+		auto expected = std::vector<int>();
+		for (auto& job : jobs)
+		{
+			if (heap.contains(*job))
+			{
+				expected.push_back(job->Priority);
+			}
+		}
+		auto popped = std::vector<int>();
+		while (!heap.empty())
+		{
+			popped.push_back(heap.pop()->Priority);
+		}
+
+		// Assert
+		std::sort(expected.begin(), expected.end());
+		Assert::IsTrue(expected == popped);
+	}
+
+	TEST_METHOD(ThrowingCompare_LeavesHeapUnchanged)
+	{
+		// Arrange
+		auto heap = intrusive_heap<Job, ThrowingOrder>();
+		auto random = std::mt19937(11);
+		auto jobs = std::vector<intrusive_ptr<Job>>();
+		for (auto i = 0; i < 100; ++i)
+		{
+			jobs.push_back(make_intrusive<Job>(i, static_cast<int>(random() % 1000)));
+			heap.push(jobs.back());
+		}
+
+		// Act
+		auto thrown = 0;
+		for (auto i = 0; i < 2000; ++i)
+		{
+			auto& job = *jobs[random() % jobs.size()];
+			auto priority = job.Priority;
+			ThrowingOrder::Budget = static_cast<int>(random() % 8);
+			try
+			{
+				if (!heap.contains(job))
+				{
+					heap.push(intrusive_ptr<Job>(&job));
+				}
+				else if (i % 2 == 0)
+				{
+					heap.erase(job);
+				}
+				else
+				{
+					job.Priority = static_cast<int>(random() % 1000);
+					heap.update(job);
+				}
+			}
+			catch (const std::runtime_error&)
+			{
+				job.Priority = priority;
+				++thrown;
+			}
+		}
+		ThrowingOrder::Budget = -1;
+		auto expected = std::vector<int>();
+		for (auto& job : jobs)
+		{
+			if (heap.contains(*job))
+			{
+				expected.push_back(job->Priority);
+			}
+		}
+		auto popped = std::vector<int>();
+		while (!heap.empty())
+		{
+			popped.push_back(heap.pop()->Priority);
+		}
+
+		// Assert
+		std::sort(expected.begin(), expected.end());
+		Assert::IsTrue(thrown > 0);
+		Assert::IsFalse(noexcept(heap.pop()));
+		Assert::IsTrue(noexcept(intrusive_heap<Job>().pop()));
+		Assert::IsTrue(expected == popped);
+		for (auto& job : jobs)
+		{
+			Assert::AreEqual(1u, job.use_count());
+		}
+	}
+};
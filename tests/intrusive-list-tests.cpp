@@ -0,0 +1,164 @@
+#include <vector>
+#include "CppUnitTest.h"
+#include "include/intrusive_list.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+struct QueueTag { };
+struct IndexTag { };
+
+struct ListItem
+	: public RefCountObject<ListItem>
+	, public intrusive_list_hook<QueueTag>
+	, public intrusive_list_hook<IndexTag>
+{
+	ListItem(int value) : Value(value) { }
+	virtual ~ListItem() = default;
+
+	int Value;
+};
+
+using ItemQueue = intrusive_list<ListItem, QueueTag>;
+using ItemIndex = intrusive_list<ListItem, IndexTag>;
+
+
+TEST_CLASS(IntrusiveListTests)
+{
+public:
+
+	TEST_METHOD(PushAndPop_Fifo_Success)
+	{
+		// Arrange
+		auto list = ItemQueue();
+
+		// Act
+		list.push_back(make_intrusive<ListItem>(1));
+		list.push_back(make_intrusive<ListItem>(2));
+		list.push_front(make_intrusive<ListItem>(0));
+		auto size = list.size();
+		auto first = list.pop_front();
+		auto last = list.pop_back();
+
+		// Assert
+		Assert::AreEqual(size_t(3), size);
+		Assert::AreEqual(0, first->Value);
+		Assert::AreEqual(2, last->Value);
+		Assert::AreEqual(1u, first.use_count());
+		Assert::AreEqual(size_t(1), list.size());
+		Assert::AreEqual(1, list.front().Value);
+	}
+
+	TEST_METHOD(PopFromEmpty_ReturnsNull)
+	{
+		// Arrange
+		auto list = ItemQueue();
+
+		// Act
+		auto ptr = list.pop_front();
+
+		// Assert
+		Assert::IsTrue(list.empty());
+		Assert::IsNull(ptr.get());
+	}
+
+	TEST_METHOD(PushEmpty_IsIgnored)
+	{
+		// Arrange
+		auto list = ItemQueue();
+		list.push_back(make_intrusive<ListItem>(1));
+
+		// Act
+		list.push_back(intrusive_ptr<ListItem>());
+		list.push_front(intrusive_ptr<ListItem>());
+		auto position = list.insert(list.begin(), intrusive_ptr<ListItem>());
+
+		// Assert
+		Assert::AreEqual(size_t(1), list.size());
+		Assert::IsTrue(position == list.begin());
+		Assert::AreEqual(1, list.front().Value);
+	}
+
+	TEST_METHOD(ListHoldsReference_Success)
+	{
+		// Arrange
+		auto list = ItemQueue();
+		auto ptr = make_intrusive<ListItem>(5);
+
+		// Act
+		list.push_back(ptr);
+		auto linked_count = ptr.use_count();
+		list.clear();
+		auto unlinked_count = ptr.use_count();
+
+		// Assert
+		Assert::AreEqual(2u, linked_count);
+		Assert::AreEqual(1u, unlinked_count);
+		Assert::IsFalse(static_cast<intrusive_list_hook<QueueTag>&>(*ptr).is_linked());
+	}
+
+	TEST_METHOD(EraseFromMiddle_Success)
+	{
+		// Arrange
+		auto list = ItemQueue();
+		auto middle = make_intrusive<ListItem>(2);
+		list.push_back(make_intrusive<ListItem>(1));
+		list.push_back(middle);
+		list.push_back(make_intrusive<ListItem>(3));
+
+		// Act
+		auto erased = list.erase(*middle);
+		auto values = std::vector<int>();
+		for (auto& item : list)
+		{
+			values.push_back(item.Value);
+		}
+
+		// Assert
+		Assert::IsTrue(erased == middle);
+		Assert::AreEqual(2u, middle.use_count());
+		Assert::AreEqual(size_t(2), values.size());
+		Assert::AreEqual(1, values[0]);
+		Assert::AreEqual(3, values[1]);
+	}
+
+	TEST_METHOD(MembershipInSeveralLists_Success)
+	{
+		// Arrange
+		auto queue = ItemQueue();
+		auto index = ItemIndex();
+		auto ptr = make_intrusive<ListItem>(7);
+
+		// Act
+		queue.push_back(ptr);
+		index.push_back(ptr);
+		auto linked_count = ptr.use_count();
+		queue.erase(*ptr);
+		auto in_queue = static_cast<intrusive_list_hook<QueueTag>&>(*ptr).is_linked();
+		auto in_index = static_cast<intrusive_list_hook<IndexTag>&>(*ptr).is_linked();
+
+		// Assert
+		Assert::AreEqual(3u, linked_count);
+		Assert::AreEqual(2u, ptr.use_count());
+		Assert::IsFalse(in_queue);
+		Assert::IsTrue(in_index);
+		Assert::AreEqual(7, index.front().Value);
+	}
+
+	TEST_METHOD(MoveList_Success)
+	{
+		// Arrange
+		auto list = ItemQueue();
+		list.push_back(make_intrusive<ListItem>(1));
+		list.push_back(make_intrusive<ListItem>(2));
+
+		// Act
+		auto moved = std::move(list);
+		auto it = moved.erase(moved.begin());
+
+		// Assert
+		Assert::IsTrue(list.empty());
+		Assert::AreEqual(size_t(1), moved.size());
+		Assert::AreEqual(2, it->Value);
+		Assert::AreEqual(2, moved.back().Value);
+	}
+};
@@ -0,0 +1,132 @@
+#include <thread>
+#include <vector>
+#include "CppUnitTest.h"
+#include "include/intrusive_mpsc_queue.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+struct Message : public RefCountObject<Message>, public intrusive_mpsc_hook<>
+{
+	Message(int producer, int value) : Producer(producer), Value(value) { }
+	virtual ~Message() = default;
+
+	int Producer;
+	int Value;
+};
+
+
+TEST_CLASS(IntrusiveMpscQueueTests)
+{
+public:
+
+	TEST_METHOD(PushAndPop_Fifo_Success)
+	{
+		// Arrange
+		auto queue = intrusive_mpsc_queue<Message>();
+		auto ptr = make_intrusive<Message>(0, 1);
+
+		// Act
+		queue.push(ptr);
+		queue.push(make_intrusive<Message>(0, 2));
+		auto queued_count = ptr.use_count();
+		auto first = queue.pop();
+		auto second = queue.pop();
+		auto third = queue.pop();
+
+		// Assert
+		Assert::AreEqual(2u, queued_count);
+		Assert::IsTrue(first == ptr);
+		Assert::AreEqual(2, second->Value);
+		Assert::AreEqual(1u, second.use_count());
+		Assert::IsNull(third.get());
+		Assert::IsTrue(queue.empty());
+	}
+
+	TEST_METHOD(ConsumeBatch_Success)
+	{
+		// Arrange
+		auto queue = intrusive_mpsc_queue<Message>();
+		for (auto i = 0; i < 10; ++i)
+		{
+			queue.push(make_intrusive<Message>(0, i));
+		}
+		auto values = std::vector<int>();
+
+		// Act
+		auto first_batch = queue.consume([&](intrusive_ptr<Message> message)
+		{
+			values.push_back(message->Value);
+		}, 4);
+		auto second_batch = queue.consume([&](intrusive_ptr<Message> message)
+		{
+			values.push_back(message->Value);
+		});
+
+		// Assert
+		Assert::AreEqual(size_t(4), first_batch);
+		Assert::AreEqual(size_t(6), second_batch);
+		for (auto i = 0; i < 10; ++i)
+		{
+			Assert::AreEqual(i, values[i]);
+		}
+	}
+
+	TEST_METHOD(DestroyNonEmptyQueue_ReleasesObjects)
+	{
+		// Arrange
+		auto ptr = make_intrusive<Message>(0, 1);
+
+		// Act
+		{
+			auto queue = intrusive_mpsc_queue<Message>();
+			queue.push(ptr);
+			queue.push(make_intrusive<Message>(0, 2));
+		}
+
+		// Assert
+		Assert::AreEqual(1u, ptr.use_count());
+	}
+
+	TEST_METHOD(ConcurrentProducers_PreserveOrderPerProducer)
+	{
+		// Arrange
+		const auto producers = 4;
+		const auto messages = 20000;
+		auto queue = intrusive_mpsc_queue<Message>();
+		auto threads = std::vector<std::thread>();
+		auto last_values = std::vector<int>(producers, -1);
+		auto received = 0;
+		auto ordered = true;
+
+		// Act
+		for (auto p = 0; p < producers; ++p)
+		{
+			threads.emplace_back([&queue, p, messages]()
+			{
+				for (auto i = 0; i < messages; ++i)
+				{
+					queue.push(make_intrusive<Message>(p, i));
+				}
+			});
+		}
+
+		while (received < producers * messages)
+		{
+			received += static_cast<int>(queue.consume([&](intrusive_ptr<Message> message)
+			{
+				ordered = ordered && message->Value == last_values[message->Producer] + 1;
+				last_values[message->Producer] = message->Value;
+			}));
+		}
+
+		for (auto& thread : threads)
+		{
+			thread.join();
+		}
+
+		// Assert
+		Assert::IsTrue(ordered);
+		Assert::AreEqual(producers * messages, received);
+		Assert::IsTrue(queue.empty());
+	}
+};
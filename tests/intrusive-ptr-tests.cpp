@@ -114,6 +114,39 @@ public:
 		Assert::AreEqual(raw_value, mv_value);
 	}
 
+	TEST_METHOD(CopyAssignPtr_Success)
+	{
+		// Arrange
+		auto src_ptr = make_intrusive<Object>(30);
+		auto old_ptr = make_intrusive<Object>(31);
+		auto dst_ptr = old_ptr;
+
+		// Act
+		dst_ptr = src_ptr;
+
+		// Assert
+		Assert::IsTrue(dst_ptr == src_ptr);
+		Assert::AreEqual(2u, src_ptr.use_count());
+		Assert::AreEqual(1u, old_ptr.use_count());
+	}
+
+	TEST_METHOD(MoveAssignPtr_Success)
+	{
+		// Arrange
+		auto src_ptr = make_intrusive<Object>(32);
+		auto old_ptr = make_intrusive<Object>(33);
+		auto dst_ptr = old_ptr;
+
+		// Act
+		dst_ptr = std::move(src_ptr);
+
+		// Assert
+		Assert::IsNull(src_ptr.get());
+		Assert::AreEqual(32, dst_ptr->Value);
+		Assert::AreEqual(1u, dst_ptr.use_count());
+		Assert::AreEqual(1u, old_ptr.use_count());
+	}
+
 	TEST_METHOD(ComparePtr_Success)
 	{
 		// Arrange
@@ -0,0 +1,188 @@
+#include <atomic>
+#include <thread>
+#include <vector>
+#include "CppUnitTest.h"
+#include "include/intrusive_stack.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+struct StackItem : public RefCountObject<StackItem>, public intrusive_stack_hook<>
+{
+	StackItem(int value) : Value(value) { }
+	virtual ~StackItem() = default;
+
+	int Value;
+};
+
+struct TrackedStackItem : public StackItem
+{
+	TrackedStackItem(std::atomic<bool>* destroyed) : StackItem(0), Destroyed(destroyed) { }
+	~TrackedStackItem() override { *Destroyed = true; }
+
+	std::atomic<bool>* Destroyed;
+};
+
+
+TEST_CLASS(IntrusiveStackTests)
+{
+public:
+
+	TEST_METHOD(PushAndPop_Lifo_Success)
+	{
+		// Arrange
+		auto stack = intrusive_stack<StackItem>();
+		auto ptr = make_intrusive<StackItem>(1);
+
+		// Act
+		stack.push(ptr);
+		stack.push(make_intrusive<StackItem>(2));
+		auto pushed_count = ptr.use_count();
+		auto first = stack.pop();
+		auto second = stack.pop();
+		auto third = stack.pop();
+		epoch_domain::instance().flush();
+
+		// Assert
+		Assert::AreEqual(2u, pushed_count);
+		Assert::AreEqual(2, first->Value);
+		Assert::AreEqual(1u, first.use_count());
+		Assert::IsTrue(second == ptr);
+		Assert::IsNull(third.get());
+		Assert::IsTrue(stack.empty());
+	}
+
+	TEST_METHOD(PopAll_TakesWholeChain)
+	{
+		// Arrange
+		auto stack = intrusive_stack<StackItem>();
+		for (auto i = 0; i < 5; ++i)
+		{
+			stack.push(make_intrusive<StackItem>(i));
+		}
+
+		// Act
+		auto chain = stack.pop_all();
+		auto values = std::vector<int>();
+		while (auto item = chain.pop())
+		{
+			values.push_back(item->Value);
+		}
+
+		// Assert
+		Assert::IsTrue(stack.empty());
+		Assert::AreEqual(size_t(5), values.size());
+		for (auto i = 0; i < 5; ++i)
+		{
+			Assert::AreEqual(4 - i, values[i]);
+		}
+	}
+
+	TEST_METHOD(Pop_KeepsObjectAllocatedWhilePinned)
+	{
+		// Arrange
+		auto stack = intrusive_stack<StackItem>();
+		auto destroyed = std::atomic<bool>(false);
+		auto reader_ready = std::atomic<bool>(false);
+		auto release_reader = std::atomic<bool>(false);
+		stack.push(intrusive_ptr<StackItem>(new TrackedStackItem(&destroyed)));
+
+		// Act
+		auto pinned = std::thread([&]()
+		{
+			auto guard = epoch_domain::instance().pin();
+			reader_ready = true;
+			while (!release_reader.load())
+			{
+				std::this_thread::yield();
+			}
+		});
+		while (!reader_ready.load())
+		{
+			std::this_thread::yield();
+		}
+		stack.pop().reset(nullptr);
+		epoch_domain::instance().flush();
+		auto destroyed_while_pinned = destroyed.load();
+		release_reader = true;
+		pinned.join();
+		epoch_domain::instance().flush();
+
+		// Assert
+		Assert::IsFalse(destroyed_while_pinned);
+		Assert::IsTrue(destroyed.load());
+	}
+
+	TEST_METHOD(DestroyNonEmptyStack_ReleasesObjects)
+	{
+		// Arrange
+		auto ptr = make_intrusive<StackItem>(1);
+
+		// Act
+		{
+			auto stack = intrusive_stack<StackItem>();
+			stack.push(ptr);
+			stack.push(make_intrusive<StackItem>(2));
+		}
+
+		// Assert
+		Assert::AreEqual(1u, ptr.use_count());
+	}
+
+	TEST_METHOD(ConcurrentRecycling_KeepsAllObjects)
+	{
+		// Arrange
+		const auto objects = 64;
+		const auto threads_count = 4;
+		const auto iterations = 20000;
+		auto stack = intrusive_stack<StackItem>();
+		auto threads = std::vector<std::thread>();
+		auto pops = std::atomic<int>(0);
+		for (auto i = 0; i < objects; ++i)
+		{
+			stack.push(make_intrusive<StackItem>(i));
+		}
+
+		// Act
+		for (auto t = 0; t < threads_count; ++t)
+		{
+			threads.emplace_back([&]()
+			{
+				for (auto i = 0; i < iterations; ++i)
+				{
+					if (auto item = stack.pop())
+					{
+						++pops;
+						stack.push(std::move(item));
+					}
+				}
+			});
+		}
+
+		for (auto& thread : threads)
+		{
+			thread.join();
+		}
+
+		auto items = std::vector<intrusive_ptr<StackItem>>();
+		auto chain = stack.pop_all();
+		while (auto item = chain.pop())
+		{
+			items.push_back(std::move(item));
+		}
+		epoch_domain::instance().flush();
+
+		auto sum = 0;
+		auto count = 0;
+		for (auto& item : items)
+		{
+			Assert::AreEqual(1u, item.use_count());
+			sum += item->Value;
+			++count;
+		}
+
+		// Assert
+		Assert::IsTrue(pops.load() > 0);
+		Assert::AreEqual(objects, count);
+		Assert::AreEqual(objects * (objects - 1) / 2, sum);
+	}
+};
@@ -0,0 +1,135 @@
+#include <map>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include "CppUnitTest.h"
+#include "include/intrusive_string.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+TEST_CLASS(IntrusiveStringTests)
+{
+public:
+
+	TEST_METHOD(ShortString_IsInline)
+	{
+		// Arrange
+		auto text = std::string_view("fifteen chars!!");
+
+		// Act
+		auto value = intrusive_string(text);
+		auto copy = value;
+
+		// Assert
+		Assert::AreEqual(size_t(16), sizeof(intrusive_string));
+		Assert::IsTrue(value.is_inline());
+		Assert::IsTrue(copy.is_inline());
+		Assert::AreEqual(size_t(15), value.size());
+		Assert::IsTrue(copy.view() == text);
+		Assert::AreEqual(0u, copy.use_count());
+		Assert::IsTrue(intrusive_string().empty());
+	}
+
+	TEST_METHOD(LongString_IsShared)
+	{
+		// Arrange
+		auto text = std::string("a string longer than the inline capacity");
+
+		// Act
+		auto value = intrusive_string(text);
+		auto copy = value;
+		auto moved = intrusive_string(std::move(copy));
+
+		// Assert
+		Assert::IsFalse(value.is_inline());
+		Assert::IsTrue(value.data() == moved.data());
+		Assert::AreEqual(2u, value.use_count());
+		Assert::IsTrue(copy.empty());
+		Assert::AreEqual(text, moved.str());
+		Assert::AreEqual(std::hash<std::string_view>()(text), moved.hash());
+	}
+
+	TEST_METHOD(Assignment_ReleasesPrevious)
+	{
+		// Arrange
+		auto first = intrusive_string("the first long string value");
+		auto second = intrusive_string("the second long string value");
+		auto kept = second;
+
+		// Act
+		second = first;
+		kept = "short";
+
+		// Assert
+		Assert::AreEqual(2u, first.use_count());
+		Assert::IsTrue(second == first);
+		Assert::IsTrue(kept == "short");
+	}
+
+	TEST_METHOD(Comparison_MatchesStringView)
+	{
+		// Arrange
+		auto left = intrusive_string("the same long string value");
+		auto right = intrusive_string(std::string("the same long string value"));
+		auto other = intrusive_string("the same long string valuf");
+
+		// Act
+		auto equal = left == right;
+		auto different = left == other;
+		auto ordered = left < other;
+
+		// Assert
+		Assert::IsTrue(equal);
+		Assert::IsFalse(different);
+		Assert::IsTrue(ordered);
+		Assert::IsTrue(intrusive_string("abc") < intrusive_string("abd"));
+		Assert::IsFalse(intrusive_string("abc") == intrusive_string("abcd"));
+	}
+
+	TEST_METHOD(Comparison_AcceptsLiteralsAndStrings)
+	{
+		// Arrange
+		auto inline_text = intrusive_string("hello");
+		auto shared_text = intrusive_string("a string longer than fifteen characters");
+		auto text = std::string("hello");
+
+		// Act
+		auto literal_equal = inline_text == "hello";
+		auto literal_reversed = "hello" == inline_text;
+		auto string_equal = inline_text == text;
+		auto string_different = shared_text != text;
+		auto literal_less = inline_text < "world";
+		auto string_greater = shared_text > std::string("a string");
+
+		// Assert
+		Assert::IsTrue(literal_equal);
+		Assert::IsTrue(literal_reversed);
+		Assert::IsTrue(string_equal);
+		Assert::IsTrue(string_different);
+		Assert::IsTrue(literal_less);
+		Assert::IsTrue(string_greater);
+	}
+
+	TEST_METHOD(UnorderedMap_FindsByStringView)
+	{
+		// Arrange
+		auto map = std::unordered_map<intrusive_string, int, intrusive_string_hash, std::equal_to<>>();
+		map.emplace("short", 1);
+		map.emplace("a key longer than fifteen characters", 2);
+		auto ordered = std::map<intrusive_string, int, std::less<>>(map.begin(), map.end());
+
+		// Act
+		auto first = map.find(std::string_view("short"));
+		auto second = map.find(std::string_view("a key longer than fifteen characters"));
+		auto missing = map.find(std::string_view("missing"));
+
+		// Assert
+		Assert::AreEqual(1, first->second);
+		Assert::AreEqual(2, second->second);
+		Assert::IsTrue(missing == map.end());
+		Assert::AreEqual(1, ordered.find(std::string_view("short"))->second);
+		Assert::AreEqual(1, map.find("short")->second);
+		Assert::AreEqual(2, map.find(std::string("a key longer than fifteen characters"))->second);
+		Assert::AreEqual(1, ordered.find("short")->second);
+	}
+};
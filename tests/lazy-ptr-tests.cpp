@@ -0,0 +1,181 @@
+#include <atomic>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include "CppUnitTest.h"
+#include "include/lazy_ptr.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+struct LazyCapture : public RefCountObject<LazyCapture>
+{
+	int Value = 7;
+};
+
+TEST_CLASS(LazyPtrTests)
+{
+public:
+
+	TEST_METHOD(Get_ComputesOnFirstAccess)
+	{
+		// Arrange
+		auto runs = 0;
+		auto lazy = make_lazy([&] { ++runs; return std::string("value"); });
+		auto runs_before = runs;
+
+		// Act
+		auto& first = lazy.get();
+		auto& second = *lazy;
+
+		// Assert
+		Assert::AreEqual(0, runs_before);
+		Assert::AreEqual(1, runs);
+		Assert::AreEqual(std::string("value"), first);
+		Assert::IsTrue(&first == &second);
+		Assert::AreEqual(size_t(5), lazy->size());
+		Assert::IsTrue(lazy.is_ready());
+	}
+
+	TEST_METHOD(Copies_ShareValue)
+	{
+		// Arrange
+		auto runs = 0;
+		auto lazy = make_lazy([&] { ++runs; return 42; });
+		auto copy = lazy;
+
+		// Act
+		auto value = copy.get();
+
+		// Assert
+		Assert::AreEqual(42, value);
+		Assert::AreEqual(1, runs);
+		Assert::IsTrue(lazy.is_ready());
+		Assert::IsTrue(&lazy.get() == &copy.get());
+		Assert::AreEqual(2u, lazy.use_count());
+	}
+
+	TEST_METHOD(ConcurrentGet_ComputesOnce)
+	{
+		for (auto i = 0; i < 100; ++i)
+		{
+			// Arrange
+			auto runs = std::atomic<int>(0);
+			auto lazy = make_lazy([&]
+			{
+				runs.fetch_add(1, std::memory_order_relaxed);
+				std::this_thread::yield();
+				return i;
+			});
+			auto results = std::vector<const int*>(4);
+			auto threads = std::vector<std::thread>();
+
+			// Act
+			for (auto t = 0; t < 4; ++t)
+			{
+				threads.emplace_back([&, t, lazy] { results[t] = &lazy.get(); });
+			}
+			for (auto& thread : threads)
+			{
+				thread.join();
+			}
+
+			// Assert
+			Assert::AreEqual(1, runs.load());
+			for (auto result : results)
+			{
+				Assert::IsTrue(result == &lazy.get());
+				Assert::AreEqual(i, *result);
+			}
+		}
+	}
+
+	TEST_METHOD(Dependencies_ComputedOnce)
+	{
+		// Arrange
+		auto runs = std::atomic<int>(0);
+		auto base = make_lazy([&] { runs.fetch_add(1); return 10; });
+		auto left = make_lazy([&](int value) { runs.fetch_add(1); return value + 1; }, base);
+		auto right = make_lazy([&](int value) { runs.fetch_add(1); return value * 2; }, base);
+		auto sum = make_lazy([&](int a, int b) { runs.fetch_add(1); return a + b; }, left, right);
+
+		// Act
+		auto value = sum.get();
+		auto again = sum.get() + left.get();
+
+		// Assert
+		Assert::AreEqual(31, value);
+		Assert::AreEqual(42, again);
+		Assert::AreEqual(4, runs.load());
+	}
+
+	TEST_METHOD(Evaluation_ReleasesThunkAndDependencies)
+	{
+		// Arrange
+		auto captured = make_intrusive<LazyCapture>();
+		auto dependency = make_lazy([] { return 1; });
+		auto lazy = make_lazy([captured](int value) { return captured->Value + value; }, dependency);
+		auto captured_before = captured.use_count();
+		auto dependency_before = dependency.use_count();
+
+		// Act
+		auto value = lazy.get();
+
+		// Assert
+		Assert::AreEqual(8, value);
+		Assert::AreEqual(2u, captured_before);
+		Assert::AreEqual(2u, dependency_before);
+		Assert::AreEqual(1u, captured.use_count());
+		Assert::AreEqual(1u, dependency.use_count());
+	}
+
+	TEST_METHOD(Exception_IsMemoized)
+	{
+		// Arrange
+		auto runs = 0;
+		auto lazy = make_lazy([&]() -> int { ++runs; throw std::runtime_error("failed"); });
+		auto thrown = 0;
+
+		// Act
+		for (auto i = 0; i < 2; ++i)
+		{
+			try
+			{
+				lazy.get();
+			}
+			catch (const std::runtime_error&)
+			{
+				++thrown;
+			}
+		}
+
+		// Assert
+		Assert::AreEqual(1, runs);
+		Assert::AreEqual(2, thrown);
+		Assert::IsFalse(lazy.is_ready());
+	}
+
+	TEST_METHOD(Exception_ReleasesThunkAndDependencies)
+	{
+		// Arrange
+		auto captured = make_intrusive<LazyCapture>();
+		auto dependency = make_lazy([] { return 1; });
+		auto lazy = make_lazy([captured](int) -> int { throw std::runtime_error("failed"); }, dependency);
+		auto thrown = false;
+
+		// Act
+		try
+		{
+			lazy.get();
+		}
+		catch (const std::runtime_error&)
+		{
+			thrown = true;
+		}
+
+		// Assert
+		Assert::IsTrue(thrown);
+		Assert::AreEqual(1u, captured.use_count());
+		Assert::AreEqual(1u, dependency.use_count());
+	}
+};
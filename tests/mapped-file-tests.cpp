@@ -0,0 +1,111 @@
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <system_error>
+#include "CppUnitTest.h"
+#include "include/mapped_file.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+/// <summary>
+/// A temporary file removed at the end of a test
+/// </summary>
+struct TemporaryFile
+{
+	TemporaryFile(const std::string& name, const std::string& content)
+		: Path(std::filesystem::temp_directory_path() / name)
+	{
+		auto stream = std::ofstream(Path, std::ios::binary | std::ios::trunc);
+		stream.write(content.data(), static_cast<std::streamsize>(content.size()));
+	}
+
+	~TemporaryFile()
+	{
+		auto error = std::error_code();
+		std::filesystem::remove(Path, error);
+	}
+
+	std::filesystem::path Path;
+};
+
+
+TEST_CLASS(MappedFileTests)
+{
+public:
+
+	TEST_METHOD(MapFile_ProvidesContent)
+	{
+		// Arrange
+		auto file = TemporaryFile("mapped-file-content.bin", "header:payload");
+
+		// Act
+		auto content = map_file(file.Path);
+
+		// Assert
+		Assert::AreEqual(size_t(14), content.size());
+		Assert::IsTrue(content.view() == "header:payload");
+		Assert::AreEqual(1u, content.use_count());
+	}
+
+	TEST_METHOD(Slices_KeepMappingAlive)
+	{
+		// Arrange
+		auto file = TemporaryFile("mapped-file-slices.bin", "one,two,three");
+		auto content = map_file(file.Path);
+
+		// Act
+		auto first = content.split_to(3);
+		auto last = content.slice(5);
+		auto shared = content.use_count();
+		content = mapped_slice();
+
+		// Assert
+		Assert::AreEqual(3u, shared);
+		Assert::IsTrue(first.view() == "one");
+		Assert::IsTrue(last.view() == "three");
+		Assert::AreEqual(2u, last.use_count());
+	}
+
+	TEST_METHOD(Advise_AcceptsHints)
+	{
+		// Arrange
+		auto file = TemporaryFile("mapped-file-advise.bin", std::string(100000, 'x'));
+		auto content = map_file(file.Path, { access_hint::sequential, true, true });
+		auto tail = content.slice(70000);
+
+		// Act
+		auto will_need = tail.advise(access_hint::will_need);
+		auto dont_need = tail.advise(access_hint::dont_need);
+		auto random = content.advise(access_hint::random);
+
+		// Assert
+		Assert::IsTrue(will_need);
+		Assert::IsTrue(dont_need);
+		Assert::IsTrue(random);
+		Assert::AreEqual(size_t(30000), tail.size());
+		Assert::IsTrue(tail[29999] == std::byte('x'));
+	}
+
+	TEST_METHOD(MapFile_HandlesEmptyAndMissingFiles)
+	{
+		// Arrange
+		auto file = TemporaryFile("mapped-file-empty.bin", "");
+		auto thrown = false;
+
+		// Act
+		auto empty = map_file(file.Path);
+		try
+		{
+			map_file(std::filesystem::temp_directory_path() / "mapped-file-missing.bin");
+		}
+		catch (const std::system_error&)
+		{
+			thrown = true;
+		}
+
+		// Assert
+		Assert::IsTrue(empty.empty());
+		Assert::IsTrue(empty.advise(access_hint::will_need));
+		Assert::IsTrue(thrown);
+	}
+};
@@ -0,0 +1,154 @@
+#include <atomic>
+#include <thread>
+#include <vector>
+#include "CppUnitTest.h"
+#include "include/observer_list.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+struct Listener : public RefCountObject<Listener>
+{
+	Listener(std::atomic<int>& destroyed) : Destroyed(&destroyed) { }
+	Listener() = default;
+	~Listener() override
+	{
+		if (Destroyed != nullptr)
+		{
+			Destroyed->fetch_add(1);
+		}
+	}
+
+	std::atomic<int> Calls { 0 };
+	std::atomic<int>* Destroyed = nullptr;
+};
+
+
+TEST_CLASS(ObserverListTests)
+{
+public:
+
+	TEST_METHOD(Notify_CallsListenersInOrder)
+	{
+		// Arrange
+		auto list = observer_list<Listener>();
+		auto first = make_intrusive<Listener>();
+		auto second = make_intrusive<Listener>();
+		auto order = std::vector<Listener*>();
+		list.subscribe(first);
+		list.subscribe(intrusive_ptr<Listener>());
+		list.subscribe(second);
+		auto size_before = list.size();
+
+		// Act
+		list.notify([&](Listener& listener) { order.push_back(&listener); });
+
+		// Assert
+		Assert::AreEqual(size_t(0), size_before);
+		Assert::AreEqual(size_t(2), list.size());
+		Assert::AreEqual(size_t(2), order.size());
+		Assert::IsTrue(order[0] == first.get());
+		Assert::IsTrue(order[1] == second.get());
+	}
+
+	TEST_METHOD(PendingUnsubscribe_CancelsSubscribe)
+	{
+		// Arrange
+		auto list = observer_list<Listener>();
+		auto listener = make_intrusive<Listener>();
+		auto other = make_intrusive<Listener>();
+		list.subscribe(listener);
+		list.subscribe(other);
+		list.subscribe(listener);
+
+		// Act
+		list.unsubscribe(*listener);
+		list.notify([](Listener& listener) { listener.Calls.fetch_add(1); });
+		list.unsubscribe(*listener);
+		list.notify([](Listener& listener) { listener.Calls.fetch_add(1); });
+		epoch_domain::instance().flush();
+
+		// Assert
+		Assert::AreEqual(1, listener->Calls.load());
+		Assert::AreEqual(2, other->Calls.load());
+		Assert::AreEqual(size_t(1), list.size());
+		Assert::AreEqual(1u, listener.use_count());
+	}
+
+	TEST_METHOD(UnsubscribeDuringNotify_KeepsListenerAlive)
+	{
+		// Arrange
+		auto destroyed = std::atomic<int>(0);
+		auto list = observer_list<Listener>();
+		list.subscribe(make_intrusive<Listener>(std::ref(destroyed)));
+		list.subscribe(make_intrusive<Listener>(std::ref(destroyed)));
+		auto destroyed_during = -1;
+
+		// Act
+		list.notify([&](Listener& listener)
+		{
+			list.unsubscribe(listener);
+			list.commit();
+			epoch_domain::instance().flush();
+			destroyed_during = std::max(destroyed_during, destroyed.load());
+			listener.Calls.fetch_add(1);
+		});
+		epoch_domain::instance().flush();
+
+		// Assert
+		Assert::AreEqual(0, destroyed_during);
+		Assert::AreEqual(2, destroyed.load());
+		Assert::AreEqual(size_t(0), list.size());
+	}
+
+	TEST_METHOD(ConcurrentNotify_WithChanges)
+	{
+		// Arrange
+		auto list = observer_list<Listener>();
+		auto stable = std::vector<intrusive_ptr<Listener>>();
+		for (auto i = 0; i < 100; ++i)
+		{
+			stable.push_back(make_intrusive<Listener>());
+			list.subscribe(stable.back());
+		}
+		auto transient = make_intrusive<Listener>();
+		auto stop = std::atomic<bool>(false);
+		auto notifiers = std::vector<std::thread>();
+
+		// Act
+		for (auto t = 0; t < 4; ++t)
+		{
+			notifiers.emplace_back([&]
+			{
+				for (auto i = 0; i < 1000; ++i)
+				{
+					list.notify([](Listener& listener) { listener.Calls.fetch_add(1, std::memory_order_relaxed); });
+				}
+			});
+		}
+		auto writer = std::thread([&]
+		{
+			while (!stop.load())
+			{
+				list.subscribe(transient);
+				list.commit();
+				list.unsubscribe(*transient);
+				list.commit();
+			}
+		});
+		for (auto& notifier : notifiers)
+		{
+			notifier.join();
+		}
+		stop = true;
+		writer.join();
+		epoch_domain::instance().flush();
+
+		// Assert
+		for (auto& listener : stable)
+		{
+			Assert::AreEqual(4000, listener->Calls.load());
+		}
+		Assert::AreEqual(size_t(100), list.size());
+		Assert::AreEqual(1u, transient.use_count());
+	}
+};
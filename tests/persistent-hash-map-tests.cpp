@@ -0,0 +1,229 @@
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+#include "CppUnitTest.h"
+#include "include/persistent_hash_map.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+struct CollidingHash
+{
+	size_t operator()(int key) const noexcept
+	{
+		return static_cast<size_t>(key % 3);
+	}
+};
+
+
+TEST_CLASS(PersistentHashMapTests)
+{
+public:
+
+	TEST_METHOD(InsertAndFind_Success)
+	{
+		// Arrange
+		auto map = persistent_hash_map<int, std::string>();
+
+		// Act
+		for (auto i = 0; i < 1000; ++i)
+		{
+			map.insert_or_assign(i, std::to_string(i));
+		}
+		auto replaced = !map.insert_or_assign(10, "ten");
+
+		// Assert
+		Assert::IsTrue(replaced);
+		Assert::AreEqual(size_t(1000), map.size());
+		Assert::AreEqual(std::string("ten"), *map.find(10));
+		Assert::AreEqual(std::string("999"), *map.find(999));
+		Assert::IsNull(map.find(1000));
+	}
+
+	TEST_METHOD(Snapshot_IsNotChangedByUpdates)
+	{
+		// Arrange
+		auto map = persistent_hash_map<int, int>();
+		for (auto i = 0; i < 100; ++i)
+		{
+			map.insert_or_assign(i, i);
+		}
+
+		// Act
+		auto snapshot = map;
+		map.insert_or_assign(5, 500);
+		map.erase(6);
+		auto next = snapshot.set(100, 100);
+
+		// Assert
+		Assert::AreEqual(size_t(100), snapshot.size());
+		Assert::AreEqual(5, *snapshot.find(5));
+		Assert::AreEqual(6, *snapshot.find(6));
+		Assert::IsFalse(snapshot.contains(100));
+		Assert::AreEqual(500, *map.find(5));
+		Assert::IsFalse(map.contains(6));
+		Assert::AreEqual(size_t(101), next.size());
+	}
+
+	TEST_METHOD(UniqueVersion_IsUpdatedInPlace)
+	{
+		// Arrange
+		auto map = persistent_hash_map<int, int>();
+		for (auto i = 0; i < 100; ++i)
+		{
+			map.insert_or_assign(i, i);
+		}
+		auto value = map.find(42);
+
+		// Act
+		map.insert_or_assign(42, 4200);
+		auto in_place = map.find(42);
+		auto snapshot = map;
+		map.insert_or_assign(42, 42);
+		auto copied = map.find(42);
+
+		// Assert
+		Assert::IsTrue(value == in_place);
+		Assert::IsTrue(copied != in_place);
+		Assert::AreEqual(4200, *snapshot.find(42));
+		Assert::AreEqual(42, *map.find(42));
+	}
+
+	TEST_METHOD(CollidingKeys_Success)
+	{
+		// Arrange
+		auto map = persistent_hash_map<int, int, CollidingHash>();
+
+		// Act
+		for (auto i = 0; i < 30; ++i)
+		{
+			map.insert_or_assign(i, i * 2);
+		}
+		auto snapshot = map;
+		for (auto i = 0; i < 30; i += 2)
+		{
+			map.erase(i);
+		}
+
+		// Assert
+		Assert::AreEqual(size_t(15), map.size());
+		Assert::AreEqual(size_t(30), snapshot.size());
+		Assert::IsFalse(map.contains(4));
+		Assert::AreEqual(10, *map.find(5));
+		Assert::AreEqual(8, *snapshot.find(4));
+	}
+
+	TEST_METHOD(EraseAll_Success)
+	{
+		// Arrange
+		auto map = persistent_hash_map<int, int>();
+		for (auto i = 0; i < 500; ++i)
+		{
+			map.insert_or_assign(i, i);
+		}
+
+		// Act
+		auto missing = map.erase(500);
+		for (auto i = 0; i < 500; ++i)
+		{
+			map.erase(i);
+		}
+
+		// Assert
+		Assert::IsFalse(missing);
+		Assert::IsTrue(map.empty());
+		Assert::IsNull(map.find(0));
+	}
+
+	TEST_METHOD(Diff_ReportsOnlyChanges)
+	{
+		// Arrange
+		auto map = persistent_hash_map<int, int>();
+		for (auto i = 0; i < 1000; ++i)
+		{
+			map.insert_or_assign(i, i);
+		}
+		auto next = map.set(7, 70).set(1000, 1000).without(500);
+		auto added = 0;
+		auto removed = 0;
+		auto changed = 0;
+
+		// Act
+		map.diff(next, [&](int key, const int* old_value, const int* new_value)
+		{
+			added += old_value == nullptr && key == 1000 ? 1 : 0;
+			removed += new_value == nullptr && key == 500 ? 1 : 0;
+			changed += old_value != nullptr && new_value != nullptr
+				&& key == 7 && *old_value == 7 && *new_value == 70 ? 1 : 0;
+		});
+
+		// Assert
+		Assert::AreEqual(1, added);
+		Assert::AreEqual(1, removed);
+		Assert::AreEqual(1, changed);
+	}
+
+	TEST_METHOD(RandomUpdates_MatchReference)
+	{
+		// Arrange
+		auto random = std::mt19937(42);
+		auto versions = std::vector<persistent_hash_map<int, int, CollidingHash>>();
+		auto references = std::vector<std::map<int, int>>();
+		auto map = persistent_hash_map<int, int, CollidingHash>();
+		auto reference = std::map<int, int>();
+
+		// Act
+		for (auto i = 0; i < 3000; ++i)
+		{
+			auto key = static_cast<int>(random() % 200);
+			if (random() % 3 == 0)
+			{
+				map.erase(key);
+				reference.erase(key);
+			}
+			else
+			{
+				map.insert_or_assign(key, i);
+				reference[key] = i;
+			}
+
+			if (i % 300 == 0)
+			{
+				versions.push_back(map);
+				references.push_back(reference);
+			}
+		}
+
+		// Assert
+		versions.push_back(map);
+		references.push_back(reference);
+		for (size_t v = 0; v < versions.size(); ++v)
+		{
+			auto count = size_t(0);
+			versions[v].for_each([&](int key, int value)
+			{
+				Assert::AreEqual(references[v].at(key), value);
+				++count;
+			});
+			Assert::AreEqual(references[v].size(), count);
+			Assert::AreEqual(references[v].size(), versions[v].size());
+
+			if (v > 0)
+			{
+				auto differences = std::map<int, int>(references[v - 1]);
+				versions[v - 1].diff(versions[v], [&](int key, const int*, const int* new_value)
+				{
+					if (new_value == nullptr)
+					{
+						differences.erase(key);
+					}
+					else
+					{
+						differences[key] = *new_value;
+					}
+				});
+				Assert::IsTrue(differences == references[v]);
+			}
+		}
+	}
+};
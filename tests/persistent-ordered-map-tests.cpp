@@ -0,0 +1,184 @@
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+#include "CppUnitTest.h"
+#include "include/persistent_ordered_map.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+
+TEST_CLASS(PersistentOrderedMapTests)
+{
+public:
+
+	TEST_METHOD(InsertAndFind_Success)
+	{
+		// Arrange
+		auto map = persistent_ordered_map<int, std::string>();
+
+		// Act
+		for (auto i = 0; i < 2000; ++i)
+		{
+			map.insert_or_assign((i * 7919) % 2000, std::to_string(i));
+		}
+		auto replaced = !map.insert_or_assign(10, "ten");
+
+		// Assert
+		Assert::IsTrue(replaced);
+		Assert::AreEqual(size_t(2000), map.size());
+		Assert::AreEqual(std::string("ten"), *map.find(10));
+		Assert::IsNotNull(map.find(1999));
+		Assert::IsNull(map.find(2000));
+	}
+
+	TEST_METHOD(Iteration_IsOrdered)
+	{
+		// Arrange
+		auto map = persistent_ordered_map<std::string, int>();
+		for (auto i = 999; i >= 0; --i)
+		{
+			map.insert_or_assign(std::to_string(i), i);
+		}
+
+		// Act
+		auto keys = std::vector<std::string>();
+		for (auto [key, value] : map)
+		{
+			keys.push_back(key);
+		}
+
+		// Assert
+		Assert::AreEqual(size_t(1000), keys.size());
+		Assert::IsTrue(std::is_sorted(keys.begin(), keys.end()));
+	}
+
+	TEST_METHOD(RangeQuery_Success)
+	{
+		// Arrange
+		auto map = persistent_ordered_map<int, int>();
+		for (auto i = 0; i < 1000; i += 2)
+		{
+			map.insert_or_assign(i, i * 10);
+		}
+		auto keys = std::vector<int>();
+
+		// Act
+		map.for_each_range(101, 111, [&](int key, int)
+		{
+			keys.push_back(key);
+		});
+		auto last = map.lower_bound(998);
+		auto none = map.lower_bound(999);
+
+		// Assert
+		Assert::AreEqual(size_t(5), keys.size());
+		Assert::AreEqual(102, keys.front());
+		Assert::AreEqual(110, keys.back());
+		Assert::AreEqual(9980, last.value());
+		Assert::IsTrue(none == map.end());
+	}
+
+	TEST_METHOD(OldVersion_StaysReadable)
+	{
+		// Arrange
+		auto map = persistent_ordered_map<int, int>();
+		for (auto i = 0; i < 500; ++i)
+		{
+			map.insert_or_assign(i, i);
+		}
+
+		// Act
+		auto snapshot = map;
+		auto next = map.transact([](persistent_ordered_map<int, int>& version)
+		{
+			for (auto i = 0; i < 500; i += 5)
+			{
+				version.erase(i);
+			}
+			version.insert_or_assign(1000, 1000);
+			version.insert_or_assign(1, -1);
+		});
+
+		// Assert
+		Assert::AreEqual(size_t(500), snapshot.size());
+		Assert::AreEqual(0, *snapshot.find(0));
+		Assert::AreEqual(1, *snapshot.find(1));
+		Assert::AreEqual(size_t(401), next.size());
+		Assert::IsFalse(next.contains(0));
+		Assert::AreEqual(-1, *next.find(1));
+		Assert::AreEqual(1000, *next.find(1000));
+	}
+
+	TEST_METHOD(UniqueVersion_IsUpdatedInPlace)
+	{
+		// Arrange
+		auto map = persistent_ordered_map<int, int>();
+		for (auto i = 0; i < 100; ++i)
+		{
+			map.insert_or_assign(i, i);
+		}
+		auto value = map.find(42);
+
+		// Act
+		map.insert_or_assign(42, 4200);
+		auto in_place = map.find(42);
+		auto snapshot = map;
+		map.insert_or_assign(42, 42);
+		auto copied = map.find(42);
+
+		// Assert
+		Assert::IsTrue(value == in_place);
+		Assert::IsTrue(copied != in_place);
+		Assert::AreEqual(4200, *snapshot.find(42));
+	}
+
+	TEST_METHOD(RandomUpdates_MatchReference)
+	{
+		// Arrange
+		auto random = std::mt19937(3);
+		auto versions = std::vector<persistent_ordered_map<int, int>>();
+		auto references = std::vector<std::map<int, int>>();
+		auto map = persistent_ordered_map<int, int>();
+		auto reference = std::map<int, int>();
+
+		// Act
+		for (auto i = 0; i < 20000; ++i)
+		{
+			auto key = static_cast<int>(random() % 3000);
+			if (random() % 2 == 0)
+			{
+				map.erase(key);
+				reference.erase(key);
+			}
+			else
+			{
+				map.insert_or_assign(key, i);
+				reference[key] = i;
+			}
+
+			if (i % 2000 == 0)
+			{
+				versions.push_back(map);
+				references.push_back(reference);
+			}
+		}
+		versions.push_back(map);
+		references.push_back(reference);
+
+		// Assert
+		for (size_t v = 0; v < versions.size(); ++v)
+		{
+			auto expected = references[v].begin();
+			for (auto [key, value] : versions[v])
+			{
+				Assert::IsTrue(expected != references[v].end());
+				Assert::AreEqual(expected->first, key);
+				Assert::AreEqual(expected->second, value);
+				++expected;
+			}
+			Assert::IsTrue(expected == references[v].end());
+			Assert::AreEqual(references[v].size(), versions[v].size());
+		}
+	}
+};
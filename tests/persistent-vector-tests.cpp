@@ -0,0 +1,197 @@
+#include <random>
+#include <string>
+#include <vector>
+#include "CppUnitTest.h"
+#include "include/persistent_vector.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+static void AssertSameElements(const std::vector<int>& expected, const persistent_vector<int>& actual)
+{
+	Assert::AreEqual(expected.size(), actual.size());
+
+	auto index = size_t(0);
+	for (auto& value : actual)
+	{
+		Assert::AreEqual(expected[index], value);
+		Assert::AreEqual(expected[index], actual[index]);
+		++index;
+	}
+	Assert::AreEqual(expected.size(), index);
+}
+
+
+TEST_CLASS(PersistentVectorTests)
+{
+public:
+
+	TEST_METHOD(PushBackAndIndex_Success)
+	{
+		// Arrange
+		auto vector = persistent_vector<std::string>();
+
+		// Act
+		for (auto i = 0; i < 5000; ++i)
+		{
+			vector.push_back(std::to_string(i));
+		}
+
+		// Assert
+		Assert::AreEqual(size_t(5000), vector.size());
+		Assert::AreEqual(std::string("0"), vector[0]);
+		Assert::AreEqual(std::string("1056"), vector[1056]);
+		Assert::AreEqual(std::string("4999"), vector.back());
+	}
+
+	TEST_METHOD(Snapshot_IsNotChangedByUpdates)
+	{
+		// Arrange
+		auto vector = persistent_vector<int>();
+		for (auto i = 0; i < 1000; ++i)
+		{
+			vector.push_back(i);
+		}
+
+		// Act
+		auto snapshot = vector;
+		vector.assign(10, -10);
+		vector.assign(999, -999);
+		vector.push_back(1000);
+		vector.pop_back();
+		vector.pop_back();
+
+		// Assert
+		Assert::AreEqual(size_t(1000), snapshot.size());
+		Assert::AreEqual(10, snapshot[10]);
+		Assert::AreEqual(999, snapshot[999]);
+		Assert::AreEqual(size_t(999), vector.size());
+		Assert::AreEqual(-10, vector[10]);
+		Assert::AreEqual(998, vector.back());
+	}
+
+	TEST_METHOD(UniqueVersion_IsUpdatedInPlace)
+	{
+		// Arrange
+		auto vector = persistent_vector<int>();
+		for (auto i = 0; i < 100; ++i)
+		{
+			vector.push_back(i);
+		}
+		auto element = &vector[5];
+
+		// Act
+		vector.assign(5, 50);
+		auto in_place = &vector[5];
+		auto snapshot = vector;
+		vector.assign(5, 500);
+		auto copied = &vector[5];
+
+		// Assert
+		Assert::IsTrue(element == in_place);
+		Assert::IsTrue(copied != in_place);
+		Assert::AreEqual(50, snapshot[5]);
+		Assert::AreEqual(500, vector[5]);
+	}
+
+	TEST_METHOD(TakeAndDrop_Success)
+	{
+		// Arrange
+		auto vector = persistent_vector<int>();
+		auto expected = std::vector<int>();
+		for (auto i = 0; i < 3000; ++i)
+		{
+			vector.push_back(i);
+			expected.push_back(i);
+		}
+
+		// Act
+		auto head = vector.take(1234);
+		auto rest = vector.drop(1234);
+		auto middle = vector.slice(100, 2900);
+
+		// Assert
+		AssertSameElements(std::vector<int>(expected.begin(), expected.begin() + 1234), head);
+		AssertSameElements(std::vector<int>(expected.begin() + 1234, expected.end()), rest);
+		AssertSameElements(std::vector<int>(expected.begin() + 100, expected.begin() + 2900), middle);
+		AssertSameElements(expected, vector);
+	}
+
+	TEST_METHOD(Concat_Success)
+	{
+		// Arrange
+		auto left = persistent_vector<int>();
+		auto right = persistent_vector<int>();
+		auto expected = std::vector<int>();
+		for (auto i = 0; i < 1500; ++i)
+		{
+			left.push_back(i);
+			expected.push_back(i);
+		}
+		for (auto i = 0; i < 2100; ++i)
+		{
+			right.push_back(-i);
+			expected.push_back(-i);
+		}
+
+		// Act
+		auto result = left.concat(right);
+		result.push_back(7);
+		expected.push_back(7);
+
+		// Assert
+		AssertSameElements(expected, result);
+		Assert::AreEqual(size_t(1500), left.size());
+		Assert::AreEqual(size_t(2100), right.size());
+	}
+
+	TEST_METHOD(RandomSlicesAndConcats_MatchReference)
+	{
+		// Arrange
+		auto random = std::mt19937(7);
+		auto vector = persistent_vector<int>();
+		auto expected = std::vector<int>();
+		for (auto i = 0; i < 2000; ++i)
+		{
+			vector.push_back(i);
+			expected.push_back(i);
+		}
+
+		// Act && Assert
+		for (auto step = 0; step < 200; ++step)
+		{
+			auto first = random() % (expected.size() + 1);
+			auto last = first + random() % (expected.size() - first + 1);
+			auto piece = vector.slice(first, last);
+			auto expected_piece = std::vector<int>(expected.begin() + first, expected.begin() + last);
+
+			if (random() % 2 == 0)
+			{
+				vector = vector.concat(piece);
+				expected.insert(expected.end(), expected_piece.begin(), expected_piece.end());
+			}
+			else
+			{
+				vector = piece.concat(vector);
+				expected.insert(expected.begin(), expected_piece.begin(), expected_piece.end());
+			}
+
+			if (expected.size() > 20000)
+			{
+				vector = vector.drop(expected.size() - 5000);
+				expected.erase(expected.begin(), expected.end() - 5000);
+			}
+
+			for (auto i = random() % 40; i > 0; --i)
+			{
+				vector.push_back(step);
+				expected.push_back(step);
+			}
+
+			if (step % 20 == 0)
+			{
+				AssertSameElements(expected, vector);
+			}
+		}
+		AssertSameElements(expected, vector);
+	}
+};
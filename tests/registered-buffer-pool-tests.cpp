@@ -0,0 +1,261 @@
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include "CppUnitTest.h"
+#include "include/registered_buffer_pool.h"
+#if defined(__linux__)
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+static void FillBuffer(registered_buffer& buffer, std::string_view text)
+{
+	std::memcpy(buffer.data(), text.data(), text.size());
+	buffer.resize(text.size());
+}
+
+static std::string BufferText(registered_buffer& buffer)
+{
+	return std::string(reinterpret_cast<const char*>(buffer.data()), buffer.size());
+}
+
+#if defined(__linux__)
+/// <summary>
+/// A temporary descriptor closed at the end of a test
+/// </summary>
+struct RegisteredBufferFile
+{
+	RegisteredBufferFile(std::string_view content)
+	{
+		char path[] = "/tmp/registered-buffer-XXXXXX";
+		Fd = ::mkstemp(path);
+		::unlink(path);
+		Assert::AreEqual(static_cast<ssize_t>(content.size()), ::write(Fd, content.data(), content.size()));
+	}
+
+	~RegisteredBufferFile()
+	{
+		::close(Fd);
+	}
+
+	int Fd;
+};
+
+/// <summary>
+/// Creates a ring, or returns null, if io_uring is missing in the kernel
+/// or denied by a seccomp profile, so the test is skipped
+/// </summary>
+static std::unique_ptr<io_ring> TryCreateRing(unsigned entries)
+{
+	try
+	{
+		return std::make_unique<io_ring>(entries);
+	}
+	catch (const std::system_error& e)
+	{
+		if (e.code() != std::errc::function_not_supported && e.code() != std::errc::operation_not_permitted)
+		{
+			throw;
+		}
+		Logger::WriteMessage("io_uring is unavailable, the test is skipped");
+		return nullptr;
+	}
+}
+#endif
+
+
+TEST_CLASS(RegisteredBufferPoolTests)
+{
+public:
+
+	TEST_METHOD(TryAcquire_ReturnsNullWhenExhausted)
+	{
+		// Arrange
+		auto pool = registered_buffer_pool(2, 64);
+
+		// Act
+		auto first = pool.try_acquire();
+		auto second = pool.try_acquire();
+		auto third = pool.try_acquire();
+		auto index = first->index();
+		first = nullptr;
+		auto reused = pool.try_acquire();
+
+		// Assert
+		Assert::IsTrue(third == nullptr);
+		Assert::IsTrue(reused != nullptr);
+		Assert::AreEqual(index, reused->index());
+		Assert::AreEqual(size_t(0), reused->size());
+		Assert::AreEqual(size_t(64), reused->capacity());
+		Assert::AreEqual(size_t(0), pool.available());
+	}
+
+	TEST_METHOD(Constructor_RejectsTooManyBuffers)
+	{
+		// Arrange
+		auto thrown = false;
+
+		// Act
+		auto largest = registered_buffer_pool(buffer_block::max_count, 1);
+		auto last = largest.try_acquire();
+		try
+		{
+			registered_buffer_pool(buffer_block::max_count + 1, 1);
+		}
+		catch (const std::invalid_argument&)
+		{
+			thrown = true;
+		}
+
+		// Assert
+		Assert::IsTrue(thrown);
+		Assert::AreEqual(uint16_t(0), last->index());
+		Assert::AreEqual(uint16_t(65535), largest.buffer(65535).index());
+	}
+
+	TEST_METHOD(Constructor_RejectsOverflowingTotalSize)
+	{
+		// Arrange
+		auto thrown = false;
+
+		// Act
+		try
+		{
+			registered_buffer_pool(4, SIZE_MAX / 2);
+		}
+		catch (const std::invalid_argument&)
+		{
+			thrown = true;
+		}
+
+		// Assert
+		Assert::IsTrue(thrown);
+	}
+
+	TEST_METHOD(UserData_KeepsBufferOutOfPool)
+	{
+		// Arrange
+		auto pool = registered_buffer_pool(4, 64);
+		auto buffer = pool.try_acquire();
+		FillBuffer(*buffer, "in flight");
+
+		// Act
+		auto user_data = to_user_data(std::move(buffer));
+		auto in_flight = pool.available();
+		auto completed = from_user_data(user_data);
+		auto text = BufferText(*completed);
+		completed = nullptr;
+
+		// Assert
+		Assert::AreEqual(size_t(3), in_flight);
+		Assert::AreEqual(std::string("in flight"), text);
+		Assert::AreEqual(size_t(4), pool.available());
+	}
+
+	TEST_METHOD(Buffers_ArePageAligned)
+	{
+		// Arrange
+		auto pool = registered_buffer_pool(3, 4096);
+
+		// Act
+		auto first = pool.buffer(0).data();
+		auto last = pool.buffer(2).data();
+
+		// Assert
+		Assert::AreEqual(uintptr_t(0), reinterpret_cast<uintptr_t>(first) % 4096);
+		Assert::IsTrue(last == first + 2 * 4096);
+	}
+
+#if defined(__linux__)
+	TEST_METHOD(ReadFixed_ReleasesBufferOnCompletion)
+	{
+		// Arrange
+		auto file = RegisteredBufferFile("header:payload");
+		auto pool = registered_buffer_pool(4, 4096);
+		auto ring_pointer = TryCreateRing(8);
+		if (!ring_pointer)
+		{
+			return;
+		}
+		auto& ring = *ring_pointer;
+		ring.register_buffers(pool);
+
+		// Act
+		Assert::IsTrue(ring.prepare_read_fixed(file.Fd, pool.try_acquire(), 4096, 7));
+		auto in_flight = pool.available();
+		ring.submit();
+		auto completion = io_uring_cqe();
+		ring.wait(completion);
+		auto buffer = from_user_data(completion.user_data);
+		buffer->resize(static_cast<size_t>(completion.res));
+		auto text = BufferText(*buffer);
+		buffer = nullptr;
+		ring.unregister_buffers();
+
+		// Assert
+		Assert::AreEqual(size_t(3), in_flight);
+		Assert::AreEqual(7, completion.res);
+		Assert::AreEqual(std::string("payload"), text);
+		Assert::AreEqual(size_t(4), pool.available());
+	}
+
+	TEST_METHOD(RecvMultishot_RecyclesProvidedBuffers)
+	{
+		// Arrange
+		auto ring_pointer = TryCreateRing(8);
+		if (!ring_pointer)
+		{
+			return;
+		}
+		auto& ring = *ring_pointer;
+		int fds[2];
+		Assert::AreEqual(0, ::socketpair(AF_UNIX, SOCK_SEQPACKET, 0, fds));
+		auto pool = registered_buffer_pool(1, 64);
+		ring.register_buffers(pool);
+		auto provided = provided_buffer_group(ring, 7, 2, 64);
+		auto received = std::string();
+
+		// Act
+		Assert::IsTrue(ring.prepare_recv_multishot(fds[1], provided.group(), 0));
+		for (auto message : { std::string_view("one"), std::string_view("two"), std::string_view("three") })
+		{
+			auto output = pool.try_acquire();
+			FillBuffer(*output, message);
+			Assert::IsTrue(ring.prepare_write_fixed(fds[0], std::move(output), 0));
+			ring.submit();
+			for (auto pending = 2; pending != 0; --pending)
+			{
+				auto completion = io_uring_cqe();
+				ring.wait(completion);
+				if (completion.user_data == 0)
+				{
+					Assert::IsTrue((completion.flags & IORING_CQE_F_MORE) != 0);
+					auto input = provided.take(completion.flags, static_cast<size_t>(completion.res));
+					received += BufferText(*input) + ";";
+				}
+				else
+				{
+					Assert::AreEqual(static_cast<int>(message.size()), completion.res);
+					from_user_data(completion.user_data);
+				}
+			}
+		}
+		::close(fds[0]);
+		auto end = io_uring_cqe();
+		ring.wait(end);
+		::close(fds[1]);
+
+		// Assert
+		Assert::AreEqual(std::string("one;two;three;"), received);
+		Assert::AreEqual(size_t(1), pool.available());
+		Assert::AreEqual(0, end.res);
+		Assert::IsTrue((end.flags & IORING_CQE_F_MORE) == 0);
+	}
+#endif
+};
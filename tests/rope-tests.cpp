@@ -0,0 +1,168 @@
+#include <random>
+#include <string>
+#include "CppUnitTest.h"
+#include "include/rope.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+static std::string MakeText(size_t length)
+{
+	auto text = std::string();
+	text.reserve(length);
+	for (size_t i = 0; i < length; ++i)
+	{
+		text.push_back(static_cast<char>('a' + i % 26));
+	}
+	return text;
+}
+
+
+TEST_CLASS(RopeTests)
+{
+public:
+
+	TEST_METHOD(CreateFromString_Success)
+	{
+		// Arrange
+		auto text = MakeText(10000);
+
+		// Act
+		auto value = rope(text);
+
+		// Assert
+		Assert::AreEqual(text.size(), value.size());
+		Assert::AreEqual(text[0], value[0]);
+		Assert::AreEqual(text[5000], value[5000]);
+		Assert::AreEqual(text[9999], value[9999]);
+		Assert::AreEqual(text, value.to_string());
+		Assert::IsTrue(rope().empty());
+	}
+
+	TEST_METHOD(ConcatAndSubstr_ShareChunks)
+	{
+		// Arrange
+		auto text = MakeText(20000);
+		auto value = rope(text);
+
+		// Act
+		auto piece = value.substr(4000, 8192);
+		auto joined = piece.concat(rope("0123456789"));
+
+		// Assert
+		Assert::AreEqual(text.substr(4000, 8192), piece.to_string());
+		Assert::AreEqual(text.substr(4000, 8192) + "0123456789", joined.to_string());
+		Assert::IsTrue((*piece.chunk_begin()).data() == (*value.chunk_begin()).data() + 4000);
+		Assert::AreEqual(text, value.to_string());
+	}
+
+	TEST_METHOD(InsertAndErase_Success)
+	{
+		// Arrange
+		auto text = std::string("hello world");
+		auto value = rope(text);
+		auto snapshot = value;
+
+		// Act
+		value.insert(5, rope(","));
+		value.insert(value.size(), rope("!"));
+		value.insert(0, rope(">> "));
+		value.erase(3, 1);
+
+		// Assert
+		Assert::AreEqual(std::string(">> ello, world!"), value.to_string());
+		Assert::AreEqual(text, snapshot.to_string());
+	}
+
+	TEST_METHOD(ChunkIterator_VisitsAllChunksInOrder)
+	{
+		// Arrange
+		auto value = rope(MakeText(10000));
+		value.append(rope(MakeText(5000)));
+		auto chunks = 0;
+		auto result = std::string();
+
+		// Act
+		for (auto it = value.chunk_begin(); it != value.chunk_end(); ++it)
+		{
+			result.append(*it);
+			++chunks;
+		}
+
+		// Assert
+		Assert::AreEqual(MakeText(10000) + MakeText(5000), result);
+		Assert::AreEqual(5, chunks);
+	}
+
+	TEST_METHOD(SmallAppends_AreMerged)
+	{
+		// Arrange
+		auto value = rope();
+
+		// Act
+		for (auto i = 0; i < 100; ++i)
+		{
+			value.append(rope("ab"));
+		}
+		auto chunks = 0;
+		for (auto it = value.chunk_begin(); it != value.chunk_end(); ++it)
+		{
+			++chunks;
+		}
+
+		// Assert
+		Assert::AreEqual(size_t(200), value.size());
+		Assert::AreEqual(1, chunks);
+	}
+
+	TEST_METHOD(RandomEdits_MatchReference)
+	{
+		// Arrange
+		auto random = std::mt19937(11);
+		auto value = rope(MakeText(3000));
+		auto expected = MakeText(3000);
+
+		// Act && Assert
+		for (auto step = 0; step < 2000; ++step)
+		{
+			auto position = random() % (expected.size() + 1);
+			auto count = random() % 300;
+			switch (random() % 3)
+			{
+			case 0:
+			{
+				auto text = MakeText(count);
+				value.insert(position, rope(text));
+				expected.insert(position, text);
+				break;
+			}
+			case 1:
+				value.erase(position, count);
+				expected.erase(position, count);
+				break;
+			default:
+			{
+				auto piece = value.substr(position, count);
+				Assert::AreEqual(expected.substr(position, count), piece.to_string());
+				auto target = random() % (expected.size() + 1);
+				value.insert(target, piece);
+				expected.insert(target, expected.substr(position, count));
+				break;
+			}
+			}
+
+			Assert::AreEqual(expected.size(), value.size());
+			if (step % 100 == 0)
+			{
+				Assert::AreEqual(expected, value.to_string());
+				if (!expected.empty())
+				{
+					auto index = random() % expected.size();
+					Assert::AreEqual(expected[index], value[index]);
+				}
+			}
+		}
+
+		value.compact();
+		Assert::AreEqual(expected, value.to_string());
+	}
+};
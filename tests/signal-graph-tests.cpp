@@ -0,0 +1,306 @@
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "CppUnitTest.h"
+#include "include/signal_graph.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+TEST_CLASS(SignalGraphTests)
+{
+public:
+
+	TEST_METHOD(Computed_RecomputesLazilyAfterChange)
+	{
+		// Arrange
+		auto runs = 0;
+		auto width = make_source(2);
+		auto height = make_source(3);
+		auto area = make_computed([&](int w, int h) { ++runs; return w * h; }, width, height);
+		auto runs_before = runs;
+
+		// Act
+		auto first = area.get();
+		width.set(5);
+		auto stale = area.is_stale();
+		auto runs_after_set = runs;
+		auto second = area.get();
+
+		// Assert
+		Assert::AreEqual(0, runs_before);
+		Assert::AreEqual(6, first);
+		Assert::IsTrue(stale);
+		Assert::AreEqual(1, runs_after_set);
+		Assert::AreEqual(15, second);
+		Assert::AreEqual(2, runs);
+	}
+
+	TEST_METHOD(Diamond_RecomputesEachNodeOnce)
+	{
+		// Arrange
+		auto runs = std::vector<int>(3);
+		auto source = make_source(1);
+		auto left = make_computed([&](int value) { ++runs[0]; return value + 1; }, source);
+		auto right = make_computed([&](int value) { ++runs[1]; return value * 10; }, source);
+		auto sum = make_computed([&](int a, int b) { ++runs[2]; return a + b; }, left, right);
+		sum.get();
+
+		// Act
+		source.set(2);
+		auto value = sum.get();
+
+		// Assert
+		Assert::AreEqual(23, value);
+		Assert::AreEqual(2, runs[0]);
+		Assert::AreEqual(2, runs[1]);
+		Assert::AreEqual(2, runs[2]);
+	}
+
+	TEST_METHOD(EqualValue_StopsPropagation)
+	{
+		// Arrange
+		auto runs = 0;
+		auto source = make_source(4);
+		auto parity = make_computed([](int value) { return value % 2; }, source);
+		auto label = make_computed([&](int value) { ++runs; return value == 0 ? std::string("even") : std::string("odd"); }, parity);
+		label.get();
+		auto version = parity.version();
+
+		// Act
+		source.set(6);
+		auto value = label.get();
+		source.set(6);
+
+		// Assert
+		Assert::AreEqual(std::string("even"), value);
+		Assert::AreEqual(1, runs);
+		Assert::AreEqual(version, parity.version());
+		Assert::IsFalse(label.is_stale());
+	}
+
+	TEST_METHOD(Effect_RunsOnceForBatch)
+	{
+		// Arrange
+		auto seen = std::vector<int>();
+		auto first = make_source(1);
+		auto second = make_source(2);
+		auto sum = make_computed([](int a, int b) { return a + b; }, first, second);
+		auto effect = make_effect([&](int value) { seen.push_back(value); }, sum);
+
+		// Act
+		first.set(10);
+		{
+			auto batch = signal_batch();
+			first.set(20);
+			second.set(30);
+			batch.commit();
+		}
+
+		// Assert
+		Assert::AreEqual(size_t(3), seen.size());
+		Assert::AreEqual(3, seen[0]);
+		Assert::AreEqual(12, seen[1]);
+		Assert::AreEqual(50, seen[2]);
+	}
+
+	TEST_METHOD(Effect_CanChangeSources)
+	{
+		// Arrange
+		auto input = make_source(1);
+		auto doubled = make_source(0);
+		auto seen = std::vector<int>();
+		auto forward = make_effect([doubled](int value) { doubled.set(value * 2); }, input);
+		auto observe = make_effect([&](int value) { seen.push_back(value); }, doubled);
+
+		// Act
+		input.set(5);
+
+		// Assert
+		Assert::AreEqual(size_t(2), seen.size());
+		Assert::AreEqual(2, seen[0]);
+		Assert::AreEqual(10, seen[1]);
+	}
+
+	TEST_METHOD(Effect_ExceptionRunsOtherEffectsAndRethrows)
+	{
+		// Arrange
+		auto source = make_source(1);
+		auto seen = std::vector<int>();
+		auto failing = make_effect([](int value)
+		{
+			if (value == 2)
+			{
+				throw std::runtime_error("failed");
+			}
+		}, source);
+		auto observe = make_effect([&](int value) { seen.push_back(value); }, source);
+		auto thrown = false;
+
+		// Act
+		try
+		{
+			source.set(2);
+		}
+		catch (const std::runtime_error&)
+		{
+			thrown = true;
+		}
+		source.set(3);
+
+		// Assert
+		Assert::IsTrue(thrown);
+		Assert::IsTrue(std::vector<int> { 1, 2, 3 } == seen);
+	}
+
+	TEST_METHOD(Effect_RunsAgainAfterFailedComputed)
+	{
+		// Arrange
+		auto source = make_source(1);
+		auto computed = make_computed([](int value)
+		{
+			if (value < 0)
+			{
+				throw std::runtime_error("negative");
+			}
+			return value * 10;
+		}, source);
+		auto seen = std::vector<int>();
+		auto effect = make_effect([&](int value) { seen.push_back(value); }, computed);
+		auto thrown = 0;
+
+		// Act
+		for (auto value : { -1, -2 })
+		{
+			try
+			{
+				source.set(value);
+			}
+			catch (const std::runtime_error&)
+			{
+				++thrown;
+			}
+		}
+		auto stale = computed.is_stale();
+		source.set(2);
+
+		// Assert
+		Assert::AreEqual(2, thrown);
+		Assert::IsTrue(stale);
+		Assert::IsTrue(std::vector<int> { 10, 20 } == seen);
+		Assert::IsFalse(computed.is_stale());
+	}
+
+	TEST_METHOD(Computed_StaysStaleAfterException)
+	{
+		// Arrange
+		auto source = make_source(0);
+		auto failing = true;
+		auto computed = make_computed([&](int value)
+		{
+			if (failing)
+			{
+				throw std::runtime_error("failed");
+			}
+			return value + 1;
+		}, source);
+		auto doubled = make_computed([](int value) { return value * 2; }, computed);
+		auto thrown = 0;
+
+		// Act
+		for (auto i = 0; i < 2; ++i)
+		{
+			try
+			{
+				doubled.get();
+			}
+			catch (const std::runtime_error&)
+			{
+				++thrown;
+			}
+		}
+		auto stale = computed.is_stale();
+		failing = false;
+		auto value = doubled.get();
+
+		// Assert
+		Assert::AreEqual(2, thrown);
+		Assert::IsTrue(stale);
+		Assert::AreEqual(2, value);
+		Assert::IsFalse(computed.is_stale());
+	}
+
+	TEST_METHOD(Computed_RecomputesAfterExceptionOnChange)
+	{
+		// Arrange
+		auto source = make_source(1);
+		auto computed = make_computed([](int value)
+		{
+			if (value < 0)
+			{
+				throw std::runtime_error("negative");
+			}
+			return value * 10;
+		}, source);
+		auto first = computed.get();
+
+		// Act
+		source.set(-1);
+		auto thrown = false;
+		try
+		{
+			computed.get();
+		}
+		catch (const std::runtime_error&)
+		{
+			thrown = true;
+		}
+		source.set(2);
+		auto second = computed.get();
+
+		// Assert
+		Assert::AreEqual(10, first);
+		Assert::IsTrue(thrown);
+		Assert::AreEqual(20, second);
+	}
+
+	TEST_METHOD(DeepChain_RefreshesAndFreesIteratively)
+	{
+		// Arrange
+		auto source = make_source(0);
+		auto last = signal<int>(source);
+		for (auto i = 0; i < 1000000; ++i)
+		{
+			last = make_computed([](int value) { return value + 1; }, last);
+		}
+
+		// Act
+		auto first = last.get();
+		source.set(1);
+		auto second = last.get();
+		last = signal<int>();
+
+		// Assert
+		Assert::AreEqual(1000000, first);
+		Assert::AreEqual(1000001, second);
+		Assert::AreEqual(1u, source.use_count());
+	}
+
+	TEST_METHOD(UnobservedNodes_AreFreed)
+	{
+		// Arrange
+		auto source = make_source(1);
+		auto runs = 0;
+		{
+			auto computed = make_computed([](int value) { return value + 1; }, source);
+			auto effect = make_effect([&](int) { ++runs; }, computed);
+		}
+		auto use_count = source.use_count();
+
+		// Act
+		source.set(2);
+
+		// Assert
+		Assert::AreEqual(1u, use_count);
+		Assert::AreEqual(1, runs);
+	}
+};
@@ -0,0 +1,156 @@
+#include <atomic>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+#include "CppUnitTest.h"
+#include "include/task_scheduler.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+TEST_CLASS(TaskSchedulerTests)
+{
+public:
+
+	TEST_METHOD(Diamond_RunsSuccessorsAfterPredecessors)
+	{
+		// Arrange
+		auto scheduler = task_scheduler(4);
+		auto order = std::vector<int>();
+		auto lock = std::mutex();
+		auto record = [&](int id)
+		{
+			return make_task([&, id]
+			{
+				auto guard = std::lock_guard(lock);
+				order.push_back(id);
+			});
+		};
+		auto first = record(1);
+		auto left = record(2);
+		auto right = record(3);
+		auto last = record(4);
+		first->precede(*left);
+		first->precede(*right);
+		left->precede(*last);
+		right->precede(*last);
+
+		// Act
+		scheduler.submit(last);
+		scheduler.submit(right);
+		scheduler.submit(left);
+		scheduler.submit(first);
+		last->wait();
+
+		// Assert
+		Assert::AreEqual(size_t(4), order.size());
+		Assert::AreEqual(1, order.front());
+		Assert::AreEqual(4, order.back());
+		Assert::IsTrue(first->is_done());
+	}
+
+	TEST_METHOD(Execute_ReleasesSchedulerReferences)
+	{
+		// Arrange
+		auto scheduler = task_scheduler(2);
+		auto first = make_task([] { });
+		auto second = make_task([] { });
+		first->precede(*second);
+		auto linked_count = second.use_count();
+
+		// Act
+		scheduler.submit(first);
+		scheduler.submit(second);
+		scheduler.wait_idle();
+
+		// Assert
+		Assert::AreEqual(2u, linked_count);
+		Assert::AreEqual(1u, first.use_count());
+		Assert::AreEqual(1u, second.use_count());
+	}
+
+	TEST_METHOD(WaitIdle_RefusesWorkerThread)
+	{
+		// Arrange
+		auto scheduler = task_scheduler(2);
+		auto refused = std::atomic<bool>(false);
+		auto task = make_task([&]
+		{
+			try
+			{
+				scheduler.wait_idle();
+			}
+			catch (const std::logic_error&)
+			{
+				refused = true;
+			}
+		});
+
+		// Act
+		scheduler.submit(task);
+		scheduler.wait_idle();
+
+		// Assert
+		Assert::IsTrue(refused.load());
+	}
+
+	TEST_METHOD(ForkJoin_SpawnsFromWorkers)
+	{
+		// Arrange
+		auto scheduler = task_scheduler(4);
+		auto sum = std::atomic<long long>(0);
+		auto spawn = [&](auto& self, int first, int last) -> void
+		{
+			if (last - first <= 64)
+			{
+				auto local = 0ll;
+				for (auto i = first; i < last; ++i)
+				{
+					local += i;
+				}
+				sum.fetch_add(local, std::memory_order_relaxed);
+				return;
+			}
+
+			auto middle = first + (last - first) / 2;
+			scheduler.submit(make_task([&self, first, middle] { self(self, first, middle); }));
+			scheduler.submit(make_task([&self, middle, last] { self(self, middle, last); }));
+		};
+
+		// Act
+		spawn(spawn, 0, 100000);
+		scheduler.wait_idle();
+
+		// Assert
+		Assert::AreEqual(100000ll * 99999 / 2, sum.load());
+	}
+
+	TEST_METHOD(WideGraph_JoinsAllBranches)
+	{
+		// Arrange
+		constexpr auto width = 2000;
+		auto scheduler = task_scheduler(4);
+		auto executed = std::atomic<int>(0);
+		auto joined = -1;
+		auto source = make_task([&] { executed.fetch_add(1, std::memory_order_relaxed); });
+		auto sink = make_task([&] { joined = executed.load(std::memory_order_relaxed); });
+		auto branches = std::vector<intrusive_ptr<graph_task>>();
+		for (auto i = 0; i < width; ++i)
+		{
+			branches.push_back(make_task([&] { executed.fetch_add(1, std::memory_order_relaxed); }));
+			source->precede(*branches.back());
+			branches.back()->precede(*sink);
+		}
+
+		// Act
+		scheduler.submit(sink);
+		for (auto& branch : branches)
+		{
+			scheduler.submit(branch);
+		}
+		scheduler.submit(source);
+		sink->wait();
+
+		// Assert
+		Assert::AreEqual(width + 1, joined);
+	}
+};
@@ -0,0 +1,229 @@
+#include <map>
+#include <random>
+#include <stdexcept>
+#include <vector>
+#include "CppUnitTest.h"
+#include "include/timer_wheel.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+struct Timer : public RefCountObject<Timer>, public timer_wheel_hook<>
+{
+	Timer(int id) : Id(id) { }
+	virtual ~Timer() = default;
+
+	int Id;
+};
+
+
+TEST_CLASS(TimerWheelTests)
+{
+public:
+
+	TEST_METHOD(Advance_FiresTimersInOrder)
+	{
+		// Arrange
+		auto wheel = timer_wheel<Timer>();
+		auto fired = std::vector<std::pair<int, uint64_t>>();
+		wheel.schedule(make_intrusive<Timer>(1), 100);
+		wheel.schedule(make_intrusive<Timer>(2), 5);
+		wheel.schedule(make_intrusive<Timer>(3), 5000);
+		wheel.schedule(make_intrusive<Timer>(4), 64);
+		wheel.schedule(intrusive_ptr<Timer>(), 10);
+		wheel.schedule_after(intrusive_ptr<Timer>(), 10);
+
+		// Act
+		auto count = wheel.advance(1000, [&](intrusive_ptr<Timer> timer)
+		{
+			fired.emplace_back(timer->Id, wheel.now());
+		});
+
+		// Assert
+		Assert::AreEqual(size_t(3), count);
+		Assert::AreEqual(size_t(1), wheel.size());
+		Assert::AreEqual(2, fired[0].first);
+		Assert::AreEqual(uint64_t(5), fired[0].second);
+		Assert::AreEqual(4, fired[1].first);
+		Assert::AreEqual(uint64_t(64), fired[1].second);
+		Assert::AreEqual(1, fired[2].first);
+		Assert::AreEqual(uint64_t(100), fired[2].second);
+		Assert::AreEqual(uint64_t(1000), wheel.now());
+	}
+
+	TEST_METHOD(Cancel_ReleasesWheelReference)
+	{
+		// Arrange
+		auto wheel = timer_wheel<Timer>();
+		auto timer = make_intrusive<Timer>(1);
+		wheel.schedule(timer, 10);
+		auto armed_count = timer.use_count();
+
+		// Act
+		auto cancelled = wheel.cancel(*timer);
+		auto cancelled_again = wheel.cancel(*timer);
+		auto count = wheel.advance(100, [](intrusive_ptr<Timer>) { });
+
+		// Assert
+		Assert::AreEqual(2u, armed_count);
+		Assert::IsTrue(cancelled);
+		Assert::IsFalse(cancelled_again);
+		Assert::AreEqual(1u, timer.use_count());
+		Assert::IsFalse(timer->is_armed());
+		Assert::AreEqual(size_t(0), count);
+	}
+
+	TEST_METHOD(Reschedule_MovesArmedTimer)
+	{
+		// Arrange
+		auto wheel = timer_wheel<Timer>();
+		auto timer = make_intrusive<Timer>(1);
+		auto fired_at = uint64_t(0);
+		wheel.schedule(timer, 10);
+
+		// Act
+		wheel.schedule(timer, 300000);
+		wheel.advance(299999, [&](intrusive_ptr<Timer>) { fired_at = wheel.now(); });
+		auto before = fired_at;
+		wheel.advance(400000, [&](intrusive_ptr<Timer>) { fired_at = wheel.now(); });
+
+		// Assert
+		Assert::AreEqual(uint64_t(0), before);
+		Assert::AreEqual(uint64_t(300000), fired_at);
+		Assert::AreEqual(uint64_t(300000), timer->expiry());
+		Assert::AreEqual(1u, timer.use_count());
+	}
+
+	TEST_METHOD(Handler_CanRescheduleAndCancelBatch)
+	{
+		// Arrange
+		auto wheel = timer_wheel<Timer>();
+		auto periodic = make_intrusive<Timer>(1);
+		auto victim = make_intrusive<Timer>(2);
+		auto periodic_count = 0;
+		auto victim_count = 0;
+		wheel.schedule(periodic, 10);
+		wheel.schedule(victim, 10);
+
+		// Act
+		wheel.advance(100, [&](intrusive_ptr<Timer> timer)
+		{
+			if (timer->Id == 1)
+			{
+				++periodic_count;
+				wheel.cancel(*victim);
+				wheel.schedule_after(timer, 10);
+			}
+			else
+			{
+				++victim_count;
+			}
+		});
+
+		// Assert
+		Assert::AreEqual(10, periodic_count);
+		Assert::AreEqual(0, victim_count);
+		Assert::IsTrue(periodic->is_armed());
+		Assert::AreEqual(uint64_t(110), periodic->expiry());
+	}
+
+	TEST_METHOD(Handler_CanClearWheel)
+	{
+		// Arrange
+		auto wheel = timer_wheel<Timer>();
+		auto batch = make_intrusive<Timer>(2);
+		wheel.schedule(make_intrusive<Timer>(1), 10);
+		wheel.schedule(batch, 10);
+		wheel.schedule(make_intrusive<Timer>(3), 500);
+
+		// Act
+		auto count = wheel.advance(1000, [&](intrusive_ptr<Timer>) { wheel.clear(); });
+
+		// Assert
+		Assert::AreEqual(size_t(1), count);
+		Assert::AreEqual(size_t(0), wheel.size());
+		Assert::IsFalse(batch->is_armed());
+		Assert::AreEqual(1u, batch.use_count());
+		Assert::AreEqual(uint64_t(1000), wheel.now());
+	}
+
+	TEST_METHOD(ThrowingHandler_KeepsRestOfBatchArmed)
+	{
+		// Arrange
+		auto wheel = timer_wheel<Timer>();
+		auto second = make_intrusive<Timer>(2);
+		auto third = make_intrusive<Timer>(3);
+		wheel.schedule(make_intrusive<Timer>(1), 10);
+		wheel.schedule(second, 10);
+		wheel.schedule(third, 10);
+		auto thrown = false;
+
+		// Act
+		try
+		{
+			wheel.advance(100, [&](intrusive_ptr<Timer>) { throw std::runtime_error("failed"); });
+		}
+		catch (const std::runtime_error&)
+		{
+			thrown = true;
+		}
+		auto size_after_throw = wheel.size();
+		auto armed_after_throw = second->is_armed() && third->is_armed();
+		auto fired = std::vector<int>();
+		auto count = wheel.advance(100, [&](intrusive_ptr<Timer> timer) { fired.push_back(timer->Id); });
+		wheel.schedule(second, 200);
+		wheel.clear();
+
+		// Assert
+		Assert::IsTrue(thrown);
+		Assert::AreEqual(size_t(2), size_after_throw);
+		Assert::IsTrue(armed_after_throw);
+		Assert::AreEqual(size_t(2), count);
+		Assert::IsTrue(std::vector<int> { 2, 3 } == fired);
+		Assert::AreEqual(uint64_t(100), wheel.now());
+		Assert::AreEqual(size_t(0), wheel.size());
+		Assert::AreEqual(1u, second.use_count());
+		Assert::AreEqual(1u, third.use_count());
+	}
+
+	TEST_METHOD(RandomTimers_FireAtExpiry)
+	{
+		// Arrange
+		auto random = std::mt19937_64(5);
+		auto wheel = timer_wheel<Timer>(12345);
+		auto timers = std::vector<intrusive_ptr<Timer>>();
+		auto expected = std::map<int, uint64_t>();
+		for (auto i = 0; i < 20000; ++i)
+		{
+			auto expiry = 12345 + (random() >> (random() % 64));
+			timers.push_back(make_intrusive<Timer>(i));
+			wheel.schedule(timers.back(), expiry);
+			expected[i] = timers.back()->expiry();
+		}
+		for (auto i = 0; i < 20000; i += 3)
+		{
+			wheel.cancel(*timers[i]);
+			expected.erase(i);
+		}
+		auto late = 0;
+
+		// Act
+		auto limit = uint64_t(1) << 40;
+		for (auto now = uint64_t(12345); now < limit; now += now / 3)
+		{
+			wheel.advance(now, [&](intrusive_ptr<Timer> timer)
+			{
+				late += timer->expiry() != wheel.now() ? 1 : 0;
+				expected.erase(timer->Id);
+			});
+		}
+
+		// Assert
+		Assert::AreEqual(0, late);
+		for (auto& [id, expiry] : expected)
+		{
+			Assert::IsTrue(expiry > wheel.now());
+			Assert::IsTrue(timers[id]->is_armed());
+		}
+		Assert::AreEqual(expected.size(), wheel.size());
+	}
+};
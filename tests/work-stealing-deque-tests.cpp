@@ -0,0 +1,112 @@
+#include <atomic>
+#include <thread>
+#include <vector>
+#include "CppUnitTest.h"
+#include "include/work_stealing_deque.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+struct StolenItem : public RefCountObject<StolenItem>
+{
+	StolenItem(int id) : Id(id) { }
+	virtual ~StolenItem() = default;
+
+	int Id;
+};
+
+
+TEST_CLASS(WorkStealingDequeTests)
+{
+public:
+
+	TEST_METHOD(PopAndSteal_TakeOppositeEnds)
+	{
+		// Arrange
+		auto deque = work_stealing_deque<StolenItem>(2);
+		for (auto i = 0; i < 10; ++i)
+		{
+			deque.push(make_intrusive<StolenItem>(i));
+		}
+
+		// Act
+		auto popped = deque.pop();
+		auto stolen = deque.steal();
+		auto size = deque.size();
+
+		// Assert
+		Assert::AreEqual(9, popped->Id);
+		Assert::AreEqual(0, stolen->Id);
+		Assert::AreEqual(size_t(8), size);
+	}
+
+	TEST_METHOD(Push_TransfersReference)
+	{
+		// Arrange
+		auto deque = work_stealing_deque<StolenItem>();
+		auto item = make_intrusive<StolenItem>(1);
+
+		// Act
+		deque.push(item);
+		auto queued_count = item.use_count();
+		auto popped = deque.pop();
+		auto empty = deque.pop();
+
+		// Assert
+		Assert::AreEqual(2u, queued_count);
+		Assert::IsTrue(popped == item);
+		Assert::AreEqual(2u, item.use_count());
+		Assert::IsFalse(static_cast<bool>(empty));
+	}
+
+	TEST_METHOD(ConcurrentThieves_TakeEachItemOnce)
+	{
+		// Arrange
+		constexpr auto item_count = 100000;
+		constexpr auto thief_count = 3;
+		auto deque = work_stealing_deque<StolenItem>(16);
+		auto taken = std::vector<std::atomic<int>>(item_count);
+		auto done = std::atomic<bool>(false);
+		auto thieves = std::vector<std::thread>();
+
+		// Act
+		for (auto t = 0; t < thief_count; ++t)
+		{
+			thieves.emplace_back([&]
+			{
+				while (!done.load(std::memory_order_acquire) || !deque.empty())
+				{
+					if (auto item = deque.steal())
+					{
+						taken[item->Id].fetch_add(1, std::memory_order_relaxed);
+					}
+				}
+			});
+		}
+		for (auto i = 0; i < item_count; ++i)
+		{
+			deque.push(make_intrusive<StolenItem>(i));
+			if (i % 3 == 0)
+			{
+				if (auto item = deque.pop())
+				{
+					taken[item->Id].fetch_add(1, std::memory_order_relaxed);
+				}
+			}
+		}
+		while (auto item = deque.pop())
+		{
+			taken[item->Id].fetch_add(1, std::memory_order_relaxed);
+		}
+		done.store(true, std::memory_order_release);
+		for (auto& thief : thieves)
+		{
+			thief.join();
+		}
+
+		// Assert
+		for (auto& count : taken)
+		{
+			Assert::AreEqual(1, count.load());
+		}
+	}
+};